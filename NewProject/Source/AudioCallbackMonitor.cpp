@@ -0,0 +1,200 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "AudioCallbackMonitor.h"
+
+AudioCallbackMonitor::AudioCallbackMonitor()
+{
+    startTimer(LOG_INTERVAL_MS);
+}
+
+AudioCallbackMonitor::~AudioCallbackMonitor()
+{
+    stopTimer();
+}
+
+void AudioCallbackMonitor::setStages(int numDecks, const juce::StringArray& effectNames)
+{
+    firstEffectStage = firstDeckStage + numDecks;
+    effectStageNames = effectNames;
+    numStagesInUse = juce::jlimit(0, MAX_STAGES, firstEffectStage + effectNames.size());
+}
+
+int AudioCallbackMonitor::getFirstEffectStage() const
+{
+    return firstEffectStage;
+}
+
+juce::String AudioCallbackMonitor::getStageName(int stage) const
+{
+    if (stage == syncStage)
+        return "sync";
+    if (stage == mixStage)
+        return "mix";
+    if (stage >= firstEffectStage)
+        return effectStageNames[stage - firstEffectStage];
+
+    return "deck " + juce::String(stage - firstDeckStage + 1);
+}
+
+void AudioCallbackMonitor::prepareToPlay(int samplesPerBlockExpected, double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    deadlineTicks = juce::jmax((juce::int64) 1, (juce::int64) (samplesPerBlockExpected / sampleRate
+                                                               * juce::Time::getHighResolutionTicksPerSecond()));
+    previousStartTicks = 0;
+    samplesThisSecond = 0;
+    clearStats();
+}
+
+void AudioCallbackMonitor::beginCallback(int numSamples)
+{
+    callbackStartTicks = juce::Time::getHighResolutionTicks();
+
+    if (resetRequested.exchange(false, std::memory_order_relaxed))
+        clearStats();
+
+    // A callback arriving well after the previous block ran out means the device had nothing to play
+    if (previousStartTicks != 0 && callbackStartTicks - previousStartTicks > previousDeadlineTicks * GAP_THRESHOLD)
+        numGaps.store(numGaps.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    auto newDeadlineTicks = juce::jmax((juce::int64) 1, (juce::int64) (numSamples / sampleRate
+                                                                       * juce::Time::getHighResolutionTicksPerSecond()));
+    deadlineTicks.store(newDeadlineTicks, std::memory_order_relaxed);
+    previousStartTicks = callbackStartTicks;
+    previousDeadlineTicks = newDeadlineTicks;
+
+    // Moves on to a fresh worst-case slot every second of audio
+    samplesThisSecond += numSamples;
+    if (samplesThisSecond >= sampleRate)
+    {
+        samplesThisSecond -= static_cast<int>(sampleRate);
+        int nextSecond = (currentSecond.load(std::memory_order_relaxed) + 1) % HISTORY_SECONDS;
+        worstPerSecond[(size_t) nextSecond].store(0.0, std::memory_order_relaxed);
+        currentSecond.store(nextSecond, std::memory_order_relaxed);
+    }
+}
+
+void AudioCallbackMonitor::endCallback()
+{
+    double percent = ticksToPercent(juce::Time::getHighResolutionTicks() - callbackStartTicks);
+
+    callbackStats.record(percent);
+    lastPercent.store(percent, std::memory_order_relaxed);
+    numCallbacks.store(numCallbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (percent > 100.0)
+        numOverruns.store(numOverruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    auto& worst = worstPerSecond[(size_t) currentSecond.load(std::memory_order_relaxed)];
+    if (percent > worst.load(std::memory_order_relaxed))
+        worst.store(percent, std::memory_order_relaxed);
+}
+
+void AudioCallbackMonitor::recordStage(int stage, juce::int64 elapsedTicks)
+{
+    if (juce::isPositiveAndBelow(stage, MAX_STAGES))
+        stageStats[(size_t) stage].record(ticksToPercent(elapsedTicks));
+}
+
+double AudioCallbackMonitor::ticksToPercent(juce::int64 ticks) const
+{
+    return 100.0 * (double) ticks / (double) deadlineTicks.load(std::memory_order_relaxed);
+}
+
+AudioCallbackMonitor::Snapshot AudioCallbackMonitor::getSnapshot(int worstCaseSeconds) const
+{
+    Snapshot snapshot;
+    snapshot.numCallbacks = numCallbacks.load(std::memory_order_relaxed);
+    snapshot.lastPercent = lastPercent.load(std::memory_order_relaxed);
+    snapshot.smoothedPercent = callbackStats.smoothedPercent.load(std::memory_order_relaxed);
+    snapshot.peakPercent = callbackStats.peakPercent.load(std::memory_order_relaxed);
+    snapshot.numOverruns = numOverruns.load(std::memory_order_relaxed);
+    snapshot.numGaps = numGaps.load(std::memory_order_relaxed);
+
+    for (size_t bin = 0; bin < (size_t) NUM_HISTOGRAM_BINS; ++bin)
+        snapshot.histogram[bin] = callbackStats.histogram[bin].load(std::memory_order_relaxed);
+
+    snapshot.numStages = numStagesInUse.load(std::memory_order_relaxed);
+
+    for (size_t stage = 0; stage < (size_t) snapshot.numStages; ++stage)
+    {
+        snapshot.stages[stage].smoothedPercent = stageStats[stage].smoothedPercent.load(std::memory_order_relaxed);
+        snapshot.stages[stage].peakPercent = stageStats[stage].peakPercent.load(std::memory_order_relaxed);
+    }
+
+    // The slot being filled counts as one of the seconds
+    int second = currentSecond.load(std::memory_order_relaxed);
+    for (int i = 0; i < juce::jlimit(1, HISTORY_SECONDS, worstCaseSeconds); ++i)
+    {
+        int slot = (second - i + HISTORY_SECONDS) % HISTORY_SECONDS;
+        snapshot.worstRecentPercent = juce::jmax(snapshot.worstRecentPercent,
+                                                 worstPerSecond[(size_t) slot].load(std::memory_order_relaxed));
+    }
+
+    return snapshot;
+}
+
+void AudioCallbackMonitor::reset()
+{
+    resetRequested = true;
+}
+
+void AudioCallbackMonitor::clearStats()
+{
+    callbackStats.clear();
+
+    for (auto& stats : stageStats)
+        stats.clear();
+
+    for (auto& worst : worstPerSecond)
+        worst.store(0.0, std::memory_order_relaxed);
+
+    numCallbacks.store(0, std::memory_order_relaxed);
+    lastPercent.store(0.0, std::memory_order_relaxed);
+    numOverruns.store(0, std::memory_order_relaxed);
+    numGaps.store(0, std::memory_order_relaxed);
+}
+
+void AudioCallbackMonitor::timerCallback()
+{
+    auto snapshot = getSnapshot(LOG_INTERVAL_MS / 1000);
+
+    // nothing to say while the device is stopped
+    if (snapshot.numCallbacks == callbacksAtLastLog)
+        return;
+    callbacksAtLastLog = snapshot.numCallbacks;
+
+    juce::String message = "Audio callback: " + juce::String(snapshot.smoothedPercent, 1) + "% of deadline, worst "
+                           + juce::String(snapshot.worstRecentPercent, 1) + "% in the last "
+                           + juce::String(LOG_INTERVAL_MS / 1000) + " s, " + juce::String(snapshot.numOverruns)
+                           + " overruns, " + juce::String(snapshot.numGaps) + " gaps";
+
+    for (int stage = 0; stage < snapshot.numStages; ++stage)
+        message += ", " + getStageName(stage) + " " + juce::String(snapshot.stages[(size_t) stage].smoothedPercent, 1) + "%";
+
+    juce::Logger::writeToLog(message);
+}
+
+void AudioCallbackMonitor::TimingStats::record(double percent)
+{
+    double smoothed = smoothedPercent.load(std::memory_order_relaxed);
+    smoothedPercent.store(smoothed + SMOOTHING * (percent - smoothed), std::memory_order_relaxed);
+
+    if (percent > peakPercent.load(std::memory_order_relaxed))
+        peakPercent.store(percent, std::memory_order_relaxed);
+
+    auto bin = (size_t) juce::jlimit(0, NUM_HISTOGRAM_BINS - 1, static_cast<int>(percent / HISTOGRAM_BIN_PERCENT));
+    histogram[bin].store(histogram[bin].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void AudioCallbackMonitor::TimingStats::clear()
+{
+    for (auto& count : histogram)
+        count.store(0, std::memory_order_relaxed);
+
+    smoothedPercent.store(0.0, std::memory_order_relaxed);
+    peakPercent.store(0.0, std::memory_order_relaxed);
+}
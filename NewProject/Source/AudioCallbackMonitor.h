@@ -0,0 +1,152 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+// Times the audio callback and each stage inside it (sync, every deck's render, each deck
+// effect, the mix) as a share of the block's deadline. The audio thread only does relaxed atomic stores into fixed
+// arrays, so there are no locks or allocations; the GUI and the periodic log read a snapshot.
+// Xruns are detected two ways - callbacks that overran their deadline, and gaps between
+// callbacks long enough that the device must have run dry.
+class AudioCallbackMonitor : private juce::Timer
+{
+public:
+    // Histogram of deadline usage in 2.5% steps, the last bin collects everything over 157.5%
+    static constexpr int NUM_HISTOGRAM_BINS = 64;
+    static constexpr double HISTOGRAM_BIN_PERCENT = 2.5;
+
+    // Per-second worst cases are kept for this long
+    static constexpr int HISTORY_SECONDS = 60;
+    static constexpr int DEFAULT_WORST_CASE_SECONDS = 10;
+
+    // The sync and mix stages, then one stage per deck, then one per effect
+    enum Stage { syncStage = 0, mixStage, firstDeckStage };
+    static constexpr int MAX_STAGES = 16;
+
+    struct StageSnapshot
+    {
+        double smoothedPercent{0.0};
+        double peakPercent{0.0};
+    };
+
+    struct Snapshot
+    {
+        juce::uint64 numCallbacks{0};
+        double lastPercent{0.0};
+        double smoothedPercent{0.0};
+        double peakPercent{0.0};
+        double worstRecentPercent{0.0};
+        juce::uint32 numOverruns{0};
+        juce::uint32 numGaps{0};
+        std::array<juce::uint32, NUM_HISTOGRAM_BINS> histogram{};
+        std::array<StageSnapshot, MAX_STAGES> stages{};
+        int numStages{0};
+    };
+
+    AudioCallbackMonitor();
+    ~AudioCallbackMonitor() override;
+
+    // Lays out one stage per deck followed by one per named effect (message thread, before audio starts)
+    void setStages(int numDecks, const juce::StringArray& effectNames);
+    int getFirstEffectStage() const;
+    juce::String getStageName(int stage) const;
+
+    // Clears the statistics (message thread, before audio starts)
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+
+    // Wrap the audio callback (audio thread)
+    void beginCallback(int numSamples);
+    void endCallback();
+
+    // Times one stage of the current callback - safe on the deck render workers too
+    class ScopedStage
+    {
+    public:
+        ScopedStage(AudioCallbackMonitor& monitorToUse, int stageIndex)
+            : monitor(monitorToUse), stage(stageIndex), startTicks(juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedStage()
+        {
+            monitor.recordStage(stage, juce::Time::getHighResolutionTicks() - startTicks);
+        }
+
+    private:
+        AudioCallbackMonitor& monitor;
+        int stage;
+        juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedStage)
+    };
+
+    // Records a stage that was timed elsewhere, e.g. an effect summed over every deck - one
+    // thread per stage at a time
+    void recordStage(int stage, juce::int64 elapsedTicks);
+
+    // Reads the current statistics (any thread except the audio thread)
+    Snapshot getSnapshot(int worstCaseSeconds = DEFAULT_WORST_CASE_SECONDS) const;
+
+    // Asks the audio thread to clear the statistics at its next callback
+    void reset();
+
+private:
+    // Written by one thread at a time, read by any
+    struct TimingStats
+    {
+        std::array<std::atomic<juce::uint32>, NUM_HISTOGRAM_BINS> histogram{};
+        std::atomic<double> smoothedPercent{0.0};
+        std::atomic<double> peakPercent{0.0};
+
+        void record(double percent);
+        void clear();
+    };
+
+    void clearStats();
+    double ticksToPercent(juce::int64 ticks) const;
+
+    void timerCallback() override;
+
+    TimingStats callbackStats;
+    std::array<TimingStats, MAX_STAGES> stageStats;
+    std::atomic<int> numStagesInUse{firstDeckStage};
+    int firstEffectStage{firstDeckStage};
+    juce::StringArray effectStageNames;
+
+    std::atomic<juce::uint64> numCallbacks{0};
+    std::atomic<double> lastPercent{0.0};
+    std::atomic<juce::uint32> numOverruns{0};
+    std::atomic<juce::uint32> numGaps{0};
+
+    // Worst callback of each second, as a ring indexed by currentSecond
+    std::array<std::atomic<double>, HISTORY_SECONDS> worstPerSecond{};
+    std::atomic<int> currentSecond{0};
+
+    // The current block's deadline, read by the stage timers on the render workers
+    std::atomic<juce::int64> deadlineTicks{1};
+
+    std::atomic<bool> resetRequested{false};
+
+    // audio thread only
+    double sampleRate{44100.0};
+    juce::int64 callbackStartTicks{0};
+    juce::int64 previousStartTicks{0};
+    juce::int64 previousDeadlineTicks{0};
+    int samplesThisSecond{0};
+
+    // message thread only
+    juce::uint64 callbacksAtLastLog{0};
+
+    // How late a callback can start before it counts as a gap, as a multiple of the block length
+    static constexpr double GAP_THRESHOLD = 1.8;
+    // Smoothing of the load figures - about a second of history at typical block sizes
+    static constexpr double SMOOTHING = 0.01;
+    static constexpr int LOG_INTERVAL_MS = 10000;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioCallbackMonitor)
+};
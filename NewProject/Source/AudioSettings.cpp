@@ -0,0 +1,244 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "AudioSettings.h"
+
+std::unique_ptr<juce::XmlElement> AudioSettings::load(const juce::File& file)
+{
+    if (! file.existsAsFile())
+        return nullptr;
+
+    auto settings = juce::parseXML(file);
+
+    if (settings == nullptr || ! settings->hasTagName("OTODECKSAUDIO"))
+        return nullptr;
+
+    return settings;
+}
+
+juce::Result AudioSettings::save(const juce::File& file, juce::AudioDeviceManager& deviceManager,
+                                 MixerEngine::OutputRouting routing)
+{
+    juce::XmlElement settings("OTODECKSAUDIO");
+    settings.setAttribute("outputs", MixerEngine::getOutputRoutingName(routing));
+
+    // nothing until a device has been picked or restored - the default needs no saving
+    if (auto deviceState = deviceManager.createStateXml())
+        settings.addChildElement(deviceState.release());
+
+    file.getParentDirectory().createDirectory();
+
+    if (! settings.writeTo(file))
+        return juce::Result::fail("Couldn't write " + file.getFullPathName());
+
+    return juce::Result::ok();
+}
+
+const juce::XmlElement* AudioSettings::getDeviceState(const juce::XmlElement* settings)
+{
+    return settings != nullptr ? settings->getChildByName("DEVICESETUP") : nullptr;
+}
+
+MixerEngine::OutputRouting AudioSettings::getOutputRouting(const juce::XmlElement* settings)
+{
+    auto routing = MixerEngine::OutputRouting::master;
+
+    if (settings != nullptr)
+        MixerEngine::findOutputRouting(settings->getStringAttribute("outputs"), routing);
+
+    return routing;
+}
+
+void AudioSettings::selectLowLatencyDeviceType(juce::AudioDeviceManager& deviceManager)
+{
+   #if JUCE_LINUX
+    // JACK only lists devices while its server is running, so ALSA is the fallback
+    for (auto* typeName : { "JACK", "ALSA" })
+    {
+        for (auto* type : deviceManager.getAvailableDeviceTypes())
+        {
+            if (type->getTypeName() != typeName)
+                continue;
+
+            type->scanForDevices();
+
+            if (! type->getDeviceNames(false).isEmpty())
+            {
+                deviceManager.setCurrentAudioDeviceType(typeName, false);
+                return;
+            }
+        }
+    }
+   #else
+    juce::ignoreUnused(deviceManager);
+   #endif
+}
+
+juce::File AudioSettings::getDefaultSettingsFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("OtoDecks").getChildFile("audio.xml");
+}
+
+BufferSizeProbe::BufferSizeProbe(juce::AudioDeviceManager& deviceManagerToProbe, AudioCallbackMonitor& monitorToUse)
+    : deviceManager(deviceManagerToProbe), monitor(monitorToUse)
+{
+}
+
+BufferSizeProbe::~BufferSizeProbe()
+{
+    // the device goes back to where it was, without calling out to an owner being destroyed
+    onStatusChanged = nullptr;
+    onFinished = nullptr;
+    cancel();
+}
+
+void BufferSizeProbe::start()
+{
+    auto* device = deviceManager.getCurrentAudioDevice();
+
+    if (isRunning() || device == nullptr)
+        return;
+
+    startingBufferSize = device->getCurrentBufferSizeSamples();
+    lastCleanBufferSize = 0;
+    step = 0;
+
+    for (auto bufferSize : device->getAvailableBufferSizes())
+        if (bufferSize <= startingBufferSize)
+            bufferSizes.add(bufferSize);
+
+    std::sort(bufferSizes.begin(), bufferSizes.end(), std::greater<int>());
+
+    if (bufferSizes.isEmpty())
+        bufferSizes.add(startingBufferSize);
+
+    beginStep();
+}
+
+void BufferSizeProbe::cancel()
+{
+    if (isRunning())
+        finish(startingBufferSize, "Cancelled, back at " + describe(startingBufferSize));
+}
+
+bool BufferSizeProbe::isRunning() const
+{
+    return ! bufferSizes.isEmpty();
+}
+
+void BufferSizeProbe::beginStep()
+{
+    int bufferSize = bufferSizes[step];
+
+    if (! setBufferSize(bufferSize))
+    {
+        finish(lastCleanBufferSize > 0 ? lastCleanBufferSize : startingBufferSize,
+               "The device won't run at " + juce::String(bufferSize) + " samples");
+        return;
+    }
+
+    if (onStatusChanged)
+        onStatusChanged("Trying " + describe(bufferSize) + "...");
+
+    measuring = false;
+    startTimer(SETTLE_MS);
+}
+
+void BufferSizeProbe::timerCallback()
+{
+    int bufferSize = bufferSizes[step];
+    auto* device = deviceManager.getCurrentAudioDevice();
+
+    // the device was changed from under the probe
+    if (device == nullptr || device->getCurrentBufferSizeSamples() != bufferSize)
+    {
+        finish(-1, "Stopped, the device changed");
+        return;
+    }
+
+    // the restart's own glitches are over, so the count starts now
+    if (! measuring)
+    {
+        xrunsAtStart = countXRuns();
+        measuring = true;
+        startTimer(STEP_SECONDS * 1000);
+        return;
+    }
+
+    stopTimer();
+    auto xruns = countXRuns() - xrunsAtStart;
+
+    if (xruns > 0)
+    {
+        if (lastCleanBufferSize > 0)
+            finish(lastCleanBufferSize, juce::String(xruns) + " xruns at " + juce::String(bufferSize)
+                                        + " samples, settled on " + describe(lastCleanBufferSize));
+        else
+            finish(startingBufferSize, juce::String(xruns) + " xruns at " + describe(bufferSize)
+                                       + " already - kept it, but a larger buffer would be safer");
+        return;
+    }
+
+    lastCleanBufferSize = bufferSize;
+
+    if (++step < bufferSizes.size())
+        beginStep();
+    else
+        finish(bufferSize, "No xruns down to the smallest size, " + describe(bufferSize));
+}
+
+bool BufferSizeProbe::setBufferSize(int bufferSize)
+{
+    auto setup = deviceManager.getAudioDeviceSetup();
+    setup.bufferSize = bufferSize;
+
+    auto error = deviceManager.setAudioDeviceSetup(setup, true);
+    auto* device = deviceManager.getCurrentAudioDevice();
+
+    return error.isEmpty() && device != nullptr && device->getCurrentBufferSizeSamples() == bufferSize;
+}
+
+juce::int64 BufferSizeProbe::countXRuns() const
+{
+    auto snapshot = monitor.getSnapshot();
+    juce::int64 xruns = snapshot.numOverruns + snapshot.numGaps;
+
+    if (auto* device = deviceManager.getCurrentAudioDevice())
+        xruns += juce::jmax(0, device->getXRunCount());
+
+    return xruns;
+}
+
+void BufferSizeProbe::finish(int bufferSize, const juce::String& status)
+{
+    stopTimer();
+    bufferSizes.clearQuick();
+    measuring = false;
+
+    auto* device = deviceManager.getCurrentAudioDevice();
+
+    if (bufferSize > 0 && device != nullptr && device->getCurrentBufferSizeSamples() != bufferSize)
+        setBufferSize(bufferSize);
+
+    if (onStatusChanged)
+        onStatusChanged(status);
+
+    // the restart may have left the device at another size than asked for
+    device = deviceManager.getCurrentAudioDevice();
+
+    if (onFinished && device != nullptr)
+        onFinished(device->getCurrentBufferSizeSamples());
+}
+
+juce::String BufferSizeProbe::describe(int bufferSize) const
+{
+    auto* device = deviceManager.getCurrentAudioDevice();
+    double sampleRate = device != nullptr ? device->getCurrentSampleRate() : 0.0;
+
+    if (sampleRate <= 0.0)
+        return juce::String(bufferSize) + " samples";
+
+    return juce::String(bufferSize) + " samples (" + juce::String(1000.0 * bufferSize / sampleRate, 1) + " ms)";
+}
@@ -0,0 +1,94 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "MixerEngine.h"
+
+// Saves and restores the audio device setup - the device, sample rate, buffer size and open
+// outputs, with the mixer's output routing - in Documents/OtoDecks/audio.xml:
+//
+//   <OTODECKSAUDIO outputs="cue">
+//     <DEVICESETUP deviceType="ALSA" audioOutputDeviceName="..." audioDeviceRate="48000" audioDeviceBufferSize="128" .../>
+//   </OTODECKSAUDIO>
+//
+// The DEVICESETUP element is the AudioDeviceManager's own state. On a first run with nothing
+// saved, Linux opens JACK if its server is running and ALSA otherwise, rather than going through
+// a sound server, for the shortest round trip.
+class AudioSettings
+{
+public:
+    // The saved settings, or nullptr if there are none or they can't be read
+    static std::unique_ptr<juce::XmlElement> load(const juce::File& file);
+    // Saves the device manager's setup, if one has been chosen, with the routing (message thread)
+    static juce::Result save(const juce::File& file, juce::AudioDeviceManager& deviceManager,
+                             MixerEngine::OutputRouting routing);
+
+    // The device setup from saved settings, for AudioAppComponent::setAudioChannels, or nullptr
+    static const juce::XmlElement* getDeviceState(const juce::XmlElement* settings);
+    // The saved routing, or just the master if there is none
+    static MixerEngine::OutputRouting getOutputRouting(const juce::XmlElement* settings);
+
+    // Makes JACK or ALSA the device type on Linux - does nothing elsewhere (message thread, before
+    // the device is opened)
+    static void selectLowLatencyDeviceType(juce::AudioDeviceManager& deviceManager);
+
+    // Where the app saves the settings
+    static juce::File getDefaultSettingsFile();
+};
+
+// Finds the smallest buffer the device runs at without xruns. Starting from the current size it
+// holds each of the device's buffer sizes in turn, smallest last, for STEP_SECONDS and counts the
+// xruns - the device's own count where it has one, and the callback monitor's overruns and gaps.
+// The first size that xruns stops the probe, which settles on the size before it. Something heavy
+// should be playing meanwhile, so the load is the one the buffer has to cope with.
+class BufferSizeProbe : private juce::Timer
+{
+public:
+    BufferSizeProbe(juce::AudioDeviceManager& deviceManagerToProbe, AudioCallbackMonitor& monitorToUse);
+    ~BufferSizeProbe() override;
+
+    // All on the message thread
+    void start();
+    // Stops, going back to the buffer size the probe started from
+    void cancel();
+    bool isRunning() const;
+
+    // What the probe is doing, as it changes
+    std::function<void(const juce::String& status)> onStatusChanged;
+    // The buffer size it settled on, once it has
+    std::function<void(int bufferSize)> onFinished;
+
+    // Each size runs this long, after SETTLE_MS for the device to restart
+    static constexpr int STEP_SECONDS = 5;
+    static constexpr int SETTLE_MS = 750;
+
+private:
+    void timerCallback() override;
+    // Restarts the device at the step's buffer size and waits for it to settle
+    void beginStep();
+    // Restarts the device at a buffer size, false if it won't run at it
+    bool setBufferSize(int bufferSize);
+    // Xruns so far by every count this device has
+    juce::int64 countXRuns() const;
+    // Stops at a buffer size, or where the device is for -1
+    void finish(int bufferSize, const juce::String& status);
+    juce::String describe(int bufferSize) const;
+
+    juce::AudioDeviceManager& deviceManager;
+    AudioCallbackMonitor& monitor;
+
+    // The sizes to try, largest first, and the one being tried
+    juce::Array<int> bufferSizes;
+    int step{0};
+    int startingBufferSize{0};
+    int lastCleanBufferSize{0};
+
+    bool measuring{false};
+    juce::int64 xrunsAtStart{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BufferSizeProbe)
+};
@@ -0,0 +1,96 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "AudioSettingsComponent.h"
+
+AudioSettingsComponent::AudioSettingsComponent(juce::AudioDeviceManager& deviceManagerToUse, MixerEngine& mixerToMeasure,
+                                               int maxOutputChannels)
+    : deviceManager(deviceManagerToUse),
+      deviceSelector(deviceManagerToUse, 0, 0, 2, maxOutputChannels, false, false, true, false),
+      mixer(mixerToMeasure),
+      probe(deviceManagerToUse, mixerToMeasure.getMonitor())
+{
+    addAndMakeVisible(deviceSelector);
+
+    // the probe restarts the device a few times, so the button cancels it while it runs
+    probeButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour::fromRGB(255, 159, 67)); // Orange
+    probeButton.setColour(juce::TextButton::textColourOnId, juce::Colours::black);
+    probeButton.onClick = [this]()
+    {
+        if (probe.isRunning())
+            probe.cancel();
+        else
+            probe.start();
+
+        probeButton.setToggleState(probe.isRunning(), juce::dontSendNotification);
+    };
+    addAndMakeVisible(probeButton);
+
+    statusLabel.setText("Play something heavy while the probe steps the buffer down", juce::dontSendNotification);
+    statusLabel.setColour(juce::Label::textColourId, juce::Colour::fromRGB(200, 200, 210));
+    statusLabel.setFont(juce::Font(12.0f));
+    addAndMakeVisible(statusLabel);
+
+    latencyLabel.setColour(juce::Label::textColourId, juce::Colour::fromRGB(107, 255, 107));
+    latencyLabel.setFont(juce::Font(12.0f, juce::Font::bold));
+    addAndMakeVisible(latencyLabel);
+
+    probe.onStatusChanged = [this](const juce::String& status) { statusLabel.setText(status, juce::dontSendNotification); };
+    probe.onFinished = [this](int) { probeButton.setToggleState(false, juce::dontSendNotification); };
+
+    deviceManager.addChangeListener(this);
+    updateLatencyLabel();
+
+    setSize(520, 480);
+}
+
+AudioSettingsComponent::~AudioSettingsComponent()
+{
+    deviceManager.removeChangeListener(this);
+}
+
+void AudioSettingsComponent::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colour::fromRGB(28, 28, 28));
+}
+
+void AudioSettingsComponent::resized()
+{
+    auto area = getLocalBounds().reduced(8);
+
+    latencyLabel.setBounds(area.removeFromBottom(20));
+    statusLabel.setBounds(area.removeFromBottom(20));
+    area.removeFromBottom(4);
+    probeButton.setBounds(area.removeFromBottom(28).withSizeKeepingCentre(260, 28));
+    area.removeFromBottom(8);
+
+    deviceSelector.setBounds(area);
+}
+
+void AudioSettingsComponent::changeListenerCallback(juce::ChangeBroadcaster*)
+{
+    updateLatencyLabel();
+}
+
+void AudioSettingsComponent::updateLatencyLabel()
+{
+    auto* device = deviceManager.getCurrentAudioDevice();
+
+    if (device == nullptr || device->getCurrentSampleRate() <= 0.0)
+    {
+        latencyLabel.setText("No audio device open", juce::dontSendNotification);
+        return;
+    }
+
+    // the buffer, the device's own output delay and the limiter's look-ahead - the change message
+    // comes after the restart, so the mixer has been prepared at the new rate by now
+    int bufferSize = device->getCurrentBufferSizeSamples();
+    int totalSamples = bufferSize + device->getOutputLatencyInSamples() + mixer.getLatencyInSamples();
+    double totalMs = 1000.0 * totalSamples / device->getCurrentSampleRate();
+
+    latencyLabel.setText(device->getTypeName() + " - output latency " + juce::String(totalMs, 1) + " ms ("
+                         + juce::String(bufferSize) + " sample buffer at " + juce::String(device->getCurrentSampleRate(), 0) + " Hz)",
+                         juce::dontSendNotification);
+}
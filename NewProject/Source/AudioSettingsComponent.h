@@ -0,0 +1,41 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioSettings.h"
+
+// The audio settings window - the device type and device, sample rate, buffer size and outputs,
+// with a button that probes for the smallest buffer the device runs at without xruns, and the
+// output latency the settings give. No inputs are offered, as nothing in the app listens to them.
+class AudioSettingsComponent : public juce::Component,
+                               private juce::ChangeListener
+{
+public:
+    // The mixer's own delay is added to the device's for the latency shown, and is read again
+    // whenever the device changes, as it follows the sample rate
+    AudioSettingsComponent(juce::AudioDeviceManager& deviceManagerToUse, MixerEngine& mixerToMeasure,
+                           int maxOutputChannels);
+    ~AudioSettingsComponent() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    void updateLatencyLabel();
+
+    juce::AudioDeviceManager& deviceManager;
+    juce::AudioDeviceSelectorComponent deviceSelector;
+    MixerEngine& mixer;
+    BufferSizeProbe probe;
+
+    juce::TextButton probeButton{"FIND SMALLEST STABLE BUFFER"};
+    juce::Label statusLabel;
+    juce::Label latencyLabel;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioSettingsComponent)
+};
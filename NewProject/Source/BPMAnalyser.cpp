@@ -4,10 +4,13 @@
 */
 
 #include "BPMAnalyser.h"
+#include "Tracing.h"
+#include <array>
 
 BPMAnalyser::BPMAnalyser(double sampleRate)
     : sampleRate(sampleRate), currentBPM(0.0), previousEnergy(0.0), 
-      energyThreshold(0.0), samplesProcessed(0), lastBeatTime(0.0)
+      energyThreshold(0.0), samplesProcessed(0), lastBeatTime(0.0), beatGridOffset(0.0),
+      framesSinceOnset(ACCENT_FRAMES)
 {
     // initialise analysis buffer
     analysisBuffer.setSize(1, ANALYSIS_BUFFER_SIZE);
@@ -15,6 +18,8 @@ BPMAnalyser::BPMAnalyser(double sampleRate)
     // reserve space for beat times
     energyHistory.reserve(ENERGY_HISTORY_SIZE);
     beatTimes.reserve(100);
+    onsetTimes.reserve(200);
+    onsetAccents.reserve(200);
     recentBPMValues.reserve(10);
     
     reset();
@@ -26,6 +31,8 @@ BPMAnalyser::~BPMAnalyser()
 
 double BPMAnalyser::analyseBPM(const juce::File& audioFile)
 {
+    TRACE_SCOPE("analysis", "bpm analysis");
+    
     if (!audioFile.exists())
         return 0.0;
     
@@ -79,8 +86,11 @@ double BPMAnalyser::analyseBPM(const juce::File& audioFile)
         samplesRead += samplesToRead;
     }
     
-    // Calculates the final BPM estimate
-    return estimateBPMFromBeats();
+    // Calculates the final BPM estimate and anchors the beat grid to it
+    double bpm = estimateBPMFromBeats();
+    beatGridOffset = estimateBeatGridOffset(bpm);
+    
+    return bpm;
 }
 
 void BPMAnalyser::processAudioBuffer(const float* buffer, int numSamples)
@@ -111,8 +121,8 @@ void BPMAnalyser::processAudioBuffer(const float* buffer, int numSamples)
             energyThreshold = averageEnergy * 1.3;
         }
         
-        // Detects beats
-        detectBeat(energy, samplesProcessed + i);
+        // Detects beats, timed from where the onset starts inside the frame
+        detectBeat(energy, samplesProcessed + findOnsetInFrame(buffer, i, frameSamples));
         
         previousEnergy = energy;
     }
@@ -127,9 +137,13 @@ void BPMAnalyser::reset()
     energyThreshold = 0.0;
     samplesProcessed = 0;
     lastBeatTime = 0.0;
+    beatGridOffset = 0.0;
     
     energyHistory.clear();
     beatTimes.clear();
+    onsetTimes.clear();
+    onsetAccents.clear();
+    framesSinceOnset = ACCENT_FRAMES;
     recentBPMValues.clear();
 }
 
@@ -151,24 +165,45 @@ double BPMAnalyser::calculateEnergy(const float* buffer, int startSample, int nu
     return energy / numSamples; // normalise by number of samples
 }
 
+int BPMAnalyser::findOnsetInFrame(const float* buffer, int startSample, int numSamples)
+{
+    // The first sample at half the frame's peak - searched from the frame before as well, as a
+    // beat that starts at the very end of a frame is only detected in the next one
+    float peak = 0.0f;
+    for (int i = startSample; i < startSample + numSamples; ++i)
+        peak = juce::jmax(peak, std::abs(buffer[i]));
+    
+    for (int i = juce::jmax(0, startSample - numSamples); i < startSample + numSamples; ++i)
+        if (std::abs(buffer[i]) >= peak * 0.5f)
+            return i;
+    
+    return startSample;
+}
+
 void BPMAnalyser::detectBeat(double energy, int sampleIndex)
 {
-    // Simple onset detection: energy is significantly higher than previous energy
+    // Simple onset detection: energy is significantly higher than previous energy. The first
+    // frames have no history to judge by, so only a clearly audible rise counts there - a track
+    // that starts on its first beat keeps that beat for the grid
 
     bool isOnset = (energy > energyThreshold) && 
                    (energy > previousEnergy * 1.5) && 
-                   (energyHistory.size() > 5);
+                   (energyHistory.size() > 5 || energy > START_ONSET_ENERGY);
     
-    if (isOnset)
+    double currentTime = static_cast<double>(sampleIndex) / sampleRate;
+    
+    // Avoids detecting beats too close together (minimum 0.2 seconds apart)
+    if (isOnset && (beatTimes.empty() || currentTime - lastBeatTime > 0.2))
     {
-        double currentTime = static_cast<double>(sampleIndex) / sampleRate;
-        
-        // Avoids detecting beats too close together (minimum 0.2 seconds apart)
-        if (currentTime - lastBeatTime > 0.2)
         {
             beatTimes.push_back(currentTime);
             lastBeatTime = currentTime;
             
+            // the onset's accent is its loudest frame, over the next few as well
+            onsetTimes.push_back(currentTime);
+            onsetAccents.push_back(energy);
+            framesSinceOnset = 0;
+            
             // keeps only the recent beats (last 20 secs)
             while (!beatTimes.empty() && (currentTime - beatTimes.front()) > 20.0)
             {
@@ -187,6 +222,11 @@ void BPMAnalyser::detectBeat(double energy, int sampleIndex)
             }
         }
     }
+    else if (framesSinceOnset < ACCENT_FRAMES && ! onsetAccents.empty())
+    {
+        onsetAccents.back() = juce::jmax(onsetAccents.back(), energy);
+        ++framesSinceOnset;
+    }
 }
 
 double BPMAnalyser::estimateBPMFromBeats()
@@ -234,8 +274,15 @@ double BPMAnalyser::estimateBPMFromBeats()
     if (maxCount < 3) // Need at least 3 similar intervals
         return 0.0;
     
+    // The 5ms bins only find the peak - a parabola through the bins either side puts it between
+    // them, and a straight line fitted through every beat then gives the interval itself
+    double below = intervalHistogram.count(bestBin - 1) > 0 ? intervalHistogram[bestBin - 1] : 0.0;
+    double above = intervalHistogram.count(bestBin + 1) > 0 ? intervalHistogram[bestBin + 1] : 0.0;
+    double curvature = below - 2.0 * maxCount + above;
+    double peakOffset = curvature < 0.0 ? 0.5 * (below - above) / curvature : 0.0;
+    
     // converts back to interval and then to BPM
-    double bestInterval = static_cast<double>(bestBin) / 200.0;
+    double bestInterval = refineBeatInterval((bestBin + 0.5 + peakOffset) / 200.0);
     double bpm = 60.0 / bestInterval;
     
     // Validate BPM range
@@ -255,6 +302,47 @@ double BPMAnalyser::estimateBPMFromBeats()
     return 0.0;
 }
 
+double BPMAnalyser::refineBeatInterval(double roughInterval) const
+{
+    // Least-squares line through (beat number, onset time) - its slope is the beat interval, with
+    // the onsets' 512 sample frame steps averaged out over every beat instead of binned
+    double sumBeats = 0.0, sumTimes = 0.0, sumBeatsSquared = 0.0, sumBeatTimes = 0.0;
+    double beatNumber = 0.0;
+    double lastTime = 0.0;
+    int count = 0;
+    
+    for (double time : beatTimes)
+    {
+        if (count > 0)
+        {
+            double beats = (time - lastTime) / roughInterval;
+            double wholeBeats = std::round(beats);
+            
+            // an onset off the grid (a fill, an off-beat) is left out
+            if (wholeBeats < 1.0 || std::abs(beats - wholeBeats) > 0.2)
+                continue;
+            
+            beatNumber += wholeBeats;
+        }
+        
+        lastTime = time;
+        sumBeats += beatNumber;
+        sumTimes += time;
+        sumBeatsSquared += beatNumber * beatNumber;
+        sumBeatTimes += beatNumber * time;
+        ++count;
+    }
+    
+    double denominator = count * sumBeatsSquared - sumBeats * sumBeats;
+    if (count < 4 || denominator <= 0.0)
+        return roughInterval;
+    
+    double interval = (count * sumBeatTimes - sumBeats * sumTimes) / denominator;
+    
+    // a fit pulled far from the histogram's peak has locked onto the wrong beats
+    return std::abs(interval - roughInterval) < roughInterval * 0.05 ? interval : roughInterval;
+}
+
 double BPMAnalyser::smoothBPM(double newBPM)
 {
     // Adds to recent values
@@ -280,3 +368,83 @@ double BPMAnalyser::smoothBPM(double newBPM)
     
     return weightedSum / totalWeight;
 }
+
+
+double BPMAnalyser::estimateBeatGridOffset(double bpm)
+{
+    if (bpm <= 0.0 || onsetTimes.empty())
+        return 0.0;
+    
+    double beatLength = 60.0 / bpm;
+    
+    // Averages the phase of every onset of the analysis against the beat length on the unit
+    // circle, so beats either side of the grid line don't cancel each other out. Louder onsets
+    // count for more, so the kicks outweigh anything between them
+    double sumSin = 0.0;
+    double sumCos = 0.0;
+    double loudest = 0.0;
+    
+    for (size_t i = 0; i < onsetTimes.size(); ++i)
+    {
+        double angle = std::fmod(onsetTimes[i], beatLength) / beatLength * juce::MathConstants<double>::twoPi;
+        sumSin += onsetAccents[i] * std::sin(angle);
+        sumCos += onsetAccents[i] * std::cos(angle);
+        loudest = juce::jmax(loudest, onsetAccents[i]);
+    }
+    
+    double meanAngle = std::atan2(sumSin, sumCos);
+    if (meanAngle < 0.0)
+        meanAngle += juce::MathConstants<double>::twoPi;
+    
+    double beatPhase = meanAngle / juce::MathConstants<double>::twoPi * beatLength;
+    
+    // Bar phase - every onset on the grid adds its accent to the beat of the bar it falls on,
+    // counting from the first beat of the grid. The first strong onset is the fallback downbeat
+    std::array<double, BEATS_PER_BAR> accents{};
+    std::array<int, BEATS_PER_BAR> counts{};
+    int firstStrongBeat = -1;
+    
+    for (size_t i = 0; i < onsetTimes.size(); ++i)
+    {
+        double beats = (onsetTimes[i] - beatPhase) / beatLength;
+        double wholeBeats = std::round(beats);
+        
+        // an onset off the grid (a fill, an off-beat) says nothing about the bar
+        if (std::abs(beats - wholeBeats) > 0.2)
+            continue;
+        
+        int beatInBar = ((static_cast<int>(wholeBeats) % BEATS_PER_BAR) + BEATS_PER_BAR) % BEATS_PER_BAR;
+        accents[(size_t) beatInBar] += onsetAccents[i];
+        ++counts[(size_t) beatInBar];
+        
+        if (firstStrongBeat < 0 && onsetAccents[i] >= loudest * 0.5)
+            firstStrongBeat = beatInBar;
+    }
+    
+    int downbeat = juce::jmax(0, firstStrongBeat);
+    double bestAccent = 0.0;
+    double nextAccent = 0.0;
+    int bestBeat = 0;
+    
+    for (int beat = 0; beat < BEATS_PER_BAR; ++beat)
+    {
+        double meanAccent = counts[(size_t) beat] > 0 ? accents[(size_t) beat] / counts[(size_t) beat] : 0.0;
+        
+        if (meanAccent > bestAccent)
+        {
+            nextAccent = bestAccent;
+            bestAccent = meanAccent;
+            bestBeat = beat;
+        }
+        else
+        {
+            nextAccent = juce::jmax(nextAccent, meanAccent);
+        }
+    }
+    
+    // only a clearly accented beat of the bar overrides the first strong onset
+    if (bestAccent > nextAccent * DOWNBEAT_ACCENT_RATIO)
+        downbeat = bestBeat;
+    
+    return beatPhase + downbeat * beatLength;
+}
\ No newline at end of file
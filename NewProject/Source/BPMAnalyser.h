@@ -23,9 +23,15 @@ public:
     // Gets  the currently detected BPM
     double getCurrentBPM() const { return currentBPM; }
     
+    // Gets the time in seconds of the first downbeat of the grid (the grid anchor), within the first bar
+    double getBeatGridOffset() const { return beatGridOffset; }
+    
     // Resets the analysis state
     void reset();
     void setSampleRate(double newSampleRate);
+    
+    // The grid's bars - its anchor is a downbeat, found from which beat of the bar is accented
+    static constexpr int BEATS_PER_BAR = 4;
 
 private:
     double sampleRate;
@@ -35,22 +41,39 @@ private:
     juce::AudioBuffer<float> analysisBuffer;
     std::vector<double> energyHistory;
     std::vector<double> beatTimes;
+    // Every onset of the analysis with its accent, for the grid - beatTimes only keeps the last 20 s
+    std::vector<double> onsetTimes;
+    std::vector<double> onsetAccents;
+    int framesSinceOnset;
     
         static constexpr int ANALYSIS_BUFFER_SIZE = 8192;
         static constexpr int ENERGY_HISTORY_SIZE = 200;
         static constexpr double MIN_BPM = 60.0;
         static constexpr double MAX_BPM = 200.0;
+        // Mean square energy an onset in the first frames needs, about -30 dBFS
+        static constexpr double START_ONSET_ENERGY = 1.0e-3;
+        // An onset's accent is its loudest frame this many frames from its start
+        static constexpr int ACCENT_FRAMES = 4;
+        // The downbeats must be this much louder on average than any other beat of the bar to be
+        // told apart by their accent - otherwise the first strong onset is taken as a downbeat
+        static constexpr double DOWNBEAT_ACCENT_RATIO = 1.2;
     
     // Beat detection
     double calculateEnergy(const float* buffer, int startSample, int numSamples);
+    // Where a beat starting in the frame starts, for a grid finer than the frames
+    int findOnsetInFrame(const float* buffer, int startSample, int numSamples);
     void detectBeat(double energy, int sampleIndex);
     double estimateBPMFromBeats();
+    // Fits the beat grid to the onsets for an interval finer than the histogram's bins
+    double refineBeatInterval(double roughInterval) const;
     double smoothBPM(double newBPM);
+    double estimateBeatGridOffset(double bpm);
     
     double previousEnergy;
     double energyThreshold;
     int samplesProcessed;
     double lastBeatTime;
+    double beatGridOffset;
     std::vector<double> recentBPMValues;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BPMAnalyser)
@@ -0,0 +1,610 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "Benchmarks.h"
+#include "TimeStretchAudioSource.h"
+#include "SincResamplingAudioSource.h"
+#include "DJAudioPlayer.h"
+#include "MixerEngine.h"
+#include "BPMAnalyser.h"
+#include "PlaylistComponent.h"
+#include "MasterLimiter.h"
+#include "MasterRecorder.h"
+
+namespace
+{
+    // MainComponent's audio callback without its GUI - the mixer, with the recorder on its master
+    class AppAudioCallback : public juce::AudioSource
+    {
+    public:
+        AppAudioCallback(MixerEngine& mixerToUse, MasterRecorder& recorderToUse)
+            : mixer(mixerToUse), recorder(recorderToUse)
+        {
+            mixer.onMasterBlock = [this](const juce::AudioSourceChannelInfo& master) { recorder.pushBlock(master); };
+        }
+
+        void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override
+        {
+            mixer.prepareToPlay(samplesPerBlockExpected, sampleRate);
+            recorder.prepareToPlay(samplesPerBlockExpected, sampleRate);
+        }
+
+        void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override
+        {
+            mixer.getNextAudioBlock(bufferToFill);
+        }
+
+        void releaseResources() override
+        {
+            mixer.releaseResources();
+        }
+
+    private:
+        MixerEngine& mixer;
+        MasterRecorder& recorder;
+    };
+}
+
+juce::Array<juce::var> Benchmarks::results;
+
+void Benchmarks::runAll(const juce::File& resultsFile)
+{
+    results.clearQuick();
+    printResult("OtoDecks benchmarks");
+
+    benchmarkTimeStretch();
+    benchmarkResampler();
+    benchmarkSampleRateConversion();
+    benchmarkLimiter();
+
+    // The deck benchmarks play a 44.1 kHz file on a 48 kHz device, the usual case
+    juce::TemporaryFile testFile(".wav");
+    writeTestFile(testFile.getFile(), 44100.0, 30.0);
+
+    benchmarkMixer(testFile.getFile());
+    benchmarkDeckRendering(testFile.getFile());
+    benchmarkBPMAnalysis(testFile.getFile());
+    benchmarkThumbnail(testFile.getFile());
+    benchmarkPlaylist();
+
+    if (resultsFile != juce::File())
+        writeResults(resultsFile);
+}
+
+void Benchmarks::benchmarkTimeStretch()
+{
+    // Target: under 5% of one core per deck at 48 kHz stereo
+    const double sampleRate = 48000.0;
+    const double renderSeconds = 60.0;
+    const int blockSize = 512;
+
+    auto testSignal = createTestSignal(sampleRate, 10.0);
+
+    for (double tempo : { 0.92, 1.0, 1.08, 0.5, 2.0 })
+    {
+        juce::MemoryAudioSource input(testSignal, false, true);
+        TimeStretchAudioSource stretchSource(&input, false, 2);
+        stretchSource.setBypassed(false);
+        stretchSource.setTempo(tempo);
+
+        double seconds = timeRender(stretchSource, blockSize, sampleRate, renderSeconds);
+        double percentOfCore = seconds / renderSeconds * 100.0;
+        recordResult("time-stretch/tempo " + juce::String(tempo, 2) + "/cpu", percentOfCore, "% core");
+
+        printResult("time-stretch tempo " + juce::String(tempo, 2)
+                    + ": " + juce::String(percentOfCore, 3) + "% of one core per deck"
+                    + (percentOfCore < 5.0 ? " (ok)" : " (over 5% budget)")
+                    + ", latency " + juce::String(stretchSource.getLatencyInSamples()) + " samples");
+    }
+}
+
+void Benchmarks::benchmarkResampler()
+{
+    const double sampleRate = 48000.0;
+    const double renderSeconds = 30.0;
+    const int blockSize = 512;
+
+    auto testSignal = createTestSignal(sampleRate, 10.0);
+
+    const std::pair<SincResamplingAudioSource::Quality, const char*> tiers[] = {
+        { SincResamplingAudioSource::Quality::draft,  "draft" },
+        { SincResamplingAudioSource::Quality::normal, "normal" },
+        { SincResamplingAudioSource::Quality::high,   "high" }
+    };
+
+    // Slightly off the round ratios too, since whole-sample steps skip the fractional filter phases
+    for (double ratio : { 0.25, 0.5, 0.92, 1.0, 1.08, 1.5, 2.0, 2.7, 4.0 })
+    {
+        juce::MemoryAudioSource juceInput(testSignal, false, true);
+        juce::ResamplingAudioSource juceResampler(&juceInput, false, 2);
+        juceResampler.setResamplingRatio(ratio);
+
+        double juceSeconds = timeRender(juceResampler, blockSize, sampleRate, renderSeconds);
+        recordResult("resampler/ratio " + juce::String(ratio, 2) + "/juce/cpu", juceSeconds / renderSeconds * 100.0, "% core");
+        juce::String line = "resampler ratio " + juce::String(ratio, 2) + ": juce "
+                            + juce::String(juceSeconds / renderSeconds * 100.0, 3) + "%";
+
+        for (const auto& tier : tiers)
+        {
+            juce::MemoryAudioSource input(testSignal, false, true);
+            SincResamplingAudioSource resampler(&input, false, 2);
+            resampler.setQuality(tier.first);
+            resampler.setResamplingRatio(ratio);
+
+            double seconds = timeRender(resampler, blockSize, sampleRate, renderSeconds);
+            recordResult("resampler/ratio " + juce::String(ratio, 2) + "/" + tier.second + "/cpu", seconds / renderSeconds * 100.0, "% core");
+            line += ", " + juce::String(tier.second) + " " + juce::String(seconds / renderSeconds * 100.0, 3) + "%";
+        }
+
+        printResult(line + " of one core");
+    }
+}
+
+void Benchmarks::benchmarkSampleRateConversion()
+{
+    // A 44.1 kHz file playing on a 48 kHz device
+    const double fileRate = 44100.0;
+    const double deviceRate = 48000.0;
+    const double renderSeconds = 20.0;
+    const double toneFrequency = 1000.0;
+    const int blockSize = 512;
+
+    juce::AudioBuffer<float> tone(2, static_cast<int>(fileRate * 10.0));
+    for (int i = 0; i < tone.getNumSamples(); ++i)
+    {
+        float value = 0.5f * static_cast<float>(std::sin(juce::MathConstants<double>::twoPi * toneFrequency * i / fileRate));
+        tone.setSample(0, i, value);
+        tone.setSample(1, i, value);
+    }
+
+    juce::AudioBuffer<float> output(2, static_cast<int>(deviceRate * renderSeconds));
+    const int settleSamples = static_cast<int>(deviceRate * 0.1);
+
+    for (double speed : { 0.92, 1.0, 1.08 })
+    {
+        double expectedFrequency = toneFrequency * speed;
+
+        // Before: the transport's own rate correction, then the speed resampler
+        juce::MemoryAudioSource twoStageInput(tone, false, true);
+        juce::ResamplingAudioSource rateConversion(&twoStageInput, false, 2);
+        SincResamplingAudioSource speedConversion(&rateConversion, false, 2);
+        rateConversion.setResamplingRatio(fileRate / deviceRate);
+        speedConversion.setResamplingRatio(speed);
+
+        double twoStageSeconds = timeRender(speedConversion, blockSize, deviceRate, renderSeconds, &output);
+        double twoStageTHDN = measureTHDN(output, settleSamples, expectedFrequency, deviceRate);
+
+        // After: one pass at the combined ratio
+        juce::MemoryAudioSource singleStageInput(tone, false, true);
+        SincResamplingAudioSource combinedConversion(&singleStageInput, false, 2);
+        combinedConversion.setResamplingRatio(fileRate / deviceRate * speed);
+
+        double singleStageSeconds = timeRender(combinedConversion, blockSize, deviceRate, renderSeconds, &output);
+        double singleStageTHDN = measureTHDN(output, settleSamples, expectedFrequency, deviceRate);
+
+        juce::String name = "sample rate conversion/speed " + juce::String(speed, 2);
+        recordResult(name + "/two-stage/cpu", twoStageSeconds / renderSeconds * 100.0, "% core");
+        recordResult(name + "/two-stage/thd+n", twoStageTHDN, "dB");
+        recordResult(name + "/single-stage/cpu", singleStageSeconds / renderSeconds * 100.0, "% core");
+        recordResult(name + "/single-stage/thd+n", singleStageTHDN, "dB");
+
+        printResult("sample rate conversion 44.1k -> 48k speed " + juce::String(speed, 2)
+                    + ": two-stage " + juce::String(twoStageSeconds / renderSeconds * 100.0, 3) + "% THD+N "
+                    + juce::String(twoStageTHDN, 1) + " dB, single-stage "
+                    + juce::String(singleStageSeconds / renderSeconds * 100.0, 3) + "% THD+N "
+                    + juce::String(singleStageTHDN, 1) + " dB");
+    }
+}
+
+void Benchmarks::benchmarkLimiter()
+{
+    const double sampleRate = 48000.0;
+    const double renderSeconds = 60.0;
+
+    // 12 dB hotter than the test signal, so the limiter is working all the time
+    auto testSignal = createTestSignal(sampleRate, 10.0);
+    testSignal.applyGain(juce::Decibels::decibelsToGain(12.0f));
+
+    for (int blockSize : { 64, 128, 256, 512, 1024 })
+    {
+        MasterLimiter limiter;
+        limiter.prepareToPlay(blockSize, sampleRate);
+
+        juce::AudioBuffer<float> block(2, blockSize);
+        int numBlocks = static_cast<int>(renderSeconds * sampleRate / blockSize);
+        juce::int64 limiterTicks = 0;
+        juce::int64 worstTicks = 0;
+        float outputPeak = 0.0f;
+
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            // only the limiter itself is timed, not the copy feeding it
+            int start = (i * blockSize) % (testSignal.getNumSamples() - blockSize);
+            for (int channel = 0; channel < 2; ++channel)
+                block.copyFrom(channel, 0, testSignal, channel, start, blockSize);
+
+            auto startTicks = juce::Time::getHighResolutionTicks();
+            limiter.process(block, 0, blockSize);
+            auto ticks = juce::Time::getHighResolutionTicks() - startTicks;
+
+            limiterTicks += ticks;
+            worstTicks = juce::jmax(worstTicks, ticks);
+            outputPeak = juce::jmax(outputPeak, block.getMagnitude(0, blockSize));
+        }
+
+        double seconds = juce::Time::highResolutionTicksToSeconds(limiterTicks);
+        double microsecondsPerBlock = seconds / numBlocks * 1.0e6;
+        double worstMicroseconds = juce::Time::highResolutionTicksToSeconds(worstTicks) * 1.0e6;
+        double percentOfCore = seconds / renderSeconds * 100.0;
+
+        juce::String name = "limiter/block " + juce::String(blockSize);
+        recordResult(name + "/per block", microsecondsPerBlock, "us");
+        recordResult(name + "/worst block", worstMicroseconds, "us");
+        recordResult(name + "/cpu", percentOfCore, "% core");
+
+        printResult("limiter block " + juce::String(blockSize) + ": " + juce::String(microsecondsPerBlock, 2)
+                    + " us per block (worst " + juce::String(worstMicroseconds, 2) + " us), "
+                    + juce::String(percentOfCore, 3) + "% of one core, output peak "
+                    + juce::String(juce::Decibels::gainToDecibels(outputPeak), 2) + " dBFS, latency "
+                    + juce::String(limiter.getLatencyInSamples()) + " samples");
+    }
+}
+
+void Benchmarks::benchmarkMixer(const juce::File& testFile)
+{
+    const double sampleRate = 48000.0;
+    const double renderSeconds = 10.0;
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    for (int numDecks : { 2, 4 })
+    {
+        juce::OwnedArray<DJAudioPlayer> players;
+        MixerEngine mixer;
+        MasterRecorder recorder;
+        AppAudioCallback callback(mixer, recorder);
+
+        // Slightly different speeds so every deck goes through the fractional resampler
+        for (int i = 0; i < numDecks; ++i)
+        {
+            auto* player = players.add(new DJAudioPlayer(formatManager));
+            player->loadURL(juce::URL(testFile));
+            // the analysis mustn't compete with the timed renders
+            player->waitForAnalysis(60000);
+            player->setSpeed(1.0 + 0.02 * i);
+            mixer.addDeck(player);
+        }
+
+        for (bool recording : { false, true })
+        {
+            juce::TemporaryFile recordingFile(".wav");
+
+            for (int blockSize : { 64, 128, 256, 512, 1024 })
+            {
+                for (auto* player : players)
+                {
+                    player->setPosition(0.0);
+                    player->start();
+                }
+
+                // the recorder needs the rate before it starts, and preparing it again in timeRender
+                // leaves the recording running
+                if (recording)
+                {
+                    recorder.prepareToPlay(blockSize, sampleRate);
+                    recorder.startRecording(recordingFile.getFile());
+                }
+
+                double worstBlockSeconds = 0.0;
+                double seconds = timeRender(callback, blockSize, sampleRate, renderSeconds, nullptr, &worstBlockSeconds);
+
+                if (recording)
+                    recorder.stopRecording();
+
+                // The share of each block's duration the callback used, on average and at worst
+                double blockSeconds = blockSize / sampleRate;
+                int numBlocks = static_cast<int>(renderSeconds * sampleRate / blockSize);
+                double meanLoad = seconds / (numBlocks * blockSeconds) * 100.0;
+                double worstLoad = worstBlockSeconds / blockSeconds * 100.0;
+
+                juce::String name = "mixer/" + juce::String(numDecks) + " decks/block " + juce::String(blockSize)
+                                    + (recording ? "/recording" : "");
+                recordResult(name + "/mean deadline", meanLoad, "%");
+                recordResult(name + "/worst deadline", worstLoad, "%");
+
+                printResult("mixer " + juce::String(numDecks) + " decks block " + juce::String(blockSize)
+                            + (recording ? " recording" : "") + ": mean " + juce::String(meanLoad, 2)
+                            + "% of deadline, worst " + juce::String(worstLoad, 2) + "%");
+            }
+        }
+    }
+}
+
+void Benchmarks::benchmarkDeckRendering(const juce::File& testFile)
+{
+    const double sampleRate = 48000.0;
+    const double renderSeconds = 10.0;
+    const int blockSize = 512;
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    DJAudioPlayer player(formatManager);
+    player.loadURL(juce::URL(testFile));
+    player.waitForAnalysis(60000);
+
+    for (bool keyLock : { false, true })
+    {
+        player.setKeyLock(keyLock);
+
+        for (double speed : { 0.5, 0.92, 1.0, 1.08, 1.5, 2.0 })
+        {
+            player.setSpeed(speed);
+            player.setPosition(0.0);
+            player.start();
+
+            double seconds = timeRender(player, blockSize, sampleRate, renderSeconds);
+            double percentOfCore = seconds / renderSeconds * 100.0;
+
+            juce::String mode = keyLock ? "key lock" : "resample";
+            recordResult("deck/" + mode + "/speed " + juce::String(speed, 2) + "/cpu", percentOfCore, "% core");
+            printResult("deck " + mode + " speed " + juce::String(speed, 2) + ": "
+                        + juce::String(percentOfCore, 3) + "% of one core");
+        }
+    }
+
+    player.stop();
+}
+
+void Benchmarks::benchmarkBPMAnalysis(const juce::File& testFile)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(testFile));
+    double lengthInSeconds = reader != nullptr ? reader->lengthInSamples / reader->sampleRate : 0.0;
+
+    BPMAnalyser analyser;
+
+    auto startTicks = juce::Time::getHighResolutionTicks();
+    double bpm = analyser.analyseBPM(testFile);
+    double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    double throughput = lengthInSeconds / seconds;
+    recordResult("bpm analysis/throughput", throughput, "audio s/s");
+    printResult("bpm analysis: " + juce::String(throughput, 1) + " s of audio per second (found "
+                + juce::String(bpm, 1) + " BPM, expected 128)");
+}
+
+void Benchmarks::benchmarkThumbnail(const juce::File& testFile)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    double bestSeconds = 0.0;
+    double lengthInSeconds = 0.0;
+
+    // Best of three, each with an empty cache so nothing is reused
+    for (int run = 0; run < 3; ++run)
+    {
+        juce::AudioThumbnailCache cache(1);
+        juce::AudioThumbnail thumbnail(1000, formatManager, cache); // same resolution as WaveformDisplay
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        thumbnail.setSource(new juce::FileInputSource(testFile));
+
+        // the thumbnail is built on the cache's background thread
+        while (! thumbnail.isFullyLoaded())
+            juce::Thread::sleep(1);
+
+        double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        lengthInSeconds = thumbnail.getTotalLength();
+
+        if (run == 0 || seconds < bestSeconds)
+            bestSeconds = seconds;
+    }
+
+    double throughput = lengthInSeconds / bestSeconds;
+    recordResult("thumbnail/throughput", throughput, "audio s/s");
+    printResult("thumbnail: " + juce::String(throughput, 1) + " s of audio per second");
+}
+
+void Benchmarks::benchmarkPlaylist()
+{
+    const int maxTracks = 100000;
+
+    // The playlist only keeps tracks whose files exist, so the library needs real (empty) files
+    auto libraryFolder = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                             .getNonexistentChildFile("OtoDecksBenchmarkLibrary", {}, false);
+    libraryFolder.createDirectory();
+
+    for (int i = 0; i < maxTracks; ++i)
+        libraryFolder.getChildFile("track_" + juce::String(i) + ".mp3").create();
+
+    PlaylistComponent playlist;
+
+    for (int numTracks : { 1000, 10000, 100000 })
+    {
+        // Written in the same format as PlaylistComponent::savePlaylistState
+        auto playlistFile = libraryFolder.getChildFile("playlist_" + juce::String(numTracks) + ".properties");
+        {
+            juce::PropertiesFile::Options options;
+            juce::PropertiesFile properties(playlistFile, options);
+            properties.setValue("trackCount", numTracks);
+
+            for (int i = 0; i < numTracks; ++i)
+            {
+                properties.setValue("track_" + juce::String(i) + "_path",
+                                    libraryFolder.getChildFile("track_" + juce::String(i) + ".mp3").getFullPathName());
+                properties.setValue("track_" + juce::String(i) + "_title", "Track " + juce::String(i));
+            }
+        }
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        playlist.loadPlaylistState(playlistFile);
+        double loadSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+        jassert(playlist.getNumRows() == numTracks);
+
+        startTicks = juce::Time::getHighResolutionTicks();
+        playlist.savePlaylistState(libraryFolder.getChildFile("saved.properties"));
+        double saveSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+        juce::String name = "playlist/" + juce::String(numTracks) + " tracks";
+        recordResult(name + "/load", loadSeconds * 1000.0, "ms");
+        recordResult(name + "/save", saveSeconds * 1000.0, "ms");
+        printResult("playlist " + juce::String(numTracks) + " tracks: load " + juce::String(loadSeconds * 1000.0, 1)
+                    + " ms, save " + juce::String(saveSeconds * 1000.0, 1) + " ms");
+    }
+
+    libraryFolder.deleteRecursively();
+}
+
+juce::AudioBuffer<float> Benchmarks::createTestSignal(double sampleRate, double lengthInSeconds)
+{
+    int numSamples = static_cast<int>(sampleRate * lengthInSeconds);
+    juce::AudioBuffer<float> buffer(2, numSamples);
+    juce::Random random(42);
+
+    // 128 BPM kick under a chord and some noise, roughly like a mastered track
+    const int samplesPerBeat = static_cast<int>(sampleRate * 60.0 / 128.0);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        double t = i / sampleRate;
+        double beatTime = (i % samplesPerBeat) / sampleRate;
+
+        float kick = static_cast<float>(std::sin(juce::MathConstants<double>::twoPi * 55.0 * beatTime) * std::exp(-beatTime * 12.0));
+        float chord = static_cast<float>(0.15 * std::sin(juce::MathConstants<double>::twoPi * 220.0 * t)
+                                         + 0.1 * std::sin(juce::MathConstants<double>::twoPi * 277.18 * t)
+                                         + 0.1 * std::sin(juce::MathConstants<double>::twoPi * 329.63 * t));
+        float noise = (random.nextFloat() * 2.0f - 1.0f) * 0.05f;
+
+        buffer.setSample(0, i, 0.5f * kick + chord + noise);
+        buffer.setSample(1, i, 0.5f * kick + chord - noise);
+    }
+
+    return buffer;
+}
+
+void Benchmarks::writeTestFile(const juce::File& file, double sampleRate, double lengthInSeconds)
+{
+    auto testSignal = createTestSignal(sampleRate, lengthInSeconds);
+
+    file.deleteFile();
+    std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatWriter> writer(stream != nullptr ? wavFormat.createWriterFor(stream.get(), sampleRate, 2, 16, {}, 0)
+                                                                      : nullptr);
+
+    if (writer != nullptr)
+    {
+        // the writer owns the stream now
+        stream.release();
+        writer->writeFromAudioSampleBuffer(testSignal, 0, testSignal.getNumSamples());
+    }
+}
+
+double Benchmarks::timeRender(juce::AudioSource& source, int blockSize, double sampleRate, double lengthInSeconds,
+                              juce::AudioBuffer<float>* output, double* worstBlockSeconds)
+{
+    juce::AudioBuffer<float> block(2, blockSize);
+    int numBlocks = static_cast<int>(lengthInSeconds * sampleRate / blockSize);
+
+    if (output != nullptr)
+        numBlocks = juce::jmin(numBlocks, output->getNumSamples() / blockSize);
+
+    source.prepareToPlay(blockSize, sampleRate);
+
+    auto startTicks = juce::Time::getHighResolutionTicks();
+
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        juce::AudioSourceChannelInfo info = output != nullptr ? juce::AudioSourceChannelInfo(output, i * blockSize, blockSize)
+                                                              : juce::AudioSourceChannelInfo(&block, 0, blockSize);
+        auto blockStartTicks = juce::Time::getHighResolutionTicks();
+        source.getNextAudioBlock(info);
+
+        if (worstBlockSeconds != nullptr)
+            *worstBlockSeconds = juce::jmax(*worstBlockSeconds,
+                                            juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStartTicks));
+    }
+
+    auto elapsedTicks = juce::Time::getHighResolutionTicks() - startTicks;
+
+    source.releaseResources();
+
+    return juce::Time::highResolutionTicksToSeconds(elapsedTicks);
+}
+
+double Benchmarks::measureTHDN(const juce::AudioBuffer<float>& buffer, int startSample, double frequency, double sampleRate)
+{
+    const float* data = buffer.getReadPointer(0);
+    int numSamples = buffer.getNumSamples() - startSample;
+
+    // Least-squares fit of the expected tone, whose frequency is known exactly
+    double cosSum = 0.0, sinSum = 0.0;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        double phase = juce::MathConstants<double>::twoPi * frequency * i / sampleRate;
+        cosSum += data[startSample + i] * std::cos(phase);
+        sinSum += data[startSample + i] * std::sin(phase);
+    }
+
+    double cosAmplitude = cosSum * 2.0 / numSamples;
+    double sinAmplitude = sinSum * 2.0 / numSamples;
+
+    // Everything left over after removing the tone is distortion and noise
+    double signalPower = 0.0, residualPower = 0.0;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        double phase = juce::MathConstants<double>::twoPi * frequency * i / sampleRate;
+        double fitted = cosAmplitude * std::cos(phase) + sinAmplitude * std::sin(phase);
+        double residual = data[startSample + i] - fitted;
+
+        signalPower += fitted * fitted;
+        residualPower += residual * residual;
+    }
+
+    return 10.0 * std::log10((residualPower + 1.0e-30) / (signalPower + 1.0e-30));
+}
+
+void Benchmarks::printResult(const juce::String& line)
+{
+    std::cout << line << std::endl;
+}
+
+void Benchmarks::recordResult(const juce::String& name, double value, const juce::String& unit)
+{
+    auto* result = new juce::DynamicObject();
+    result->setProperty("name", name);
+    result->setProperty("value", value);
+    result->setProperty("unit", unit);
+    results.add(juce::var(result));
+}
+
+void Benchmarks::writeResults(const juce::File& resultsFile)
+{
+    // The machine the numbers came from, so runs are only compared like for like
+    auto* run = new juce::DynamicObject();
+    run->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+    run->setProperty("version", ProjectInfo::versionString);
+    run->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    run->setProperty("cpu", juce::SystemStats::getCpuModel());
+    run->setProperty("cores", juce::SystemStats::getNumCpus());
+   #if JUCE_DEBUG
+    run->setProperty("build", "debug");
+   #else
+    run->setProperty("build", "release");
+   #endif
+    run->setProperty("results", results);
+
+    if (resultsFile.replaceWithText(juce::JSON::toString(juce::var(run))))
+        printResult("results written to " + resultsFile.getFullPathName());
+    else
+        printResult("couldn't write results to " + resultsFile.getFullPathName());
+}
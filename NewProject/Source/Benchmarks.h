@@ -0,0 +1,71 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Headless performance benchmarks, run by starting the app with --benchmark instead of opening the GUI.
+// Every result is printed as a line of text, and also recorded as a name, value and unit so a run
+// can be saved as JSON with --benchmark results.json and compared against earlier runs.
+class Benchmarks
+{
+public:
+    // Runs every benchmark, prints the results to stdout and writes them to the JSON file if one is given
+    static void runAll(const juce::File& resultsFile = {});
+
+private:
+    // The app's audio callback with 2 and 4 playing decks, as a share of the block's deadline.
+    // MainComponent::getNextAudioBlock hands the block straight to the mixer, whose master feeds
+    // the recorder, so that is what runs here - once idle and once recording
+    static void benchmarkMixer(const juce::File& testFile);
+
+    // One deck's render cost across the speed range, with and without key lock
+    static void benchmarkDeckRendering(const juce::File& testFile);
+
+    // Seconds of audio analysed per second of CPU time
+    static void benchmarkBPMAnalysis(const juce::File& testFile);
+
+    // Seconds of audio turned into a waveform overview per second, as the deck's display does it
+    static void benchmarkThumbnail(const juce::File& testFile);
+
+    // Saving and loading synthetic playlists of 1k to 100k tracks
+    static void benchmarkPlaylist();
+
+    // Key-lock time-stretching cost per deck, as a percentage of one core
+    static void benchmarkTimeStretch();
+
+    // Sinc resampler quality tiers against juce::ResamplingAudioSource across the speed range
+    static void benchmarkResampler();
+
+    // One combined sample rate and speed conversion against the previous two-stage chain
+    static void benchmarkSampleRateConversion();
+
+    // The master limiter's cost per block at 64 to 1024 samples, driven well into limiting
+    static void benchmarkLimiter();
+
+    // A few seconds of stereo test material with tones, noise and a kick on every beat
+    static juce::AudioBuffer<float> createTestSignal(double sampleRate, double lengthInSeconds);
+
+    // Writes the test signal to a 16 bit WAV file, for the benchmarks that go through a deck
+    static void writeTestFile(const juce::File& file, double sampleRate, double lengthInSeconds);
+
+    // Renders the source in blocks and returns the time it took in seconds. When an output
+    // buffer is given the audio is rendered into it, otherwise it is thrown away.
+    // The slowest single block is stored in worstBlockSeconds when given.
+    static double timeRender(juce::AudioSource& source, int blockSize, double sampleRate, double lengthInSeconds,
+                             juce::AudioBuffer<float>* output = nullptr, double* worstBlockSeconds = nullptr);
+
+    // THD+N of a rendered sine in dB, from the residual after fitting the expected tone
+    static double measureTHDN(const juce::AudioBuffer<float>& buffer, int startSample, double frequency, double sampleRate);
+
+    static void printResult(const juce::String& line);
+
+    // Adds a result to the JSON output, e.g. "mixer/4 decks/block 256/mean deadline", 12.5, "%"
+    static void recordResult(const juce::String& name, double value, const juce::String& unit);
+    static void writeResults(const juce::File& resultsFile);
+
+    static juce::Array<juce::var> results;
+};
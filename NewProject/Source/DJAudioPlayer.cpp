@@ -4,74 +4,702 @@
 */
 
 #include "DJAudioPlayer.h"
+#include "Tracing.h"
 
 DJAudioPlayer::DJAudioPlayer(juce::AudioFormatManager& _formatManager) : 
-    formatManager(_formatManager),
-    resamplingSource(&transportSource, false, 2)
+    formatManager(_formatManager)
 {
     bpmAnalyser = std::make_unique<BPMAnalyser>();
 }
 
 DJAudioPlayer::~DJAudioPlayer()
 {
-
+    ++analysisGeneration;
+    analysisPool.removeAllJobs(true, 10000);
+    
+    // the audio has stopped, so its references can go - the release pool deletes the tracks
+    if (auto* pending = pendingTrack.exchange(nullptr))
+        releaseTrack(pending);
+    releaseTrack(playingTrack);
+    releaseTrack(fadingTrack);
 }
 
 void DJAudioPlayer::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
 {
-    transportSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    resamplingSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    deviceSampleRate = sampleRate;
+    preparedBlockSize = samplesPerBlockExpected;
+    blockSizeForCommands = samplesPerBlockExpected;
+    eq.prepareToPlay(sampleRate);
+    fadeBuffer.setSize(2, samplesPerBlockExpected);
+    fadeLength = juce::jmax(1, static_cast<int>(TRACK_SWAP_FADE_SECONDS * sampleRate));
+    
+    // The audio thread isn't running, so a track it hasn't picked up yet is settled here
+    if (auto* pending = pendingTrack.exchange(nullptr))
+    {
+        releaseTrack(fadingTrack);
+        releaseTrack(playingTrack);
+        playingTrack = pending;
+    }
+    releaseTrack(fadingTrack);
+    
+    if (playingTrack != nullptr)
+        playingTrack->prepareToPlay(samplesPerBlockExpected, sampleRate);
+    
+    // the device rate is part of the resampling ratio
+    updatePlaySpeed();
 }
 
 void DJAudioPlayer::getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill)
 {
-    resamplingSource.getNextAudioBlock(bufferToFill);
+    TRACE_SCOPE("audio", "deck render");
+    swapToPendingTrack();
+    collectCommands();
+    // one value for the whole block
+    double blockGain = gain.load();
+    
+    // only cueing - nothing of the deck reaches the master, so the cheapest filter will do
+    if (playingTrack != nullptr)
+        playingTrack->getResampler().setQuality(cueTap != nullptr && blockGain <= 0.0 ? SincResamplingAudioSource::Quality::draft
+                                                                                 : resamplingQuality.load());
+    
+    juce::int64 blockStart = sampleClock;
+    publishClock(blockStart);
+    
+    // The block is rendered in pieces, split wherever a command is due
+    int done = 0;
+    while (done < bufferToFill.numSamples)
+    {
+        while (numPendingCommands > 0 && pendingCommands[0].sampleTime <= blockStart + done)
+        {
+            applyCommand(pendingCommands[0], blockStart + done);
+            std::move(pendingCommands.begin() + 1, pendingCommands.begin() + numPendingCommands, pendingCommands.begin());
+            --numPendingCommands;
+        }
+        
+        int end = bufferToFill.numSamples;
+        if (numPendingCommands > 0)
+            end = static_cast<int>(juce::jmin(static_cast<juce::int64>(end), pendingCommands[0].sampleTime - blockStart));
+        
+        renderTracks(juce::AudioSourceChannelInfo(bufferToFill.buffer, bufferToFill.startSample + done, end - done));
+        done = end;
+    }
+    
+    sampleClock += bufferToFill.numSamples;
+    
+    eq.process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+    
+    // the cue hears the deck after its EQ and auto-gain - each track applies its own - whatever
+    // its fader is at
+    if (cueTap != nullptr)
+        for (int channel = 0; channel < juce::jmin(bufferToFill.buffer->getNumChannels(), cueTap->getNumChannels()); ++channel)
+            cueTap->copyFrom(channel, 0, *bufferToFill.buffer, channel, bufferToFill.startSample, bufferToFill.numSamples);
     
     // gain application
-    if (gain != 1.0)
+    if (blockGain != 1.0)
     {
         for (int channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
         {
-            bufferToFill.buffer->applyGain(channel, bufferToFill.startSample, bufferToFill.numSamples, gain);
+            bufferToFill.buffer->applyGain(channel, bufferToFill.startSample, bufferToFill.numSamples, static_cast<float>(blockGain));
         }
     }
 }
 
 void DJAudioPlayer::releaseResources()
 {
-    transportSource.releaseResources();
-    resamplingSource.releaseResources();
+    if (playingTrack != nullptr)
+        playingTrack->releaseResources();
+}
+
+void DJAudioPlayer::renderTracks(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    if (playingTrack != nullptr)
+        playingTrack->getNextAudioBlock(bufferToFill);
+    else
+        bufferToFill.clearActiveBufferRegion();
+    
+    if (fadingTrack != nullptr)
+        crossfadeFromOldTrack(bufferToFill);
+}
+
+void DJAudioPlayer::collectCommands()
+{
+    TransportCommand command;
+    
+    while (commandQueue.pop(command))
+    {
+        // with nowhere to wait, a command lands straight away
+        if (numPendingCommands == MAX_PENDING_COMMANDS)
+            applyCommand(command, sampleClock);
+        else
+            addPendingCommand(command);
+    }
+}
+
+void DJAudioPlayer::addPendingCommand(const TransportCommand& command)
+{
+    // after any command due at the same time, so commands sent together keep their order
+    int index = numPendingCommands;
+    while (index > 0 && pendingCommands[(size_t) index - 1].sampleTime > command.sampleTime)
+    {
+        pendingCommands[(size_t) index] = pendingCommands[(size_t) index - 1];
+        --index;
+    }
+    
+    pendingCommands[(size_t) index] = command;
+    ++numPendingCommands;
+}
+
+void DJAudioPlayer::applyCommand(const TransportCommand& command, juce::int64 sampleTime)
+{
+    // Commands for "as soon as possible" have no time to be late for, and sync's own steering
+    // lands on every block, so it would only water the figures down
+    if (command.sampleTime > 0 && command.type != TransportCommand::Type::syncRatio)
+    {
+        juce::int64 lateness = sampleTime - command.sampleTime;
+        commandsApplied.store(commandsApplied.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        
+        if (lateness > 0)
+        {
+            commandsLate.store(commandsLate.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if (lateness > maxCommandLateness.load(std::memory_order_relaxed))
+                maxCommandLateness.store(lateness, std::memory_order_relaxed);
+        }
+    }
+    
+    switch (command.type)
+    {
+        // the speeds carry over to the next track, so they are kept with or without one
+        case TransportCommand::Type::speed:
+            if (command.value > 0.0 && command.value <= 4.0)
+            {
+                userSpeedRatio = command.value;
+                updatePlaySpeed();
+            }
+            return;
+            
+        case TransportCommand::Type::syncRatio:
+            if (command.value > 0.0 && command.value <= 4.0)
+            {
+                syncRatio = command.value;
+            }
+            else if (syncRatio > 0.0)
+            {
+                userSpeedRatio = syncRatio;
+                syncRatio = 0.0;
+            }
+            updatePlaySpeed();
+            return;
+            
+        // The stretcher crossfades in and out on its own, this keeps the speed with it
+        case TransportCommand::Type::keyLock:
+            keyLocked = command.value != 0.0;
+            if (playingTrack != nullptr)
+                playingTrack->getStretcher().setBypassed(! keyLocked);
+            updatePlaySpeed();
+            return;
+            
+        default:
+            break;
+    }
+    
+    if (playingTrack == nullptr)
+        return;
+    
+    switch (command.type)
+    {
+        case TransportCommand::Type::play:
+            playingTrack->getTransport().start();
+            lastStartSampleTime = sampleTime;
+            break;
+            
+        case TransportCommand::Type::stop:
+            playingTrack->getTransport().stop();
+            break;
+            
+        case TransportCommand::Type::seek:
+            // The transport runs at the file's own rate, so positions are in file samples
+            if (command.value >= 0.0)
+            {
+                playingTrack->getTransport().setNextReadPosition(static_cast<juce::int64>(command.value * playingTrack->getFileSampleRate()));
+                playingTrack->flushBuffers();
+            }
+            break;
+            
+        case TransportCommand::Type::hotCue:
+        {
+            // Crossfaded, so the stretcher and resampler carry on without a flush
+            auto cue = playingTrack->getHotCues().getCue(static_cast<int>(command.value));
+            if (cue >= 0)
+                playingTrack->getLoops().jumpTo(cue, playingTrack->getTransport().isPlaying());
+            break;
+        }
+            
+        case TransportCommand::Type::loopIn:
+            playingTrack->getLoops().markLoopIn();
+            break;
+            
+        case TransportCommand::Type::loopOut:
+            playingTrack->getLoops().markLoopOut();
+            break;
+            
+        case TransportCommand::Type::autoLoop:
+        case TransportCommand::Type::loopRoll:
+        {
+            juce::int64 start, end;
+            if (getBeatLoop(*playingTrack, command.value, start, end))
+            {
+                auto& loops = playingTrack->getLoops();
+                
+                if (command.type == TransportCommand::Type::loopRoll)
+                    loops.startRoll(start, end);
+                else
+                    loops.setLoop(start, end);
+                
+                // The read head is ahead of what is heard by the chain's latency, so it can already
+                // be past a short loop's end - it wraps there now, at the same place in the loop
+                auto readPosition = loops.getNextReadPosition();
+                if (readPosition >= end)
+                    loops.jumpTo(start + (readPosition - start) % (end - start), true);
+            }
+            break;
+        }
+            
+        case TransportCommand::Type::loopExit:
+            if (playingTrack->getLoops().isRolling())
+                playingTrack->getLoops().endRoll(playingTrack->getTransport().isPlaying());
+            else
+                playingTrack->getLoops().clearLoop();
+            break;
+            
+        case TransportCommand::Type::reverse:
+            playingTrack->setReversed(command.value != 0.0);
+            break;
+            
+        case TransportCommand::Type::censor:
+            if (command.value != 0.0)
+                playingTrack->startCensor();
+            else
+                playingTrack->endCensor();
+            break;
+            
+        case TransportCommand::Type::speed:
+        case TransportCommand::Type::syncRatio:
+        case TransportCommand::Type::keyLock:
+            break;
+    }
+}
+
+bool DJAudioPlayer::getBeatLoop(DeckTrack& track, double beats, juce::int64& start, juce::int64& end) const
+{
+    double bpm = currentTrackBPM;
+    
+    if (! bpmAnalysisComplete || bpm <= 0.0 || beats < MIN_LOOP_BEATS || beats > MAX_LOOP_BEATS)
+        return false;
+    
+    // In file samples - the grid snaps to whole beats, or to the loop length for shorter loops,
+    // from the position being heard rather than the read head ahead of it
+    double fileRate = track.getFileSampleRate();
+    double beatSamples = 60.0 / bpm * fileRate;
+    double step = beatSamples * juce::jmin(beats, 1.0);
+    double gridStart = beatGridOffset * fileRate;
+    auto current = track.getAudiblePosition();
+    
+    start = juce::jmax(static_cast<juce::int64>(0), static_cast<juce::int64>(std::round(gridStart + std::floor((current - gridStart) / step) * step)));
+    end = start + static_cast<juce::int64>(std::round(beats * beatSamples));
+    return true;
+}
+
+void DJAudioPlayer::publishClock(juce::int64 blockStart)
+{
+    // An odd sequence number means the clock is being written
+    auto sequence = clockSequence.load(std::memory_order_relaxed);
+    clockSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    clockBlockStart.store(blockStart, std::memory_order_relaxed);
+    clockBlockTicks.store(juce::Time::getHighResolutionTicks(), std::memory_order_relaxed);
+    
+    clockSequence.store(sequence + 2, std::memory_order_release);
+}
+
+void DJAudioPlayer::queueCommand(const TransportCommand& command)
+{
+    // The scratch ring only decodes while it's needed, so a reverse or censor on its way starts it
+    // a few blocks before it lands
+    bool needsRing = command.type == TransportCommand::Type::reverse || command.type == TransportCommand::Type::censor;
+    if (needsRing && command.value != 0.0)
+        if (auto* track = currentTrack.load(std::memory_order_acquire))
+            track->getScratch().warmUp();
+    
+    // only fills up if the audio thread has stopped taking commands
+    if (! commandQueue.push(command))
+        jassertfalse;
+}
+
+void DJAudioPlayer::sendCommand(TransportCommand::Type type, double value)
+{
+    TransportCommand command;
+    command.type = type;
+    command.value = value;
+    command.sampleTime = getSampleTimeNow() + COMMAND_LATENCY_BLOCKS * blockSizeForCommands.load();
+    queueCommand(command);
+}
+
+juce::int64 DJAudioPlayer::getSampleTimeNow() const
+{
+    juce::uint32 sequence;
+    juce::int64 blockStart, blockTicks;
+    
+    do
+    {
+        sequence = clockSequence.load(std::memory_order_acquire);
+        blockStart = clockBlockStart.load(std::memory_order_relaxed);
+        blockTicks = clockBlockTicks.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    while ((sequence & 1) != 0 || clockSequence.load(std::memory_order_relaxed) != sequence);
+    
+    // nothing rendered yet
+    if (blockTicks == 0)
+        return blockStart;
+    
+    // How far the device has got through the block - never more than a block, so the clock
+    // doesn't run on while the device is stopped
+    double elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockTicks) * deviceSampleRate;
+    return blockStart + static_cast<juce::int64>(juce::jlimit(0.0, static_cast<double>(blockSizeForCommands.load()), elapsed));
+}
+
+void DJAudioPlayer::scheduleCommand(const TransportCommand& command)
+{
+    if (numPendingCommands == MAX_PENDING_COMMANDS)
+        applyCommand(command, sampleClock);
+    else
+        addPendingCommand(command);
+}
+
+juce::int64 DJAudioPlayer::getNextBlockSampleTime() const
+{
+    return sampleClock;
+}
+
+juce::int64 DJAudioPlayer::getLastStartSampleTime() const
+{
+    return lastStartSampleTime;
+}
+
+DJAudioPlayer::CommandTimingStats DJAudioPlayer::getCommandTimingStats() const
+{
+    CommandTimingStats stats;
+    stats.numCommands = commandsApplied.load();
+    stats.numLate = commandsLate.load();
+    stats.maxLateSamples = maxCommandLateness.load();
+    return stats;
+}
+
+void DJAudioPlayer::swapToPendingTrack()
+{
+    auto* next = pendingTrack.exchange(nullptr, std::memory_order_acq_rel);
+    if (next == nullptr)
+        return;
+    
+    // a track still fading out from the last swap is cut short
+    releaseTrack(fadingTrack);
+    
+    fadingTrack = playingTrack;
+    playingTrack = next;
+    fadeSamplesDone = 0;
+    
+    // a new track starts at normal speed, unless sync is holding the deck to its leader, and takes
+    // any key lock change made since it was loaded
+    playingTrack->getStretcher().setBypassed(! keyLocked);
+    userSpeedRatio = 1.0;
+    updatePlaySpeed();
+}
+
+void DJAudioPlayer::crossfadeFromOldTrack(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    TRACE_SCOPE("audio", "track crossfade");
+    int done = 0;
+    
+    // in pieces no bigger than the preallocated fade buffer
+    while (done < bufferToFill.numSamples && fadeSamplesDone < fadeLength)
+    {
+        int num = juce::jmin(bufferToFill.numSamples - done, fadeLength - fadeSamplesDone, fadeBuffer.getNumSamples());
+        int start = bufferToFill.startSample + done;
+        
+        juce::AudioSourceChannelInfo oldInfo(&fadeBuffer, 0, num);
+        fadingTrack->getNextAudioBlock(oldInfo);
+        
+        float startGain = static_cast<float>(fadeSamplesDone) / fadeLength;
+        float endGain = static_cast<float>(fadeSamplesDone + num) / fadeLength;
+        
+        for (int channel = 0; channel < juce::jmin(2, bufferToFill.buffer->getNumChannels()); ++channel)
+        {
+            bufferToFill.buffer->applyGainRamp(channel, start, num, startGain, endGain);
+            bufferToFill.buffer->addFromWithRamp(channel, start, fadeBuffer.getReadPointer(channel), num,
+                                                 1.0f - startGain, 1.0f - endGain);
+        }
+        
+        done += num;
+        fadeSamplesDone += num;
+    }
+    
+    if (fadeSamplesDone >= fadeLength)
+        releaseTrack(fadingTrack);
+}
+
+void DJAudioPlayer::releaseTrack(DeckTrack*& track)
+{
+    // the pool always holds its own reference, so this never deletes
+    if (track != nullptr)
+        track->decReferenceCountWithoutDeleting();
+    
+    track = nullptr;
 }
 
 void DJAudioPlayer::loadURL(juce::URL audioURL)
 {
-    auto* reader = formatManager.createReaderFor(audioURL.createInputStream(juce::URL::InputStreamOptions
-        (juce::URL::ParameterHandling::inAddress)));
+    TRACE_SCOPE("decode", "load track");
+    auto openReader = [this, &audioURL]
+    {
+        return formatManager.createReaderFor(audioURL.createInputStream(juce::URL::InputStreamOptions
+            (juce::URL::ParameterHandling::inAddress)));
+    };
+    
+    auto* reader = openReader();
     if (reader != nullptr)
     {
-        transportSource.setSource(nullptr);
-        readerSource.reset();
+        // The hot cues read the file twice more - once to decode the cue windows, once to take over
+        // where a window ends - and the scratch ring once. A reader that won't open only loses its
+        // own feature
+        auto* spareReader = openReader();
+        auto* windowReader = openReader();
+        auto* scratchReader = openReader();
+        
+        if (spareReader == nullptr || windowReader == nullptr)
+            juce::Logger::writeToLog("Hot cues will seek the decoder: couldn't open " + audioURL.getLocalFile().getFileName() + " again");
+        if (scratchReader == nullptr)
+            juce::Logger::writeToLog("No scratching or reverse: couldn't open " + audioURL.getLocalFile().getFileName() + " again");
         
-        std::unique_ptr<juce::AudioFormatReaderSource> newSource(new juce::AudioFormatReaderSource(reader, true));
-        transportSource.setSource(newSource.get(), 0, nullptr, reader->sampleRate);
-        readerSource.reset(newSource.release());
+        // The new track is set up completely before the audio thread can see it, with the deck's
+        // key lock and quality, a fresh speed and, once the device is running, its buffers
+        DeckTrack::Ptr newTrack = new DeckTrack(reader, spareReader, windowReader, scratchReader, audioURL.getLocalFile());
+        newTrack->getStretcher().setBypassed(! keyLocked);
+        newTrack->getResampler().setQuality(resamplingQuality);
+        newTrack->getScratch().setOffline(offlineRendering);
+        applySpeedRatio(*newTrack, 1.0);
+        
+        if (preparedBlockSize > 0)
+            newTrack->prepareToPlay(preparedBlockSize, deviceSampleRate);
+        
+        releasePool->add(newTrack);
+        
+        // The new track becomes the loaded one in the same step as the last track's analysis is
+        // abandoned, so a result for the last track can't reach this one's trim or beat grid. It
+        // starts at unity, with no beat grid, until its analysis is done
+        {
+            const juce::ScopedLock lock(analysisResultLock);
+            ++analysisGeneration;
+            loadedTrack = newTrack;
+            currentTrack.store(newTrack.get(), std::memory_order_release);
+            bpmAnalysisComplete = false;
+            currentTrackBPM = 0.0;
+            beatGridOffset = 0.0;
+            beatGridDone.reset();
+            loudnessAnalysisComplete = false;
+            loudnessAnalysisDone.reset();
+            updateAutoGain();
+        }
         
-        // Stores the audio file and start BPM analysis
         currentAudioFile = audioURL.getLocalFile();
-        bpmAnalysisComplete = false;
-        currentTrackBPM = 0.0;
         currentSpeedRatio = 1.0; // Resets the speed ratio for any new track
         
-        // Performs the  BPM analysis in background
+        // Performs the BPM and loudness analysis in background, so the load doesn't wait for a
+        // decode of the whole track - cached results apply straight away
         if (currentAudioFile.exists())
         {
-        // Starts the  BPM analysis
-        currentTrackBPM = bpmAnalyser->analyseBPM(currentAudioFile);
-        bpmAnalysisComplete = (currentTrackBPM > 0.0);
+            analyseBeatGrid(currentAudioFile);
+            analyseLoudness(currentAudioFile);
         }
+        else
+        {
+            beatGridDone.signal();
+            loudnessAnalysisDone.signal();
+        }
+        
+        // Hands the audio thread a reference of its own once a cached loudness has set its trim -
+        // a track it never got round to picking up is dropped
+        newTrack->incReferenceCount();
+        if (auto* skipped = pendingTrack.exchange(newTrack.get(), std::memory_order_acq_rel))
+            skipped->decReferenceCountWithoutDeleting();
     }
 }
 
+void DJAudioPlayer::analyseBeatGrid(const juce::File& audioFile)
+{
+    double bpm = 0.0;
+    double offset = 0.0;
+    int generation = analysisGeneration;
+    
+    // Analyses the track the first time it is loaded, then uses the cached beat grid
+    if (analysisCache->getBeatGrid(audioFile, bpm, offset))
+    {
+        setBeatGridResult(generation, bpm, offset);
+        return;
+    }
+    
+    analysisPool.addJob([this, audioFile, generation]
+    {
+        // a track loaded since has its own job queued behind this one
+        if (analysisGeneration != generation)
+            return;
+        
+        double bpm = bpmAnalyser->analyseBPM(audioFile);
+        double offset = bpmAnalyser->getBeatGridOffset();
+        
+        if (bpm > 0.0)
+            analysisCache->setBeatGrid(audioFile, bpm, offset);
+        
+        setBeatGridResult(generation, bpm, offset);
+    });
+}
+
+void DJAudioPlayer::setBeatGridResult(int generation, double bpm, double offset)
+{
+    const juce::ScopedLock lock(analysisResultLock);
+    
+    if (analysisGeneration != generation)
+        return;
+    
+    // the grid is in place before the audio thread is told there is one
+    beatGridOffset = offset;
+    currentTrackBPM = bpm;
+    bpmAnalysisComplete = (bpm > 0.0);
+    beatGridDone.signal();
+}
+
+void DJAudioPlayer::analyseLoudness(const juce::File& audioFile)
+{
+    double lufs = 0.0;
+    double truePeak = 0.0;
+    
+    int generation = analysisGeneration;
+    
+    // A cached result applies straight away, before the track has played a sample
+    if (analysisCache->getLoudness(audioFile, lufs, truePeak))
+    {
+        setLoudnessResult(generation, true, lufs, truePeak);
+        return;
+    }
+    
+    analysisPool.addJob([this, audioFile, generation]
+    {
+        auto isStale = [this, generation] { return analysisGeneration != generation; };
+        
+        LoudnessAnalyser analyser;
+        bool measured = analyser.analyseFile(audioFile, formatManager, isStale);
+        
+        if (measured)
+            analysisCache->setLoudness(audioFile, analyser.getIntegratedLUFS(), analyser.getTruePeakDecibels());
+        
+        setLoudnessResult(generation, measured, analyser.getIntegratedLUFS(), analyser.getTruePeakDecibels());
+    });
+}
+
+void DJAudioPlayer::setLoudnessResult(int generation, bool measured, double lufs, double truePeak)
+{
+    // another track may have been loaded while this one was measured
+    const juce::ScopedLock lock(analysisResultLock);
+    
+    if (analysisGeneration != generation)
+        return;
+    
+    if (measured)
+    {
+        trackLoudness = lufs;
+        trackTruePeak = truePeak;
+        loudnessAnalysisComplete = true;
+        updateAutoGain();
+    }
+    
+    loudnessAnalysisDone.signal();
+}
+
+void DJAudioPlayer::updateAutoGain()
+{
+    double gainDb = 0.0;
+    
+    if (autoGainEnabled && loudnessAnalysisComplete && trackLoudness > LoudnessAnalyser::SILENCE_LUFS)
+    {
+        gainDb = autoGainTarget - trackLoudness;
+        
+        if (gainDb > 0.0)
+            gainDb = juce::jmin(gainDb, juce::jmax(0.0, AUTO_GAIN_PEAK_CEILING - trackTruePeak));
+        
+        gainDb = juce::jlimit(-MAX_AUTO_GAIN_DB, MAX_AUTO_GAIN_DB, gainDb);
+    }
+    
+    autoGainTargetGain = juce::Decibels::decibelsToGain(static_cast<float>(gainDb));
+    
+    if (auto* track = currentTrack.load(std::memory_order_acquire))
+        track->setTrim(autoGainTargetGain);
+}
+
+void DJAudioPlayer::setAutoGainEnabled(bool shouldBeEnabled)
+{
+    const juce::ScopedLock lock(analysisResultLock);
+    autoGainEnabled = shouldBeEnabled;
+    updateAutoGain();
+}
+
+bool DJAudioPlayer::isAutoGainEnabled() const
+{
+    return autoGainEnabled;
+}
+
+void DJAudioPlayer::setAutoGainTarget(double targetLUFS)
+{
+    const juce::ScopedLock lock(analysisResultLock);
+    autoGainTarget = targetLUFS;
+    updateAutoGain();
+}
+
+double DJAudioPlayer::getAutoGainTarget() const
+{
+    return autoGainTarget;
+}
+
+bool DJAudioPlayer::isLoudnessAnalysisComplete() const
+{
+    return loudnessAnalysisComplete;
+}
+
+double DJAudioPlayer::getTrackLoudness() const
+{
+    return trackLoudness;
+}
+
+double DJAudioPlayer::getTrackTruePeak() const
+{
+    return trackTruePeak;
+}
+
+double DJAudioPlayer::getAutoGainDecibels() const
+{
+    return juce::Decibels::gainToDecibels(autoGainTargetGain.load());
+}
+
+bool DJAudioPlayer::waitForAnalysis(int timeoutMs)
+{
+    auto start = juce::Time::getMillisecondCounter();
+    
+    if (! beatGridDone.wait(timeoutMs))
+        return false;
+    
+    int elapsed = static_cast<int>(juce::Time::getMillisecondCounter() - start);
+    return loudnessAnalysisDone.wait(timeoutMs < 0 ? -1 : juce::jmax(0, timeoutMs - elapsed));
+}
+
 void DJAudioPlayer::setGain(double gain)
 {
     if (gain >= 0.0 && gain <= 1.0)
@@ -80,51 +708,231 @@ void DJAudioPlayer::setGain(double gain)
     }
 }
 
+void DJAudioPlayer::setCueTap(juce::AudioBuffer<float>* buffer)
+{
+    cueTap = buffer;
+}
+
 void DJAudioPlayer::setSpeed(double ratio)
 {
     if (ratio > 0.0 && ratio <= 4.0)
+        sendCommand(TransportCommand::Type::speed, ratio);
+}
+
+void DJAudioPlayer::setKeyLock(bool shouldLockKey)
+{
+    // the bypass and the speed change together on the audio thread, between samples
+    sendCommand(TransportCommand::Type::keyLock, shouldLockKey ? 1.0 : 0.0);
+}
+
+bool DJAudioPlayer::isKeyLocked() const
+{
+    return keyLocked;
+}
+
+void DJAudioPlayer::setResamplingQuality(SincResamplingAudioSource::Quality quality)
+{
+    // picked up by the playing track at its next block
+    resamplingQuality = quality;
+}
+
+void DJAudioPlayer::setOfflineRendering(bool shouldWait)
+{
+    offlineRendering = shouldWait;
+}
+
+void DJAudioPlayer::setEQGain(DeckEQ::Band band, double decibels)
+{
+    eq.setBandGain(band, static_cast<float>(decibels));
+}
+
+void DJAudioPlayer::setEQKill(DeckEQ::Band band, bool shouldKill)
+{
+    eq.setBandKilled(band, shouldKill);
+}
+
+bool DJAudioPlayer::isEQKilled(DeckEQ::Band band) const
+{
+    return eq.isBandKilled(band);
+}
+
+void DJAudioPlayer::updatePlaySpeed()
+{
+    double ratio = syncRatio > 0.0 ? syncRatio : userSpeedRatio;
+    
+    if (playingTrack != nullptr)
+        applySpeedRatio(*playingTrack, ratio);
+    
+    // Tracks the current speed for the BPM calculations
+    currentSpeedRatio = ratio;
+}
+
+void DJAudioPlayer::applySpeedRatio(DeckTrack& track, double ratio)
+{
+    // file samples read per device sample at normal speed, e.g. 44100 / 48000
+    double sampleRateRatio = track.getFileSampleRate() / deviceSampleRate;
+    track.setPlaySpeed(ratio);
+    
+    if (keyLocked)
     {
-        resamplingSource.setResamplingRatio(ratio);
-        // Tracks the current speed for the BPM calculations
-        currentSpeedRatio = ratio;
+        track.getStretcher().setTempo(ratio);
+        track.getResampler().setResamplingRatio(sampleRateRatio);
+    }
+    else
+    {
+        track.getResampler().setResamplingRatio(sampleRateRatio * ratio);
     }
 }
 
 void DJAudioPlayer::setPosition(double posInSecs)
 {
     if (posInSecs >= 0.0)
-    {
-        transportSource.setPosition(posInSecs);
-    }
+        sendCommand(TransportCommand::Type::seek, posInSecs);
 }
 
 void DJAudioPlayer::setPositionRelative(double pos)
 {
-    if (transportSource.getLengthInSeconds() > 0)
+    if (getLengthInSeconds() > 0)
     {
-        double posInSecs = pos * transportSource.getLengthInSeconds();
+        double posInSecs = pos * getLengthInSeconds();
         setPosition(posInSecs);
     }
 }
 
 double DJAudioPlayer::getLengthInSeconds()
 {
-    return transportSource.getLengthInSeconds();
+    auto* track = currentTrack.load(std::memory_order_acquire);
+    return track != nullptr ? track->getLengthInSeconds() : 0.0;
 }
 
 void DJAudioPlayer::start()
 {
-    transportSource.start();
+    sendCommand(TransportCommand::Type::play);
 }
 
 void DJAudioPlayer::stop()
 {
-    transportSource.stop();
+    sendCommand(TransportCommand::Type::stop);
 }
 
 double DJAudioPlayer::getPositionRelative()
 {
-        return transportSource.getCurrentPosition() / transportSource.getLengthInSeconds();
+        return getPositionInSeconds() / getLengthInSeconds();
+}
+
+bool DJAudioPlayer::isLoopActive() const
+{
+    auto* track = currentTrack.load(std::memory_order_acquire);
+    return track != nullptr && track->getLoops().isLoopActive();
+}
+
+bool DJAudioPlayer::isLoopRolling() const
+{
+    auto* track = currentTrack.load(std::memory_order_acquire);
+    return track != nullptr && track->getLoops().isRolling();
+}
+
+void DJAudioPlayer::setHotCue(int index, double posInSecs)
+{
+    if (auto* track = currentTrack.load(std::memory_order_acquire))
+        if (posInSecs >= 0.0 && posInSecs < track->getLengthInSeconds())
+            track->getHotCues().setCue(index, static_cast<juce::int64>(posInSecs * track->getFileSampleRate()));
+}
+
+void DJAudioPlayer::startScratch()
+{
+    if (auto* track = currentTrack.load(std::memory_order_acquire))
+        track->getScratch().grab();
+}
+
+void DJAudioPlayer::scratchBy(double seconds)
+{
+    if (auto* track = currentTrack.load(std::memory_order_acquire))
+        track->getScratch().moveBy(seconds);
+}
+
+void DJAudioPlayer::stopScratch()
+{
+    if (auto* track = currentTrack.load(std::memory_order_acquire))
+        track->getScratch().release();
+}
+
+bool DJAudioPlayer::isScratching() const
+{
+    auto* track = currentTrack.load(std::memory_order_acquire);
+    return track != nullptr && track->isScratching();
+}
+
+bool DJAudioPlayer::isReversed() const
+{
+    auto* track = currentTrack.load(std::memory_order_acquire);
+    return track != nullptr && track->isReversed();
+}
+
+bool DJAudioPlayer::isCensoring() const
+{
+    auto* track = currentTrack.load(std::memory_order_acquire);
+    return track != nullptr && track->isCensoring();
+}
+
+juce::uint32 DJAudioPlayer::getScratchUnderruns() const
+{
+    auto* track = currentTrack.load(std::memory_order_acquire);
+    return track != nullptr ? track->getScratch().getNumUnderruns() : 0;
+}
+
+void DJAudioPlayer::clearHotCue(int index)
+{
+    if (auto* track = currentTrack.load(std::memory_order_acquire))
+        track->getHotCues().setCue(index, -1);
+}
+
+bool DJAudioPlayer::hasHotCue(int index) const
+{
+    auto* track = currentTrack.load(std::memory_order_acquire);
+    return track != nullptr && track->getHotCues().getCue(index) >= 0;
+}
+
+double DJAudioPlayer::getHotCue(int index) const
+{
+    auto* track = currentTrack.load(std::memory_order_acquire);
+    if (track == nullptr || track->getHotCues().getCue(index) < 0)
+        return -1.0;
+    
+    return track->getHotCues().getCue(index) / track->getFileSampleRate();
+}
+
+double DJAudioPlayer::getPositionInSeconds()
+{
+    auto* track = currentTrack.load(std::memory_order_acquire);
+    if (track == nullptr)
+        return 0.0;
+    
+    double fileRate = track->getFileSampleRate();
+    if (track->isScratching())
+        return track->getScratch().getPosition() / fileRate;
+    
+    double position = track->getTransport().getNextReadPosition() / fileRate;
+    
+    // The time-stretcher reads ahead of what is being heard, so key-locked decks report the audible position
+    if (keyLocked)
+        position -= track->getStretcher().getLatencyInSamples() / fileRate;
+    
+    return position;
+}
+
+double DJAudioPlayer::getAudiblePositionInSeconds() const
+{
+    if (playingTrack == nullptr)
+        return 0.0;
+    
+    return playingTrack->getAudiblePosition() / playingTrack->getFileSampleRate();
+}
+
+bool DJAudioPlayer::isPlaying() const
+{
+    auto* track = currentTrack.load(std::memory_order_acquire);
+    return track != nullptr && track->getTransport().isPlaying();
 }
 
 double DJAudioPlayer::getBPM() const
@@ -147,4 +955,18 @@ double DJAudioPlayer::getCurrentSpeed() const
 bool DJAudioPlayer::isBPMAnalysisComplete() const
 {
     return bpmAnalysisComplete;
+}
+
+double DJAudioPlayer::getBeatGridOffset() const
+{
+    return beatGridOffset;
+}
+
+void DJAudioPlayer::setSyncRatio(double ratio)
+{
+    // Same limits as setSpeed
+    if (ratio > 0.0 && ratio <= 4.0)
+        scheduleCommand({ TransportCommand::Type::syncRatio, ratio, getNextBlockSampleTime() });
+    else if (ratio == 0.0)
+        sendCommand(TransportCommand::Type::syncRatio, 0.0);
 }
\ No newline at end of file
@@ -7,6 +7,11 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "BPMAnalyser.h"
+#include "DeckTrack.h"
+#include "TransportCommandQueue.h"
+#include "DeckEQ.h"
+#include "LoudnessAnalyser.h"
+#include "TrackAnalysisCache.h"
 
 class DJAudioPlayer : public juce::AudioSource
 {
@@ -18,9 +23,35 @@ class DJAudioPlayer : public juce::AudioSource
     void getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill) override;
     void releaseResources() override;
 
+    // Opens and prepares the track here, then hands it to the audio thread, which swaps to it
+    // with a short crossfade at its next block
     void loadURL(juce::URL audioURL);
     void setGain(double gain);
     void setSpeed(double ratio);
+    
+    // A buffer the next block is copied into before the fader, for the headphone cue, or nullptr
+    // for none - set by the mixer just before it renders the deck (audio thread)
+    void setCueTap(juce::AudioBuffer<float>* buffer);
+    
+    // Key lock - speed changes alter the tempo only, keeping the original pitch. Sent like any other
+    // command, and the deck crossfades between the two over one stretch frame
+    void setKeyLock(bool shouldLockKey);
+    bool isKeyLocked() const;
+    
+    // Resampler quality for the master output. A deck in the headphone cue with its fader closed
+    // isn't heard on the master, so it drops to draft on its own until the fader opens
+    void setResamplingQuality(SincResamplingAudioSource::Quality quality);
+    // Offline rendering - reverse, censor and scratches wait for their decoding instead of playing
+    // on past it, so the deck is no longer real time. Set before loading
+    void setOfflineRendering(bool shouldWait);
+    
+    // Three-band isolator EQ, always in the signal path - gains are -6 to +6 dB
+    void setEQGain(DeckEQ::Band band, double decibels);
+    void setEQKill(DeckEQ::Band band, bool shouldKill);
+    bool isEQKilled(DeckEQ::Band band) const;
+    // Play, stop, seek and speed go through sendCommand, timestamped like every other command sent
+    // from the GUI, so they land in the order they were made. A seek that isn't to a hot cue seeks
+    // the decoder on the audio thread, see HotCueSource
     void setPosition(double posInSecs);
     void setPositionRelative(double pos);
     
@@ -29,24 +60,224 @@ class DJAudioPlayer : public juce::AudioSource
     void start();
     void stop();
 
+    // Hot cues on the loaded track, cleared by loading another. A jump is a TransportCommand::Type::hotCue
+    // with the cue's index, which plays from the cue's pre-decoded window with a short crossfade
+    void setHotCue(int index, double posInSecs);
+    void clearHotCue(int index);
+    bool hasHotCue(int index) const;
+    double getHotCue(int index) const;
+
+    // Loops - manual in and out points, and auto-loops and loop rolls of MIN_LOOP_BEATS to
+    // MAX_LOOP_BEATS on the beat grid - are transport commands. A roll ends where playback would
+    // have got to without it, and loopExit ends whichever is running.
+    bool isLoopActive() const;
+    bool isLoopRolling() const;
+
+    // Scratching - while the platter is held the deck plays wherever it is pushed, forwards or
+    // backwards, by seconds of the track. Once it is let go it runs back up to the deck's speed and
+    // the transport carries on from there (message thread, or a controller's)
+    void startScratch();
+    void scratchBy(double seconds);
+    void stopScratch();
+    bool isScratching() const;
+
+    // Reverse play and censor are transport commands, played backwards from a ring decoded behind
+    // the playhead. A censor ends where playback would have got to without it.
+    bool isReversed() const;
+    bool isCensoring() const;
+    // Blocks of scratch, reverse or censor that ran ahead of the decoded audio in the loaded track
+    juce::uint32 getScratchUnderruns() const;
+
+    // Sample-accurate transport. Commands land at an exact sample of the deck's clock, which
+    // counts every sample the deck has rendered and never goes back
+    struct CommandTimingStats
+    {
+        juce::uint32 numCommands{0};
+        juce::uint32 numLate{0};       // landed after the sample they asked for
+        juce::int64 maxLateSamples{0};
+    };
+
+    // Queues a command for its exact sample time (one thread at a time)
+    void queueCommand(const TransportCommand& command);
+    // Queues a command timestamped now, landing a fixed COMMAND_LATENCY_BLOCKS later so the
+    // GUI's timing jitter doesn't move it (message thread)
+    void sendCommand(TransportCommand::Type type, double value = 0.0);
+    // Estimate of the sample the deck is rendering at this moment (any thread)
+    juce::int64 getSampleTimeNow() const;
+    // Adds a command the audio thread has worked out itself, e.g. a start quantised to another
+    // deck's beat (audio thread, before this deck renders)
+    void scheduleCommand(const TransportCommand& command);
+    // Sample time at the start of the deck's next block (audio thread)
+    juce::int64 getNextBlockSampleTime() const;
+    // Sample time a play command last actually landed on, -1 before the first (audio thread)
+    juce::int64 getLastStartSampleTime() const;
+
+    CommandTimingStats getCommandTimingStats() const;
+
     double getPositionRelative();
+    double getPositionInSeconds();
+    // The position of the next sample the deck puts out, for phase measurements between blocks -
+    // exact to the sample where getPositionInSeconds is only as fine as the blocks (audio thread)
+    double getAudiblePositionInSeconds() const;
+    bool isPlaying() const;
     double getBPM() const;
     double getOriginalBPM() const;
     double getCurrentSpeed() const;
     bool isBPMAnalysisComplete() const;
+    
+    // Time in seconds of the first beat of the analysed beat grid
+    double getBeatGridOffset() const;
+    
+    // Called by the SyncEngine on the audio thread, before the deck renders, to steer the tempo of a
+    // synced deck. The ratio takes over from the user's speed at the start of the next block, and
+    // speed commands only change the speed sync hands back to. A ratio of 0 releases sync from the
+    // message thread, and the deck keeps the synced tempo as its speed.
+    void setSyncRatio(double ratio);
+
+    // Auto-gain brings every track to the same integrated loudness. The loudness is measured in
+    // the background after a load, and the gain fades in on the audio thread once it is known.
+    void setAutoGainEnabled(bool shouldBeEnabled);
+    bool isAutoGainEnabled() const;
+    void setAutoGainTarget(double targetLUFS);
+    double getAutoGainTarget() const;
+
+    bool isLoudnessAnalysisComplete() const;
+    // Integrated loudness in LUFS and true peak in dBTP of the loaded track
+    double getTrackLoudness() const;
+    double getTrackTruePeak() const;
+    // The gain auto-gain is heading for, 0 dB while it is off or still measuring
+    double getAutoGainDecibels() const;
+
+    // Blocks until the loaded track's beat grid and loudness are known, for offline rendering (not
+    // the audio thread)
+    bool waitForAnalysis(int timeoutMs);
+
+    static constexpr double DEFAULT_AUTO_GAIN_TARGET = -14.0;
+    // Auto-gain never moves a track further than this
+    static constexpr double MAX_AUTO_GAIN_DB = 12.0;
+    // Boosts stop short of pushing the true peak over this
+    static constexpr double AUTO_GAIN_PEAK_CEILING = -1.0;
+    static constexpr double AUTO_GAIN_RAMP_SECONDS = DeckTrack::TRIM_RAMP_SECONDS;
+    // Crossfade from the old track to the new one when a track is loaded
+    static constexpr double TRACK_SWAP_FADE_SECONDS = 0.02;
+    static constexpr double MIN_LOOP_BEATS = 1.0 / 32.0;
+    static constexpr double MAX_LOOP_BEATS = 32.0;
+    // Commands sent from the GUI land this many blocks after they were sent
+    static constexpr int COMMAND_LATENCY_BLOCKS = 1;
+    // Commands waiting for their time on the audio thread
+    static constexpr int MAX_PENDING_COMMANDS = 64;
 
 
   private:
+    // Routes a speed ratio to the resampler, or to the time-stretcher when the key is locked.
+    // The file to device sample rate conversion is folded into the same resampling pass.
+    void applySpeedRatio(DeckTrack& track, double ratio);
+    // Plays the playing track at the synced ratio while there is one, at the user's speed otherwise (audio thread)
+    void updatePlaySpeed();
+
+    // Picks up a newly loaded track and starts the crossfade to it (audio thread)
+    void swapToPendingTrack();
+    // Mixes the outgoing track into the block while the crossfade lasts (audio thread)
+    void crossfadeFromOldTrack(const juce::AudioSourceChannelInfo& bufferToFill);
+    // Drops the audio thread's reference without deleting, the release pool frees the track
+    static void releaseTrack(DeckTrack*& track);
+    // Renders part of the block from the playing track and any crossfade (audio thread)
+    void renderTracks(const juce::AudioSourceChannelInfo& bufferToFill);
+    // Moves queued commands into the pending list, in time order (audio thread)
+    void collectCommands();
+    void addPendingCommand(const TransportCommand& command);
+    void applyCommand(const TransportCommand& command, juce::int64 sampleTime);
+    // A loop of the beats on the track's beat grid, starting on the grid at or before the audible
+    // position - false without a beat grid (audio thread)
+    bool getBeatLoop(DeckTrack& track, double beats, juce::int64& start, juce::int64& end) const;
+    // Publishes the deck's clock for getSampleTimeNow (audio thread)
+    void publishClock(juce::int64 blockStart);
+
+    // Finds the track's beat grid on the analysis thread, unless the cache already knows it
+    void analyseBeatGrid(const juce::File& audioFile);
+    // Publishes a beat grid for the load it was found for, and drops one for an earlier load (any thread)
+    void setBeatGridResult(int generation, double bpm, double offset);
+    // Measures the track's loudness on the analysis thread, unless the cache already knows it
+    void analyseLoudness(const juce::File& audioFile);
+    // Publishes a loudness for the load it was measured for, and drops one for an earlier load (any thread)
+    void setLoudnessResult(int generation, bool measured, double lufs, double truePeak);
+    // Works out the auto-gain from the track's loudness and the target, and hands it to the track
+    void updateAutoGain();
+
     juce::AudioFormatManager& formatManager;
-    std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
-    juce::AudioTransportSource transportSource;
-    juce::ResamplingAudioSource resamplingSource{&transportSource, false, 2};
-    double gain{1.0};
-    double currentSpeedRatio{1.0}; // Track current speed for BPM calculation
+    juce::SharedResourcePointer<DeckTrackReleasePool> releasePool;
+
+    // The latest loaded track - set by the message thread, read from any thread
+    std::atomic<DeckTrack*> currentTrack{nullptr};
+    DeckTrack::Ptr loadedTrack;
+    // A loaded track waiting for the audio thread, carrying a reference for it
+    std::atomic<DeckTrack*> pendingTrack{nullptr};
+
+    // audio thread only - each holds a reference
+    DeckTrack* playingTrack{nullptr};
+    DeckTrack* fadingTrack{nullptr};
+    int fadeSamplesDone{0};
+    int fadeLength{1};
+    juce::AudioBuffer<float> fadeBuffer;
+
+    DeckEQ eq;
+    std::atomic<bool> keyLocked{false};
+    std::atomic<SincResamplingAudioSource::Quality> resamplingQuality{SincResamplingAudioSource::Quality::high};
+    std::atomic<bool> offlineRendering{false};
+    std::atomic<double> deviceSampleRate{44100.0};
+    int preparedBlockSize{0};
+
+    // Transport commands, and the deck's sample clock
+    TransportCommandQueue commandQueue;
+    std::array<TransportCommand, MAX_PENDING_COMMANDS> pendingCommands;
+    int numPendingCommands{0};
+    juce::int64 sampleClock{0};
+    juce::int64 lastStartSampleTime{-1};
+    std::atomic<int> blockSizeForCommands{0};
+
+    // Clock at the start of the last block and when it started, read through clockSequence
+    std::atomic<juce::uint32> clockSequence{0};
+    std::atomic<juce::int64> clockBlockStart{0};
+    std::atomic<juce::int64> clockBlockTicks{0};
+
+    std::atomic<juce::uint32> commandsApplied{0};
+    std::atomic<juce::uint32> commandsLate{0};
+    std::atomic<juce::int64> maxCommandLateness{0};
+    // set from the GUI and from MIDI on the audio thread, read by whichever thread renders the deck
+    std::atomic<double> gain{1.0};
+    juce::AudioBuffer<float>* cueTap{nullptr};
+    std::atomic<double> currentSpeedRatio{1.0}; // Track current speed for BPM calculation
+    // audio thread - the speed from speed commands, and the SyncEngine's ratio while synced
+    double userSpeedRatio{1.0};
+    double syncRatio{0.0};
     
-    // BPM Analysis
+    // BPM Analysis - read by the SyncEngine on the audio thread. The analyser is only used by the
+    // analysis pool's one thread
     std::unique_ptr<BPMAnalyser> bpmAnalyser;
-    double currentTrackBPM{0.0};
-    bool bpmAnalysisComplete{false};
+    std::atomic<double> currentTrackBPM{0.0};
+    std::atomic<double> beatGridOffset{0.0};
+    std::atomic<bool> bpmAnalysisComplete{false};
+    juce::WaitableEvent beatGridDone{true};
     juce::File currentAudioFile;
+
+    // Analysis results shared by every deck
+    juce::SharedResourcePointer<TrackAnalysisCache> analysisCache;
+
+    // Loudness analysis and auto-gain
+    std::atomic<bool> autoGainEnabled{true};
+    std::atomic<double> autoGainTarget{DEFAULT_AUTO_GAIN_TARGET};
+    std::atomic<double> trackLoudness{LoudnessAnalyser::SILENCE_LUFS};
+    std::atomic<double> trackTruePeak{LoudnessAnalyser::SILENCE_LUFS};
+    std::atomic<bool> loudnessAnalysisComplete{false};
+    juce::WaitableEvent loudnessAnalysisDone{true};
+    // Bumped on every load, so an analysis of the previous track is abandoned
+    std::atomic<int> analysisGeneration{0};
+    // Stops a finishing analysis and a new load interleaving their results
+    juce::CriticalSection analysisResultLock;
+
+    // Linear gain the loaded track's trim is heading for
+    std::atomic<float> autoGainTargetGain{1.0f};
+
+    // Declared last so it stops before anything its jobs use is destroyed
+    juce::ThreadPool analysisPool{1, 0, juce::Thread::Priority::low};
 };
@@ -0,0 +1,226 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "DeckEQ.h"
+
+#if JUCE_USE_SSE_INTRINSICS
+ #include <xmmintrin.h>
+#elif JUCE_USE_ARM_NEON
+ #include <arm_neon.h>
+#endif
+
+namespace
+{
+    // Just enough of a four lane float vector for the biquads, with a scalar fallback
+   #if JUCE_USE_SSE_INTRINSICS
+    using Lanes = __m128;
+    inline Lanes load(const float* p) noexcept                { return _mm_load_ps(p); }
+    inline void store(float* p, Lanes v) noexcept             { _mm_store_ps(p, v); }
+    inline Lanes set(float a, float b) noexcept               { return _mm_setr_ps(a, b, a, b); }
+    inline Lanes add(Lanes a, Lanes b) noexcept               { return _mm_add_ps(a, b); }
+    inline Lanes sub(Lanes a, Lanes b) noexcept               { return _mm_sub_ps(a, b); }
+    inline Lanes mul(Lanes a, Lanes b) noexcept               { return _mm_mul_ps(a, b); }
+    inline Lanes upperPair(Lanes v) noexcept                  { return _mm_movehl_ps(v, v); }
+   #elif JUCE_USE_ARM_NEON
+    using Lanes = float32x4_t;
+    inline Lanes load(const float* p) noexcept                { return vld1q_f32(p); }
+    inline void store(float* p, Lanes v) noexcept             { vst1q_f32(p, v); }
+    inline Lanes set(float a, float b) noexcept               { float32x2_t pair = { a, b }; return vcombine_f32(pair, pair); }
+    inline Lanes add(Lanes a, Lanes b) noexcept               { return vaddq_f32(a, b); }
+    inline Lanes sub(Lanes a, Lanes b) noexcept               { return vsubq_f32(a, b); }
+    inline Lanes mul(Lanes a, Lanes b) noexcept               { return vmulq_f32(a, b); }
+    inline Lanes upperPair(Lanes v) noexcept                  { return vcombine_f32(vget_high_f32(v), vget_high_f32(v)); }
+   #else
+    struct Lanes { float v[4]; };
+    inline Lanes load(const float* p) noexcept                { return { { p[0], p[1], p[2], p[3] } }; }
+    inline void store(float* p, Lanes v) noexcept             { for (int i = 0; i < 4; ++i) p[i] = v.v[i]; }
+    inline Lanes set(float a, float b) noexcept               { return { { a, b, a, b } }; }
+    inline Lanes add(Lanes a, Lanes b) noexcept               { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+    inline Lanes sub(Lanes a, Lanes b) noexcept               { for (int i = 0; i < 4; ++i) a.v[i] -= b.v[i]; return a; }
+    inline Lanes mul(Lanes a, Lanes b) noexcept               { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+    inline Lanes upperPair(Lanes v) noexcept                  { return { { v.v[2], v.v[3], v.v[2], v.v[3] } }; }
+   #endif
+
+    // A biquad stage with its coefficients and state held in registers for a block
+    struct LoadedBiquad
+    {
+        Lanes b0, b1, b2, a1, a2, z1, z2;
+
+        // Transposed direct form II
+        Lanes process(Lanes x) noexcept
+        {
+            Lanes y = add(mul(b0, x), z1);
+            z1 = add(sub(mul(b1, x), mul(a1, y)), z2);
+            z2 = sub(mul(b2, x), mul(a2, y));
+            return y;
+        }
+    };
+
+    // Butterworth low and high pass, and the allpass a fourth order Linkwitz-Riley pair sums to
+    struct Coefficients { double b0, b1, b2, a1, a2; };
+
+    Coefficients butterworth(double frequency, double sampleRate, bool highPass)
+    {
+        const double q = juce::MathConstants<double>::sqrt2 / 2.0;
+        double k = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        double norm = 1.0 / (1.0 + k / q + k * k);
+        double a1 = 2.0 * (k * k - 1.0) * norm;
+        double a2 = (1.0 - k / q + k * k) * norm;
+
+        if (highPass)
+            return { norm, -2.0 * norm, norm, a1, a2 };
+
+        return { k * k * norm, 2.0 * k * k * norm, k * k * norm, a1, a2 };
+    }
+
+    Coefficients linkwitzRileyAllpass(double frequency, double sampleRate)
+    {
+        auto lowPass = butterworth(frequency, sampleRate, false);
+        return { lowPass.a2, lowPass.a1, 1.0, lowPass.a1, lowPass.a2 };
+    }
+}
+
+void DeckEQ::FourLaneBiquad::setLanes(int firstLane, double nb0, double nb1, double nb2, double na1, double na2)
+{
+    for (int lane = firstLane; lane < firstLane + 2; ++lane)
+    {
+        b0[lane] = static_cast<float>(nb0);
+        b1[lane] = static_cast<float>(nb1);
+        b2[lane] = static_cast<float>(nb2);
+        a1[lane] = static_cast<float>(na1);
+        a2[lane] = static_cast<float>(na2);
+    }
+}
+
+void DeckEQ::FourLaneBiquad::reset()
+{
+    std::fill(std::begin(z1), std::end(z1), 0.0f);
+    std::fill(std::begin(z2), std::end(z2), 0.0f);
+}
+
+DeckEQ::DeckEQ()
+{
+    for (int band = 0; band < numBands; ++band)
+    {
+        bandGainDb[(size_t) band] = 0.0f;
+        bandKilled[(size_t) band] = false;
+    }
+
+    prepareToPlay(44100.0);
+}
+
+void DeckEQ::prepareToPlay(double sampleRate)
+{
+    auto setStage = [this](Stage stage, int firstLane, const Coefficients& c)
+    {
+        stages[(size_t) stage].setLanes(firstLane, c.b0, c.b1, c.b2, c.a1, c.a2);
+    };
+
+    // Lanes 0 and 1 carry the lower side of each split, lanes 2 and 3 the upper side
+    for (auto stage : { lowSplit1, lowSplit2 })
+    {
+        setStage(stage, 0, butterworth(LOW_CROSSOVER_HZ, sampleRate, false));
+        setStage(stage, 2, butterworth(LOW_CROSSOVER_HZ, sampleRate, true));
+    }
+
+    for (auto stage : { highSplit1, highSplit2 })
+    {
+        setStage(stage, 0, butterworth(HIGH_CROSSOVER_HZ, sampleRate, false));
+        setStage(stage, 2, butterworth(HIGH_CROSSOVER_HZ, sampleRate, true));
+    }
+
+    // only the low band goes through the allpass, the upper lanes are unused
+    setStage(lowAllpass, 0, linkwitzRileyAllpass(HIGH_CROSSOVER_HZ, sampleRate));
+    setStage(lowAllpass, 2, { 1.0, 0.0, 0.0, 0.0, 0.0 });
+
+    for (auto& stage : stages)
+        stage.reset();
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        bandGain[(size_t) band].reset(sampleRate, SMOOTHING_SECONDS);
+        bandGain[(size_t) band].setCurrentAndTargetValue(bandKilled[(size_t) band] ? 0.0f
+                                                         : juce::Decibels::decibelsToGain(bandGainDb[(size_t) band].load()));
+    }
+}
+
+void DeckEQ::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    if (buffer.getNumChannels() == 0 || numSamples <= 0)
+        return;
+
+    juce::ScopedNoDenormals noDenormals;
+
+    for (int band = 0; band < numBands; ++band)
+        bandGain[(size_t) band].setTargetValue(bandKilled[(size_t) band] ? 0.0f
+                                               : juce::Decibels::decibelsToGain(bandGainDb[(size_t) band].load()));
+
+    bool smoothing = bandGain[low].isSmoothing() || bandGain[mid].isSmoothing() || bandGain[high].isSmoothing();
+    float lowGain = bandGain[low].getCurrentValue();
+    float midGain = bandGain[mid].getCurrentValue();
+    float highGain = bandGain[high].getCurrentValue();
+
+    std::array<LoadedBiquad, numStages> loaded;
+    for (size_t i = 0; i < stages.size(); ++i)
+    {
+        const auto& s = stages[i];
+        loaded[i] = { load(s.b0), load(s.b1), load(s.b2), load(s.a1), load(s.a2), load(s.z1), load(s.z2) };
+    }
+
+    float* left = buffer.getWritePointer(0, startSample);
+    float* right = buffer.getNumChannels() > 1 ? buffer.getWritePointer(1, startSample) : nullptr;
+    alignas(16) float lowBand[4];
+    alignas(16) float upperBands[4];
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float leftIn = left[i];
+        float rightIn = right != nullptr ? right[i] : leftIn;
+
+        // {low L, low R, rest L, rest R}, then the rest split into {mid L, mid R, high L, high R}
+        Lanes lowSplit = loaded[lowSplit2].process(loaded[lowSplit1].process(set(leftIn, rightIn)));
+        Lanes upper = loaded[highSplit2].process(loaded[highSplit1].process(upperPair(lowSplit)));
+        store(lowBand, loaded[lowAllpass].process(lowSplit));
+        store(upperBands, upper);
+
+        if (smoothing)
+        {
+            lowGain = bandGain[low].getNextValue();
+            midGain = bandGain[mid].getNextValue();
+            highGain = bandGain[high].getNextValue();
+        }
+
+        left[i] = lowGain * lowBand[0] + midGain * upperBands[0] + highGain * upperBands[2];
+
+        if (right != nullptr)
+            right[i] = lowGain * lowBand[1] + midGain * upperBands[1] + highGain * upperBands[3];
+    }
+
+    for (size_t i = 0; i < stages.size(); ++i)
+    {
+        store(stages[i].z1, loaded[i].z1);
+        store(stages[i].z2, loaded[i].z2);
+    }
+}
+
+void DeckEQ::setBandGain(Band band, float decibels)
+{
+    bandGainDb[(size_t) band] = juce::jlimit(-MAX_GAIN_DB, MAX_GAIN_DB, decibels);
+}
+
+float DeckEQ::getBandGain(Band band) const
+{
+    return bandGainDb[(size_t) band];
+}
+
+void DeckEQ::setBandKilled(Band band, bool shouldBeKilled)
+{
+    bandKilled[(size_t) band] = shouldBeKilled;
+}
+
+bool DeckEQ::isBandKilled(Band band) const
+{
+    return bandKilled[(size_t) band];
+}
@@ -0,0 +1,79 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+// Isolator-style three-band EQ for a deck. Fourth order Linkwitz-Riley crossovers split the
+// signal into low, mid and high bands (the low band goes through the high crossover's allpass so
+// the bands sum back flat), then each band gets its own gain of up to +/-6 dB, or is killed.
+// Only the band gains move, and they are smoothed per sample; the crossover coefficients depend
+// on nothing but the sample rate, so they are worked out once in prepareToPlay. Both channels and
+// both sides of each crossover run together as four lanes of one SIMD biquad.
+class DeckEQ
+{
+public:
+    enum Band
+    {
+        low = 0,
+        mid,
+        high,
+        numBands
+    };
+
+    DeckEQ();
+
+    // Works out the crossovers and clears the filters (before audio starts)
+    void prepareToPlay(double sampleRate);
+
+    // EQs the first two channels in place, a mono buffer on its own (audio thread)
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    // -6 to +6 dB
+    void setBandGain(Band band, float decibels);
+    float getBandGain(Band band) const;
+
+    // A killed band is silent whatever its gain
+    void setBandKilled(Band band, bool shouldBeKilled);
+    bool isBandKilled(Band band) const;
+
+    static constexpr float MAX_GAIN_DB = 6.0f;
+    static constexpr double LOW_CROSSOVER_HZ = 250.0;
+    static constexpr double HIGH_CROSSOVER_HZ = 2500.0;
+    static constexpr double SMOOTHING_SECONDS = 0.02;
+
+private:
+    // One biquad per lane - lanes are {left, right, left, right} of two different filters
+    struct FourLaneBiquad
+    {
+        alignas(16) float b0[4], b1[4], b2[4], a1[4], a2[4];
+        alignas(16) float z1[4], z2[4];
+
+        void setLanes(int firstLane, double nb0, double nb1, double nb2, double na1, double na2);
+        void reset();
+    };
+
+    // low pass | high pass at the low crossover (two stages each), low pass | high pass at the
+    // high crossover (two stages each) and the high crossover's allpass for the low band
+    enum Stage
+    {
+        lowSplit1 = 0,
+        lowSplit2,
+        highSplit1,
+        highSplit2,
+        lowAllpass,
+        numStages
+    };
+
+    std::array<FourLaneBiquad, numStages> stages;
+
+    std::array<std::atomic<float>, numBands> bandGainDb{};
+    std::array<std::atomic<bool>, numBands> bandKilled{};
+    std::array<juce::SmoothedValue<float>, numBands> bandGain;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckEQ)
+};
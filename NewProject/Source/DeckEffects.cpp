@@ -0,0 +1,273 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "DeckEffects.h"
+
+double DeckEffect::Timing::getBeatSeconds() const
+{
+    double tempo = bpm > 0.0 ? juce::jmax(MIN_BPM, bpm) : FALLBACK_BPM;
+    return 60.0 / tempo;
+}
+
+//==============================================================================
+void FxDelayLine::prepare(int maxDelaySamples)
+{
+    // one extra sample so the longest delay can still interpolate
+    size = juce::jmax(2, maxDelaySamples + 2);
+    buffer.setSize(2, size);
+    clear();
+}
+
+void FxDelayLine::clear()
+{
+    buffer.clear();
+    writeIndex = 0;
+}
+
+float FxDelayLine::read(int channel, double delaySamples) const
+{
+    delaySamples = juce::jlimit(1.0, (double) (size - 2), delaySamples);
+
+    double readPosition = writeIndex - delaySamples;
+    if (readPosition < 0.0)
+        readPosition += size;
+
+    int index = (int) readPosition;
+    float fraction = (float) (readPosition - index);
+    int nextIndex = index + 1 == size ? 0 : index + 1;
+
+    auto* data = buffer.getReadPointer(channel);
+    return data[index] + fraction * (data[nextIndex] - data[index]);
+}
+
+void FxDelayLine::push(float left, float right)
+{
+    buffer.setSample(0, writeIndex, left);
+    buffer.setSample(1, writeIndex, right);
+
+    if (++writeIndex == size)
+        writeIndex = 0;
+}
+
+int FxDelayLine::getMaxDelay() const
+{
+    return size - 2;
+}
+
+//==============================================================================
+void FxOnePole::setCutoff(double frequency, double sampleRate)
+{
+    coefficient = (float) (1.0 - std::exp(-juce::MathConstants<double>::twoPi * frequency / sampleRate));
+}
+
+void FxOnePole::reset()
+{
+    state[0] = state[1] = 0.0f;
+}
+
+float FxOnePole::processLowPass(float x, int channel)
+{
+    state[channel] += coefficient * (x - state[channel]);
+    return state[channel];
+}
+
+float FxOnePole::processHighPass(float x, int channel)
+{
+    return x - processLowPass(x, channel);
+}
+
+//==============================================================================
+void EchoEffect::prepareToPlay(int, double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    line.prepare((int) std::ceil(MAX_DELAY_SECONDS * sampleRate));
+    lowCut.setCutoff(200.0, sampleRate);
+    highCut.setCutoff(3000.0, sampleRate);
+    glide = 1.0 - std::exp(-1.0 / (GLIDE_SECONDS * sampleRate));
+    reset();
+}
+
+void EchoEffect::reset()
+{
+    line.clear();
+    lowCut.reset();
+    highCut.reset();
+    currentDelay = 0.0;
+}
+
+void EchoEffect::process(const juce::AudioBuffer<float>& send, juce::AudioBuffer<float>& output,
+                         int numSamples, const Timing& timing)
+{
+    double targetDelay = BEATS * timing.getBeatSeconds() * sampleRate;
+
+    // a fresh echo starts at the right time instead of gliding up from nothing
+    if (currentDelay <= 0.0)
+        currentDelay = targetDelay;
+
+    auto* inLeft = send.getReadPointer(0);
+    auto* inRight = send.getReadPointer(1);
+    auto* outLeft = output.getWritePointer(0);
+    auto* outRight = output.getWritePointer(1);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        currentDelay += glide * (targetDelay - currentDelay);
+
+        float echoLeft = line.read(0, currentDelay);
+        float echoRight = line.read(1, currentDelay);
+
+        // the repeats get thinner each time round
+        float feedbackLeft = highCut.processLowPass(lowCut.processHighPass(echoLeft, 0), 0);
+        float feedbackRight = highCut.processLowPass(lowCut.processHighPass(echoRight, 1), 1);
+
+        line.push(inLeft[i] + FEEDBACK * feedbackLeft, inRight[i] + FEEDBACK * feedbackRight);
+
+        outLeft[i] = echoLeft;
+        outRight[i] = echoRight;
+    }
+}
+
+//==============================================================================
+void ReverbEffect::prepareToPlay(int, double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    // sizes the comb and allpass buffers for this sample rate
+    reverb.setSampleRate(sampleRate);
+
+    juce::Reverb::Parameters parameters;
+    parameters.roomSize = 0.82f;
+    parameters.damping = 0.45f;
+    parameters.wetLevel = 0.35f;
+    parameters.dryLevel = 0.0f;
+    parameters.width = 1.0f;
+    reverb.setParameters(parameters);
+
+    preDelay.prepare((int) std::ceil(MAX_DELAY_SECONDS * sampleRate));
+    lowCut.setCutoff(150.0, sampleRate);
+    reset();
+}
+
+void ReverbEffect::reset()
+{
+    reverb.reset();
+    preDelay.clear();
+    lowCut.reset();
+}
+
+void ReverbEffect::process(const juce::AudioBuffer<float>& send, juce::AudioBuffer<float>& output,
+                           int numSamples, const Timing& timing)
+{
+    double delay = PRE_DELAY_BEATS * timing.getBeatSeconds() * sampleRate;
+
+    auto* inLeft = send.getReadPointer(0);
+    auto* inRight = send.getReadPointer(1);
+    auto* outLeft = output.getWritePointer(0);
+    auto* outRight = output.getWritePointer(1);
+
+    // keeps the bass out of the tail so it doesn't muddy the next kick
+    for (int i = 0; i < numSamples; ++i)
+    {
+        preDelay.push(lowCut.processHighPass(inLeft[i], 0), lowCut.processHighPass(inRight[i], 1));
+        outLeft[i] = preDelay.read(0, delay);
+        outRight[i] = preDelay.read(1, delay);
+    }
+
+    reverb.processStereo(outLeft, outRight, numSamples);
+}
+
+//==============================================================================
+void FlangerEffect::prepareToPlay(int, double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    line.prepare((int) std::ceil(MAX_DELAY_MS * 0.001 * sampleRate) + 1);
+    reset();
+}
+
+void FlangerEffect::reset()
+{
+    line.clear();
+}
+
+void FlangerEffect::process(const juce::AudioBuffer<float>& send, juce::AudioBuffer<float>& output,
+                            int numSamples, const Timing& timing)
+{
+    // Locks to the beat grid while the deck plays, and keeps sweeping at the same rate when it stops
+    if (timing.isPlaying)
+        lfoBeats = timing.beatPosition;
+
+    double beatsPerSample = 1.0 / (timing.getBeatSeconds() * sampleRate);
+    double minDelay = MIN_DELAY_MS * 0.001 * sampleRate;
+    double depth = (MAX_DELAY_MS - MIN_DELAY_MS) * 0.001 * sampleRate;
+
+    auto* inLeft = send.getReadPointer(0);
+    auto* inRight = send.getReadPointer(1);
+    auto* outLeft = output.getWritePointer(0);
+    auto* outRight = output.getWritePointer(1);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        double phase = lfoBeats / SWEEP_BEATS;
+        phase -= std::floor(phase);
+
+        // the right side runs a quarter of a sweep ahead to widen the image
+        double sweepLeft = 0.5 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * phase);
+        double sweepRight = 0.5 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * (phase + 0.25));
+
+        float delayedLeft = line.read(0, minDelay + depth * sweepLeft);
+        float delayedRight = line.read(1, minDelay + depth * sweepRight);
+
+        line.push(inLeft[i] + FEEDBACK * delayedLeft, inRight[i] + FEEDBACK * delayedRight);
+
+        outLeft[i] = delayedLeft;
+        outRight[i] = delayedRight;
+
+        lfoBeats += beatsPerSample;
+    }
+}
+
+//==============================================================================
+void BeatDelayEffect::prepareToPlay(int, double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    line.prepare((int) std::ceil(MAX_DELAY_SECONDS * sampleRate));
+    glide = 1.0 - std::exp(-1.0 / (GLIDE_SECONDS * sampleRate));
+    reset();
+}
+
+void BeatDelayEffect::reset()
+{
+    line.clear();
+    currentDelay = 0.0;
+}
+
+void BeatDelayEffect::process(const juce::AudioBuffer<float>& send, juce::AudioBuffer<float>& output,
+                              int numSamples, const Timing& timing)
+{
+    double targetDelay = BEATS * timing.getBeatSeconds() * sampleRate;
+
+    if (currentDelay <= 0.0)
+        currentDelay = targetDelay;
+
+    auto* inLeft = send.getReadPointer(0);
+    auto* inRight = send.getReadPointer(1);
+    auto* outLeft = output.getWritePointer(0);
+    auto* outRight = output.getWritePointer(1);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        currentDelay += glide * (targetDelay - currentDelay);
+
+        float delayedLeft = line.read(0, currentDelay);
+        float delayedRight = line.read(1, currentDelay);
+
+        // the send goes in on the left, and each repeat crosses to the other side
+        float mono = 0.5f * (inLeft[i] + inRight[i]);
+        line.push(mono + FEEDBACK * delayedRight, FEEDBACK * delayedLeft);
+
+        outLeft[i] = delayedLeft;
+        outRight[i] = delayedRight;
+    }
+}
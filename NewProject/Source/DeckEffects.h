@@ -0,0 +1,167 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Send effects for the deck effects rack. Each effect takes the deck's send signal and writes
+// only its wet return, with delay times and modulation rates worked out from the deck's tempo
+// every block. Everything an effect needs is allocated in prepareToPlay, so process() is safe
+// on the audio thread and the deck render workers.
+class DeckEffect
+{
+public:
+    // Where the deck is in the music at the start of a block
+    struct Timing
+    {
+        double bpm{0.0};              // current tempo, 0 until the deck has been analysed
+        double beatPosition{0.0};     // beats since the first beat of the grid
+        bool isPlaying{false};
+
+        // Seconds per beat, at 120 BPM while the deck has no tempo yet
+        double getBeatSeconds() const;
+    };
+
+    virtual ~DeckEffect() = default;
+
+    // A string literal, so it can also name the effect's trace events
+    virtual const char* getName() const = 0;
+
+    // Allocates the delay lines for blocks of up to maxBlockSize samples (message thread)
+    virtual void prepareToPlay(int maxBlockSize, double sampleRate) = 0;
+
+    // Writes the wet return for numSamples of the stereo send into output
+    virtual void process(const juce::AudioBuffer<float>& send, juce::AudioBuffer<float>& output,
+                         int numSamples, const Timing& timing) = 0;
+
+    // Clears the delay lines so the next use starts silent
+    virtual void reset() = 0;
+
+    // Longest delay any effect needs - a whole beat at 40 BPM with room for modulation
+    static constexpr double MAX_DELAY_SECONDS = 2.0;
+    // Slowest tempo the delay times follow, so they always fit in the delay lines
+    static constexpr double MIN_BPM = 40.0;
+    static constexpr double FALLBACK_BPM = 120.0;
+};
+
+// Stereo delay line with a fractional read position, preallocated to a fixed length
+class FxDelayLine
+{
+public:
+    void prepare(int maxDelaySamples);
+    void clear();
+
+    // Delay of 1 is the sample pushed last
+    float read(int channel, double delaySamples) const;
+    void push(float left, float right);
+
+    int getMaxDelay() const;
+
+private:
+    juce::AudioBuffer<float> buffer;
+    int writeIndex{0};
+    int size{1};
+};
+
+// One-pole filter for shaping the feedback paths
+class FxOnePole
+{
+public:
+    void setCutoff(double frequency, double sampleRate);
+    void reset();
+
+    float processLowPass(float x, int channel);
+    float processHighPass(float x, int channel);
+
+private:
+    float coefficient{1.0f};
+    float state[2]{};
+};
+
+// Tape-style echo one beat behind the music. The repeats lose highs and lows as they feed
+// back, and the delay glides to a new tempo rather than jumping, like a tape machine
+class EchoEffect : public DeckEffect
+{
+public:
+    const char* getName() const override { return "echo"; }
+    void prepareToPlay(int maxBlockSize, double sampleRate) override;
+    void process(const juce::AudioBuffer<float>& send, juce::AudioBuffer<float>& output,
+                 int numSamples, const Timing& timing) override;
+    void reset() override;
+
+    static constexpr double BEATS = 1.0;
+    static constexpr float FEEDBACK = 0.6f;
+    static constexpr double GLIDE_SECONDS = 0.2;
+
+private:
+    FxDelayLine line;
+    FxOnePole lowCut, highCut;
+    double sampleRate{44100.0};
+    double currentDelay{0.0};
+    double glide{1.0};
+};
+
+// Plate-style reverb with a pre-delay of a sixteenth note, so the tail sits behind the beat
+class ReverbEffect : public DeckEffect
+{
+public:
+    const char* getName() const override { return "reverb"; }
+    void prepareToPlay(int maxBlockSize, double sampleRate) override;
+    void process(const juce::AudioBuffer<float>& send, juce::AudioBuffer<float>& output,
+                 int numSamples, const Timing& timing) override;
+    void reset() override;
+
+    static constexpr double PRE_DELAY_BEATS = 0.25;
+
+private:
+    juce::Reverb reverb;
+    FxDelayLine preDelay;
+    FxOnePole lowCut;
+    double sampleRate{44100.0};
+};
+
+// Flanger whose sweep takes eight beats and follows the deck's beat grid while it plays,
+// so the sweep lands in the same place every phrase
+class FlangerEffect : public DeckEffect
+{
+public:
+    const char* getName() const override { return "flanger"; }
+    void prepareToPlay(int maxBlockSize, double sampleRate) override;
+    void process(const juce::AudioBuffer<float>& send, juce::AudioBuffer<float>& output,
+                 int numSamples, const Timing& timing) override;
+    void reset() override;
+
+    static constexpr double SWEEP_BEATS = 8.0;
+    static constexpr double MIN_DELAY_MS = 0.5;
+    static constexpr double MAX_DELAY_MS = 5.0;
+    static constexpr float FEEDBACK = 0.6f;
+
+private:
+    FxDelayLine line;
+    double sampleRate{44100.0};
+    double lfoBeats{0.0};
+};
+
+// Clean ping-pong delay on the dotted eighth, bouncing between left and right
+class BeatDelayEffect : public DeckEffect
+{
+public:
+    const char* getName() const override { return "delay"; }
+    void prepareToPlay(int maxBlockSize, double sampleRate) override;
+    void process(const juce::AudioBuffer<float>& send, juce::AudioBuffer<float>& output,
+                 int numSamples, const Timing& timing) override;
+    void reset() override;
+
+    static constexpr double BEATS = 0.75;
+    static constexpr float FEEDBACK = 0.45f;
+    static constexpr double GLIDE_SECONDS = 0.05;
+
+private:
+    FxDelayLine line;
+    double sampleRate{44100.0};
+    double currentDelay{0.0};
+    double glide{1.0};
+};
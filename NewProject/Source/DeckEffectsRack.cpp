@@ -0,0 +1,154 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "DeckEffectsRack.h"
+#include "Tracing.h"
+
+DeckEffectsRack::DeckEffectsRack()
+{
+    effects[echo] = std::make_unique<EchoEffect>();
+    effects[reverb] = std::make_unique<ReverbEffect>();
+    effects[flanger] = std::make_unique<FlangerEffect>();
+    effects[delay] = std::make_unique<BeatDelayEffect>();
+
+    // the flanger is an insert-style sound so it comes back louder than the others
+    returnLevels[echo] = 0.5f;
+    returnLevels[reverb] = 0.5f;
+    returnLevels[flanger] = 0.8f;
+    returnLevels[delay] = 0.5f;
+}
+
+void DeckEffectsRack::prepareToPlay(int samplesPerBlockExpected, double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    for (auto& effect : effects)
+        effect->prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+    sendBuffer.setSize(2, samplesPerBlockExpected);
+    returnBuffer.setSize(2, samplesPerBlockExpected);
+    tailSamples = (int) (DeckEffect::MAX_DELAY_SECONDS * sampleRate);
+
+    for (int i = 0; i < numEffects; ++i)
+    {
+        sendGains[(size_t) i].reset(sampleRate, SEND_RAMP_SECONDS);
+        sendGains[(size_t) i].setCurrentAndTargetValue(0.0f);
+        running[(size_t) i] = false;
+        silentSamples[(size_t) i] = 0;
+        lastTicks[(size_t) i] = 0;
+    }
+}
+
+void DeckEffectsRack::process(juce::AudioBuffer<float>& buffer, int numSamples, const DeckEffect::Timing& timing)
+{
+    auto enabled = enabledEffects.load(std::memory_order_acquire);
+    int blockSize = sendBuffer.getNumSamples();
+
+    for (int i = 0; i < numEffects; ++i)
+    {
+        auto index = (size_t) i;
+        bool isEnabled = (enabled & (1u << i)) != 0;
+        lastTicks[index] = 0;
+
+        // bypassed and silent - costs nothing
+        if (! isEnabled && ! running[index])
+            continue;
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        auto& effect = *effects[index];
+        auto& sendGain = sendGains[index];
+        TRACE_SCOPE("audio", effect.getName());
+
+        running[index] = true;
+        sendGain.setTargetValue(isEnabled ? 1.0f : 0.0f);
+        float level = returnLevels[index].load(std::memory_order_relaxed);
+        float returnPeak = 0.0f;
+
+        // A block bigger than prepareToPlay promised is done in pieces rather than reallocating
+        for (int start = 0; start < numSamples; start += blockSize)
+        {
+            int num = juce::jmin(blockSize, numSamples - start);
+
+            auto chunkTiming = timing;
+            chunkTiming.beatPosition += start / (timing.getBeatSeconds() * sampleRate);
+
+            auto* inLeft = buffer.getReadPointer(0, start);
+            auto* inRight = buffer.getReadPointer(1, start);
+            auto* sendLeft = sendBuffer.getWritePointer(0);
+            auto* sendRight = sendBuffer.getWritePointer(1);
+
+            for (int sample = 0; sample < num; ++sample)
+            {
+                float gain = sendGain.getNextValue();
+                sendLeft[sample] = inLeft[sample] * gain;
+                sendRight[sample] = inRight[sample] * gain;
+            }
+
+            effect.process(sendBuffer, returnBuffer, num, chunkTiming);
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                buffer.addFrom(channel, start, returnBuffer, channel, 0, num, level);
+                returnPeak = juce::jmax(returnPeak, returnBuffer.getMagnitude(channel, 0, num));
+            }
+        }
+
+        // Once the send has faded out and the tail has been silent long enough, the effect goes idle
+        if (! isEnabled && ! sendGain.isSmoothing())
+        {
+            silentSamples[index] = returnPeak < TAIL_SILENCE ? silentSamples[index] + numSamples : 0;
+
+            if (silentSamples[index] >= tailSamples)
+            {
+                effect.reset();
+                running[index] = false;
+                silentSamples[index] = 0;
+            }
+        }
+        else
+        {
+            silentSamples[index] = 0;
+        }
+
+        lastTicks[index] = juce::Time::getHighResolutionTicks() - startTicks;
+    }
+}
+
+void DeckEffectsRack::setEffectEnabled(Effect effect, bool shouldBeEnabled)
+{
+    auto bit = 1u << (unsigned) effect;
+
+    if (shouldBeEnabled)
+        enabledEffects.fetch_or(bit, std::memory_order_release);
+    else
+        enabledEffects.fetch_and(~bit, std::memory_order_release);
+}
+
+bool DeckEffectsRack::isEffectEnabled(Effect effect) const
+{
+    return (enabledEffects.load(std::memory_order_acquire) & (1u << (unsigned) effect)) != 0;
+}
+
+void DeckEffectsRack::setEffectLevel(Effect effect, float level)
+{
+    returnLevels[(size_t) effect].store(juce::jlimit(0.0f, 1.0f, level), std::memory_order_relaxed);
+}
+
+juce::int64 DeckEffectsRack::getLastEffectTicks(Effect effect) const
+{
+    return lastTicks[(size_t) effect];
+}
+
+const char* DeckEffectsRack::getEffectName(Effect effect)
+{
+    switch (effect)
+    {
+        case echo:    return "echo";
+        case reverb:  return "reverb";
+        case flanger: return "flanger";
+        case delay:   return "delay";
+        default:      return "";
+    }
+}
@@ -0,0 +1,64 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include "DeckEffects.h"
+
+// One deck's send effects. Every effect is created and prepared up front, and the GUI switches
+// them by flipping bits in one atomic mask that the render thread reads once per block - so
+// inserting or bypassing an effect never allocates or takes a lock on the audio side. Sends fade
+// in and out, and a bypassed effect keeps running until its tail has died away, then costs nothing.
+class DeckEffectsRack
+{
+public:
+    enum Effect { echo = 0, reverb, flanger, delay, numEffects };
+
+    DeckEffectsRack();
+
+    // Prepares every effect, enabled or not, so switching one on is free (message thread)
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+
+    // Adds the effect returns to the deck's output (audio thread or a deck render worker)
+    void process(juce::AudioBuffer<float>& buffer, int numSamples, const DeckEffect::Timing& timing);
+
+    // Any thread - takes effect at the next block
+    void setEffectEnabled(Effect effect, bool shouldBeEnabled);
+    bool isEffectEnabled(Effect effect) const;
+
+    // How loud the effect's return is mixed in, 0 to 1
+    void setEffectLevel(Effect effect, float level);
+
+    // Time the effect took in the last block, for the callback monitor - read on the audio
+    // thread once the deck has finished rendering
+    juce::int64 getLastEffectTicks(Effect effect) const;
+
+    static const char* getEffectName(Effect effect);
+
+    // Send fades when an effect is switched
+    static constexpr double SEND_RAMP_SECONDS = 0.01;
+    // A bypassed effect is dropped once its return has been below this for MAX_DELAY_SECONDS
+    static constexpr float TAIL_SILENCE = 1.0e-4f;
+
+private:
+    std::array<std::unique_ptr<DeckEffect>, numEffects> effects;
+
+    // bit n set = effect n switched on
+    std::atomic<juce::uint32> enabledEffects{0};
+    std::array<std::atomic<float>, numEffects> returnLevels;
+
+    // render thread only
+    std::array<juce::SmoothedValue<float>, numEffects> sendGains;
+    std::array<bool, numEffects> running{};
+    std::array<int, numEffects> silentSamples{};
+    std::array<juce::int64, numEffects> lastTicks{};
+    juce::AudioBuffer<float> sendBuffer, returnBuffer;
+    double sampleRate{44100.0};
+    int tailSamples{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckEffectsRack)
+};
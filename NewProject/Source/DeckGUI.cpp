@@ -7,14 +7,35 @@
 #include "DeckGUI.h"
 #include "PlaylistComponent.h"
 
-DeckGUI::DeckGUI(DJAudioPlayer* _player, 
+namespace
+{
+    // Where the button is in one of the deck's rows of buttons, or -1 if it isn't one of them
+    template <typename Buttons>
+    int findButton(const Buttons& buttons, const juce::Button* button)
+    {
+        for (size_t i = 0; i < buttons.size(); ++i)
+            if (&buttons[i] == button)
+                return static_cast<int>(i);
+
+        return -1;
+    }
+}
+
+DeckGUI::DeckGUI(int _deckNumber,
+                  DJAudioPlayer* _player, 
                   juce::AudioFormatManager & formatManagerToUse,
                   juce::AudioThumbnailCache & thumbnailCacheToUse)
-                  : player(_player), waveformDisplay(formatManagerToUse, thumbnailCacheToUse)
+                  : deckNumber(_deckNumber), player(_player), waveformDisplay(formatManagerToUse, thumbnailCacheToUse)
 {
     addAndMakeVisible(playButton);
     addAndMakeVisible(stopButton);
     addAndMakeVisible(loadButton);
+    addAndMakeVisible(syncButton);
+    addAndMakeVisible(keyLockButton);
+    addAndMakeVisible(autoGainButton);
+    addAndMakeVisible(downbeatButton);
+    addAndMakeVisible(scratchButton);
+    addAndMakeVisible(cueButton);
     addAndMakeVisible(volSlider);
     addAndMakeVisible(volLabel);
     addAndMakeVisible(speedSlider);
@@ -26,13 +47,17 @@ DeckGUI::DeckGUI(DJAudioPlayer* _player,
      // Adds BPM display
     addAndMakeVisible(bpmLabel); 
     addAndMakeVisible(waveformDisplay);
+    addAndMakeVisible(levelMeter);
     
     // Sets up waveform interaction callback
     waveformDisplay.onPositionChange = [this](double position) {
         if (player != nullptr) {
-            player->setPositionRelative(position);
+            player->sendCommand(TransportCommand::Type::seek, position * player->getLengthInSeconds());
         }
     };
+    waveformDisplay.onScratchStart = [this] { player->startScratch(); };
+    waveformDisplay.onScratchMove = [this](double seconds) { player->scratchBy(seconds); };
+    waveformDisplay.onScratchEnd = [this] { player->stopScratch(); };
 
     volLabel.setText("Volume", juce::dontSendNotification);
     volLabel.setJustificationType(juce::Justification::centredLeft);
@@ -78,6 +103,12 @@ posLabel.setText("Position", juce::dontSendNotification);
     playButton.addListener(this);
     stopButton.addListener(this);
     loadButton.addListener(this);
+    syncButton.addListener(this);
+    keyLockButton.addListener(this);
+    autoGainButton.addListener(this);
+    downbeatButton.addListener(this);
+    scratchButton.addListener(this);
+    cueButton.addListener(this);
     volSlider.addListener(this);
     speedSlider.addListener(this);
     posSlider.addListener(this);
@@ -86,6 +117,82 @@ posLabel.setText("Position", juce::dontSendNotification);
     styleButton(playButton, juce::Colour::fromRGB(46, 213, 115)); // Green
     styleButton(stopButton, juce::Colour::fromRGB(255, 107, 107)); // coral
     styleButton(loadButton, juce::Colour::fromRGB(116, 185, 255)); // Blue
+    styleButton(syncButton, juce::Colour::fromRGB(255, 159, 67)); // Orange
+    
+    styleButton(keyLockButton, juce::Colour::fromRGB(85, 239, 196)); // Mint
+    styleButton(autoGainButton, juce::Colour::fromRGB(116, 185, 255)); // Blue
+    styleButton(downbeatButton, juce::Colour::fromRGB(46, 213, 115)); // Green
+    styleButton(scratchButton, juce::Colour::fromRGB(255, 107, 107)); // coral
+    styleButton(cueButton, juce::Colour::fromRGB(253, 203, 110)); // Yellow
+    
+    // sync stays lit while the deck is following the other deck
+    syncButton.setClickingTogglesState(true);
+    // key lock stays lit while speed changes keep the original pitch
+    keyLockButton.setClickingTogglesState(true);
+    // scratch stays lit while dragging the waveform scratches
+    scratchButton.setClickingTogglesState(true);
+    // cue stays lit while the deck is in the headphones
+    cueButton.setClickingTogglesState(true);
+    // auto-gain stays lit while tracks are levelled to the loudness target
+    autoGainButton.setClickingTogglesState(true);
+    autoGainButton.setToggleState(player->isAutoGainEnabled(), juce::dontSendNotification);
+    
+    // EQ - a small vertical slider per band over a kill switch, which stays lit while the band is cut
+    const char* bandNames[] = { "L", "M", "H" };
+    for (int band = 0; band < DeckEQ::numBands; ++band)
+    {
+        auto& eqSlider = eqSliders[(size_t) band];
+        eqSlider.setSliderStyle(juce::Slider::LinearVertical);
+        eqSlider.setRange(-DeckEQ::MAX_GAIN_DB, DeckEQ::MAX_GAIN_DB, 0.1);
+        eqSlider.setValue(0.0);
+        eqSlider.setDoubleClickReturnValue(true, 0.0);
+        eqSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+        eqSlider.addListener(this);
+        styleSlider(eqSlider, juce::Colour::fromRGB(64, 224, 208));
+        addAndMakeVisible(eqSlider);
+        
+        auto& killButton = eqKillButtons[(size_t) band];
+        killButton.setButtonText(bandNames[band]);
+        killButton.setClickingTogglesState(true);
+        killButton.addListener(this);
+        styleButton(killButton, juce::Colour::fromRGB(255, 107, 107)); // coral
+        addAndMakeVisible(killButton);
+    }
+    
+    // Loops - LOOP is lit from the player in the timer, like the hot cues
+    for (auto* loopButton : { &loopInButton, &loopOutButton, &loopHalveButton, &loopDoubleButton, &autoLoopButton, &loopRollButton,
+                              &reverseButton, &censorButton })
+    {
+        loopButton->addListener(this);
+        styleButton(*loopButton, juce::Colour::fromRGB(85, 239, 196)); // Mint
+        addAndMakeVisible(loopButton);
+    }
+    loopLengthLabel.setJustificationType(juce::Justification::centred);
+    loopLengthLabel.setColour(juce::Label::textColourId, juce::Colours::white);
+    addAndMakeVisible(loopLengthLabel);
+    updateLoopLengthLabel();
+    
+    // Hot cues - lit from the player in the timer, so a load clears them
+    for (int cue = 0; cue < HotCueSource::NUM_CUES; ++cue)
+    {
+        auto& hotCueButton = hotCueButtons[(size_t) cue];
+        hotCueButton.setButtonText(juce::String(cue + 1));
+        hotCueButton.addListener(this);
+        styleButton(hotCueButton, juce::Colour::fromRGB(254, 202, 87)); // Yellow
+        addAndMakeVisible(hotCueButton);
+    }
+    
+    // FX - disabled until the mixer hands over the deck's rack
+    for (int effect = 0; effect < DeckEffectsRack::numEffects; ++effect)
+    {
+        auto& fxButton = fxButtons[(size_t) effect];
+        fxButton.setButtonText(juce::String(DeckEffectsRack::getEffectName(static_cast<DeckEffectsRack::Effect>(effect))).toUpperCase());
+        fxButton.setClickingTogglesState(true);
+        fxButton.setEnabled(false);
+        fxButton.addListener(this);
+        styleButton(fxButton, juce::Colour::fromRGB(162, 155, 254)); // Lavender
+        addAndMakeVisible(fxButton);
+    }
     
     // Style the sliders with coordinated colors
     styleSlider(volSlider, juce::Colour::fromRGB(116, 185, 255));  // Blue
@@ -134,7 +241,7 @@ void DeckGUI::paint (juce::Graphics& g)
     // Deck label
     g.setColour(juce::Colour::fromRGB(220, 220, 225));
     g.setFont(juce::Font(12.0f, juce::Font::bold));
-    g.drawText("DECK", getLocalBounds().removeFromTop(22).reduced(8, 3), 
+    g.drawText("DECK " + juce::String(deckNumber), getLocalBounds().removeFromTop(22).reduced(8, 3), 
                juce::Justification::topLeft, true);
 }
 
@@ -145,12 +252,14 @@ void DeckGUI::resized()
     
     // Top row - buttons (fixed height for consistency)
     auto buttonArea = area.removeFromTop(50);
-    int buttonWidth = (buttonArea.getWidth() - 20) / 3; 
+    int buttonWidth = (buttonArea.getWidth() - 30) / 4; 
     playButton.setBounds(buttonArea.removeFromLeft(buttonWidth));
     buttonArea.removeFromLeft(10);
     stopButton.setBounds(buttonArea.removeFromLeft(buttonWidth));
     buttonArea.removeFromLeft(10);
     loadButton.setBounds(buttonArea.removeFromLeft(buttonWidth));
+    buttonArea.removeFromLeft(10);
+    syncButton.setBounds(buttonArea.removeFromLeft(buttonWidth));
     
     area.removeFromTop(8); // spacing after buttons
 
@@ -170,7 +279,48 @@ void DeckGUI::resized()
     auto waveformArea = area.removeFromBottom(120); 
     waveformDisplay.setBounds(waveformArea);
     
-    area.removeFromBottom(8); // gap between controls and waveform
+    area.removeFromBottom(6); // gap between the FX row and waveform
+    
+    // FX row just above the waveform
+    auto fxArea = area.removeFromBottom(22);
+    int fxButtonWidth = fxArea.getWidth() / DeckEffectsRack::numEffects;
+    for (auto& fxButton : fxButtons)
+        fxButton.setBounds(fxArea.removeFromLeft(fxButtonWidth).reduced(2, 0));
+    
+    area.removeFromBottom(6); // gap between the hot cue row and FX row
+    
+    // Hot cue row above the FX
+    auto hotCueArea = area.removeFromBottom(22);
+    int hotCueButtonWidth = hotCueArea.getWidth() / HotCueSource::NUM_CUES;
+    for (auto& hotCueButton : hotCueButtons)
+        hotCueButton.setBounds(hotCueArea.removeFromLeft(hotCueButtonWidth).reduced(2, 0));
+    
+    area.removeFromBottom(6); // gap between the loop row and hot cue row
+    
+    // Loop row above the hot cues, with reverse and censor at the end
+    auto loopArea = area.removeFromBottom(22);
+    int loopItemWidth = loopArea.getWidth() / 9;
+    for (juce::Component* loopItem : std::initializer_list<juce::Component*>{ &loopInButton, &loopOutButton, &loopHalveButton, &loopLengthLabel,
+                                                                              &loopDoubleButton, &autoLoopButton, &loopRollButton,
+                                                                              &reverseButton, &censorButton })
+        loopItem->setBounds(loopArea.removeFromLeft(loopItemWidth).reduced(2, 0));
+    
+    area.removeFromBottom(6); // gap between controls and loop row
+
+    // Level meter beside the controls
+    levelMeter.setBounds(area.removeFromRight(30));
+    area.removeFromRight(5);
+    
+    // EQ columns between the controls and the meter
+    auto eqArea = area.removeFromRight(84);
+    area.removeFromRight(5);
+    int eqColumnWidth = eqArea.getWidth() / DeckEQ::numBands;
+    for (int band = 0; band < DeckEQ::numBands; ++band)
+    {
+        auto column = eqArea.removeFromLeft(eqColumnWidth);
+        eqKillButtons[(size_t) band].setBounds(column.removeFromBottom(20).reduced(2, 0));
+        eqSliders[(size_t) band].setBounds(column.reduced(2, 2));
+    }
     
     // Control section - inline labels with sliders
     int controlHeight = area.getHeight() / 3; 
@@ -178,28 +328,86 @@ void DeckGUI::resized()
     // Volume control row
     auto volArea = area.removeFromTop(controlHeight);
     volLabel.setBounds(volArea.removeFromLeft(60)); 
+    autoGainButton.setBounds(volArea.removeFromRight(45).reduced(2, 6));
     volSlider.setBounds(volArea.reduced(5, 8)); 
     
     // Speed control row  
     auto speedArea = area.removeFromTop(controlHeight);
     speedLabel.setBounds(speedArea.removeFromLeft(60));
+    keyLockButton.setBounds(speedArea.removeFromRight(45).reduced(2, 6));
+    cueButton.setBounds(speedArea.removeFromRight(45).reduced(2, 6));
     speedSlider.setBounds(speedArea.reduced(5, 8)); 
     
     // Position control row
     auto posArea = area.removeFromTop(controlHeight);
     posLabel.setBounds(posArea.removeFromLeft(60)); 
+    scratchButton.setBounds(posArea.removeFromRight(45).reduced(2, 6));
+    downbeatButton.setBounds(posArea.removeFromRight(45).reduced(2, 6));
     posSlider.setBounds(posArea.reduced(5, 8)); 
 }
 
+void DeckGUI::setLevelMeter(const LevelMeter* meter)
+{
+    levelMeter.setMeter(meter);
+}
+
+void DeckGUI::setEffectsRack(DeckEffectsRack* rack)
+{
+    effectsRack = rack;
+    
+    for (int effect = 0; effect < DeckEffectsRack::numEffects; ++effect)
+    {
+        auto& fxButton = fxButtons[(size_t) effect];
+        fxButton.setEnabled(effectsRack != nullptr);
+        fxButton.setToggleState(effectsRack != nullptr && effectsRack->isEffectEnabled(static_cast<DeckEffectsRack::Effect>(effect)),
+                                juce::dontSendNotification);
+    }
+}
+
 void DeckGUI::buttonClicked(juce::Button* button)
 {
+    // the rows of buttons are looked up first, so each row is one branch below
+    int eqBand = findButton(eqKillButtons, button);
+    int cue = findButton(hotCueButtons, button);
+    int effect = findButton(fxButtons, button);
+    
     if (button == &playButton)
     {
-        player->start();
+        player->sendCommand(TransportCommand::Type::play);
     }
     else if (button == &stopButton)
     {
-        player->stop();
+        player->sendCommand(TransportCommand::Type::stop);
+    }
+    else if (button == &keyLockButton)
+    {
+        player->setKeyLock(keyLockButton.getToggleState());
+    }
+    else if (button == &autoGainButton)
+    {
+        player->setAutoGainEnabled(autoGainButton.getToggleState());
+    }
+    else if (button == &syncButton)
+    {
+        if (onSyncToggled)
+            onSyncToggled(syncButton.getToggleState());
+    }
+    else if (button == &cueButton)
+    {
+        if (onCueToggled)
+            onCueToggled(cueButton.getToggleState());
+    }
+    else if (button == &downbeatButton)
+    {
+        if (onPlayOnDownbeat)
+            onPlayOnDownbeat();
+    }
+    else if (button == &scratchButton)
+    {
+        // a record held when scratching is switched off is let go
+        waveformDisplay.setScratchMode(scratchButton.getToggleState());
+        if (! scratchButton.getToggleState())
+            player->stopScratch();
     }
     else if (button == &loadButton)
     {
@@ -222,6 +430,68 @@ void DeckGUI::buttonClicked(juce::Button* button)
                                     }
                                 });
     }
+    else if (eqBand >= 0)
+    {
+        player->setEQKill(static_cast<DeckEQ::Band>(eqBand), button->getToggleState());
+    }
+    else if (button == &loopInButton)
+    {
+        player->sendCommand(TransportCommand::Type::loopIn);
+    }
+    else if (button == &loopOutButton)
+    {
+        player->sendCommand(TransportCommand::Type::loopOut);
+    }
+    else if (button == &autoLoopButton)
+    {
+        player->sendCommand(player->isLoopActive() ? TransportCommand::Type::loopExit : TransportCommand::Type::autoLoop, loopBeats);
+    }
+    else if (button == &reverseButton)
+    {
+        player->sendCommand(TransportCommand::Type::reverse, player->isReversed() ? 0.0 : 1.0);
+    }
+    else if (button == &loopHalveButton || button == &loopDoubleButton)
+    {
+        loopBeats = juce::jlimit(DJAudioPlayer::MIN_LOOP_BEATS, DJAudioPlayer::MAX_LOOP_BEATS,
+                                 button == &loopHalveButton ? loopBeats / 2.0 : loopBeats * 2.0);
+        updateLoopLengthLabel();
+    }
+    else if (cue >= 0)
+    {
+        if (juce::ModifierKeys::currentModifiers.isShiftDown())
+            player->clearHotCue(cue);
+        else if (player->hasHotCue(cue))
+            player->sendCommand(TransportCommand::Type::hotCue, cue);
+        else
+            player->setHotCue(cue, player->getPositionInSeconds());
+    }
+    else if (effect >= 0)
+    {
+        if (effectsRack != nullptr)
+            effectsRack->setEffectEnabled(static_cast<DeckEffectsRack::Effect>(effect), button->getToggleState());
+    }
+}
+
+void DeckGUI::buttonStateChanged(juce::Button* button)
+{
+    if (button == &loopRollButton && loopRollButton.isDown() != rollHeld)
+    {
+        rollHeld = loopRollButton.isDown();
+        player->sendCommand(rollHeld ? TransportCommand::Type::loopRoll : TransportCommand::Type::loopExit, loopBeats);
+    }
+    else if (button == &censorButton && censorButton.isDown() != censorHeld)
+    {
+        censorHeld = censorButton.isDown();
+        player->sendCommand(TransportCommand::Type::censor, censorHeld ? 1.0 : 0.0);
+    }
+}
+
+void DeckGUI::updateLoopLengthLabel()
+{
+    // whole beats, or a fraction of one
+    juce::String text = loopBeats >= 1.0 ? juce::String(juce::roundToInt(loopBeats))
+                                         : "1/" + juce::String(juce::roundToInt(1.0 / loopBeats));
+    loopLengthLabel.setText(text, juce::dontSendNotification);
 }
 
 void DeckGUI::sliderValueChanged(juce::Slider* slider)
@@ -232,11 +502,17 @@ void DeckGUI::sliderValueChanged(juce::Slider* slider)
     }
     else if (slider == &speedSlider)
     {
-        player->setSpeed(slider->getValue());
+        player->sendCommand(TransportCommand::Type::speed, slider->getValue());
     }
     else if (slider == &posSlider)
     {
-        player->setPositionRelative(slider->getValue());
+        player->sendCommand(TransportCommand::Type::seek, slider->getValue() * player->getLengthInSeconds());
+    }
+    
+    for (int band = 0; band < DeckEQ::numBands; ++band)
+    {
+        if (slider == &eqSliders[(size_t) band])
+            player->setEQGain(static_cast<DeckEQ::Band>(band), slider->getValue());
     }
 }
 
@@ -266,6 +542,25 @@ void DeckGUI::sliderValueChanged(juce::Slider* slider)
   {
     waveformDisplay.setPositionRelative(player->getPositionRelative());
     
+    for (int cue = 0; cue < HotCueSource::NUM_CUES; ++cue)
+        hotCueButtons[(size_t) cue].setToggleState(player->hasHotCue(cue), juce::dontSendNotification);
+    autoLoopButton.setToggleState(player->isLoopActive() && ! player->isLoopRolling(), juce::dontSendNotification);
+    loopRollButton.setToggleState(player->isLoopRolling(), juce::dontSendNotification);
+    reverseButton.setToggleState(player->isReversed(), juce::dontSendNotification);
+    censorButton.setToggleState(player->isCensoring(), juce::dontSendNotification);
+    
+    // The speed can also change from sync or a track load, so the slider follows it unless being dragged
+    if (! speedSlider.isMouseButtonDown())
+        speedSlider.setValue(player->getCurrentSpeed(), juce::dontSendNotification);
+    
+    // The gain auto-gain is applying follows the BPM once the track's loudness is measured
+    juce::String autoGainText;
+    if (player->isAutoGainEnabled() && player->isLoudnessAnalysisComplete())
+    {
+        double autoGainDb = player->getAutoGainDecibels();
+        autoGainText = "  |  " + juce::String(autoGainDb > 0.0 ? "+" : "") + juce::String(autoGainDb, 1) + " dB";
+    }
+    
     // Update BPM display
     if (player->isBPMAnalysisComplete())
     {
@@ -282,18 +577,18 @@ void DeckGUI::sliderValueChanged(juce::Slider* slider)
                 if (speedRatio > 1.0)
                     speedPercent = "+" + speedPercent;
                 
-                bpmLabel.setText("BPM: " + juce::String(currentBPM, 1) + " (" + speedPercent + "%)", 
+                bpmLabel.setText("BPM: " + juce::String(currentBPM, 1) + " (" + speedPercent + "%)" + autoGainText, 
                                 juce::dontSendNotification);
             }
             else
             {
                 // Normal speed, just show BPM
-                bpmLabel.setText("BPM: " + juce::String(currentBPM, 1), juce::dontSendNotification);
+                bpmLabel.setText("BPM: " + juce::String(currentBPM, 1) + autoGainText, juce::dontSendNotification);
             }
         }
         else
         {
-            bpmLabel.setText("BPM: ---", juce::dontSendNotification);
+            bpmLabel.setText("BPM: ---" + autoGainText, juce::dontSendNotification);
         }
     }
     else
@@ -8,6 +8,8 @@
 #include <JuceHeader.h>
 #include "DJAudioPlayer.h"
 #include "WaveformDisplay.h"
+#include "LevelMeterComponent.h"
+#include "DeckEffectsRack.h"
 
 class DeckGUI  : public juce::Component,
                 public juce::Button::Listener,
@@ -16,7 +18,7 @@ class DeckGUI  : public juce::Component,
                 public juce::Timer
 {
 public:
-    DeckGUI(DJAudioPlayer* player, juce::AudioFormatManager& formatManagerToUse, juce::AudioThumbnailCache& thumbnailCacheToUse);
+    DeckGUI(int deckNumber, DJAudioPlayer* player, juce::AudioFormatManager& formatManagerToUse, juce::AudioThumbnailCache& thumbnailCacheToUse);
     ~DeckGUI() override;
 
     void paint (juce::Graphics&) override;
@@ -24,6 +26,8 @@ public:
     
     // Implement Button::Listener
     void buttonClicked(juce::Button* button) override;
+    // ROLL and CEN only act while they are held down
+    void buttonStateChanged(juce::Button* button) override;
     
     // Implement Slider::Listener
     void sliderValueChanged(juce::Slider* slider) override;
@@ -36,6 +40,19 @@ public:
     
     // Method to load track from external source (like playlist)
     void loadTrack(const juce::File& audioFile);
+    
+    // Callback for when the SYNC button is toggled
+    std::function<void(bool)> onSyncToggled;
+    // Callback for the BAR button, which starts the deck on the other deck's next downbeat
+    std::function<void()> onPlayOnDownbeat;
+    // Callback for when the CUE button puts the deck in the headphone cue or takes it out
+    std::function<void(bool)> onCueToggled;
+
+    // Shows the deck's level meter beside its controls
+    void setLevelMeter(const LevelMeter* meter);
+
+    // Connects the FX buttons to the deck's effects rack in the mixer
+    void setEffectsRack(DeckEffectsRack* rack);
 
 private:
 
@@ -57,11 +74,51 @@ private:
     juce::TextButton playButton{"PLAY"};
     juce::TextButton stopButton{"STOP"};
     juce::TextButton loadButton{"LOAD"};
+    juce::TextButton syncButton{"SYNC"};
+    juce::TextButton keyLockButton{"KEY"};
+    juce::TextButton autoGainButton{"AUTO"};
+    juce::TextButton downbeatButton{"BAR"};
+    // Switches the waveform from seeking to scratching
+    juce::TextButton scratchButton{"SCR"};
+    // Sends the deck to the headphone cue
+    juce::TextButton cueButton{"CUE"};
+    
+    // EQ gain and kill switch for each band, low to high
+    std::array<juce::Slider, DeckEQ::numBands> eqSliders;
+    std::array<juce::TextButton, DeckEQ::numBands> eqKillButtons;
+    
+    // Loops - IN and OUT set a manual loop, LOOP starts or ends an auto-loop of the length shown,
+    // which - and + halve and double, and holding ROLL rolls that length
+    void updateLoopLengthLabel();
+    juce::TextButton loopInButton{"IN"};
+    juce::TextButton loopOutButton{"OUT"};
+    juce::TextButton loopHalveButton{"-"};
+    juce::TextButton loopDoubleButton{"+"};
+    juce::Label loopLengthLabel;
+    juce::TextButton autoLoopButton{"LOOP"};
+    juce::TextButton loopRollButton{"ROLL"};
+    double loopBeats{4.0};
+    bool rollHeld{false};
+    
+    // REV switches reverse play, lit from the player, and holding CEN censors
+    juce::TextButton reverseButton{"REV"};
+    juce::TextButton censorButton{"CEN"};
+    bool censorHeld{false};
+
+    // One pad per hot cue, lit while the cue is set - click sets an empty cue or jumps to a set one,
+    // shift-click clears it
+    std::array<juce::TextButton, HotCueSource::NUM_CUES> hotCueButtons;
+
+    // One switch per send effect, lit while the effect is on
+    std::array<juce::TextButton, DeckEffectsRack::numEffects> fxButtons;
+    DeckEffectsRack* effectsRack{nullptr};
     
+    int deckNumber;
     DJAudioPlayer* player;
     std::unique_ptr<juce::FileChooser> fileChooser;
 
     WaveformDisplay waveformDisplay;
+    LevelMeterComponent levelMeter;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeckGUI)
 };
\ No newline at end of file
@@ -0,0 +1,167 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "DeckRenderPool.h"
+
+#if JUCE_USE_SSE_INTRINSICS
+ #include <xmmintrin.h>
+#endif
+
+class DeckRenderPool::Worker : public juce::Thread
+{
+public:
+    Worker(DeckRenderPool& ownerPool, int index)
+        : juce::Thread("Deck render " + juce::String(index + 1)), owner(ownerPool)
+    {
+    }
+
+    ~Worker() override
+    {
+        stopThread(1000);
+    }
+
+    // Wakes the worker if it has gone to sleep (audio thread)
+    void wakeIfSleeping()
+    {
+        if (sleeping.load())
+            blockReady.signal();
+    }
+
+    void wake()
+    {
+        blockReady.signal();
+    }
+
+    void run() override
+    {
+        auto seenGeneration = owner.blockGeneration.load(std::memory_order_acquire);
+
+        while (! threadShouldExit())
+        {
+            auto spinEnd = juce::Time::getHighResolutionTicks() + owner.spinTicks;
+
+            while (owner.blockGeneration.load(std::memory_order_acquire) == seenGeneration
+                   && juce::Time::getHighResolutionTicks() < spinEnd && ! threadShouldExit())
+                DeckRenderPool::pause();
+
+            if (owner.blockGeneration.load(std::memory_order_acquire) == seenGeneration)
+            {
+                // Announced before looking at the generation once more - a block that starts
+                // after that look sees the flag and signals. The timeout only matters when stopping
+                sleeping = true;
+
+                if (owner.blockGeneration.load() == seenGeneration)
+                    blockReady.wait(100);
+
+                sleeping = false;
+                continue;
+            }
+
+            seenGeneration = owner.blockGeneration.load(std::memory_order_acquire);
+            owner.processJobs();
+        }
+    }
+
+private:
+    DeckRenderPool& owner;
+    juce::WaitableEvent blockReady;
+    std::atomic<bool> sleeping{false};
+};
+
+DeckRenderPool::DeckRenderPool(std::function<void(int)> renderJob)
+    : job(std::move(renderJob))
+{
+}
+
+DeckRenderPool::~DeckRenderPool()
+{
+    stop();
+}
+
+void DeckRenderPool::start(int numWorkers, int samplesPerBlockExpected, double sampleRate)
+{
+    stop();
+
+    auto options = juce::Thread::RealtimeOptions{}.withApproximateAudioProcessingTime(samplesPerBlockExpected, sampleRate);
+    spinTicks = juce::Time::secondsToHighResolutionTicks(SPIN_BLOCKS * samplesPerBlockExpected / sampleRate);
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto worker = std::make_unique<Worker>(*this, i);
+
+        if (! worker->startRealtimeThread(options))
+        {
+            juce::Logger::writeToLog("Deck render: real-time priority refused, " + juce::String(numWorkers - i) + " of "
+                                     + juce::String(numWorkers) + " workers not started - their decks render on the audio thread");
+            break;
+        }
+
+        workers.add(worker.release());
+    }
+}
+
+void DeckRenderPool::stop()
+{
+    for (auto* worker : workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->wake();
+    }
+
+    workers.clear();
+}
+
+int DeckRenderPool::getNumWorkers() const
+{
+    return workers.size();
+}
+
+void DeckRenderPool::run(int numJobs)
+{
+    if (workers.isEmpty() || numJobs < 2)
+    {
+        for (int i = 0; i < numJobs; ++i)
+            job(i);
+        return;
+    }
+
+    jobsRemaining = numJobs;
+    numJobsInBlock = numJobs;
+    nextJob = 0;
+
+    // Spinning workers pick the block up from the generation - only a sleeping one is signalled
+    blockGeneration.fetch_add(1);
+
+    for (auto* worker : workers)
+        worker->wakeIfSleeping();
+
+    processJobs();
+
+    // The remaining decks are already being rendered, so this wait is at most one deck long
+    while (jobsRemaining.load(std::memory_order_acquire) > 0)
+        pause();
+}
+
+void DeckRenderPool::pause()
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    _mm_pause();
+   #elif JUCE_ARM && (defined (__aarch64__) || defined (__arm__))
+    __asm__ __volatile__ ("yield");
+   #endif
+}
+
+void DeckRenderPool::processJobs()
+{
+    for (;;)
+    {
+        int index = nextJob.fetch_add(1, std::memory_order_acq_rel);
+        if (index >= numJobsInBlock.load(std::memory_order_acquire))
+            break;
+
+        job(index);
+        jobsRemaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
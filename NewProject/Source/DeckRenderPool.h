@@ -0,0 +1,63 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Renders the decks of one audio block in parallel. A few real-time worker threads start on each
+// block and take decks from a shared counter, while the audio thread renders decks too and then
+// waits for the rest, so every deck is finished when run() returns. Only decks a worker has
+// already taken are waited for, so the wait is never longer than one deck.
+//
+// A block starts by moving on a generation counter the workers spin on, so while audio is running
+// the audio thread never makes a system call to wake them. A worker that has seen no block for
+// SPIN_BLOCKS block lengths goes to sleep on an event instead, and the next block signals it.
+// A worker the system won't give real-time priority isn't started - the audio thread waiting on
+// a lower priority thread could miss its deadline - and its share of the decks renders on the
+// audio thread instead.
+class DeckRenderPool
+{
+public:
+    // The job renders one deck by index - it is called from the workers and the audio thread
+    explicit DeckRenderPool(std::function<void(int)> renderJob);
+    ~DeckRenderPool();
+
+    // Starts up to numWorkers real-time workers, sized for the block length (message thread,
+    // before audio starts)
+    void start(int numWorkers, int samplesPerBlockExpected, double sampleRate);
+    void stop();
+
+    int getNumWorkers() const;
+
+    // Renders jobs 0 to numJobs - 1 and returns once they are all done (audio thread)
+    void run(int numJobs);
+
+    // A worker stops spinning after this many block lengths without a block
+    static constexpr int SPIN_BLOCKS = 4;
+
+private:
+    class Worker;
+
+    // Takes jobs off the shared counter until there are none left
+    void processJobs();
+
+    std::function<void(int)> job;
+    juce::OwnedArray<Worker> workers;
+
+    // Spins with the CPU's pause hint, not giving up the core
+    static void pause();
+
+    // Moved on at the start of every block
+    std::atomic<juce::uint32> blockGeneration{0};
+    // How long a worker spins waiting for the next block, in high resolution ticks
+    juce::int64 spinTicks{0};
+
+    std::atomic<int> numJobsInBlock{0};
+    std::atomic<int> nextJob{0};
+    std::atomic<int> jobsRemaining{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckRenderPool)
+};
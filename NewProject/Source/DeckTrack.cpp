@@ -0,0 +1,339 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "DeckTrack.h"
+#include "Tracing.h"
+
+DeckTrack::DeckTrack(juce::AudioFormatReader* reader, juce::AudioFormatReader* spareReader,
+                     juce::AudioFormatReader* windowReader, juce::AudioFormatReader* scratchReader,
+                     const juce::File& audioFile)
+    : fileSampleRate(reader->sampleRate),
+      cueSource(reader, spareReader, windowReader),
+      scratchSource(scratchReader),
+      file(audioFile)
+{
+    // stretching is only switched on with key lock, and works on the file's samples ahead of the resampler
+    stretchSource.setBypassed(true);
+    stretchSource.setInputSampleRate(fileSampleRate);
+    handoverBuffer.setSize(2, HANDOVER_FADE_SAMPLES);
+}
+
+DeckTrack::~DeckTrack()
+{
+}
+
+void DeckTrack::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    TRACE_SCOPE("decode", "prepare track");
+
+    deviceSampleRate = sampleRate;
+    trim.reset(sampleRate, TRIM_RAMP_SECONDS);
+
+    // prepares the stretcher and transport on the way down
+    resamplingSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    scratchSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+    // Decoding a block now opens the decoder and pulls the start of the file into the disk cache.
+    // The transport isn't playing, so the reader is read directly and then rewound. The transport
+    // has no sample rate conversion - the resampler converts the file rate and the speed together
+    auto position = loopSource.getNextReadPosition();
+    juce::AudioBuffer<float> scratch(2, juce::jmax(1, samplesPerBlockExpected));
+    juce::AudioSourceChannelInfo info(&scratch, 0, scratch.getNumSamples());
+    loopSource.getNextAudioBlock(info);
+    loopSource.setNextReadPosition(position);
+
+    flushBuffers();
+}
+
+void DeckTrack::releaseResources()
+{
+    resamplingSource.releaseResources();
+    scratchSource.releaseResources();
+}
+
+void DeckTrack::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    bool isReversed = reversed.load() || censoring.load();
+    double speed = transportSource.isPlaying() ? playSpeed.load() : 0.0;
+    double releaseVelocity = isReversed ? -speed : speed;
+    bool reverseEnded = wasReversed && ! isReversed;
+    wasReversed = isReversed;
+
+    if (! scratching.load() && (scratchSource.isHeld() || isReversed))
+    {
+        // Grabbed or reversed - the scratch source takes over from what is being heard, past what
+        // the stretcher and resampler hold, at the speed it was playing or straight into reverse
+        auto heard = static_cast<juce::int64>(std::round(getAudiblePosition()));
+
+        scratchSource.start(heard, releaseVelocity);
+        scratching = true;
+        handoverSamplesDone = 0;
+    }
+    else if (scratching.load() && ! scratchSource.isHeld() && ! isReversed
+             && (reverseEnded || scratchSource.isSettled(releaseVelocity)))
+    {
+        // Let go and back up to speed, or out of reverse - the transport carries on from where the
+        // scratch got to, or after a censor from where it would have been without it, from the
+        // history or the reader prepared below rather than a decoder seek
+        loopSource.seekToPrepared(getReturnPosition());
+        flushBuffers();
+        scratchSource.stop();
+        scratching = false;
+        censorReturnPending = false;
+        handoverSamplesDone = 0;
+    }
+
+    if (censoring.load() || censorReturnPending)
+        censorPosition += speed * bufferToFill.numSamples * fileSampleRate / deviceSampleRate;
+
+    if (scratching.load())
+    {
+        scratchSource.render(bufferToFill, releaseVelocity);
+        loopSource.prepareSeek(getReturnPosition());
+    }
+    else
+    {
+        resamplingSource.getNextAudioBlock(bufferToFill);
+        scratchSource.setPlayhead(loopSource.getNextReadPosition());
+    }
+
+    if (handoverSamplesDone < HANDOVER_FADE_SAMPLES)
+        mixHandover(bufferToFill, releaseVelocity);
+
+    applyTrim(bufferToFill);
+}
+
+void DeckTrack::applyTrim(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    float target = trimTarget.load();
+
+    if (trimStarted)
+    {
+        trim.setTargetValue(target);
+    }
+    else
+    {
+        trim.setCurrentAndTargetValue(target);
+        trimStarted = true;
+    }
+
+    float startTrim = trim.getCurrentValue();
+    trim.skip(bufferToFill.numSamples);
+    float endTrim = trim.getCurrentValue();
+
+    if (startTrim != 1.0f || endTrim != 1.0f)
+        for (int channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+            bufferToFill.buffer->applyGainRamp(channel, bufferToFill.startSample, bufferToFill.numSamples, startTrim, endTrim);
+}
+
+void DeckTrack::mixHandover(const juce::AudioSourceChannelInfo& bufferToFill, double releaseVelocity)
+{
+    auto& buffer = *bufferToFill.buffer;
+    int numSamples = juce::jmin(bufferToFill.numSamples, HANDOVER_FADE_SAMPLES - handoverSamplesDone);
+    juce::AudioSourceChannelInfo handover(&handoverBuffer, 0, numSamples);
+
+    // the side that was playing carries on for the length of the fade
+    if (scratching.load())
+        resamplingSource.getNextAudioBlock(handover);
+    else
+        scratchSource.render(handover, releaseVelocity);
+
+    float fadeStart = static_cast<float>(handoverSamplesDone) / HANDOVER_FADE_SAMPLES;
+    float fadeEnd = static_cast<float>(handoverSamplesDone + numSamples) / HANDOVER_FADE_SAMPLES;
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        buffer.applyGainRamp(channel, bufferToFill.startSample, numSamples, fadeStart, fadeEnd);
+        buffer.addFromWithRamp(channel, bufferToFill.startSample, handoverBuffer.getReadPointer(juce::jmin(channel, 1)),
+                               numSamples, 1.0f - fadeStart, 1.0f - fadeEnd);
+    }
+
+    handoverSamplesDone += numSamples;
+}
+
+HotCueSource& DeckTrack::getHotCues()
+{
+    return cueSource;
+}
+
+LoopSource& DeckTrack::getLoops()
+{
+    return loopSource;
+}
+
+ScratchSource& DeckTrack::getScratch()
+{
+    return scratchSource;
+}
+
+TrackTransport& DeckTrack::getTransport()
+{
+    return transportSource;
+}
+
+TimeStretchAudioSource& DeckTrack::getStretcher()
+{
+    return stretchSource;
+}
+
+SincResamplingAudioSource& DeckTrack::getResampler()
+{
+    return resamplingSource;
+}
+
+void DeckTrack::flushBuffers()
+{
+    stretchSource.flushBuffers();
+    resamplingSource.flushBuffers();
+}
+
+void DeckTrack::setPlaySpeed(double speed)
+{
+    playSpeed = speed;
+}
+
+void DeckTrack::setReversed(bool shouldReverse)
+{
+    reversed = shouldReverse && scratchSource.isAvailable();
+}
+
+bool DeckTrack::isReversed() const
+{
+    return reversed.load();
+}
+
+void DeckTrack::startCensor()
+{
+    if (reversed.load() || censoring.load() || ! scratchSource.isAvailable())
+        return;
+
+    // the forward position carries on from what is being heard
+    censorPosition = getAudiblePosition();
+
+    censoring = true;
+}
+
+void DeckTrack::endCensor()
+{
+    if (! censoring.load())
+        return;
+
+    // reversed since, so it stays in reverse
+    censoring = false;
+    censorReturnPending = ! reversed.load();
+}
+
+juce::int64 DeckTrack::getReturnPosition() const
+{
+    return censoring.load() || censorReturnPending ? static_cast<juce::int64>(censorPosition) : scratchSource.getPosition();
+}
+
+bool DeckTrack::isCensoring() const
+{
+    return censoring.load();
+}
+
+bool DeckTrack::isScratching() const
+{
+    return scratching.load();
+}
+
+juce::int64 DeckTrack::getPlayPosition() const
+{
+    return scratching.load() ? scratchSource.getPosition() : transportSource.getNextReadPosition();
+}
+
+double DeckTrack::getAudiblePosition() const
+{
+    if (scratching.load())
+        return static_cast<double>(scratchSource.getPosition());
+
+    auto position = static_cast<double>(transportSource.getNextReadPosition());
+    double buffered = resamplingSource.getBufferedInputSamples();
+
+    // the resampler's input comes out of the stretcher, where each sample stands for tempo file samples
+    if (! stretchSource.isBypassed())
+        position -= stretchSource.getLatencyInSamples() + buffered * stretchSource.getTempo();
+    else
+        position -= buffered;
+
+    return position;
+}
+
+void DeckTrack::setTrim(float gain)
+{
+    trimTarget = gain;
+}
+
+double DeckTrack::getFileSampleRate() const
+{
+    return fileSampleRate;
+}
+
+double DeckTrack::getLengthInSeconds() const
+{
+    if (fileSampleRate <= 0.0)
+        return 0.0;
+
+    return transportSource.getTotalLength() / fileSampleRate;
+}
+
+const juce::File& DeckTrack::getFile() const
+{
+    return file;
+}
+
+//==============================================================================
+DeckTrackReleasePool::DeckTrackReleasePool()
+    : juce::Thread("Deck track release")
+{
+    startThread(juce::Thread::Priority::low);
+}
+
+DeckTrackReleasePool::~DeckTrackReleasePool()
+{
+    stopThread(RELEASE_INTERVAL_MS * 4);
+}
+
+void DeckTrackReleasePool::add(DeckTrack::Ptr track)
+{
+    const juce::ScopedLock sl(lock);
+    tracks.add({ std::move(track), 0 });
+}
+
+void DeckTrackReleasePool::run()
+{
+    while (! threadShouldExit())
+    {
+        wait(RELEASE_INTERVAL_MS);
+        releaseUnusedTracks();
+    }
+}
+
+void DeckTrackReleasePool::releaseUnusedTracks()
+{
+    juce::Array<DeckTrack::Ptr> unused;
+
+    {
+        const juce::ScopedLock sl(lock);
+
+        for (int i = tracks.size(); --i >= 0;)
+        {
+            auto& entry = tracks.getReference(i);
+
+            // only the pool's own reference is left
+            if (entry.track->getReferenceCount() > 1)
+                entry.unusedPasses = 0;
+            else if (++entry.unusedPasses >= 2)
+            {
+                unused.add(std::move(entry.track));
+                tracks.remove(i);
+            }
+        }
+    }
+
+    // the tracks are deleted here, outside the lock
+    unused.clear();
+}
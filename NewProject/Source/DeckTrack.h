@@ -0,0 +1,150 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TimeStretchAudioSource.h"
+#include "SincResamplingAudioSource.h"
+#include "TrackTransport.h"
+#include "HotCueSource.h"
+#include "LoopSource.h"
+#include "ScratchSource.h"
+
+// One loaded track and the chain that plays it - reader with its hot cues, loops, transport,
+// time-stretcher and resampler. While the platter is held the track plays from the scratch
+// source instead, and hands back to the transport where the scratch leaves off.
+// A deck builds a new one for every load and prepares it completely before the audio thread
+// sees it, so changing track on the audio thread is only a pointer swap.
+class DeckTrack : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<DeckTrack>;
+
+    // Takes ownership of the readers, all of the same file - two are for the hot cues and one for
+    // scratching. Only the first is needed: without the others the cues seek the decoder, and the
+    // track neither scratches nor plays in reverse
+    DeckTrack(juce::AudioFormatReader* reader, juce::AudioFormatReader* spareReader,
+              juce::AudioFormatReader* windowReader, juce::AudioFormatReader* scratchReader,
+              const juce::File& audioFile);
+    ~DeckTrack() override;
+
+    // Allocates every stage for the device and decodes the first block, then rewinds - so the
+    // audio thread's first read of the track opens nothing and starts warm (not the audio thread)
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+    void releaseResources();
+
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill);
+
+    HotCueSource& getHotCues();
+    LoopSource& getLoops();
+    ScratchSource& getScratch();
+    TrackTransport& getTransport();
+    TimeStretchAudioSource& getStretcher();
+    SincResamplingAudioSource& getResampler();
+
+    // Clears the stretcher and resampler history, e.g. after a seek
+    void flushBuffers();
+
+    // The speed the track plays at, which a released platter runs back up to (any thread)
+    void setPlaySpeed(double speed);
+    // True while the scratch source is playing the track (any thread)
+    bool isScratching() const;
+
+    // Reverse play, through the scratch source - the platter runs backwards at the play speed. Censor
+    // and reverse do nothing if the scratch source has no reader (audio thread)
+    void setReversed(bool shouldReverse);
+    bool isReversed() const;
+    // Censor plays in reverse until it ends, then carries on forwards from where the track would have
+    // been without it. Does nothing while the deck is already reversed (audio thread)
+    void startCensor();
+    void endCensor();
+    bool isCensoring() const;
+    // The play position in file samples, from whichever of the transport and scratch is playing
+    juce::int64 getPlayPosition() const;
+    // The file position of the next sample out of the chain - behind the play position by what the
+    // stretcher and resampler have read but not yet played (audio thread)
+    double getAudiblePosition() const;
+
+    // The track's auto-gain, applied to its own output so a track fading out of a swap keeps its
+    // level while the next fades in at its own. The first block starts at the trim, and later
+    // changes ramp over TRIM_RAMP_SECONDS (any thread)
+    void setTrim(float gain);
+    static constexpr double TRIM_RAMP_SECONDS = 0.5;
+
+    // Crossfade when the scratch source takes over from the transport or hands back
+    static constexpr int HANDOVER_FADE_SAMPLES = 256;
+
+    double getFileSampleRate() const;
+    double getLengthInSeconds() const;
+    const juce::File& getFile() const;
+
+private:
+    const double fileSampleRate;
+    HotCueSource cueSource;
+    LoopSource loopSource{cueSource, fileSampleRate};
+    TrackTransport transportSource{&loopSource};
+    TimeStretchAudioSource stretchSource{&transportSource, false, 2};
+    SincResamplingAudioSource resamplingSource{&stretchSource, false, 2};
+    ScratchSource scratchSource;
+    const juce::File file;
+
+    // Fades the side handing over out under the side taking over (audio thread)
+    void mixHandover(const juce::AudioSourceChannelInfo& bufferToFill, double releaseVelocity);
+    // Where the transport takes back over from the scratch source, as things stand (audio thread)
+    juce::int64 getReturnPosition() const;
+    // Ramps the block to the trim (audio thread)
+    void applyTrim(const juce::AudioSourceChannelInfo& bufferToFill);
+
+    std::atomic<double> playSpeed{1.0};
+    std::atomic<bool> scratching{false};
+    std::atomic<bool> reversed{false};
+    std::atomic<bool> censoring{false};
+    double deviceSampleRate{44100.0};
+
+    // audio thread - where playback would be without the censor, until the transport is back there
+    bool wasReversed{false};
+    bool censorReturnPending{false};
+    double censorPosition{0.0};
+    juce::AudioBuffer<float> handoverBuffer;
+    int handoverSamplesDone{HANDOVER_FADE_SAMPLES};
+
+    std::atomic<float> trimTarget{1.0f};
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> trim{1.0f};
+    bool trimStarted{false};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckTrack)
+};
+
+// Keeps every deck's tracks alive until no deck is using them, then deletes them on its own
+// background thread, so a swapped-out track is never freed on the audio thread. A track is only
+// deleted once nothing but the pool has held it for two passes in a row, which also covers a
+// thread that read a deck's track pointer just before a load replaced it.
+class DeckTrackReleasePool : private juce::Thread
+{
+public:
+    DeckTrackReleasePool();
+    ~DeckTrackReleasePool() override;
+
+    // Holds the track until it is unused (message thread)
+    void add(DeckTrack::Ptr track);
+
+    static constexpr int RELEASE_INTERVAL_MS = 500;
+
+private:
+    void run() override;
+    void releaseUnusedTracks();
+
+    struct Entry
+    {
+        DeckTrack::Ptr track;
+        int unusedPasses{0};
+    };
+
+    juce::CriticalSection lock;
+    juce::Array<Entry> tracks;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckTrackReleasePool)
+};
@@ -0,0 +1,332 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "HotCueSource.h"
+#include "Tracing.h"
+
+HotCueSource::HotCueSource(juce::AudioFormatReader* reader, juce::AudioFormatReader* spareReader, juce::AudioFormatReader* windowReaderToUse)
+    : juce::Thread("Hot cue windows"),
+      windowReader(windowReaderToUse),
+      windowLength(juce::jmax(1, static_cast<int>(WINDOW_SECONDS * reader->sampleRate)))
+{
+    readers[0] = std::make_unique<juce::AudioFormatReaderSource>(reader, true);
+
+    if (spareReader != nullptr)
+        readers[1] = std::make_unique<juce::AudioFormatReaderSource>(spareReader, true);
+
+    // All the windows are allocated up front, so the thread only ever decodes into them
+    if (windowReader != nullptr)
+        for (auto& cue : cues)
+            for (auto& window : cue.windows)
+                window.audio.setSize(2, windowLength);
+
+    spareScratch.setSize(2, SPARE_WARM_SAMPLES);
+    skipScratch.setSize(2, SPARE_WARM_SAMPLES);
+
+    if (windowReader != nullptr || readers[1] != nullptr)
+        startThread();
+}
+
+HotCueSource::~HotCueSource()
+{
+    stopThread(2000);
+}
+
+void HotCueSource::setCue(int index, juce::int64 newPosition)
+{
+    if (! juce::isPositiveAndBelow(index, NUM_CUES))
+        return;
+
+    cues[(size_t) index].position = newPosition < 0 ? -1 : newPosition;
+    notify();
+}
+
+juce::int64 HotCueSource::getCue(int index) const
+{
+    return juce::isPositiveAndBelow(index, NUM_CUES) ? cues[(size_t) index].position.load() : -1;
+}
+
+bool HotCueSource::isCueWindowReady(int index) const
+{
+    if (! juce::isPositiveAndBelow(index, NUM_CUES))
+        return false;
+
+    const auto& cue = cues[(size_t) index];
+    int published = cue.published.load();
+    auto cuePosition = cue.position.load();
+
+    return cuePosition >= 0 && published >= 0 && cue.windows[(size_t) published].start.load() == cuePosition;
+}
+
+void HotCueSource::setNextReadPosition(juce::int64 newPosition)
+{
+    newPosition = juce::jmax(static_cast<juce::int64>(0), newPosition);
+    currentWindow = nullptr;
+
+    if (startWindowAt(newPosition))
+        return;
+
+    stopWindow();
+    readers[(size_t) activeReader.load()]->setNextReadPosition(newPosition);
+    position = newPosition;
+}
+
+juce::int64 HotCueSource::getNextReadPosition() const
+{
+    return position.load();
+}
+
+void HotCueSource::prepareSeek(juce::int64 newPosition)
+{
+    if (readers[1] == nullptr)
+        return;
+
+    // A spare on its way to or ready at a target in reach is left alone. A new target is centred
+    // on the position, so it stays in reach while the position moves either way
+    auto target = spareTarget.load();
+    bool inReach = spareState.load() != spareIdle
+                && newPosition >= target + MAX_PREPARED_SKIP / 8
+                && newPosition <= target + MAX_PREPARED_SKIP * 7 / 8;
+
+    if (! inReach)
+        requestSpare(juce::jmax(static_cast<juce::int64>(0), newPosition - MAX_PREPARED_SKIP / 2));
+}
+
+bool HotCueSource::seekToPrepared(juce::int64 newPosition)
+{
+    if (spareState.load() != spareReady)
+        return false;
+
+    // read once the spare is ready, so it is the position it is ready at
+    auto readyAt = spareReadyAt.load();
+    if (newPosition < readyAt || newPosition - readyAt > MAX_PREPARED_SKIP)
+        return false;
+
+    stopWindow();
+    activeReader = 1 - activeReader.load();
+    spareState = spareIdle;
+
+    // reading on from where the spare is ready never seeks the decoder
+    auto& reader = *readers[(size_t) activeReader.load()];
+
+    for (auto remaining = newPosition - readyAt; remaining > 0;)
+    {
+        int numToSkip = static_cast<int>(juce::jmin(remaining, static_cast<juce::int64>(skipScratch.getNumSamples())));
+        reader.getNextAudioBlock(juce::AudioSourceChannelInfo(&skipScratch, 0, numToSkip));
+        remaining -= numToSkip;
+    }
+
+    position = newPosition;
+    return true;
+}
+
+juce::int64 HotCueSource::getTotalLength() const
+{
+    return readers[0]->getTotalLength();
+}
+
+bool HotCueSource::isLooping() const
+{
+    return false;
+}
+
+void HotCueSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    for (auto& reader : readers)
+        if (reader != nullptr)
+            reader->prepareToPlay(samplesPerBlockExpected, sampleRate);
+}
+
+void HotCueSource::releaseResources()
+{
+    for (auto& reader : readers)
+        if (reader != nullptr)
+            reader->releaseResources();
+}
+
+void HotCueSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    readAt(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+}
+
+void HotCueSource::readAt(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    int done = 0;
+
+    while (done < numSamples)
+    {
+        if (currentWindow != nullptr)
+        {
+            auto offset = static_cast<int>(position.load() - currentWindow->start.load());
+            int available = currentWindow->length - offset;
+
+            if (available > 0)
+            {
+                int numToCopy = juce::jmin(numSamples - done, available);
+                for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                    buffer.copyFrom(channel, startSample + done, currentWindow->audio, juce::jmin(channel, 1), offset, numToCopy);
+
+                position += numToCopy;
+                done += numToCopy;
+                continue;
+            }
+
+            continueAfterWindow();
+        }
+
+        int numToRead = numSamples - done;
+        readers[(size_t) activeReader.load()]->getNextAudioBlock(juce::AudioSourceChannelInfo(&buffer, startSample + done, numToRead));
+        position += numToRead;
+        done += numToRead;
+    }
+}
+
+bool HotCueSource::startWindowAt(juce::int64 newPosition)
+{
+    if (windowReader == nullptr)
+        return false;
+
+    for (auto& cue : cues)
+    {
+        int published = cue.published.load();
+        if (published < 0)
+            continue;
+
+        // Claims the window before using it, and checks it wasn't replaced in the meantime - the
+        // thread never decodes into the window claimed
+        const auto* window = &cue.windows[(size_t) published];
+        windowInUse = window;
+
+        if (cue.published.load() != published)
+            continue;
+
+        auto start = window->start.load();
+        if (newPosition >= start && newPosition < start + window->length)
+        {
+            currentWindow = window;
+            position = newPosition;
+            requestSpare(start + window->length);
+            return true;
+        }
+    }
+
+    windowInUse = nullptr;
+    return false;
+}
+
+void HotCueSource::stopWindow()
+{
+    currentWindow = nullptr;
+    windowInUse = nullptr;
+}
+
+void HotCueSource::continueAfterWindow()
+{
+    auto end = position.load();
+    stopWindow();
+
+    if (spareState.load() == spareReady && spareReadyAt.load() == end)
+    {
+        // The spare has been decoded up to here, so playback carries straight on from it
+        activeReader = 1 - activeReader.load();
+        spareState = spareIdle;
+    }
+    else
+    {
+        // too soon after the jump for the thread - seeks here instead
+        TRACE_SCOPE("decode", "hot cue fallback seek");
+        readers[(size_t) activeReader.load()]->setNextReadPosition(end);
+    }
+}
+
+void HotCueSource::requestSpare(juce::int64 target)
+{
+    if (readers[1] == nullptr)
+        return;
+
+    if (spareState.load() == spareReady && spareReadyAt.load() == target)
+        return;
+
+    // A spare the thread is already working on is moved to the new target when it's done
+    spareTarget = target;
+
+    int expected = spareIdle;
+    if (! spareState.compare_exchange_strong(expected, spareRequested) && expected == spareReady)
+        spareState.compare_exchange_strong(expected, spareRequested);
+}
+
+void HotCueSource::run()
+{
+    while (! threadShouldExit())
+    {
+        prepareSpare();
+        refreshWindows();
+        wait(POLL_INTERVAL_MS);
+    }
+}
+
+void HotCueSource::refreshWindows()
+{
+    if (windowReader == nullptr)
+        return;
+
+    for (auto& cue : cues)
+    {
+        auto target = cue.position.load();
+        if (target < 0 || target == cue.decodedPosition)
+            continue;
+
+        // decodes into the window that isn't published, unless the audio thread is still reading it
+        int index = cue.published.load() == 0 ? 1 : 0;
+        auto& window = cue.windows[(size_t) index];
+        if (windowInUse.load() == &window)
+            continue;
+
+        TRACE_SCOPE("decode", "hot cue window");
+        int length = static_cast<int>(juce::jmin(static_cast<juce::int64>(windowLength), windowReader->lengthInSamples - target));
+
+        if (length > 0)
+        {
+            windowReader->read(&window.audio, 0, length, target, true, true);
+            window.start = target;
+            window.length = length;
+            cue.published = index;
+        }
+
+        cue.decodedPosition = target;
+
+        // a jump waiting on the spare reader comes first
+        prepareSpare();
+    }
+}
+
+void HotCueSource::prepareSpare()
+{
+    if (readers[1] == nullptr)
+        return;
+
+    int expected = spareRequested;
+    if (! spareState.compare_exchange_strong(expected, spareWorking))
+        return;
+
+    TRACE_SCOPE("decode", "hot cue spare reader");
+    auto& spare = *readers[(size_t) (1 - activeReader.load())];
+    juce::int64 target;
+
+    // Decodes up to the target, so the reader's next read carries straight on with no seek
+    do
+    {
+        target = spareTarget.load();
+        auto warmStart = juce::jmax(static_cast<juce::int64>(0), target - SPARE_WARM_SAMPLES);
+        spare.setNextReadPosition(warmStart);
+
+        if (target > warmStart)
+            spare.getNextAudioBlock(juce::AudioSourceChannelInfo(&spareScratch, 0, static_cast<int>(target - warmStart)));
+    }
+    while (spareTarget.load() != target && ! threadShouldExit());
+
+    spareReadyAt = target;
+    spareState = spareReady;
+}
@@ -0,0 +1,119 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+// Reads a track's file for its deck, with up to eight hot cues. Each cue keeps a short window of
+// decoded audio, refreshed on the source's own thread, so a seek to a cue plays from memory with no
+// decoder seek on the audio thread (the LoopSource above crossfades into it). While a window plays
+// the thread seeks a second reader to where the window ends, and playback carries on from that
+// reader once the window runs out. If the thread hasn't got there in time the audio thread seeks
+// the reader itself - which sounds the same, it only costs more.
+class HotCueSource : public juce::PositionableAudioSource,
+                     private juce::Thread
+{
+public:
+    // Takes ownership of the readers, which must all read the same file. Without the spare and
+    // window readers the cues still work, as plain seeks.
+    HotCueSource(juce::AudioFormatReader* reader, juce::AudioFormatReader* spareReader, juce::AudioFormatReader* windowReader);
+    ~HotCueSource() override;
+
+    static constexpr int NUM_CUES = 8;
+    // Decoded audio kept at each cue
+    static constexpr double WINDOW_SECONDS = 0.5;
+
+    // Sets a cue in file samples, or clears it with -1 - its window is decoded in the background (message thread)
+    void setCue(int index, juce::int64 position);
+    juce::int64 getCue(int index) const;
+    // True once the cue's window is decoded at its current position
+    bool isCueWindowReady(int index) const;
+
+    // Seeks from a cue's window if it lands in one (audio thread, or while it isn't running). Anywhere
+    // else it is a decoder seek on the calling thread - a seek command, or a jump the loop history
+    // can't serve, pays for it on the audio thread. Only the cues are kept off it.
+    void setNextReadPosition(juce::int64 newPosition) override;
+    juce::int64 getNextReadPosition() const override;
+
+    // Keeps the spare reader ready a little before a position playback may soon move to, e.g. where
+    // a scratch will hand back to the transport. The thread only seeks it again once the position
+    // has moved out of reach (audio thread)
+    void prepareSeek(juce::int64 newPosition);
+    // Moves playback to the position from the spare reader, if prepareSeek left it ready up to
+    // MAX_PREPARED_SKIP before the position, decoding on to it. False, with nothing moved, if it
+    // didn't (audio thread)
+    bool seekToPrepared(juce::int64 newPosition);
+    // How far the spare reader is decoded on to reach a prepared seek - far cheaper than a seek
+    static constexpr int MAX_PREPARED_SKIP = 8192;
+    juce::int64 getTotalLength() const override;
+    bool isLooping() const override;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+private:
+    struct Window
+    {
+        juce::AudioBuffer<float> audio;
+        std::atomic<juce::int64> start{-1};
+        int length{0};
+    };
+
+    // Two windows per cue - the thread decodes into whichever isn't published
+    struct Cue
+    {
+        std::atomic<juce::int64> position{-1};
+        std::array<Window, 2> windows;
+        std::atomic<int> published{-1};
+        juce::int64 decodedPosition{-1};    // the thread's own
+    };
+
+    // The spare reader belongs to the audio thread while idle or ready, to the thread otherwise
+    enum SpareState { spareIdle, spareRequested, spareWorking, spareReady };
+
+    void run() override;
+    void refreshWindows();
+    void prepareSpare();
+
+    // Starts playing from the window holding the position, false if none does (audio thread)
+    bool startWindowAt(juce::int64 newPosition);
+    void stopWindow();
+    // Carries on from the spare reader where the window ends, or seeks the reader there
+    void continueAfterWindow();
+    void requestSpare(juce::int64 target);
+    // Reads onwards from the current position, through the window and then the reader
+    void readAt(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    std::array<std::unique_ptr<juce::AudioFormatReaderSource>, 2> readers;
+    std::unique_ptr<juce::AudioFormatReader> windowReader;
+    const int windowLength;
+    std::array<Cue, NUM_CUES> cues;
+
+    // audio thread - the read position and the window being played, if any
+    std::atomic<juce::int64> position{0};
+    const Window* currentWindow{nullptr};
+    // the window the audio thread may be reading, which the thread never decodes into
+    std::atomic<const Window*> windowInUse{nullptr};
+    std::atomic<int> activeReader{0};
+
+    std::atomic<int> spareState{spareIdle};
+    std::atomic<juce::int64> spareTarget{0};
+    std::atomic<juce::int64> spareReadyAt{-1};
+
+    // the thread's decode space for warming the spare reader, and the audio thread's for decoding
+    // on to a prepared seek
+    juce::AudioBuffer<float> spareScratch;
+    juce::AudioBuffer<float> skipScratch;
+
+    // How often the thread looks for work without being woken
+    static constexpr int POLL_INTERVAL_MS = 10;
+    // Decoded up to a target so the spare reader's next read carries straight on
+    static constexpr int SPARE_WARM_SAMPLES = 2048;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HotCueSource)
+};
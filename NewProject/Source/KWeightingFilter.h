@@ -0,0 +1,90 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+// The ITU-R BS.1770 K-weighting filter - a high shelf for the head followed by the RLB high pass -
+// used by the live level meters and the offline loudness analysis. The coefficients are worked out
+// for any sample rate from the filters' analogue prototypes.
+template <int NumChannels>
+class KWeightingFilter
+{
+public:
+    KWeightingFilter()
+    {
+        prepare(48000.0);
+    }
+
+    // Works out the coefficients and clears the filter state
+    void prepare(double sampleRate)
+    {
+        {
+            const double f0 = 1681.974450955533;
+            const double gainDb = 3.999843853973347;
+            const double q = 0.7071752369554196;
+
+            double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+            double vh = std::pow(10.0, gainDb / 20.0);
+            double vb = std::pow(vh, 0.4996667741545416);
+            double a0 = 1.0 + k / q + k * k;
+
+            shelf.b0 = (vh + vb * k / q + k * k) / a0;
+            shelf.b1 = 2.0 * (k * k - vh) / a0;
+            shelf.b2 = (vh - vb * k / q + k * k) / a0;
+            shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+            shelf.a2 = (1.0 - k / q + k * k) / a0;
+        }
+        {
+            const double f0 = 38.13547087602444;
+            const double q = 0.5003270373238773;
+
+            double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+            double a0 = 1.0 + k / q + k * k;
+
+            highPass.b0 = 1.0;
+            highPass.b1 = -2.0;
+            highPass.b2 = 1.0;
+            highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+            highPass.a2 = (1.0 - k / q + k * k) / a0;
+        }
+
+        reset();
+    }
+
+    void reset()
+    {
+        shelf.z1.fill(0.0);
+        shelf.z2.fill(0.0);
+        highPass.z1.fill(0.0);
+        highPass.z2.fill(0.0);
+    }
+
+    double processSample(double x, int channel) noexcept
+    {
+        return highPass.processSample(shelf.processSample(x, channel), channel);
+    }
+
+private:
+    // Transposed direct form II, one state per channel
+    struct Biquad
+    {
+        double b0{1.0}, b1{0.0}, b2{0.0}, a1{0.0}, a2{0.0};
+        std::array<double, NumChannels> z1{}, z2{};
+
+        double processSample(double x, int channel) noexcept
+        {
+            double y = b0 * x + z1[(size_t) channel];
+            z1[(size_t) channel] = b1 * x - a1 * y + z2[(size_t) channel];
+            z2[(size_t) channel] = b2 * x - a2 * y;
+            return y;
+        }
+    };
+
+    Biquad shelf;
+    Biquad highPass;
+};
@@ -0,0 +1,122 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "LevelMeter.h"
+#include "VectorOps.h"
+
+LevelMeter::LevelMeter()
+{
+    prepareToPlay(sampleRate);
+}
+
+void LevelMeter::prepareToPlay(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    kWeighting.prepare(sampleRate);
+
+    subBlockEnergy.fill(0.0);
+    subBlockIndex = 0;
+    numSubBlocksFilled = 0;
+    subBlockLength = juce::jmax(1, juce::roundToInt(sampleRate * 0.1));
+    samplesInSubBlock = 0;
+    currentEnergy = 0.0;
+
+    for (int channel = 0; channel < NUM_CHANNELS; ++channel)
+    {
+        peak[(size_t) channel] = 0.0f;
+        meanSquare[(size_t) channel] = 0.0f;
+    }
+
+    momentaryLUFS = SILENCE_LUFS;
+    shortTermLUFS = SILENCE_LUFS;
+}
+
+void LevelMeter::process(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    if (numSamples <= 0 || buffer.getNumChannels() == 0)
+        return;
+
+    // Peak falls back at 20 dB per second, RMS is a 300 ms exponential average
+    float peakDecay = static_cast<float>(std::pow(10.0, -numSamples / sampleRate));
+    float rmsCoefficient = static_cast<float>(1.0 - std::exp(-numSamples / (0.3 * sampleRate)));
+
+    for (int channel = 0; channel < NUM_CHANNELS; ++channel)
+    {
+        const float* data = buffer.getReadPointer(juce::jmin(channel, buffer.getNumChannels() - 1), startSample);
+
+        auto range = juce::FloatVectorOperations::findMinAndMax(data, numSamples);
+        float blockPeak = juce::jmax(-range.getStart(), range.getEnd());
+        float blockMeanSquare = VectorOps::sumOfSquares(data, numSamples) / numSamples;
+
+        auto& channelPeak = peak[(size_t) channel];
+        channelPeak.store(juce::jmax(blockPeak, channelPeak.load(std::memory_order_relaxed) * peakDecay), std::memory_order_relaxed);
+
+        auto& channelMeanSquare = meanSquare[(size_t) channel];
+        float previous = channelMeanSquare.load(std::memory_order_relaxed);
+        channelMeanSquare.store(previous + rmsCoefficient * (blockMeanSquare - previous), std::memory_order_relaxed);
+    }
+
+    // K-weighted energy, summed over both channels and split into 100 ms blocks
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int channel = 0; channel < NUM_CHANNELS; ++channel)
+        {
+            double x = buffer.getSample(juce::jmin(channel, buffer.getNumChannels() - 1), startSample + i);
+            double weighted = kWeighting.processSample(x, channel);
+            currentEnergy += weighted * weighted;
+        }
+
+        if (++samplesInSubBlock == subBlockLength)
+        {
+            subBlockEnergy[(size_t) subBlockIndex] = currentEnergy / subBlockLength;
+            subBlockIndex = (subBlockIndex + 1) % NUM_SUB_BLOCKS;
+            numSubBlocksFilled = juce::jmin(numSubBlocksFilled + 1, NUM_SUB_BLOCKS);
+            samplesInSubBlock = 0;
+            currentEnergy = 0.0;
+
+            momentaryLUFS.store(loudnessOfLast(4), std::memory_order_relaxed);
+            shortTermLUFS.store(loudnessOfLast(NUM_SUB_BLOCKS), std::memory_order_relaxed);
+        }
+    }
+}
+
+float LevelMeter::loudnessOfLast(int numSubBlocks) const
+{
+    int count = juce::jmin(numSubBlocks, numSubBlocksFilled);
+    if (count == 0)
+        return SILENCE_LUFS;
+
+    double energy = 0.0;
+    for (int i = 1; i <= count; ++i)
+        energy += subBlockEnergy[(size_t) ((subBlockIndex - i + NUM_SUB_BLOCKS) % NUM_SUB_BLOCKS)];
+
+    energy /= count;
+
+    if (energy <= 1.0e-10)
+        return SILENCE_LUFS;
+
+    return static_cast<float>(-0.691 + 10.0 * std::log10(energy));
+}
+
+float LevelMeter::getPeak(int channel) const
+{
+    return peak[(size_t) juce::jlimit(0, NUM_CHANNELS - 1, channel)].load(std::memory_order_relaxed);
+}
+
+float LevelMeter::getRMS(int channel) const
+{
+    return std::sqrt(meanSquare[(size_t) juce::jlimit(0, NUM_CHANNELS - 1, channel)].load(std::memory_order_relaxed));
+}
+
+float LevelMeter::getMomentaryLUFS() const
+{
+    return momentaryLUFS.load(std::memory_order_relaxed);
+}
+
+float LevelMeter::getShortTermLUFS() const
+{
+    return shortTermLUFS.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,62 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include "KWeightingFilter.h"
+
+// Stereo peak, RMS and EBU R128 loudness meter, run on the audio thread. Peak and RMS come
+// from the SIMD kernels with meter ballistics applied per block; loudness is K-weighted as in
+// ITU-R BS.1770 and averaged over 400 ms (momentary) and 3 s (short-term). Every reading is
+// an atomic, so the GUI can poll it at any time.
+class LevelMeter
+{
+public:
+    static constexpr int NUM_CHANNELS = 2;
+
+    // Loudness reported while there is only silence
+    static constexpr float SILENCE_LUFS = -100.0f;
+
+    LevelMeter();
+
+    // Works out the K-weighting filters for the sample rate and clears the readings (before audio starts)
+    void prepareToPlay(double sampleRate);
+
+    // Meters a block - a mono buffer is metered on both sides (audio thread)
+    void process(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    // Linear gains, with the peak falling back at 20 dB/s and the RMS averaged over 300 ms
+    float getPeak(int channel) const;
+    float getRMS(int channel) const;
+
+    float getMomentaryLUFS() const;
+    float getShortTermLUFS() const;
+
+private:
+    // Mean square of the last numSubBlocks 100 ms blocks, as LUFS
+    float loudnessOfLast(int numSubBlocks) const;
+
+    double sampleRate{44100.0};
+
+    KWeightingFilter<NUM_CHANNELS> kWeighting;
+
+    // K-weighted energy of each 100 ms block, the last 3 s of them
+    static constexpr int NUM_SUB_BLOCKS = 30;
+    std::array<double, NUM_SUB_BLOCKS> subBlockEnergy{};
+    int subBlockIndex{0};
+    int numSubBlocksFilled{0};
+    int subBlockLength{4410};
+    int samplesInSubBlock{0};
+    double currentEnergy{0.0};
+
+    std::array<std::atomic<float>, NUM_CHANNELS> peak{};
+    std::array<std::atomic<float>, NUM_CHANNELS> meanSquare{};
+    std::atomic<float> momentaryLUFS{SILENCE_LUFS};
+    std::atomic<float> shortTermLUFS{SILENCE_LUFS};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LevelMeter)
+};
@@ -0,0 +1,120 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "LevelMeterComponent.h"
+
+LevelMeterComponent::LevelMeterComponent()
+{
+    setOpaque(false);
+    startTimerHz(REFRESH_RATE_HZ);
+}
+
+LevelMeterComponent::~LevelMeterComponent()
+{
+    stopTimer();
+}
+
+void LevelMeterComponent::setMeter(const LevelMeter* meterToShow)
+{
+    meter = meterToShow;
+    shownState = readState();
+    repaint();
+}
+
+juce::Rectangle<int> LevelMeterComponent::getBarArea() const
+{
+    return getLocalBounds().withTrimmedBottom(TEXT_HEIGHT).reduced(1);
+}
+
+LevelMeterComponent::DisplayState LevelMeterComponent::readState() const
+{
+    DisplayState state;
+
+    if (meter == nullptr)
+        return state;
+
+    int barHeight = getBarArea().getHeight();
+
+    auto toHeight = [barHeight](float gain)
+    {
+        float db = juce::Decibels::gainToDecibels(gain, MIN_DB);
+        return juce::roundToInt(juce::jmap(juce::jlimit(MIN_DB, MAX_DB, db), MIN_DB, MAX_DB, 0.0f, (float) barHeight));
+    };
+
+    for (int channel = 0; channel < LevelMeter::NUM_CHANNELS; ++channel)
+    {
+        state.rmsHeight[(size_t) channel] = toHeight(meter->getRMS(channel));
+        state.peakHeight[(size_t) channel] = toHeight(meter->getPeak(channel));
+    }
+
+    state.momentaryTenths = juce::roundToInt(meter->getMomentaryLUFS() * 10.0f);
+    state.shortTermTenths = juce::roundToInt(meter->getShortTermLUFS() * 10.0f);
+    return state;
+}
+
+void LevelMeterComponent::timerCallback()
+{
+    auto state = readState();
+
+    if (! (state == shownState))
+    {
+        shownState = state;
+        repaint();
+    }
+}
+
+juce::String LevelMeterComponent::formatLoudness(int tenths) const
+{
+    if (tenths <= juce::roundToInt(LevelMeter::SILENCE_LUFS * 10.0f))
+        return "-inf";
+
+    // narrow meters only have room for whole numbers
+    return getWidth() >= 40 ? juce::String(tenths / 10.0, 1) : juce::String(juce::roundToInt(tenths / 10.0));
+}
+
+void LevelMeterComponent::paint(juce::Graphics& g)
+{
+    auto barArea = getBarArea();
+
+    g.setColour(juce::Colour::fromRGB(25, 25, 30));
+    g.fillRect(barArea.expanded(1));
+
+    int barWidth = (barArea.getWidth() - 2) / LevelMeter::NUM_CHANNELS;
+
+    // 0 dBFS marker
+    int zeroY = barArea.getBottom() - juce::roundToInt(juce::jmap(0.0f, MIN_DB, MAX_DB, 0.0f, (float) barArea.getHeight()));
+    g.setColour(juce::Colour::fromRGB(70, 70, 80));
+    g.drawHorizontalLine(zeroY, (float) barArea.getX(), (float) barArea.getRight());
+
+    for (int channel = 0; channel < LevelMeter::NUM_CHANNELS; ++channel)
+    {
+        auto bar = barArea.withWidth(barWidth).withX(barArea.getX() + channel * (barWidth + 2));
+        int rmsHeight = shownState.rmsHeight[(size_t) channel];
+        int peakHeight = shownState.peakHeight[(size_t) channel];
+
+        // teal up to -18 dB, orange to 0 dB, red above
+        juce::ColourGradient gradient(juce::Colour::fromRGB(220, 20, 60), 0.0f, (float) bar.getY(),
+                                      juce::Colour::fromRGB(64, 224, 208), 0.0f, (float) bar.getBottom(), false);
+        gradient.addColour(1.0 - juce::jmap(0.0, (double) MIN_DB, (double) MAX_DB, 0.0, 1.0), juce::Colour::fromRGB(255, 159, 67));
+        gradient.addColour(1.0 - juce::jmap(-18.0, (double) MIN_DB, (double) MAX_DB, 0.0, 1.0), juce::Colour::fromRGB(64, 224, 208));
+        g.setGradientFill(gradient);
+        g.fillRect(bar.withTop(bar.getBottom() - rmsHeight));
+
+        if (peakHeight > 0)
+        {
+            g.setColour(peakHeight > bar.getBottom() - zeroY ? juce::Colour::fromRGB(220, 20, 60) : juce::Colour::fromRGB(220, 220, 225));
+            g.fillRect(bar.getX(), bar.getBottom() - peakHeight, bar.getWidth(), 2);
+        }
+    }
+
+    // momentary over short-term loudness
+    auto textArea = getLocalBounds().removeFromBottom(TEXT_HEIGHT);
+    g.setFont(juce::Font(9.0f));
+    g.setColour(juce::Colour::fromRGB(220, 220, 225));
+    g.drawText("M " + formatLoudness(shownState.momentaryTenths), textArea.removeFromTop(TEXT_HEIGHT / 2),
+               juce::Justification::centred, false);
+    g.setColour(juce::Colour::fromRGB(180, 180, 185));
+    g.drawText("S " + formatLoudness(shownState.shortTermTenths), textArea, juce::Justification::centred, false);
+}
@@ -0,0 +1,58 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LevelMeter.h"
+
+// Draws a LevelMeter as a pair of vertical bars - RMS filled, peak as a line - with the
+// momentary and short-term loudness underneath. It polls the meter and only repaints when
+// something visible has changed.
+class LevelMeterComponent : public juce::Component,
+                            private juce::Timer
+{
+public:
+    LevelMeterComponent();
+    ~LevelMeterComponent() override;
+
+    // The meter to show, or nullptr for none (message thread)
+    void setMeter(const LevelMeter* meterToShow);
+
+    void paint(juce::Graphics& g) override;
+
+    // Bars cover this range of levels
+    static constexpr float MIN_DB = -60.0f;
+    static constexpr float MAX_DB = 6.0f;
+
+private:
+    // What is on screen - compared each tick so unchanged meters are never repainted
+    struct DisplayState
+    {
+        std::array<int, LevelMeter::NUM_CHANNELS> rmsHeight{};
+        std::array<int, LevelMeter::NUM_CHANNELS> peakHeight{};
+        int momentaryTenths{0};
+        int shortTermTenths{0};
+
+        bool operator==(const DisplayState& other) const
+        {
+            return rmsHeight == other.rmsHeight && peakHeight == other.peakHeight
+                && momentaryTenths == other.momentaryTenths && shortTermTenths == other.shortTermTenths;
+        }
+    };
+
+    void timerCallback() override;
+    DisplayState readState() const;
+    juce::Rectangle<int> getBarArea() const;
+    juce::String formatLoudness(int tenths) const;
+
+    const LevelMeter* meter{nullptr};
+    DisplayState shownState;
+
+    static constexpr int REFRESH_RATE_HZ = 30;
+    static constexpr int TEXT_HEIGHT = 24;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LevelMeterComponent)
+};
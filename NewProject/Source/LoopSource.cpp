@@ -0,0 +1,282 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "LoopSource.h"
+#include "Tracing.h"
+
+LoopSource::LoopSource(HotCueSource& sourceToRead, double fileSampleRate)
+    : source(sourceToRead),
+      historyLength(juce::jmax(FADE_SAMPLES * 4, static_cast<int>(HISTORY_SECONDS * fileSampleRate)))
+{
+    history.setSize(2, historyLength);
+    fadeBuffer.setSize(2, FADE_SAMPLES);
+}
+
+LoopSource::~LoopSource()
+{
+}
+
+void LoopSource::setLoop(juce::int64 start, juce::int64 end)
+{
+    // too short to crossfade
+    if (end - start < 2)
+        return;
+
+    loopStart = start;
+    loopEnd = end;
+    loopActive = true;
+
+    auto current = position.load();
+    loopEngaged = current >= start && current <= end;
+}
+
+void LoopSource::clearLoop()
+{
+    loopActive = false;
+    rolling = false;
+}
+
+void LoopSource::markLoopIn()
+{
+    loopInPosition = position.load();
+}
+
+void LoopSource::markLoopOut()
+{
+    // the out point is where playback is, so the loop wraps straight away
+    if (loopInPosition >= 0 && position.load() > loopInPosition)
+        setLoop(loopInPosition, position.load());
+}
+
+void LoopSource::startRoll(juce::int64 start, juce::int64 end)
+{
+    // A roll that changes length carries on from the same place
+    if (! rolling.load())
+        rollPosition = position.load();
+
+    setLoop(start, end);
+    rolling = loopActive.load();
+}
+
+void LoopSource::endRoll(bool shouldCrossfade)
+{
+    if (! rolling.load())
+        return;
+
+    clearLoop();
+    jumpTo(rollPosition, shouldCrossfade);
+}
+
+bool LoopSource::isLoopActive() const
+{
+    return loopActive.load();
+}
+
+bool LoopSource::isRolling() const
+{
+    return rolling.load();
+}
+
+juce::int64 LoopSource::getLoopStart() const
+{
+    return loopStart.load();
+}
+
+juce::int64 LoopSource::getLoopEnd() const
+{
+    return loopEnd.load();
+}
+
+void LoopSource::jumpTo(juce::int64 newPosition, bool shouldCrossfade)
+{
+    if (shouldCrossfade)
+        startCrossfade(FADE_SAMPLES);
+    else
+        fadeLength = 0;
+
+    position = juce::jmax(static_cast<juce::int64>(0), newPosition);
+
+    auto current = position.load();
+    loopEngaged = current >= loopStart.load() && current <= loopEnd.load();
+}
+
+void LoopSource::setNextReadPosition(juce::int64 newPosition)
+{
+    jumpTo(newPosition, false);
+}
+
+void LoopSource::prepareSeek(juce::int64 newPosition)
+{
+    if (! canReadWithoutSeeking(newPosition))
+        source.prepareSeek(newPosition);
+}
+
+void LoopSource::seekToPrepared(juce::int64 newPosition)
+{
+    newPosition = juce::jmax(static_cast<juce::int64>(0), newPosition);
+
+    // if the source wasn't ready either, the next read seeks it
+    if (! canReadWithoutSeeking(newPosition))
+        source.seekToPrepared(newPosition);
+
+    jumpTo(newPosition, false);
+}
+
+bool LoopSource::canReadWithoutSeeking(juce::int64 newPosition) const
+{
+    return (newPosition >= historyStart && newPosition < historyEnd) || newPosition == source.getNextReadPosition();
+}
+
+juce::int64 LoopSource::getNextReadPosition() const
+{
+    return position.load();
+}
+
+juce::int64 LoopSource::getTotalLength() const
+{
+    return source.getTotalLength();
+}
+
+bool LoopSource::isLooping() const
+{
+    return false;
+}
+
+void LoopSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    source.prepareToPlay(samplesPerBlockExpected, sampleRate);
+}
+
+void LoopSource::releaseResources()
+{
+    source.releaseResources();
+}
+
+void LoopSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    auto& buffer = *bufferToFill.buffer;
+    int done = 0;
+
+    // Read in pieces that stop at the loop end, where playback wraps
+    while (done < bufferToFill.numSamples)
+    {
+        int numToRead = bufferToFill.numSamples - done;
+
+        if (loopActive.load())
+        {
+            auto start = loopStart.load();
+            auto end = loopEnd.load();
+            auto current = position.load();
+
+            if (current >= start && current < end)
+                loopEngaged = true;
+
+            if (loopEngaged && current >= end)
+            {
+                // fades out the audio past the loop end under the loop start
+                startCrossfade(static_cast<int>(juce::jmin(static_cast<juce::int64>(FADE_SAMPLES), (end - start) / 2)));
+                position = start;
+                current = start;
+            }
+
+            if (loopEngaged)
+                numToRead = static_cast<int>(juce::jmin(static_cast<juce::int64>(numToRead), end - current));
+        }
+
+        readSamples(buffer, bufferToFill.startSample + done, numToRead);
+        mixCrossfade(buffer, bufferToFill.startSample + done, numToRead);
+
+        if (rolling.load())
+            rollPosition += numToRead;
+
+        done += numToRead;
+    }
+}
+
+void LoopSource::readSamples(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    while (numSamples > 0)
+    {
+        auto current = position.load();
+        int count = juce::jmin(numSamples, historyLength);
+        int ringIndex = static_cast<int>(current % historyLength);
+
+        if (current >= historyStart && current < historyEnd)
+        {
+            // Already in the history - the decoder isn't touched
+            count = static_cast<int>(juce::jmin(static_cast<juce::int64>(count), historyEnd - current));
+            int firstPart = juce::jmin(count, historyLength - ringIndex);
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            {
+                int historyChannel = juce::jmin(channel, 1);
+                buffer.copyFrom(channel, startSample, history, historyChannel, ringIndex, firstPart);
+
+                if (count > firstPart)
+                    buffer.copyFrom(channel, startSample + firstPart, history, historyChannel, 0, count - firstPart);
+            }
+        }
+        else
+        {
+            // Reads on from the source, seeking it first if playback has moved, and keeps what it read
+            if (source.getNextReadPosition() != current)
+            {
+                TRACE_SCOPE("decode", "loop source seek");
+                source.setNextReadPosition(current);
+            }
+
+            if (current != historyEnd)
+                historyStart = historyEnd = current;
+
+            source.getNextAudioBlock(juce::AudioSourceChannelInfo(&buffer, startSample, count));
+
+            int firstPart = juce::jmin(count, historyLength - ringIndex);
+
+            for (int channel = 0; channel < history.getNumChannels(); ++channel)
+            {
+                int bufferChannel = juce::jmin(channel, buffer.getNumChannels() - 1);
+                history.copyFrom(channel, ringIndex, buffer, bufferChannel, startSample, firstPart);
+
+                if (count > firstPart)
+                    history.copyFrom(channel, 0, buffer, bufferChannel, startSample + firstPart, count - firstPart);
+            }
+
+            historyEnd += count;
+            historyStart = juce::jmax(historyStart, historyEnd - historyLength);
+        }
+
+        position = current + count;
+        startSample += count;
+        numSamples -= count;
+    }
+}
+
+void LoopSource::startCrossfade(int length)
+{
+    fadeLength = juce::jlimit(0, FADE_SAMPLES, length);
+    fadeSamplesDone = 0;
+
+    if (fadeLength > 0)
+        readSamples(fadeBuffer, 0, fadeLength);
+}
+
+void LoopSource::mixCrossfade(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    if (fadeSamplesDone >= fadeLength)
+        return;
+
+    int fade = juce::jmin(numSamples, fadeLength - fadeSamplesDone);
+    float fadeStart = static_cast<float>(fadeSamplesDone) / fadeLength;
+    float fadeEnd = static_cast<float>(fadeSamplesDone + fade) / fadeLength;
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        buffer.applyGainRamp(channel, startSample, fade, fadeStart, fadeEnd);
+        buffer.addFromWithRamp(channel, startSample, fadeBuffer.getReadPointer(juce::jmin(channel, 1), fadeSamplesDone),
+                               fade, 1.0f - fadeStart, 1.0f - fadeEnd);
+    }
+
+    fadeSamplesDone += fade;
+}
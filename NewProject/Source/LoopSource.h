@@ -0,0 +1,100 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "HotCueSource.h"
+
+// Plays a track from its hot cue source, with loops. Everything read from the source is also kept
+// in a history ring of the last HISTORY_SECONDS, so once a loop has played through once - or at
+// once, for a loop over audio that has just played - every wrap is served from memory and the
+// decoder isn't touched until playback leaves the loop. Loop wraps, jumps and the end of a loop
+// roll crossfade over a few milliseconds. Positions are in file samples.
+class LoopSource : public juce::PositionableAudioSource
+{
+public:
+    // Doesn't own the source
+    LoopSource(HotCueSource& sourceToRead, double fileSampleRate);
+    ~LoopSource() override;
+
+    // Loops on the audio thread, or while it isn't running. A loop wraps once playback is inside it.
+    void setLoop(juce::int64 start, juce::int64 end);
+    // Ends a loop or roll where it is - playback carries on past the loop end
+    void clearLoop();
+    // Manual loop - the out point starts a loop back to the last in point
+    void markLoopIn();
+    void markLoopOut();
+
+    // A roll loops like any other, and ending it jumps to where playback would have got to without it
+    void startRoll(juce::int64 start, juce::int64 end);
+    void endRoll(bool shouldCrossfade);
+
+    // Any thread
+    bool isLoopActive() const;
+    bool isRolling() const;
+    juce::int64 getLoopStart() const;
+    juce::int64 getLoopEnd() const;
+
+    // Moves playback, crossfading from where it was when shouldCrossfade is set (audio thread)
+    void jumpTo(juce::int64 newPosition, bool shouldCrossfade);
+
+    // A plain seek, with no crossfade
+    void setNextReadPosition(juce::int64 newPosition) override;
+    // Keeps the source ready near a position playback may soon seek to, unless the history or the
+    // source's own position already covers it (audio thread)
+    void prepareSeek(juce::int64 newPosition);
+    // A plain seek that plays on from the history or the prepared source where it can, so the
+    // decoder is only sought if neither covers the position (audio thread)
+    void seekToPrepared(juce::int64 newPosition);
+    juce::int64 getNextReadPosition() const override;
+    juce::int64 getTotalLength() const override;
+    bool isLooping() const override;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+    // Covers a 32 beat loop down to 96 BPM - a longer loop still works, but wraps through a seek
+    static constexpr double HISTORY_SECONDS = 20.0;
+    // Crossfade at a loop wrap or a jump
+    static constexpr int FADE_SAMPLES = 128;
+
+private:
+    // True if reading from the position needs no decoder seek - the history holds it, or the
+    // source is already there (audio thread)
+    bool canReadWithoutSeeking(juce::int64 newPosition) const;
+    // Reads onwards from the position, from the history where it has the audio (audio thread)
+    void readSamples(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+    // Reads the audio past the position into the fade buffer, to fade out under what comes next
+    void startCrossfade(int length);
+    // Mixes the faded out audio under the start of what was just read
+    void mixCrossfade(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    HotCueSource& source;
+
+    // audio thread - the read position, and the span of the file the history holds
+    std::atomic<juce::int64> position{0};
+    juce::AudioBuffer<float> history;
+    const int historyLength;
+    juce::int64 historyStart{0};
+    juce::int64 historyEnd{0};
+
+    std::atomic<bool> loopActive{false};
+    std::atomic<bool> rolling{false};
+    std::atomic<juce::int64> loopStart{0};
+    std::atomic<juce::int64> loopEnd{0};
+    // audio thread - set once playback is inside the loop, so a loop ahead waits to be reached
+    bool loopEngaged{false};
+    juce::int64 loopInPosition{-1};
+    // where playback would be without the roll
+    juce::int64 rollPosition{0};
+
+    juce::AudioBuffer<float> fadeBuffer;
+    int fadeLength{0};
+    int fadeSamplesDone{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoopSource)
+};
@@ -0,0 +1,198 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "LoudnessAnalyser.h"
+#include "Tracing.h"
+#include <numeric>
+
+LoudnessAnalyser::LoudnessAnalyser()
+{
+    prepare(sampleRate);
+}
+
+void LoudnessAnalyser::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    kWeighting.prepare(sampleRate);
+
+    subBlockEnergy.clear();
+    subBlockLength = juce::jmax(1, juce::roundToInt(sampleRate * 0.1));
+    samplesInSubBlock = 0;
+    currentEnergy = 0.0;
+
+    // Anything at 192 kHz and above is already fine enough to find the peaks
+    oversampling = sampleRate < 96000.0 ? 4 : (sampleRate < 192000.0 ? 2 : 1);
+
+    // Hann windowed sinc, split into phases that each sum to unity gain
+    int numTaps = oversampling * TAPS_PER_PHASE;
+    double centre = (numTaps - 1) / 2.0;
+    interpolationTaps.assign((size_t) numTaps, 0.0f);
+
+    for (int phase = 0; phase < oversampling; ++phase)
+    {
+        double sum = 0.0;
+        std::array<double, TAPS_PER_PHASE> taps{};
+
+        for (int tap = 0; tap < TAPS_PER_PHASE; ++tap)
+        {
+            double n = tap * oversampling + phase;
+            double x = (n - centre) / oversampling;
+            double sinc = std::abs(x) < 1.0e-9 ? 1.0 : std::sin(juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+            double window = 0.5 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * (n + 0.5) / numTaps);
+            taps[(size_t) tap] = sinc * window;
+            sum += taps[(size_t) tap];
+        }
+
+        for (int tap = 0; tap < TAPS_PER_PHASE; ++tap)
+            interpolationTaps[(size_t) (phase * TAPS_PER_PHASE + tap)] = static_cast<float>(taps[(size_t) tap] / sum);
+    }
+
+    // Each history holds the last TAPS_PER_PHASE samples twice over, so they can be read without wrapping
+    for (auto& channelHistory : history)
+        channelHistory.assign(TAPS_PER_PHASE * 2, 0.0f);
+
+    historyPosition = 0;
+    truePeak = 0.0f;
+}
+
+void LoudnessAnalyser::process(const juce::AudioBuffer<float>& buffer, int numSamples)
+{
+    if (numSamples <= 0 || buffer.getNumChannels() == 0)
+        return;
+
+    int startPosition = historyPosition;
+
+    for (int channel = 0; channel < NUM_CHANNELS; ++channel)
+    {
+        const float* data = buffer.getReadPointer(juce::jmin(channel, buffer.getNumChannels() - 1));
+
+        // every channel's history starts from the same place for the block
+        historyPosition = startPosition;
+        truePeak = juce::jmax(truePeak, findTruePeak(data, numSamples, channel));
+    }
+
+    // K-weighted energy, summed over both channels and split into 100 ms blocks
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int channel = 0; channel < NUM_CHANNELS; ++channel)
+        {
+            double weighted = kWeighting.processSample(buffer.getSample(juce::jmin(channel, buffer.getNumChannels() - 1), i), channel);
+            currentEnergy += weighted * weighted;
+        }
+
+        if (++samplesInSubBlock == subBlockLength)
+        {
+            subBlockEnergy.push_back(currentEnergy / subBlockLength);
+            samplesInSubBlock = 0;
+            currentEnergy = 0.0;
+        }
+    }
+}
+
+float LoudnessAnalyser::findTruePeak(const float* data, int numSamples, int channel)
+{
+    auto& channelHistory = history[(size_t) channel];
+    float blockPeak = 0.0f;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        channelHistory[(size_t) historyPosition] = data[i];
+        channelHistory[(size_t) (historyPosition + TAPS_PER_PHASE)] = data[i];
+        historyPosition = (historyPosition + 1) % TAPS_PER_PHASE;
+
+        // oldest to newest sample, against the taps in reverse
+        const float* recent = channelHistory.data() + historyPosition;
+
+        for (int phase = 0; phase < oversampling; ++phase)
+        {
+            const float* taps = interpolationTaps.data() + phase * TAPS_PER_PHASE;
+            float interpolated = 0.0f;
+
+            for (int tap = 0; tap < TAPS_PER_PHASE; ++tap)
+                interpolated += taps[tap] * recent[TAPS_PER_PHASE - 1 - tap];
+
+            blockPeak = juce::jmax(blockPeak, std::abs(interpolated));
+        }
+
+        // the samples themselves always count
+        blockPeak = juce::jmax(blockPeak, std::abs(data[i]));
+    }
+
+    return blockPeak;
+}
+
+double LoudnessAnalyser::getIntegratedLUFS() const
+{
+    // 400 ms gating blocks overlapping by 75%, so one per 100 ms block after the first three
+    auto toLUFS = [](double energy) { return -0.691 + 10.0 * std::log10(energy); };
+    const double absoluteGateEnergy = std::pow(10.0, (-70.0 + 0.691) / 10.0);
+
+    std::vector<double> gatingBlocks;
+
+    for (size_t i = 3; i < subBlockEnergy.size(); ++i)
+    {
+        double energy = (subBlockEnergy[i - 3] + subBlockEnergy[i - 2] + subBlockEnergy[i - 1] + subBlockEnergy[i]) / 4.0;
+
+        if (energy > absoluteGateEnergy)
+            gatingBlocks.push_back(energy);
+    }
+
+    if (gatingBlocks.empty())
+        return SILENCE_LUFS;
+
+    double ungatedEnergy = std::accumulate(gatingBlocks.begin(), gatingBlocks.end(), 0.0) / (double) gatingBlocks.size();
+    double relativeGateEnergy = ungatedEnergy * std::pow(10.0, -10.0 / 10.0);
+
+    double gatedSum = 0.0;
+    int numGated = 0;
+
+    for (auto energy : gatingBlocks)
+    {
+        if (energy > relativeGateEnergy)
+        {
+            gatedSum += energy;
+            ++numGated;
+        }
+    }
+
+    return numGated > 0 ? toLUFS(gatedSum / numGated) : SILENCE_LUFS;
+}
+
+double LoudnessAnalyser::getTruePeakDecibels() const
+{
+    return juce::Decibels::gainToDecibels((double) truePeak, SILENCE_LUFS);
+}
+
+bool LoudnessAnalyser::analyseFile(const juce::File& audioFile, juce::AudioFormatManager& formatManager,
+                                   const std::function<bool()>& shouldStop)
+{
+    TRACE_SCOPE("analysis", "loudness analysis");
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(audioFile));
+
+    if (reader == nullptr)
+        return false;
+
+    prepare(reader->sampleRate);
+
+    // Reading into a stereo buffer repeats a mono track on both sides, as the deck plays it
+    const int chunkSize = 65536;
+    juce::AudioBuffer<float> buffer(NUM_CHANNELS, chunkSize);
+
+    for (juce::int64 position = 0; position < reader->lengthInSamples; position += chunkSize)
+    {
+        if (shouldStop && shouldStop())
+            return false;
+
+        int numSamples = static_cast<int>(juce::jmin((juce::int64) chunkSize, reader->lengthInSamples - position));
+
+        if (! reader->read(&buffer, 0, numSamples, position, true, true))
+            return false;
+
+        process(buffer, numSamples);
+    }
+
+    return true;
+}
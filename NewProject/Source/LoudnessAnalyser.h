@@ -0,0 +1,61 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "KWeightingFilter.h"
+
+// Measures a whole track's integrated loudness (ITU-R BS.1770-4, with the -70 LUFS absolute
+// and -10 LU relative gates) and its true peak, found by 4x oversampling as in BS.1770 annex 2.
+// Mono tracks are measured as they play, on both sides.
+class LoudnessAnalyser
+{
+public:
+    static constexpr int NUM_CHANNELS = 2;
+
+    // Reported for silence, or a track too short to measure
+    static constexpr double SILENCE_LUFS = -100.0;
+
+    LoudnessAnalyser();
+
+    // Clears the measurement and sets up the filters for the sample rate
+    void prepare(double sampleRate);
+
+    // Measures the next part of the track
+    void process(const juce::AudioBuffer<float>& buffer, int numSamples);
+
+    double getIntegratedLUFS() const;
+    double getTruePeakDecibels() const;
+
+    // Reads and measures a whole file. Returns false if it can't be read, or shouldStop
+    // returned true part way through.
+    bool analyseFile(const juce::File& audioFile, juce::AudioFormatManager& formatManager,
+                     const std::function<bool()>& shouldStop = {});
+
+private:
+    // Highest oversampled sample among the input samples just added
+    float findTruePeak(const float* data, int numSamples, int channel);
+
+    double sampleRate{48000.0};
+    KWeightingFilter<NUM_CHANNELS> kWeighting;
+
+    // Mean square of every 100 ms of the track - each gating block is four of them
+    std::vector<double> subBlockEnergy;
+    int subBlockLength{4800};
+    int samplesInSubBlock{0};
+    double currentEnergy{0.0};
+
+    // Polyphase interpolation filter for the true peak, one row of taps per phase
+    int oversampling{4};
+    std::vector<float> interpolationTaps;
+    std::array<std::vector<float>, NUM_CHANNELS> history;
+    int historyPosition{0};
+    float truePeak{0.0f};
+
+    static constexpr int TAPS_PER_PHASE = 12;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoudnessAnalyser)
+};
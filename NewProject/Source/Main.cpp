@@ -5,6 +5,10 @@
 
 #include <JuceHeader.h>
 #include "MainComponent.h"
+#include "Benchmarks.h"
+#include "OfflineRenderer.h"
+#include "RegressionChecks.h"
+#include "TrackAnalysisCache.h"
 
 class NewProjectApplication  : public juce::JUCEApplication
 {
@@ -17,8 +21,49 @@ public:
 
     void initialise (const juce::String& commandLine) override
     {
+        juce::StringArray args;
+        args.addTokens (commandLine, true);
 
-        mainWindow.reset (new MainWindow (getApplicationName()));
+        // the headless modes analyse temporary tracks - their results aren't kept in the user's cache
+        if (args.contains ("--benchmark") || args.contains ("--render") || args.contains ("--check"))
+            TrackAnalysisCache::keepInMemory();
+
+        // runs the benchmarks headless, without opening a window - "--benchmark results.json" also saves them
+        int benchmarkArg = args.indexOf ("--benchmark");
+        if (benchmarkArg >= 0)
+        {
+            juce::File resultsFile;
+            if (benchmarkArg + 1 < args.size() && ! args[benchmarkArg + 1].startsWith ("--"))
+                resultsFile = juce::File::getCurrentWorkingDirectory().getChildFile (args[benchmarkArg + 1].unquoted());
+
+            Benchmarks::runAll (resultsFile);
+            quit();
+            return;
+        }
+
+        // renders a scripted mix to a WAV file, also without a window or audio device
+        if (args.contains ("--render"))
+        {
+            setApplicationReturnValue (OfflineRenderer::renderFromCommandLine (args));
+            quit();
+            return;
+        }
+
+        // renders synthetic mixes and checks what comes out - the exit code is the number of checks that failed
+        if (args.contains ("--check"))
+        {
+            setApplicationReturnValue (RegressionChecks::runAll());
+            quit();
+            return;
+        }
+
+        // "--decks N" opens with N decks instead of two
+        int numDecks = MixerEngine::MIN_DECKS;
+        int decksArg = args.indexOf ("--decks");
+        if (decksArg >= 0 && decksArg + 1 < args.size())
+            numDecks = args[decksArg + 1].getIntValue();
+
+        mainWindow.reset (new MainWindow (getApplicationName(), numDecks));
     }
 
     void shutdown() override
@@ -42,14 +87,14 @@ public:
     class MainWindow    : public juce::DocumentWindow
     {
     public:
-        MainWindow (juce::String name)
+        MainWindow (juce::String name, int numDecks)
             : DocumentWindow (name,
                               juce::Desktop::getInstance().getDefaultLookAndFeel()
                                                           .findColour (juce::ResizableWindow::backgroundColourId),
                               DocumentWindow::allButtons)
         {
             setUsingNativeTitleBar (true);
-            setContentOwned (new MainComponent(), true);
+            setContentOwned (new MainComponent (numDecks), true);
             #if JUCE_IOS || JUCE_ANDROID
             setFullScreen (true);
            #else
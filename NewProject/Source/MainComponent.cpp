@@ -4,32 +4,102 @@
 */
 
 #include "MainComponent.h"
+#include "Tracing.h"
+#include "AudioSettingsComponent.h"
 
-MainComponent::MainComponent()
+MainComponent::MainComponent(int numDecks)
+    : samplePads(mixer.getSamplePads(), formatManager),
+      playlistComponent(juce::jlimit(MixerEngine::MIN_DECKS, MixerEngine::MAX_DECKS, numDecks)),
+      performanceOverlay(mixer.getMonitor(), [this]
+      {
+          auto* device = deviceManager.getCurrentAudioDevice();
+          return device != nullptr ? device->getXRunCount() : -1;
+      })
 {
-
-    setSize (800, 600);
+    numDecks = juce::jlimit(MixerEngine::MIN_DECKS, MixerEngine::MAX_DECKS, numDecks);
+    
+    // 400 pixels per deck column, with a second row of decks beyond four, and the sample pads
+    int numColumns = numDecks <= 4 ? numDecks : (numDecks + 1) / 2;
+    setSize (400 * numColumns + PADS_WIDTH + 8, numDecks <= 4 ? 686 : 1042);
     
     // register audio formats for the formatManager
     formatManager.registerBasicFormats();
-
-    if (juce::RuntimePermissions::isRequired (juce::RuntimePermissions::recordAudio)
-        && ! juce::RuntimePermissions::isGranted (juce::RuntimePermissions::recordAudio))
-    {
-        juce::RuntimePermissions::request (juce::RuntimePermissions::recordAudio,
-                                           [&] (bool granted) { setAudioChannels (granted ? 2 : 0, 2); });
-    }
-    else
+    
+    // the controller's events are applied by the mixer, so it is connected before the audio device starts
+    mixer.setControllerInput(&controller);
+    
+    // the recorder only copies the master into its FIFO, whatever the outputs are routed to
+    mixer.onMasterBlock = [this](const juce::AudioSourceChannelInfo& master) { recorder.pushBlock(master); };
+    
+    // creates the decks and adds them to the mixer before the audio device starts
+    for (int i = 0; i < numDecks; ++i)
     {
-        // Input/output channels
-        setAudioChannels (2, 2);
+        auto* player = players.add(new DJAudioPlayer(formatManager));
+        mixer.addDeck(player);
+        
+        auto* deckGUI = deckGUIs.add(new DeckGUI(i + 1, player, formatManager, thumbnailCache));
+        addAndMakeVisible(deckGUI);
+        deckGUI->setLevelMeter(&mixer.getDeckMeter(i));
+        deckGUI->setEffectsRack(&mixer.getDeckEffects(i));
+        
+        // connects the deck's SYNC button to the sync engine
+        deckGUI->onSyncToggled = [this, i](bool shouldSync) { mixer.getSyncEngine().setSyncEnabled(i, shouldSync); };
+        
+        // and its CUE button to the headphone cue
+        deckGUI->onCueToggled = [this, i](bool shouldCue) { mixer.setCueEnabled(i, shouldCue); };
+        
+        // BAR starts the deck on the next downbeat of the deck beside it (1 and 2, 3 and 4, ...)
+        int leader = (i ^ 1) < numDecks ? (i ^ 1) : 0;
+        deckGUI->onPlayOnDownbeat = [this, i, leader] { mixer.startOnNextDownbeat(i, leader); };
     }
     
-    // adds the the two DeckGUI components
-    addAndMakeVisible(deckGUI1);
-    addAndMakeVisible(deckGUI2);
+    // the mapping in Documents/OtoDecks if there is one, otherwise the default layout for these decks
+    loadMapping(MidiMapping::getDefaultMappingFile());
 
+    // The saved device and routing, or on a first run the lowest latency device type - outputs
+    // only, as nothing listens to the inputs
+    auto savedSettings = AudioSettings::load(AudioSettings::getDefaultSettingsFile());
+    auto* savedDevice = AudioSettings::getDeviceState(savedSettings.get());
+    mixer.setOutputRouting(AudioSettings::getOutputRouting(savedSettings.get()));
+    
+    if (savedDevice == nullptr)
+        AudioSettings::selectLowLatencyDeviceType(deviceManager);
+    
+    setAudioChannels (0, mixer.getNumOutputChannels(), savedDevice);
+    deviceManager.addChangeListener(this);
+    
     addAndMakeVisible(playlistComponent);
+
+    masterMeter.setMeter(&mixer.getMasterMeter());
+    addAndMakeVisible(masterMeter);
+    addAndMakeVisible(samplePads);
+    
+    // CUE MIX blends the cued decks (left) with the master (right) in the headphones
+    cueMix.setRange(0.0, 1.0);
+    cueMix.setValue(0.0);
+    cueMix.setSliderStyle(juce::Slider::LinearHorizontal);
+    cueMix.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    cueMix.onValueChange = [this]() {
+        mixer.setCueMix(cueMix.getValue());
+    };
+    cueMix.setColour(juce::Slider::thumbColourId, juce::Colour::fromRGB(253, 203, 110));
+    cueMix.setColour(juce::Slider::trackColourId, juce::Colour::fromRGB(70, 70, 60));
+    cueMix.setColour(juce::Slider::backgroundColourId, juce::Colour::fromRGB(50, 50, 40));
+    addAndMakeVisible(cueMix);
+    
+    cueMixLabel.setText("CUE MIX", juce::dontSendNotification);
+    cueMixLabel.setJustificationType(juce::Justification::centred);
+    cueMixLabel.setColour(juce::Label::textColourId, juce::Colour::fromRGB(253, 203, 110));
+    cueMixLabel.setFont(juce::Font(10.0f, juce::Font::bold));
+    addAndMakeVisible(cueMixLabel);
+    
+    // OUTPUTS opens the audio settings, and picks the master alone, the master and a headphone cue,
+    // or a pair for each deck
+    outputsButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour::fromRGB(253, 203, 110));
+    outputsButton.setColour(juce::TextButton::textColourOnId, juce::Colours::black);
+    outputsButton.onClick = [this]() { showOutputsMenu(); };
+    outputsButton.setToggleState(mixer.getOutputRouting() != MixerEngine::OutputRouting::master, juce::dontSendNotification);
+    addAndMakeVisible(outputsButton);
     
     // Sets up crossfader for blending between decks
     crossfader.setRange(0.0, 1.0);
@@ -37,7 +107,7 @@ MainComponent::MainComponent()
     crossfader.setSliderStyle(juce::Slider::LinearHorizontal);
     crossfader.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
     crossfader.onValueChange = [this]() {
-        updateCrossfaderMix();
+        mixer.setCrossfader(crossfader.getValue());
     };
     
     // styles the crossfader
@@ -59,6 +129,9 @@ MainComponent::MainComponent()
     masterVolume.setValue(0.8); // default to 80%
     masterVolume.setSliderStyle(juce::Slider::LinearHorizontal);
     masterVolume.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    masterVolume.onValueChange = [this]() {
+        mixer.setMasterVolume(masterVolume.getValue());
+    };
     
     // Styles the master volume slider
     masterVolume.setColour(juce::Slider::thumbColourId, juce::Colour::fromRGB(107, 255, 107));
@@ -79,6 +152,9 @@ MainComponent::MainComponent()
     masterFilter.setValue(0.5); 
     masterFilter.setSliderStyle(juce::Slider::LinearHorizontal);
     masterFilter.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    masterFilter.onValueChange = [this]() {
+        mixer.setMasterFilter(masterFilter.getValue());
+    };
     
     // style the master filter slider
     masterFilter.setColour(juce::Slider::thumbColourId, juce::Colour::fromRGB(255, 159, 67)); // Orange
@@ -93,89 +169,274 @@ MainComponent::MainComponent()
     masterFilterLabel.setColour(juce::Label::textColourId, juce::Colour::fromRGB(255, 180, 120));
     masterFilterLabel.setFont(juce::Font(10.0f, juce::Font::bold));
     addAndMakeVisible(masterFilterLabel);
+    
+    // PERF toggles the callback statistics overlay
+    perfButton.setClickingTogglesState(true);
+    perfButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour::fromRGB(64, 224, 208));
+    perfButton.setColour(juce::TextButton::textColourOnId, juce::Colours::black);
+    perfButton.onClick = [this]() {
+        performanceOverlay.setVisible(perfButton.getToggleState());
+    };
+    addAndMakeVisible(perfButton);
+    
+    // TRACE records every thread's trace events until it is switched off again
+    traceButton.setClickingTogglesState(true);
+    traceButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour::fromRGB(220, 20, 60));
+    traceButton.onClick = [this]() {
+        Tracing::setEnabled(traceButton.getToggleState());
+        
+        if (! traceButton.getToggleState())
+        {
+            auto traceFile = Tracing::getDefaultTraceFile();
+            auto result = Tracing::writeChromeTrace(traceFile);
+            juce::Logger::writeToLog(result.wasOk() ? "Trace saved to " + traceFile.getFullPathName()
+                                                    : "Trace not saved: " + result.getErrorMessage());
+        }
+    };
+    addAndMakeVisible(traceButton);
+    
+    // REC asks for a format, then records the master output until it is clicked again
+    recordButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour::fromRGB(220, 20, 60));
+    recordButton.onClick = [this]() {
+        if (recorder.isRecording())
+        {
+            recorder.stopRecording();
+            recordButton.setToggleState(false, juce::dontSendNotification);
+            
+            auto stats = recorder.getStats();
+            juce::Logger::writeToLog("Recording saved to " + recorder.getRecordingFile().getFullPathName()
+                                     + " - FIFO peak " + juce::String(stats.highWaterMark) + " of "
+                                     + juce::String(stats.fifoCapacity) + " samples, "
+                                     + juce::String(stats.droppedBlocks) + " blocks dropped");
+            return;
+        }
+        
+        juce::PopupMenu formatMenu;
+        formatMenu.addItem(1, "Record WAV");
+        formatMenu.addItem(2, "Record FLAC");
+        formatMenu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&recordButton), [this](int choice)
+        {
+            if (choice == 0)
+                return;
+            
+            auto result = recorder.startRecording(MasterRecorder::getDefaultRecordingFile(choice == 2 ? ".flac" : ".wav"));
+            recordButton.setToggleState(result.wasOk(), juce::dontSendNotification);
+            
+            if (result.failed())
+                juce::Logger::writeToLog("Recording failed: " + result.getErrorMessage());
+        });
+    };
+    addAndMakeVisible(recordButton);
+    
+    // MIDI lists the controllers to open and loads or saves the mapping
+    midiButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour::fromRGB(116, 185, 255));
+    midiButton.setColour(juce::TextButton::textColourOnId, juce::Colours::black);
+    midiButton.onClick = [this]() { showMidiMenu(); };
+    addAndMakeVisible(midiButton);
+    
+    performanceOverlay.setRecorder(&recorder);
+    performanceOverlay.setLimiter(&mixer.getLimiter());
+    performanceOverlay.setControllerInput(&controller);
+    
+    // added last so it sits on top of the decks
+    addChildComponent(performanceOverlay);
 
     // connects the playlist to decks for track loading
     playlistComponent.onTrackLoadRequest = [this](int deckIndex, const juce::File& audioFile)
     {
-        if (deckIndex == 0)
-            deckGUI1.loadTrack(audioFile);
-        else if (deckIndex == 1)
-            deckGUI2.loadTrack(audioFile);
+        if (auto* deckGUI = deckGUIs[deckIndex])
+            deckGUI->loadTrack(audioFile);
     };
     
-    // initialize crossfader mixing
-    updateCrossfaderMix();
+    // initialize the mixer from the controls
+    mixer.setCrossfader(crossfader.getValue());
+    mixer.setMasterVolume(masterVolume.getValue());
+    mixer.setMasterFilter(masterFilter.getValue());
+    mixer.setCueMix(cueMix.getValue());
 }
 
 MainComponent::~MainComponent()
 {
-    // This shuts down the audio device and clears the audio source.
+    // no more MIDI, then the audio device shuts down and clears the audio source
+    controller.closeDevice();
+    deviceManager.removeChangeListener(this);
     shutdownAudio();
 }
 
-void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+void MainComponent::loadMapping(const juce::File& mappingFile)
 {
-    this->sampleRate = sampleRate;
-    player1.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    player2.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    auto mapping = std::make_unique<MidiMapping>();
+    auto result = mapping->loadFromFile(mappingFile);
+    
+    if (result.failed())
+    {
+        // a missing file is the usual case - anything else is worth reporting
+        if (mappingFile.existsAsFile())
+            juce::Logger::writeToLog("Mapping not loaded, using the default layout: " + result.getErrorMessage());
+        
+        mapping->loadFromJSON(MidiMapping::getDefaultJSON(players.size()));
+    }
+    
+    controller.setMapping(std::move(mapping));
 }
 
-void MainComponent::getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill)
+void MainComponent::showMidiMenu()
 {
-    // creates temporary buffers for each deck
-    juce::AudioBuffer<float> deck1Buffer(bufferToFill.buffer->getNumChannels(), bufferToFill.numSamples);
-    juce::AudioBuffer<float> deck2Buffer(bufferToFill.buffer->getNumChannels(), bufferToFill.numSamples);
+    auto devices = juce::MidiInput::getAvailableDevices();
+    auto currentDevice = controller.getDeviceName();
+    
+    juce::PopupMenu midiMenu;
+    for (int i = 0; i < devices.size(); ++i)
+        midiMenu.addItem(i + 1, devices[i].name, true, devices[i].name == currentDevice);
+    
+    if (devices.isEmpty())
+        midiMenu.addItem(-1, "No MIDI inputs found", false);
+    
+   #if JUCE_LINUX || JUCE_MAC
+    midiMenu.addItem(1000, "Virtual input \"OtoDecks\"", true, currentDevice == "OtoDecks");
+   #endif
+    midiMenu.addItem(1001, "Close MIDI input", currentDevice.isNotEmpty());
+    midiMenu.addSeparator();
+    midiMenu.addItem(1002, "Load mapping...");
+    midiMenu.addItem(1003, "Save default mapping to " + MidiMapping::getDefaultMappingFile().getFileName());
+    midiMenu.addSectionHeader("Mapping: " + controller.getMappingName());
+    
+    midiMenu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&midiButton), [this, devices](int choice)
+    {
+        auto result = juce::Result::ok();
+        
+        if (choice >= 1 && choice <= devices.size())
+            result = controller.openDevice(devices[choice - 1].identifier);
+        else if (choice == 1000)
+            result = controller.openVirtualDevice("OtoDecks");
+        else if (choice == 1001)
+            controller.closeDevice();
+        else if (choice == 1002)
+        {
+            mappingChooser = std::make_unique<juce::FileChooser>("Select a controller mapping...",
+                                                                 MidiMapping::getDefaultMappingFile().getParentDirectory(), "*.json");
+            mappingChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                                        [this](const juce::FileChooser& chooser)
+                                        {
+                                            if (chooser.getResult().existsAsFile())
+                                                loadMapping(chooser.getResult());
+                                        });
+        }
+        else if (choice == 1003)
+        {
+            // a template to edit, without overwriting a mapping already there
+            auto mappingFile = MidiMapping::getDefaultMappingFile();
+            mappingFile.getParentDirectory().createDirectory();
+            
+            if (mappingFile.existsAsFile() || ! mappingFile.replaceWithText(MidiMapping::getDefaultJSON(players.size())))
+                result = juce::Result::fail("Not saved, " + mappingFile.getFullPathName() + " already exists or can't be written");
+            else
+                juce::Logger::writeToLog("Default mapping saved to " + mappingFile.getFullPathName());
+        }
+        
+        midiButton.setToggleState(controller.getDeviceName().isNotEmpty(), juce::dontSendNotification);
+        
+        if (result.failed())
+            juce::Logger::writeToLog("MIDI: " + result.getErrorMessage());
+    });
+}
+
+void MainComponent::setOutputRouting(MixerEngine::OutputRouting routing)
+{
+    mixer.setOutputRouting(routing);
+    
+    // the device restarts with the outputs the routing needs
+    int neededOutputs = mixer.getNumOutputChannels();
+    auto setup = deviceManager.getAudioDeviceSetup();
+    setup.useDefaultOutputChannels = false;
+    setup.outputChannels.clear();
+    setup.outputChannels.setRange(0, neededOutputs, true);
+    
+    auto error = deviceManager.setAudioDeviceSetup(setup, true);
+    auto* device = deviceManager.getCurrentAudioDevice();
+    int openOutputs = device != nullptr ? device->getActiveOutputChannels().countNumberOfSetBits() : 0;
+    
+    if (error.isNotEmpty())
+        juce::Logger::writeToLog("Outputs not changed: " + error);
+    else if (openOutputs < neededOutputs)
+        juce::Logger::writeToLog("The audio device has " + juce::String(openOutputs) + " of the "
+                                 + juce::String(neededOutputs) + " outputs this routing needs - the rest aren't heard");
     
-    // gets the audio from each of the decks
-    juce::AudioSourceChannelInfo deck1Info(&deck1Buffer, 0, bufferToFill.numSamples);
-    juce::AudioSourceChannelInfo deck2Info(&deck2Buffer, 0, bufferToFill.numSamples);
+    outputsButton.setToggleState(routing != MixerEngine::OutputRouting::master, juce::dontSendNotification);
     
-    player1.getNextAudioBlock(deck1Info);
-    player2.getNextAudioBlock(deck2Info);
+    // the device may not have changed, but the routing has
+    saveAudioSettings();
+}
+
+void MainComponent::showAudioSettings()
+{
+    juce::DialogWindow::LaunchOptions options;
+    options.content.setOwned(new AudioSettingsComponent(deviceManager, mixer, MixerEngine::MAX_OUTPUT_CHANNELS));
+    options.dialogTitle = "Audio settings";
+    options.dialogBackgroundColour = juce::Colour::fromRGB(28, 28, 28);
+    options.escapeKeyTriggersCloseButton = true;
+    options.useNativeTitleBar = true;
+    options.resizable = false;
+    options.launchAsync();
+}
+
+void MainComponent::changeListenerCallback(juce::ChangeBroadcaster*)
+{
+    saveAudioSettings();
+}
+
+void MainComponent::saveAudioSettings()
+{
+    auto result = AudioSettings::save(AudioSettings::getDefaultSettingsFile(), deviceManager, mixer.getOutputRouting());
     
-    // clears the output buffer
-    bufferToFill.clearActiveBufferRegion();
+    if (result.failed())
+        juce::Logger::writeToLog("Audio settings not saved: " + result.getErrorMessage());
+}
+
+void MainComponent::showOutputsMenu()
+{
+    using Routing = MixerEngine::OutputRouting;
+    auto routing = mixer.getOutputRouting();
+    auto* device = deviceManager.getCurrentAudioDevice();
     
-    // mix with crossfader gains and apply master filter
-    double filterValue = masterFilter.getValue();
+    juce::PopupMenu outputsMenu;
+    outputsMenu.addItem(4, "Audio device settings...");
+    outputsMenu.addSeparator();
     
-    for (int channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+    if (device != nullptr)
+        outputsMenu.addSectionHeader(device->getName() + " - " + juce::String(device->getOutputChannelNames().size()) + " outputs");
+    
+    outputsMenu.addItem(1, "Master on 1/2", true, routing == Routing::master);
+    outputsMenu.addItem(2, "Master on 1/2, headphone cue on 3/4", true, routing == Routing::masterAndCue);
+    outputsMenu.addItem(3, "Each deck on its own pair and the pads after them, for an external mixer", true, routing == Routing::separateDecks);
+    
+    outputsMenu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&outputsButton), [this](int choice)
     {
-        auto* outputData = bufferToFill.buffer->getWritePointer(channel, bufferToFill.startSample);
-        const auto* deck1Data = deck1Buffer.getReadPointer(channel);
-        const auto* deck2Data = deck2Buffer.getReadPointer(channel);
-        
-        for (int sample = 0; sample < bufferToFill.numSamples; ++sample)
-        {
-            float mixedSample = (deck1Data[sample] * crossfaderLeftGain) + 
-                               (deck2Data[sample] * crossfaderRightGain);
-            
-            // Apply master filter effect
-            if (filterValue < 0.5)
-            {
-                // Low-pass filter (cut highs) - left side of slider
-                float cutoffRatio = filterValue * 2.0f; 
-                float filterFactor = 0.1f + (cutoffRatio * 0.9f); 
-                mixedSample *= filterFactor;
-            }
-            else if (filterValue > 0.5)
-            {
-                // High-pass filter (cut lows) - right side of slider
-                float cutoffRatio = (filterValue - 0.5f) * 2.0f; 
-                float filterFactor = 1.0f - (cutoffRatio * 0.7f); 
-                mixedSample = mixedSample * filterFactor + (mixedSample * 0.3f * cutoffRatio);
-            }
-            
-            // Master volume
-            outputData[sample] = mixedSample * static_cast<float>(masterVolume.getValue());
-        }
-    }
+        if (choice == 1)
+            setOutputRouting(Routing::master);
+        else if (choice == 2)
+            setOutputRouting(Routing::masterAndCue);
+        else if (choice == 3)
+            setOutputRouting(Routing::separateDecks);
+        else if (choice == 4)
+            showAudioSettings();
+    });
+}
+
+void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+{
+    mixer.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    recorder.prepareToPlay(samplesPerBlockExpected, sampleRate);
+}
+
+void MainComponent::getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    mixer.getNextAudioBlock(bufferToFill);
 }
 
 void MainComponent::releaseResources()
 {
-    player1.releaseResources();
-    player2.releaseResources();
+    mixer.releaseResources();
 }
 
 void MainComponent::paint (juce::Graphics& g)
@@ -192,9 +453,9 @@ void MainComponent::paint (juce::Graphics& g)
     auto playlistHeight = getHeight() * 0.3;
     auto crossfaderY = bounds.getBottom() - playlistHeight - 43;
     
-    juce::Rectangle<int> crossfaderPanel(bounds.getX() + (bounds.getWidth() - 720) / 2, 
+    juce::Rectangle<int> crossfaderPanel(bounds.getX() + (bounds.getWidth() - 780) / 2, 
                                         crossfaderY, 
-                                        720, 
+                                        780, 
                                         35);
     
     g.setColour(juce::Colour::fromRGB(35, 35, 45).withAlpha(0.8f));
@@ -220,7 +481,7 @@ void MainComponent::resized()
     
     // Crossfader area between decks and playlist
     auto crossfaderArea = area.removeFromBottom(35);
-    auto crossfaderPanelArea = crossfaderArea.withSizeKeepingCentre(720, 25);
+    auto crossfaderPanelArea = crossfaderArea.withSizeKeepingCentre(780, 25);
     
     // Crossfader label inside the panel on the left
     auto labelArea = crossfaderPanelArea.removeFromLeft(80);
@@ -258,29 +519,53 @@ void MainComponent::resized()
     // Small gap
     crossfaderPanelArea.removeFromLeft(10);
     
+    // REC, TRACE, MIDI and PERF buttons on the far right
+    perfButton.setBounds(crossfaderPanelArea.removeFromRight(40));
+    crossfaderPanelArea.removeFromRight(4);
+    midiButton.setBounds(crossfaderPanelArea.removeFromRight(40));
+    crossfaderPanelArea.removeFromRight(4);
+    traceButton.setBounds(crossfaderPanelArea.removeFromRight(48));
+    crossfaderPanelArea.removeFromRight(4);
+    recordButton.setBounds(crossfaderPanelArea.removeFromRight(40));
+    crossfaderPanelArea.removeFromRight(8);
+    
     // Master filter slider in remaining space
     masterFilter.setBounds(crossfaderPanelArea);
     
     // Add gap between crossfader and decks
     area.removeFromBottom(8);
     
-    // splits the remaining area equally between the two decks
-    auto deckWidth = (area.getWidth() - 10) / 2;
-    auto leftDeckArea = area.removeFromLeft(deckWidth);
-    area.removeFromLeft(10); // small gap between decks
-    auto rightDeckArea = area;
+    // master meter on the right of the decks
+    masterMeter.setBounds(area.removeFromRight(40));
+    area.removeFromRight(8);
     
-    // set deck positions
-    deckGUI1.setBounds(leftDeckArea);
-    deckGUI2.setBounds(rightDeckArea);
-}
+    // sample pads between the decks and the master meter, over the cue mix and outputs
+    auto padsArea = area.removeFromRight(PADS_WIDTH);
+    area.removeFromRight(8);
+    
+    outputsButton.setBounds(padsArea.removeFromBottom(24));
+    padsArea.removeFromBottom(4);
+    cueMix.setBounds(padsArea.removeFromBottom(22));
+    cueMixLabel.setBounds(padsArea.removeFromBottom(14));
+    padsArea.removeFromBottom(6);
+    samplePads.setBounds(padsArea);
 
-void MainComponent::updateCrossfaderMix()
-{
-    // crossfader value: 0.0 = full left (deck1), 1.0 = full right (deck2)
-    double crossfaderPos = crossfader.getValue();
+    // splits the remaining area equally between the decks - one row for up to four, two rows beyond that
+    int numRows = deckGUIs.size() <= 4 ? 1 : 2;
+    int numColumns = (deckGUIs.size() + numRows - 1) / numRows;
+    auto deckWidth = (area.getWidth() - 10 * (numColumns - 1)) / numColumns;
+    auto deckHeight = (area.getHeight() - 10 * (numRows - 1)) / numRows;
+    
+    // set deck positions, with a small gap between decks
+    for (int i = 0; i < deckGUIs.size(); ++i)
+    {
+        int row = i / numColumns;
+        int column = i % numColumns;
+        deckGUIs[i]->setBounds(area.getX() + column * (deckWidth + 10),
+                               area.getY() + row * (deckHeight + 10),
+                               deckWidth, deckHeight);
+    }
     
-    // calculate gain for each deck using crossfading curve
-    crossfaderLeftGain = std::cos(crossfaderPos * juce::MathConstants<double>::halfPi);
-    crossfaderRightGain = std::sin(crossfaderPos * juce::MathConstants<double>::halfPi);
-}
\ No newline at end of file
+    // overlay in the top right corner of the decks
+    performanceOverlay.setBounds(area.getRight() - 330, area.getY() + 60, 320, 235);
+}
@@ -9,11 +9,18 @@
 #include "DJAudioPlayer.h"
 #include "DeckGUI.h"
 #include "PlaylistComponent.h"
+#include "MixerEngine.h"
+#include "PerformanceOverlay.h"
+#include "MasterRecorder.h"
+#include "SamplePadComponent.h"
+#include "AudioSettings.h"
 
-class MainComponent  : public juce::AudioAppComponent
+class MainComponent  : public juce::AudioAppComponent,
+                       private juce::ChangeListener
 {
 public:
-    MainComponent();
+    // numDecks is clamped to the mixer's 2 to 8 deck range
+    explicit MainComponent(int numDecks = MixerEngine::MIN_DECKS);
     ~MainComponent() override;
 
     void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
@@ -24,29 +31,37 @@ public:
     void resized() override;
     
 private:
-    
-    // crossfader mixing logic
-    void updateCrossfaderMix();
 
     // WaveForm display
     juce::AudioFormatManager formatManager;
     juce::AudioThumbnailCache thumbnailCache{100};
 
-    // Audio players and mixers
-    DJAudioPlayer player1{formatManager};
-    DJAudioPlayer player2{formatManager};
-    juce::MixerAudioSource mixerSource;
+    // Audio players and the mixer that renders and blends them
+    juce::OwnedArray<DJAudioPlayer> players;
+    MixerEngine mixer;
+    
+    // GUI components - one for each deck
+    juce::OwnedArray<DeckGUI> deckGUIs;
+
+    // master output level, beside the decks
+    LevelMeterComponent masterMeter;
+
+    // sample pads, between the decks and the master meter
+    SamplePadComponent samplePads;
     
-    // crossfader gains for mixer
-    double crossfaderLeftGain = 0.707; 
-    double crossfaderRightGain = 0.707;
+    // headphone cue blend and the output routing, under the sample pads
+    juce::Slider cueMix;
+    juce::Label cueMixLabel;
+    juce::TextButton outputsButton{"OUTPUTS"};
     
-    // sample rate for audio processing
-    double sampleRate = 44100.0;
+    // Routes the mixer and opens as many device outputs as the routing needs (message thread)
+    void setOutputRouting(MixerEngine::OutputRouting routing);
+    void showOutputsMenu();
+    void showAudioSettings();
     
-    // GUI components - one for each deck
-    DeckGUI deckGUI1{&player1, formatManager, thumbnailCache};
-    DeckGUI deckGUI2{&player2, formatManager, thumbnailCache};
+    // saves the device setup and routing whenever the device changes
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    void saveAudioSettings();
 
     PlaylistComponent playlistComponent;
     
@@ -61,6 +76,28 @@ private:
     // master filter slider
     juce::Slider masterFilter;
     juce::Label masterFilterLabel;
+    
+    // audio callback statistics, shown over the decks with the PERF button
+    juce::TextButton perfButton{"PERF"};
+    PerformanceOverlay performanceOverlay;
+    
+    // records a Chrome trace while on, and saves it when switched off
+    juce::TextButton traceButton{"TRACE"};
+    
+    // records the master output to disk from a background thread
+    MasterRecorder recorder;
+    juce::TextButton recordButton{"REC"};
+    
+    // MIDI controller input, straight to the audio thread - MIDI picks the device and the mapping
+    MidiControllerInput controller;
+    juce::TextButton midiButton{"MIDI"};
+    std::unique_ptr<juce::FileChooser> mappingChooser;
+    
+    // Loads a mapping file, or the default layout if it can't (message thread)
+    void loadMapping(const juce::File& mappingFile);
+    void showMidiMenu();
+
+    static constexpr int PADS_WIDTH = 120;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
\ No newline at end of file
@@ -0,0 +1,156 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "MasterLimiter.h"
+#include "VectorOps.h"
+
+MasterLimiter::MasterLimiter()
+{
+    setCeiling(DEFAULT_CEILING_DB);
+    prepareToPlay(512, 44100.0);
+}
+
+void MasterLimiter::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    latency = juce::jmax(1, juce::roundToInt(sampleRate * LOOKAHEAD_SECONDS));
+    windowLength = latency + 1;
+    maxBlockSize = juce::jmax(1, samplesPerBlockExpected);
+    releaseCoefficient = static_cast<float>(1.0 - std::exp(-1.0 / (RELEASE_SECONDS * sampleRate)));
+
+    delayLine.setSize(2, latency + maxBlockSize);
+    delayLine.clear();
+    peakBuffer.allocate((size_t) maxBlockSize, true);
+    gainBuffer.allocate((size_t) maxBlockSize, true);
+
+    minimumValues.allocate((size_t) windowLength, true);
+    minimumIndices.allocate((size_t) windowLength, true);
+    minimumHead = 0;
+    minimumSize = 0;
+    sampleIndex = 0;
+
+    // the average starts out at unity gain
+    averageRing.allocate((size_t) windowLength, false);
+    for (int i = 0; i < windowLength; ++i)
+        averageRing[i] = 1.0f;
+    averagePosition = 0;
+    averageSum = windowLength;
+
+    releasedGain = 1.0f;
+    gainReduction = 0.0f;
+}
+
+void MasterLimiter::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    if (buffer.getNumChannels() == 0)
+        return;
+
+    // mono is limited as both sides of a pair
+    float* left = buffer.getWritePointer(0, startSample);
+    float* right = buffer.getNumChannels() > 1 ? buffer.getWritePointer(1, startSample) : nullptr;
+
+    float lowestGain = 1.0f;
+
+    // A block bigger than prepareToPlay promised is limited in pieces rather than reallocating
+    for (int done = 0; done < numSamples;)
+    {
+        int chunk = juce::jmin(maxBlockSize, numSamples - done);
+        processChunk(left + done, right != nullptr ? right + done : nullptr, chunk);
+        lowestGain = juce::jmin(lowestGain, juce::FloatVectorOperations::findMinimum(gainBuffer.get(), chunk));
+        done += chunk;
+    }
+
+    gainReduction.store(juce::Decibels::gainToDecibels(lowestGain), std::memory_order_relaxed);
+}
+
+void MasterLimiter::processChunk(float* left, float* right, int numSamples)
+{
+    if (right != nullptr)
+        VectorOps::maxAbs(peakBuffer, left, right, numSamples);
+    else
+        juce::FloatVectorOperations::abs(peakBuffer, left, numSamples);
+
+    const float limit = ceiling.load(std::memory_order_relaxed);
+    const bool limiting = enabled.load(std::memory_order_relaxed);
+
+    for (int i = 0; i < numSamples; ++i, ++sampleIndex)
+    {
+        float peak = peakBuffer[i];
+        float required = limiting && peak > limit ? limit / peak : 1.0f;
+
+        // Lowest gain needed by any sample in the window - expired entries leave the front,
+        // and entries needing more gain than this sample leave the back
+        if (minimumSize > 0 && minimumIndices[minimumHead] <= sampleIndex - windowLength)
+        {
+            minimumHead = (minimumHead + 1) % windowLength;
+            --minimumSize;
+        }
+
+        while (minimumSize > 0 && minimumValues[(minimumHead + minimumSize - 1) % windowLength] >= required)
+            --minimumSize;
+
+        int back = (minimumHead + minimumSize) % windowLength;
+        minimumValues[back] = required;
+        minimumIndices[back] = sampleIndex;
+        ++minimumSize;
+
+        // drops straight to the held gain, recovers at the release rate
+        float held = minimumValues[minimumHead];
+        releasedGain = held < releasedGain ? held : releasedGain + releaseCoefficient * (held - releasedGain);
+
+        // The average ramps down over the window, reaching the held gain as the peak leaves the delay
+        averageSum += releasedGain - averageRing[averagePosition];
+        averageRing[averagePosition] = releasedGain;
+        averagePosition = (averagePosition + 1) % windowLength;
+        gainBuffer[i] = static_cast<float>(averageSum / windowLength);
+    }
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        float* data = channel == 0 ? left : right;
+
+        if (data == nullptr)
+            continue;
+
+        // delayed samples out, the new block in behind them
+        float* delayed = delayLine.getWritePointer(channel);
+        juce::FloatVectorOperations::copy(delayed + latency, data, numSamples);
+        juce::FloatVectorOperations::multiply(data, delayed, gainBuffer, numSamples);
+        std::memmove(delayed, delayed + numSamples, sizeof(float) * (size_t) latency);
+
+        // rounding in the average can leave the odd sample a hair over the ceiling
+        if (limiting)
+            juce::FloatVectorOperations::clip(data, data, -limit, limit, numSamples);
+    }
+}
+
+int MasterLimiter::getLatencyInSamples() const
+{
+    return latency;
+}
+
+void MasterLimiter::setEnabled(bool shouldBeEnabled)
+{
+    enabled = shouldBeEnabled;
+}
+
+bool MasterLimiter::isEnabled() const
+{
+    return enabled;
+}
+
+void MasterLimiter::setCeiling(float ceilingDecibels)
+{
+    ceiling = juce::Decibels::decibelsToGain(juce::jmin(0.0f, ceilingDecibels));
+}
+
+float MasterLimiter::getCeiling() const
+{
+    return juce::Decibels::gainToDecibels(ceiling.load());
+}
+
+float MasterLimiter::getGainReductionDecibels() const
+{
+    return gainReduction.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,77 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Look-ahead brick-wall limiter for the master bus. The stereo-linked peak of each sample sets
+// the gain it needs; a minimum over the look-ahead window followed by a moving average of the
+// same length turns that into a smooth gain that is already down when the peak comes out of
+// the delay line, so nothing gets past the ceiling. The delay is a fixed 1.5 ms, reported by
+// getLatencyInSamples(). Everything is allocated in prepareToPlay.
+class MasterLimiter
+{
+public:
+    MasterLimiter();
+
+    // Allocates the delay line and the gain buffers (message thread, before audio starts)
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+
+    // Limits the first two channels in place (audio thread)
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    // The same for the whole time the device runs, whether the limiter is on or off
+    int getLatencyInSamples() const;
+
+    // Switching off lets the gain recover and carries on delaying, so the latency never changes
+    void setEnabled(bool shouldBeEnabled);
+    bool isEnabled() const;
+
+    void setCeiling(float ceilingDecibels);
+    float getCeiling() const;
+
+    // Most gain reduction in the last block, 0 dB or below
+    float getGainReductionDecibels() const;
+
+    static constexpr double LOOKAHEAD_SECONDS = 0.0015;
+    static constexpr double RELEASE_SECONDS = 0.1;
+    static constexpr float DEFAULT_CEILING_DB = -0.3f;
+
+private:
+    // Limits up to maxBlockSize samples
+    void processChunk(float* left, float* right, int numSamples);
+
+    int latency{0};
+    // The window the gain is held and averaged over, one longer than the delay
+    int windowLength{1};
+    int maxBlockSize{0};
+    float releaseCoefficient{0.0f};
+
+    // Each channel holds the delayed samples followed by the incoming block
+    juce::AudioBuffer<float> delayLine;
+    juce::HeapBlock<float> peakBuffer;
+    juce::HeapBlock<float> gainBuffer;
+
+    // Sliding minimum of the required gain - a monotonic queue in a ring
+    juce::HeapBlock<float> minimumValues;
+    juce::HeapBlock<juce::int64> minimumIndices;
+    int minimumHead{0};
+    int minimumSize{0};
+    juce::int64 sampleIndex{0};
+
+    // Moving average of the held gain
+    juce::HeapBlock<float> averageRing;
+    int averagePosition{0};
+    double averageSum{0.0};
+
+    float releasedGain{1.0f};
+
+    std::atomic<bool> enabled{true};
+    std::atomic<float> ceiling{1.0f};
+    std::atomic<float> gainReduction{0.0f};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MasterLimiter)
+};
@@ -0,0 +1,186 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "MasterRecorder.h"
+
+MasterRecorder::MasterRecorder()
+    : juce::Thread("Master recorder")
+{
+}
+
+MasterRecorder::~MasterRecorder()
+{
+    stopRecording();
+}
+
+void MasterRecorder::prepareToPlay(int samplesPerBlockExpected, double newSampleRate)
+{
+    // a recording can't change sample rate part way through
+    if (isRecording() && newSampleRate != sampleRate)
+        stopRecording();
+
+    sampleRate = newSampleRate;
+
+    if (isRecording())
+        return;
+
+    int capacity = juce::jmax(samplesPerBlockExpected * 4, static_cast<int>(sampleRate * FIFO_SECONDS));
+    fifo.setTotalSize(capacity);
+    fifoBuffer.setSize(2, capacity);
+}
+
+juce::Result MasterRecorder::startRecording(const juce::File& file)
+{
+    stopRecording();
+
+    file.deleteFile();
+    std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+
+    if (stream == nullptr)
+        return juce::Result::fail("Can't write to " + file.getFullPathName());
+
+    std::unique_ptr<juce::AudioFormat> format;
+    if (file.hasFileExtension(".flac"))
+        format = std::make_unique<juce::FlacAudioFormat>();
+    else
+        format = std::make_unique<juce::WavAudioFormat>();
+
+    writer.reset(format->createWriterFor(stream.get(), sampleRate, 2, 24, {}, 0));
+
+    if (writer == nullptr)
+        return juce::Result::fail("Can't record " + format->getFormatName() + " at " + juce::String(sampleRate) + " Hz");
+
+    // the writer owns the stream now
+    stream.release();
+    recordingFile = file;
+
+    fifo.reset();
+    samplesWritten = 0;
+    highWaterMark = 0;
+    droppedBlocks = 0;
+    droppedSamples = 0;
+    writeFailed = false;
+
+    recording.store(true, std::memory_order_release);
+    startThread();
+
+    return juce::Result::ok();
+}
+
+void MasterRecorder::stopRecording()
+{
+    if (! isRecording())
+        return;
+
+    // The audio thread stops pushing first, then the writer drains the FIFO and exits
+    recording.store(false, std::memory_order_release);
+    stopThread(5000);
+
+    writeAvailable();
+    writer.reset();
+}
+
+bool MasterRecorder::isRecording() const
+{
+    return recording.load(std::memory_order_acquire);
+}
+
+juce::File MasterRecorder::getRecordingFile() const
+{
+    return recordingFile;
+}
+
+void MasterRecorder::pushBlock(const juce::AudioSourceChannelInfo& block)
+{
+    if (! recording.load(std::memory_order_acquire))
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(block.numSamples, start1, size1, start2, size2);
+
+    // Never waits for the disk - a block that doesn't fit is dropped whole and counted
+    if (size1 + size2 < block.numSamples)
+    {
+        droppedBlocks.store(droppedBlocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        droppedSamples.store(droppedSamples.load(std::memory_order_relaxed) + block.numSamples, std::memory_order_relaxed);
+        return;
+    }
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        // mono devices record the same signal on both sides
+        int sourceChannel = juce::jmin(channel, block.buffer->getNumChannels() - 1);
+
+        if (size1 > 0)
+            fifoBuffer.copyFrom(channel, start1, *block.buffer, sourceChannel, block.startSample, size1);
+        if (size2 > 0)
+            fifoBuffer.copyFrom(channel, start2, *block.buffer, sourceChannel, block.startSample + size1, size2);
+    }
+
+    fifo.finishedWrite(size1 + size2);
+
+    int waiting = fifo.getNumReady();
+    if (waiting > highWaterMark.load(std::memory_order_relaxed))
+        highWaterMark.store(waiting, std::memory_order_relaxed);
+}
+
+void MasterRecorder::run()
+{
+    while (! threadShouldExit())
+    {
+        if (writeAvailable() == 0)
+            wait(WRITER_POLL_MS);
+    }
+}
+
+int MasterRecorder::writeAvailable()
+{
+    if (writer == nullptr)
+        return 0;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+    bool ok = true;
+
+    if (size1 > 0)
+    {
+        const float* channels[] = { fifoBuffer.getReadPointer(0, start1), fifoBuffer.getReadPointer(1, start1) };
+        ok = writer->writeFromFloatArrays(channels, 2, size1);
+    }
+
+    if (size2 > 0 && ok)
+    {
+        const float* channels[] = { fifoBuffer.getReadPointer(0, start2), fifoBuffer.getReadPointer(1, start2) };
+        ok = writer->writeFromFloatArrays(channels, 2, size2);
+    }
+
+    fifo.finishedRead(size1 + size2);
+
+    if (! ok)
+        writeFailed = true;
+
+    samplesWritten += size1 + size2;
+    return size1 + size2;
+}
+
+MasterRecorder::Stats MasterRecorder::getStats() const
+{
+    Stats stats;
+    stats.samplesWritten = samplesWritten.load();
+    stats.fifoCapacity = fifo.getTotalSize();
+    stats.highWaterMark = highWaterMark.load();
+    stats.droppedBlocks = droppedBlocks.load();
+    stats.droppedSamples = droppedSamples.load();
+    stats.writeFailed = writeFailed.load();
+    return stats;
+}
+
+juce::File MasterRecorder::getDefaultRecordingFile(const juce::String& extension)
+{
+    auto folder = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("OtoDecks");
+    folder.createDirectory();
+    return folder.getChildFile("set-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + extension);
+}
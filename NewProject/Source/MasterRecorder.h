@@ -0,0 +1,77 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Records the master output to a WAV or FLAC file. The audio thread only copies each block
+// into a preallocated lock-free FIFO; a background thread empties it to disk, so a slow disk
+// can never hold up the audio callback. If the FIFO does fill up, whole blocks are dropped
+// and counted rather than waiting for space.
+class MasterRecorder : private juce::Thread
+{
+public:
+    struct Stats
+    {
+        juce::int64 samplesWritten{0};
+        int fifoCapacity{0};
+        int highWaterMark{0};        // most samples ever waiting in the FIFO
+        juce::uint32 droppedBlocks{0};
+        juce::int64 droppedSamples{0};
+        bool writeFailed{false};
+    };
+
+    MasterRecorder();
+    ~MasterRecorder() override;
+
+    // Allocates the FIFO for the device's sample rate (message thread, before audio starts)
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+
+    // Starts recording to a 24 bit file - FLAC if the file ends in .flac, otherwise WAV (message thread)
+    juce::Result startRecording(const juce::File& file);
+
+    // Stops recording and writes whatever is left in the FIFO (message thread)
+    void stopRecording();
+
+    bool isRecording() const;
+    juce::File getRecordingFile() const;
+
+    // Copies the block into the FIFO while recording (audio thread)
+    void pushBlock(const juce::AudioSourceChannelInfo& block);
+
+    Stats getStats() const;
+
+    // Default location for a new recording, in the OtoDecks documents folder
+    static juce::File getDefaultRecordingFile(const juce::String& extension);
+
+    // The FIFO holds this much audio, to ride out long disk stalls
+    static constexpr double FIFO_SECONDS = 10.0;
+
+private:
+    void run() override;
+
+    // Writes everything waiting in the FIFO, returns the number of samples written
+    int writeAvailable();
+
+    juce::AbstractFifo fifo{1};
+    juce::AudioBuffer<float> fifoBuffer;
+    double sampleRate{44100.0};
+
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    juce::File recordingFile;
+    std::atomic<bool> recording{false};
+
+    std::atomic<juce::int64> samplesWritten{0};
+    std::atomic<int> highWaterMark{0};
+    std::atomic<juce::uint32> droppedBlocks{0};
+    std::atomic<juce::int64> droppedSamples{0};
+    std::atomic<bool> writeFailed{false};
+
+    // How often the writer thread checks the FIFO - well inside its capacity
+    static constexpr int WRITER_POLL_MS = 20;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MasterRecorder)
+};
@@ -0,0 +1,192 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "MidiControllerInput.h"
+
+MidiControllerInput::MidiControllerInput()
+    : mapping(std::make_unique<MidiMapping>())
+{
+}
+
+MidiControllerInput::~MidiControllerInput()
+{
+    closeDevice();
+}
+
+juce::Result MidiControllerInput::openDevice(const juce::String& identifier)
+{
+    closeDevice();
+    input = juce::MidiInput::openDevice(identifier, this);
+
+    if (input == nullptr)
+        return juce::Result::fail("Couldn't open MIDI input " + identifier);
+
+    input->start();
+    return juce::Result::ok();
+}
+
+juce::Result MidiControllerInput::openVirtualDevice(const juce::String& name)
+{
+   #if JUCE_LINUX || JUCE_MAC
+    closeDevice();
+    input = juce::MidiInput::createNewDevice(name, this);
+
+    if (input == nullptr)
+        return juce::Result::fail("Couldn't create the virtual MIDI input " + name);
+
+    input->start();
+    return juce::Result::ok();
+   #else
+    juce::ignoreUnused(name);
+    return juce::Result::fail("Virtual MIDI inputs aren't supported on this platform");
+   #endif
+}
+
+void MidiControllerInput::closeDevice()
+{
+    // once stop returns the MIDI thread has finished with the callback
+    if (input != nullptr)
+        input->stop();
+
+    input.reset();
+}
+
+juce::String MidiControllerInput::getDeviceName() const
+{
+    return input != nullptr ? input->getName() : juce::String();
+}
+
+void MidiControllerInput::setMapping(std::unique_ptr<MidiMapping> newMapping)
+{
+    if (newMapping == nullptr)
+        return;
+
+    if (input != nullptr)
+        input->stop();
+
+    mapping = std::move(newMapping);
+    topBits = {};
+
+    if (input != nullptr)
+        input->start();
+}
+
+juce::String MidiControllerInput::getMappingName() const
+{
+    return mapping->getName();
+}
+
+void MidiControllerInput::handleIncomingMidiMessage(juce::MidiInput*, const juce::MidiMessage& message)
+{
+    processMessage(message, juce::Time::getMillisecondCounterHiRes());
+}
+
+void MidiControllerInput::processMessage(const juce::MidiMessage& message, double receivedMs)
+{
+    int channel = message.getChannel();
+
+    if (message.isController())
+    {
+        int number = message.getControllerNumber();
+        int value = message.getControllerValue();
+        auto* control = mapping->findController(channel, number);
+
+        if (control == nullptr)
+            return;
+
+        if (control->target == MidiMapping::Target::jog)
+        {
+            // relative - 1 to 63 ticks forwards, 127 down to 65 backwards
+            int ticks = value < 64 ? value : value - 128;
+            if (ticks != 0)
+                push(*control, ticks * control->scale, receivedMs);
+        }
+        else if (MidiMapping::isButton(control->target))
+        {
+            push(*control, value >= 64 ? 1.0 : 0.0, receivedMs);
+        }
+        else
+        {
+            double position = value / 127.0;
+
+            if (control->highResolution)
+            {
+                auto& top = topBits[(size_t) (channel - 1)][(size_t) control->number];
+
+                // the top half arrives first and resets the bottom half
+                if (number == control->number)
+                    top = value;
+
+                position = ((top << 7) | (number == control->number ? 0 : value)) / 16383.0;
+            }
+
+            push(*control, control->minValue + (control->maxValue - control->minValue) * position, receivedMs);
+        }
+    }
+    else if (message.isNoteOnOrOff())
+    {
+        if (auto* control = mapping->findNote(channel, message.getNoteNumber()))
+        {
+            // a pad plays at the note's velocity - every other button just sees it pressed
+            double pressed = message.isNoteOn() ? juce::jmax(1.0f / 127.0f, message.getFloatVelocity()) : 0.0;
+            push(*control, control->target == MidiMapping::Target::pad ? pressed : (pressed > 0.0 ? 1.0 : 0.0), receivedMs);
+        }
+    }
+}
+
+void MidiControllerInput::push(const MidiMapping::Control& control, double value, double receivedMs)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 + size2 < 1)
+    {
+        numDropped = numDropped.load() + 1;
+        return;
+    }
+
+    auto& event = events[(size_t) (size1 > 0 ? start1 : start2)];
+    event.target = control.target;
+    event.deckIndex = control.deckIndex;
+    event.index = control.index;
+    event.value = value;
+    event.receivedMs = receivedMs;
+    fifo.finishedWrite(1);
+}
+
+bool MidiControllerInput::popEvent(ControllerEvent& event)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(1, start1, size1, start2, size2);
+
+    if (size1 + size2 < 1)
+        return false;
+
+    event = events[(size_t) (size1 > 0 ? start1 : start2)];
+    fifo.finishedRead(1);
+    return true;
+}
+
+void MidiControllerInput::recordLatency(const ControllerEvent& event)
+{
+    double latency = juce::jmax(0.0, juce::Time::getMillisecondCounterHiRes() - event.receivedMs);
+
+    // only the audio thread writes these
+    totalLatencyMs = totalLatencyMs.load() + latency;
+    numEvents = numEvents.load() + 1;
+
+    if (latency > maxLatencyMs.load())
+        maxLatencyMs = latency;
+}
+
+MidiControllerInput::LatencyStats MidiControllerInput::getLatencyStats() const
+{
+    LatencyStats stats;
+    stats.numEvents = numEvents.load();
+    stats.numDropped = numDropped.load();
+    stats.averageMs = stats.numEvents > 0 ? totalLatencyMs.load() / stats.numEvents : 0.0;
+    stats.maxMs = maxLatencyMs.load();
+    return stats;
+}
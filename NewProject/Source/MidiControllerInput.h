@@ -0,0 +1,85 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include "MidiMapping.h"
+
+// A control change from the MIDI controller, on its way to the audio thread
+struct ControllerEvent
+{
+    MidiMapping::Target target{MidiMapping::Target::volume};
+    int deckIndex{-1};
+    int index{0};           // the hot cue or pad
+    double value{0.0};      // in the control's range, seconds for a jog, 1 or 0 for a button pressed or released
+    double receivedMs{0.0}; // when the message came in, on the millisecond counter
+};
+
+// Reads a MIDI controller and turns its messages into ControllerEvents through a MidiMapping, on
+// the MIDI thread. The events skip the message thread altogether - they go through a single
+// producer, single consumer FIFO to the audio thread, which applies them at the top of its next
+// block and records how long each one took to get there.
+//
+// High resolution controls put their two 7 bit halves back together here. A new top half resets
+// the bottom one, as the MIDI spec has it, so a controller that only sends the top half still works.
+class MidiControllerInput : private juce::MidiInputCallback
+{
+public:
+    MidiControllerInput();
+    ~MidiControllerInput() override;
+
+    // Opens an input device by its identifier, closing any other (message thread)
+    juce::Result openDevice(const juce::String& identifier);
+    // Opens a virtual input other software can connect to, e.g. with aconnect on Linux (message thread)
+    juce::Result openVirtualDevice(const juce::String& name);
+    void closeDevice();
+    juce::String getDeviceName() const;
+
+    // Replaces the mapping - the device is paused while it swaps (message thread)
+    void setMapping(std::unique_ptr<MidiMapping> newMapping);
+    juce::String getMappingName() const;
+
+    // Maps one message and queues its event - the MIDI callback's work, public so a message can be
+    // fed in without a device (one thread at a time)
+    void processMessage(const juce::MidiMessage& message, double receivedMs);
+
+    // Audio thread - false once the queue is empty
+    bool popEvent(ControllerEvent& event);
+    // Audio thread - records how long an event took from the MIDI thread to being applied
+    void recordLatency(const ControllerEvent& event);
+
+    struct LatencyStats
+    {
+        juce::uint32 numEvents{0};
+        juce::uint32 numDropped{0};  // lost to a full queue
+        double averageMs{0.0};
+        double maxMs{0.0};
+    };
+    LatencyStats getLatencyStats() const;
+
+    static constexpr int CAPACITY = 512;
+
+private:
+    void handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message) override;
+    void push(const MidiMapping::Control& control, double value, double receivedMs);
+
+    std::unique_ptr<juce::MidiInput> input;
+    std::unique_ptr<MidiMapping> mapping;
+
+    // MIDI thread - the top 7 bits last seen on each channel's high resolution controllers
+    std::array<std::array<int, 32>, 16> topBits{};
+
+    juce::AbstractFifo fifo{CAPACITY};
+    std::array<ControllerEvent, CAPACITY> events;
+
+    std::atomic<juce::uint32> numEvents{0};
+    std::atomic<juce::uint32> numDropped{0};
+    std::atomic<double> totalLatencyMs{0.0};
+    std::atomic<double> maxLatencyMs{0.0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiControllerInput)
+};
@@ -0,0 +1,290 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "MidiMapping.h"
+#include "HotCueSource.h"
+#include "SamplePadBank.h"
+
+namespace
+{
+    struct TargetName
+    {
+        const char* name;
+        MidiMapping::Target target;
+    };
+
+    const TargetName targetNames[] = {
+        { "volume", MidiMapping::Target::volume },             { "speed", MidiMapping::Target::speed },
+        { "eqLow", MidiMapping::Target::eqLow },               { "eqMid", MidiMapping::Target::eqMid },
+        { "eqHigh", MidiMapping::Target::eqHigh },             { "crossfader", MidiMapping::Target::crossfader },
+        { "masterVolume", MidiMapping::Target::masterVolume }, { "masterFilter", MidiMapping::Target::masterFilter },
+        { "padVolume", MidiMapping::Target::padVolume },       { "jog", MidiMapping::Target::jog },
+        { "play", MidiMapping::Target::play },                 { "stop", MidiMapping::Target::stop },
+        { "hotCue", MidiMapping::Target::hotCue },             { "pad", MidiMapping::Target::pad },
+        { "jogTouch", MidiMapping::Target::jogTouch },         { "reverse", MidiMapping::Target::reverse },
+        { "censor", MidiMapping::Target::censor }
+    };
+}
+
+MidiMapping::MidiMapping()
+{
+}
+
+juce::Result MidiMapping::loadFromFile(const juce::File& file)
+{
+    if (! file.existsAsFile())
+        return juce::Result::fail("Mapping not found: " + file.getFullPathName());
+
+    return loadFromJSON(file.loadFileAsString());
+}
+
+juce::Result MidiMapping::loadFromJSON(const juce::String& json)
+{
+    juce::var mapping;
+    auto parseResult = juce::JSON::parse(json, mapping);
+
+    if (parseResult.failed())
+        return juce::Result::fail("Mapping is not valid JSON: " + parseResult.getErrorMessage());
+
+    if (! mapping.isObject())
+        return juce::Result::fail("Mapping must be a JSON object");
+
+    auto controlList = mapping.getProperty("controls", {});
+
+    if (! controlList.isArray())
+        return juce::Result::fail("Mapping has no controls array");
+
+    // Parsed in full before anything is replaced, so a bad file leaves the old mapping working
+    juce::Array<Control> parsed;
+    std::array<juce::int16, 16 * 128> parsedControllers{};
+    std::array<juce::int16, 16 * 128> parsedNotes{};
+
+    for (int i = 0; i < controlList.size(); ++i)
+    {
+        Control control;
+        auto result = parseControl(controlList[i], i + 1, control);
+
+        if (result.failed())
+            return result;
+
+        auto& lookup = control.isNote ? parsedNotes : parsedControllers;
+        int slot = (control.channel - 1) * 128 + control.number;
+        int lowSlot = slot + 32;
+
+        if (lookup[(size_t) slot] != 0 || (control.highResolution && lookup[(size_t) lowSlot] != 0))
+            return juce::Result::fail("Control " + juce::String(i + 1) + " uses a message an earlier control already has");
+
+        parsed.add(control);
+        lookup[(size_t) slot] = static_cast<juce::int16>(parsed.size());
+
+        if (control.highResolution)
+            lookup[(size_t) lowSlot] = static_cast<juce::int16>(parsed.size());
+    }
+
+    name = mapping.getProperty("name", "Unnamed controller").toString();
+    controls.swapWith(parsed);
+    controllerLookup = parsedControllers;
+    noteLookup = parsedNotes;
+    return juce::Result::ok();
+}
+
+juce::Result MidiMapping::parseControl(const juce::var& item, int position, Control& control) const
+{
+    auto error = [position](const juce::String& message)
+    {
+        return juce::Result::fail("Control " + juce::String(position) + " " + message);
+    };
+
+    bool hasController = item.hasProperty("cc");
+    bool hasNote = item.hasProperty("note");
+
+    if (hasController == hasNote)
+        return error("needs either a cc or a note number");
+
+    control.isNote = hasNote;
+    control.number = item.getProperty(hasNote ? "note" : "cc", 0);
+    control.channel = item.getProperty("channel", 1);
+
+    if (! juce::isPositiveAndBelow(control.number, 128) || control.channel < 1 || control.channel > 16)
+        return error("needs a number from 0 to 127 and a channel from 1 to 16");
+
+    auto targetName = item.getProperty("target", {}).toString();
+
+    if (! findTarget(targetName, control.target))
+        return error("has an unknown target \"" + targetName + "\"");
+
+    if (control.isNote && ! isButton(control.target))
+        return error("(" + targetName + ") needs a cc, not a note");
+
+    control.highResolution = item.getProperty("highResolution", false);
+
+    if (control.highResolution && (! isContinuous(control.target) || control.isNote || control.number >= 32))
+        return error("can only be high resolution on a continuous cc from 0 to 31");
+
+    bool isMaster = control.target == Target::crossfader || control.target == Target::masterVolume
+                 || control.target == Target::masterFilter || control.target == Target::padVolume
+                 || control.target == Target::pad;
+
+    if (! isMaster)
+    {
+        int deck = item.getProperty("deck", 0);
+        if (deck < 1)
+            return error("(" + targetName + ") needs a deck numbered from 1");
+
+        control.deckIndex = deck - 1;
+    }
+
+    if (control.target == Target::hotCue)
+    {
+        int cue = item.getProperty("cue", 0);
+        if (cue < 1 || cue > HotCueSource::NUM_CUES)
+            return error("needs a cue from 1 to " + juce::String(HotCueSource::NUM_CUES));
+
+        control.index = cue - 1;
+    }
+
+    if (control.target == Target::pad)
+    {
+        int pad = item.getProperty("pad", 0);
+        if (pad < 1 || pad > SamplePadBank::NUM_PADS)
+            return error("needs a pad from 1 to " + juce::String(SamplePadBank::NUM_PADS));
+
+        control.index = pad - 1;
+    }
+
+    getDefaultRange(control.target, control.minValue, control.maxValue);
+    control.minValue = item.getProperty("min", control.minValue);
+    control.maxValue = item.getProperty("max", control.maxValue);
+    control.scale = item.getProperty("scale", DEFAULT_JOG_SCALE);
+
+    return juce::Result::ok();
+}
+
+bool MidiMapping::findTarget(const juce::String& targetName, Target& target)
+{
+    for (const auto& entry : targetNames)
+    {
+        if (targetName == entry.name)
+        {
+            target = entry.target;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void MidiMapping::getDefaultRange(Target target, double& minValue, double& maxValue)
+{
+    minValue = 0.0;
+    maxValue = 1.0;
+
+    // a pitch fader's usual +/-8%, and the EQ's own range in dB
+    if (target == Target::speed)
+    {
+        minValue = 0.92;
+        maxValue = 1.08;
+    }
+    else if (target == Target::eqLow || target == Target::eqMid || target == Target::eqHigh)
+    {
+        minValue = -6.0;
+        maxValue = 6.0;
+    }
+}
+
+const MidiMapping::Control* MidiMapping::findController(int channel, int number) const
+{
+    if (channel < 1 || channel > 16 || ! juce::isPositiveAndBelow(number, 128))
+        return nullptr;
+
+    int index = controllerLookup[(size_t) ((channel - 1) * 128 + number)];
+    return index > 0 ? &controls.getReference(index - 1) : nullptr;
+}
+
+const MidiMapping::Control* MidiMapping::findNote(int channel, int number) const
+{
+    if (channel < 1 || channel > 16 || ! juce::isPositiveAndBelow(number, 128))
+        return nullptr;
+
+    int index = noteLookup[(size_t) ((channel - 1) * 128 + number)];
+    return index > 0 ? &controls.getReference(index - 1) : nullptr;
+}
+
+juce::String MidiMapping::getName() const
+{
+    return name;
+}
+
+int MidiMapping::getNumControls() const
+{
+    return controls.size();
+}
+
+bool MidiMapping::isContinuous(Target target)
+{
+    return target == Target::volume || target == Target::speed || target == Target::eqLow
+        || target == Target::eqMid || target == Target::eqHigh || target == Target::crossfader
+        || target == Target::masterVolume || target == Target::masterFilter || target == Target::padVolume;
+}
+
+bool MidiMapping::isButton(Target target)
+{
+    return ! isContinuous(target) && target != Target::jog;
+}
+
+juce::String MidiMapping::getDefaultJSON(int numDecks)
+{
+    juce::Array<juce::var> controlList;
+
+    auto add = [&controlList](const char* type, int number, int channel, const char* target,
+                              std::initializer_list<std::pair<const char*, juce::var>> extra)
+    {
+        auto* control = new juce::DynamicObject();
+        control->setProperty(type, number);
+        control->setProperty("channel", channel);
+        control->setProperty("target", target);
+
+        for (const auto& property : extra)
+            control->setProperty(property.first, property.second);
+
+        controlList.add(juce::var(control));
+    };
+
+    for (int deck = 1; deck <= numDecks; ++deck)
+    {
+        add("cc", 7, deck, "volume", { { "deck", deck }, { "highResolution", true } });
+        add("cc", 9, deck, "speed", { { "deck", deck }, { "highResolution", true } });
+        add("cc", 16, deck, "eqHigh", { { "deck", deck } });
+        add("cc", 17, deck, "eqMid", { { "deck", deck } });
+        add("cc", 18, deck, "eqLow", { { "deck", deck } });
+        add("cc", 20, deck, "jog", { { "deck", deck }, { "scale", DEFAULT_JOG_SCALE } });
+        add("note", 11, deck, "play", { { "deck", deck } });
+        add("note", 12, deck, "stop", { { "deck", deck } });
+        add("note", 14, deck, "reverse", { { "deck", deck } });
+        add("note", 15, deck, "censor", { { "deck", deck } });
+        add("note", 16, deck, "jogTouch", { { "deck", deck } });
+
+        for (int cue = 1; cue <= HotCueSource::NUM_CUES; ++cue)
+            add("note", cue - 1, deck, "hotCue", { { "deck", deck }, { "cue", cue } });
+    }
+
+    for (int pad = 1; pad <= SamplePadBank::NUM_PADS; ++pad)
+        add("note", 35 + pad, 10, "pad", { { "pad", pad } });
+
+    add("cc", 7, 16, "masterVolume", { { "highResolution", true } });
+    add("cc", 8, 16, "crossfader", { { "highResolution", true } });
+    add("cc", 10, 16, "masterFilter", {});
+    add("cc", 11, 16, "padVolume", {});
+
+    auto* mapping = new juce::DynamicObject();
+    mapping->setProperty("name", "Default " + juce::String(numDecks) + " deck layout");
+    mapping->setProperty("controls", controlList);
+    return juce::JSON::toString(juce::var(mapping));
+}
+
+juce::File MidiMapping::getDefaultMappingFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("OtoDecks").getChildFile("controller.json");
+}
@@ -0,0 +1,96 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+// Maps a MIDI controller's knobs, faders and buttons to the mixer's controls. A mapping is a JSON
+// file like:
+//
+//   {
+//     "name": "My controller",
+//     "controls": [
+//       { "cc": 7,   "channel": 1,  "target": "volume", "deck": 1, "highResolution": true },
+//       { "cc": 20,  "channel": 1,  "target": "jog", "deck": 1, "scale": 0.005 },
+//       { "note": 11, "channel": 1, "target": "play", "deck": 1 },
+//       { "note": 0,  "channel": 1, "target": "hotCue", "deck": 1, "cue": 1 },
+//       { "note": 36, "channel": 10, "target": "pad", "pad": 1 },
+//       { "cc": 8,   "channel": 16, "target": "crossfader", "highResolution": true }
+//     ]
+//   }
+//
+// Each control is a "cc" or a "note" number on a channel from 1 to 16. A high resolution control
+// is a 14 bit pair - the controller number (0 to 31) carries the top 7 bits and the number 32
+// above it the bottom 7. "min" and "max" change a continuous control's range, and a jog's "scale"
+// is the seconds of track each tick of the wheel moves while it is touched. Decks, hot cues and
+// pads are numbered from 1; the master controls have no deck.
+class MidiMapping
+{
+public:
+    enum class Target
+    {
+        // continuous, from a controller
+        volume, speed, eqLow, eqMid, eqHigh, crossfader, masterVolume, masterFilter, padVolume,
+        // relative ticks from a jog wheel
+        jog,
+        // buttons, pressed and released
+        play, stop, hotCue, pad, jogTouch, reverse, censor
+    };
+
+    struct Control
+    {
+        bool isNote{false};
+        int channel{1};
+        int number{0};
+        Target target{Target::volume};
+        int deckIndex{-1};         // -1 for the master controls
+        int index{0};              // the hot cue or pad
+        bool highResolution{false};
+        double minValue{0.0};
+        double maxValue{1.0};
+        double scale{DEFAULT_JOG_SCALE};
+    };
+
+    MidiMapping();
+
+    juce::Result loadFromFile(const juce::File& file);
+    juce::Result loadFromJSON(const juce::String& json);
+
+    // A layout for numDecks decks - each deck on its own channel, the pads on channel 10 and the
+    // master section on channel 16 - also saved as the template for a mapping file
+    static juce::String getDefaultJSON(int numDecks);
+    // Where the app looks for the mapping on startup
+    static juce::File getDefaultMappingFile();
+
+    // The control a message number maps to, or nullptr. A high resolution control is found by its
+    // top and bottom controller numbers alike (any thread once loaded).
+    const Control* findController(int channel, int number) const;
+    const Control* findNote(int channel, int number) const;
+
+    juce::String getName() const;
+    int getNumControls() const;
+
+    static bool isContinuous(Target target);
+    static bool isButton(Target target);
+
+    static constexpr double DEFAULT_JOG_SCALE = 0.005;
+
+private:
+    // Parses one entry of the controls array, at position for the error message
+    juce::Result parseControl(const juce::var& item, int position, Control& control) const;
+    static bool findTarget(const juce::String& name, Target& target);
+    static void getDefaultRange(Target target, double& minValue, double& maxValue);
+
+    juce::String name;
+    juce::Array<Control> controls;
+
+    // One past the control's index for every channel and number of each message type, 0 for none
+    std::array<juce::int16, 16 * 128> controllerLookup{};
+    std::array<juce::int16, 16 * 128> noteLookup{};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiMapping)
+};
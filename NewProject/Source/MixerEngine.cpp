@@ -0,0 +1,657 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "MixerEngine.h"
+#include "Tracing.h"
+
+MixerEngine::MixerEngine()
+    : renderPool([this](int deckIndex) { renderDeck(deckIndex); })
+{
+    setCrossfader(0.5);
+
+    for (auto& leader : downbeatLeaders)
+        leader = -1;
+
+    downbeatChecks.fill(-1);
+
+    for (auto& cue : cueEnabled)
+        cue = false;
+}
+
+MixerEngine::~MixerEngine()
+{
+    renderPool.stop();
+}
+
+void MixerEngine::addDeck(DJAudioPlayer* player)
+{
+    jassert(decks.size() < MAX_DECKS);
+
+    decks.add(player);
+    deckBuffers.add(new juce::AudioBuffer<float>(2, 0));
+    cueBuffers.add(new juce::AudioBuffer<float>(2, 0));
+    deckEffects.add(new DeckEffectsRack());
+    deckMeters.add(new LevelMeter());
+    syncEngine.addDeck(player);
+
+    juce::StringArray effectNames;
+    for (int effect = 0; effect < DeckEffectsRack::numEffects; ++effect)
+        effectNames.add(DeckEffectsRack::getEffectName(static_cast<DeckEffectsRack::Effect>(effect)));
+    monitor.setStages(decks.size(), effectNames);
+}
+
+int MixerEngine::getNumDecks() const
+{
+    return decks.size();
+}
+
+DJAudioPlayer* MixerEngine::getDeck(int deckIndex) const
+{
+    return decks[deckIndex];
+}
+
+SyncEngine& MixerEngine::getSyncEngine()
+{
+    return syncEngine;
+}
+
+AudioCallbackMonitor& MixerEngine::getMonitor()
+{
+    return monitor;
+}
+
+const LevelMeter& MixerEngine::getDeckMeter(int deckIndex) const
+{
+    return *deckMeters.getUnchecked(deckIndex);
+}
+
+const LevelMeter& MixerEngine::getMasterMeter() const
+{
+    return masterMeter;
+}
+
+DeckEffectsRack& MixerEngine::getDeckEffects(int deckIndex)
+{
+    return *deckEffects.getUnchecked(deckIndex);
+}
+
+SamplePadBank& MixerEngine::getSamplePads()
+{
+    return samplePads;
+}
+
+void MixerEngine::setOutputRouting(OutputRouting routing)
+{
+    outputRouting = routing;
+}
+
+MixerEngine::OutputRouting MixerEngine::getOutputRouting() const
+{
+    return outputRouting.load();
+}
+
+int MixerEngine::getNumOutputChannels() const
+{
+    switch (outputRouting.load())
+    {
+        case OutputRouting::masterAndCue:   return 4;
+        case OutputRouting::separateDecks:  return 2 * juce::jmax(1, decks.size()) + 2;
+        case OutputRouting::master:         break;
+    }
+
+    return 2;
+}
+
+const char* MixerEngine::getOutputRoutingName(OutputRouting routing)
+{
+    switch (routing)
+    {
+        case OutputRouting::masterAndCue:   return "cue";
+        case OutputRouting::separateDecks:  return "decks";
+        case OutputRouting::master:         break;
+    }
+
+    return "master";
+}
+
+bool MixerEngine::findOutputRouting(const juce::String& name, OutputRouting& routing)
+{
+    for (auto candidate : { OutputRouting::master, OutputRouting::masterAndCue, OutputRouting::separateDecks })
+    {
+        if (name == getOutputRoutingName(candidate))
+        {
+            routing = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void MixerEngine::setCueEnabled(int deckIndex, bool shouldCue)
+{
+    if (juce::isPositiveAndBelow(deckIndex, MAX_DECKS))
+        cueEnabled[(size_t) deckIndex] = shouldCue;
+}
+
+bool MixerEngine::isCueEnabled(int deckIndex) const
+{
+    return juce::isPositiveAndBelow(deckIndex, MAX_DECKS) && cueEnabled[(size_t) deckIndex].load();
+}
+
+void MixerEngine::setCueMix(double mix)
+{
+    cueMix = juce::jlimit(0.0, 1.0, mix);
+}
+
+juce::AudioSourceChannelInfo MixerEngine::getMasterOutput()
+{
+    return juce::AudioSourceChannelInfo(&masterBuffer, 0, currentBlockSize);
+}
+
+void MixerEngine::setControllerInput(MidiControllerInput* input)
+{
+    controllerInput = input;
+}
+
+MasterLimiter& MixerEngine::getLimiter()
+{
+    return limiter;
+}
+
+int MixerEngine::getLatencyInSamples() const
+{
+    return limiter.getLatencyInSamples();
+}
+
+void MixerEngine::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    currentSampleRate = sampleRate;
+    syncEngine.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    monitor.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    masterMeter.prepareToPlay(sampleRate);
+    samplePads.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    limiter.prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+    preparedBlockSize = samplesPerBlockExpected;
+    audioThreadNamed = false;
+    masterBuffer.setSize(2, samplesPerBlockExpected);
+    padBuffer.setSize(2, samplesPerBlockExpected);
+    alignmentDelay.setSize(MAX_OUTPUT_CHANNELS, limiter.getLatencyInSamples());
+    alignmentDelay.clear();
+    alignmentPosition = 0;
+
+    for (int i = 0; i < decks.size(); ++i)
+    {
+        decks.getUnchecked(i)->prepareToPlay(samplesPerBlockExpected, sampleRate);
+        deckBuffers.getUnchecked(i)->setSize(2, samplesPerBlockExpected);
+        cueBuffers.getUnchecked(i)->setSize(2, samplesPerBlockExpected);
+        deckEffects.getUnchecked(i)->prepareToPlay(samplesPerBlockExpected, sampleRate);
+        deckMeters.getUnchecked(i)->prepareToPlay(sampleRate);
+    }
+
+    // One worker per deck beyond the first, as the audio thread renders decks itself,
+    // leaving a core free for the GUI
+    int numWorkers = juce::jmin(decks.size() - 1, juce::SystemStats::getNumCpus() - 1);
+    renderPool.start(juce::jmax(0, numWorkers), samplesPerBlockExpected, sampleRate);
+}
+
+void MixerEngine::releaseResources()
+{
+    renderPool.stop();
+
+    for (auto* deck : decks)
+        deck->releaseResources();
+}
+
+void MixerEngine::renderDeck(int deckIndex)
+{
+    AudioCallbackMonitor::ScopedStage stage(monitor, AudioCallbackMonitor::firstDeckStage + deckIndex);
+    TRACE_SCOPE("audio", "render deck");
+
+    auto& player = *decks.getUnchecked(deckIndex);
+    auto timing = getEffectTiming(player);
+
+    juce::AudioSourceChannelInfo deckInfo(deckBuffers.getUnchecked(deckIndex), 0, currentBlockSize);
+    player.getNextAudioBlock(deckInfo);
+
+    // the deck's stage includes its effects, which are also broken out into stages of their own
+    deckEffects.getUnchecked(deckIndex)->process(*deckInfo.buffer, currentBlockSize, timing);
+
+    // metered on the deck's own render thread, so the meters scale with the decks
+    deckMeters.getUnchecked(deckIndex)->process(*deckInfo.buffer, 0, currentBlockSize);
+}
+
+void MixerEngine::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    monitor.beginCallback(bufferToFill.numSamples);
+
+    // a restarted device may call back on a new thread, so this is done once per prepareToPlay
+    if (! audioThreadNamed)
+    {
+        Tracing::setCurrentThreadName("Audio callback");
+        audioThreadNamed = true;
+    }
+
+    TRACE_SCOPE("audio", "audio callback");
+
+    if (preparedBlockSize == 0)
+    {
+        bufferToFill.clearActiveBufferRegion();
+        monitor.endCallback();
+        return;
+    }
+
+    // A bigger block than prepareToPlay promised is rendered in pieces the buffers were sized for
+    for (int done = 0; done < bufferToFill.numSamples; done += preparedBlockSize)
+        renderBlock(juce::AudioSourceChannelInfo(bufferToFill.buffer, bufferToFill.startSample + done,
+                                                 juce::jmin(preparedBlockSize, bufferToFill.numSamples - done)));
+
+    monitor.endCallback();
+}
+
+void MixerEngine::renderBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    // applies the controller's events, then sets the synced decks' tempo and phase correction before rendering
+    {
+        AudioCallbackMonitor::ScopedStage stage(monitor, AudioCallbackMonitor::syncStage);
+        TRACE_SCOPE("audio", "sync");
+        applyControllerEvents();
+        syncEngine.processBlock(bufferToFill.numSamples);
+        scheduleDownbeatStarts(bufferToFill.numSamples);
+    }
+
+    // A new routing starts from a silent delay line, not the last routing's audio
+    auto routing = outputRouting.load();
+    if (routing != blockRouting)
+        alignmentDelay.clear();
+    blockRouting = routing;
+
+    // The cued decks copy themselves into their cue buffers as they render
+    for (int i = 0; i < decks.size(); ++i)
+    {
+        cuedThisBlock[(size_t) i] = blockRouting == OutputRouting::masterAndCue && cueEnabled[(size_t) i].load();
+        decks.getUnchecked(i)->setCueTap(cuedThisBlock[(size_t) i] ? cueBuffers.getUnchecked(i) : nullptr);
+    }
+
+    // gets the audio from every deck, in parallel
+    currentBlockSize = bufferToFill.numSamples;
+    renderPool.run(decks.size());
+    recordEffectStages();
+    measureDownbeatStarts();
+
+    {
+        AudioCallbackMonitor::ScopedStage stage(monitor, AudioCallbackMonitor::mixStage);
+        TRACE_SCOPE("audio", "mix");
+        mixDecks(currentBlockSize);
+
+        // The pads' own pair takes them before the master volume, as the decks' pairs do. The
+        // master isn't played, but it is still recorded, so they go into it as they would otherwise
+        if (blockRouting == OutputRouting::separateDecks)
+        {
+            padBuffer.clear(0, currentBlockSize);
+            samplePads.addNextAudioBlock(juce::AudioSourceChannelInfo(&padBuffer, 0, currentBlockSize), 1.0f);
+
+            for (int channel = 0; channel < masterBuffer.getNumChannels(); ++channel)
+                masterBuffer.addFrom(channel, 0, padBuffer, channel % 2, 0, currentBlockSize, static_cast<float>(masterVolume.load()));
+        }
+        else
+        {
+            samplePads.addNextAudioBlock(getMasterOutput(), static_cast<float>(masterVolume.load()));
+        }
+
+        limiter.process(masterBuffer, 0, currentBlockSize);
+        masterMeter.process(masterBuffer, 0, currentBlockSize);
+        routeOutputs(bufferToFill);
+    }
+
+    if (onMasterBlock)
+        onMasterBlock(getMasterOutput());
+}
+
+DeckEffect::Timing MixerEngine::getEffectTiming(DJAudioPlayer& player)
+{
+    DeckEffect::Timing timing;
+    timing.bpm = player.getBPM();
+    timing.isPlaying = player.isPlaying();
+
+    // taken before the deck renders, so it is the beat heard at the start of the block - the same
+    // clock as sync and downbeat starts
+    if (player.isBPMAnalysisComplete())
+        timing.beatPosition = (player.getAudiblePositionInSeconds() - player.getBeatGridOffset()) * player.getOriginalBPM() / 60.0;
+
+    return timing;
+}
+
+void MixerEngine::startOnNextDownbeat(int deckIndex, int leaderIndex)
+{
+    if (juce::isPositiveAndBelow(deckIndex, decks.size()))
+        downbeatLeaders[(size_t) deckIndex] = leaderIndex;
+}
+
+MixerEngine::DownbeatStartStats MixerEngine::getDownbeatStartStats() const
+{
+    DownbeatStartStats stats;
+    stats.numStarts = downbeatStarts.load();
+    stats.maxErrorSamples = maxDownbeatError.load();
+    return stats;
+}
+
+void MixerEngine::scheduleDownbeatStarts(int numSamples)
+{
+    for (int deckIndex = 0; deckIndex < decks.size(); ++deckIndex)
+    {
+        int leaderIndex = downbeatLeaders[(size_t) deckIndex].load();
+        if (leaderIndex < 0)
+            continue;
+
+        auto& follower = *decks.getUnchecked(deckIndex);
+        auto* leader = leaderIndex != deckIndex ? decks[leaderIndex] : nullptr;
+
+        TransportCommand start;
+        start.type = TransportCommand::Type::play;
+        start.sampleTime = follower.getNextBlockSampleTime();
+
+        if (leader != nullptr && leader->isPlaying() && leader->isBPMAnalysisComplete() && leader->getBPM() > 0.0)
+        {
+            // Where the leader is on its grid at the output now, past its resampler and stretcher,
+            // and how many output samples until its next bar
+            double beat = (leader->getAudiblePositionInSeconds() - leader->getBeatGridOffset()) * leader->getOriginalBPM() / 60.0;
+            double nextDownbeat = std::ceil(beat / BEATS_PER_BAR) * BEATS_PER_BAR;
+            double beatsPerSample = leader->getBPM() / 60.0 / currentSampleRate;
+            double samplesToDownbeat = (nextDownbeat - beat) / beatsPerSample;
+
+            // not in this block - keeps waiting
+            if (samplesToDownbeat >= numSamples)
+                continue;
+
+            auto offset = static_cast<juce::int64>(std::round(samplesToDownbeat));
+            offset = juce::jlimit<juce::int64>(0, numSamples - 1, offset);
+            start.sampleTime += offset;
+        }
+        else
+        {
+            leader = nullptr;
+        }
+
+        // a new request made meanwhile is left for the next block
+        if (downbeatLeaders[(size_t) deckIndex].compare_exchange_strong(leaderIndex, -1))
+        {
+            follower.scheduleCommand(start);
+            downbeatStarts = downbeatStarts.load() + 1;
+            downbeatChecks[(size_t) deckIndex] = leader != nullptr ? leaderIndex : -1;
+        }
+    }
+}
+
+void MixerEngine::measureDownbeatStarts()
+{
+    for (int deckIndex = 0; deckIndex < decks.size(); ++deckIndex)
+    {
+        int leaderIndex = downbeatChecks[(size_t) deckIndex];
+        downbeatChecks[(size_t) deckIndex] = -1;
+
+        if (leaderIndex < 0)
+            continue;
+
+        auto& follower = *decks.getUnchecked(deckIndex);
+        auto& leader = *decks.getUnchecked(leaderIndex);
+
+        // the start didn't land in this block - the deck has no track
+        juce::int64 blockEnd = follower.getNextBlockSampleTime();
+        juce::int64 startedAt = follower.getLastStartSampleTime();
+        double beatsPerSample = leader.getBPM() / 60.0 / currentSampleRate;
+
+        if (startedAt < blockEnd - currentBlockSize || beatsPerSample <= 0.0)
+            continue;
+
+        // The leader's beat at the output now, past its resampler and stretcher, taken back to
+        // the sample the follower started on - none of it comes from the scheduling above
+        double beatNow = (leader.getAudiblePositionInSeconds() - leader.getBeatGridOffset()) * leader.getOriginalBPM() / 60.0;
+        double beatAtStart = beatNow - static_cast<double>(blockEnd - startedAt) * beatsPerSample;
+
+        double barsOff = beatAtStart / BEATS_PER_BAR - std::round(beatAtStart / BEATS_PER_BAR);
+        double error = std::abs(barsOff) * BEATS_PER_BAR / beatsPerSample;
+
+        if (error > maxDownbeatError.load())
+            maxDownbeatError = error;
+    }
+}
+
+void MixerEngine::applyControllerEvents()
+{
+    if (controllerInput == nullptr)
+        return;
+
+    ControllerEvent event;
+
+    while (controllerInput->popEvent(event))
+    {
+        controllerInput->recordLatency(event);
+        applyControllerEvent(event);
+    }
+}
+
+void MixerEngine::applyControllerEvent(const ControllerEvent& event)
+{
+    using Target = MidiMapping::Target;
+
+    auto* deck = event.deckIndex >= 0 ? decks[event.deckIndex] : nullptr;
+    bool pressed = event.value > 0.0;
+
+    // a mapping written for more decks than are open
+    if (event.deckIndex >= 0 && deck == nullptr)
+        return;
+
+    // transport changes land on the first sample of the block, like the downbeat starts
+    auto schedule = [deck](TransportCommand::Type type, double value)
+    {
+        deck->scheduleCommand({ type, value, deck->getNextBlockSampleTime() });
+    };
+
+    switch (event.target)
+    {
+        case Target::volume:        deck->setGain(juce::jlimit(0.0, 1.0, event.value)); break;
+        case Target::speed:         schedule(TransportCommand::Type::speed, event.value); break;
+        case Target::eqLow:         deck->setEQGain(DeckEQ::low, event.value); break;
+        case Target::eqMid:         deck->setEQGain(DeckEQ::mid, event.value); break;
+        case Target::eqHigh:        deck->setEQGain(DeckEQ::high, event.value); break;
+        case Target::crossfader:    setCrossfader(juce::jlimit(0.0, 1.0, event.value)); break;
+        case Target::masterVolume:  setMasterVolume(juce::jlimit(0.0, 1.0, event.value)); break;
+        case Target::masterFilter:  setMasterFilter(juce::jlimit(0.0, 1.0, event.value)); break;
+        case Target::padVolume:     samplePads.setVolume(static_cast<float>(event.value)); break;
+        case Target::jog:           deck->scratchBy(event.value); break;
+
+        case Target::play:
+            if (pressed)
+                schedule(deck->isPlaying() ? TransportCommand::Type::stop : TransportCommand::Type::play, 0.0);
+            break;
+
+        case Target::stop:
+            if (pressed)
+                schedule(TransportCommand::Type::stop, 0.0);
+            break;
+
+        case Target::hotCue:
+            if (pressed && deck->hasHotCue(event.index))
+                schedule(TransportCommand::Type::hotCue, event.index);
+            break;
+
+        case Target::pad:
+            if (pressed)
+                samplePads.trigger(event.index, static_cast<float>(event.value));
+            break;
+
+        case Target::jogTouch:
+            if (pressed)
+                deck->startScratch();
+            else
+                deck->stopScratch();
+            break;
+
+        case Target::reverse:
+            if (pressed)
+                schedule(TransportCommand::Type::reverse, deck->isReversed() ? 0.0 : 1.0);
+            break;
+
+        case Target::censor:
+            schedule(TransportCommand::Type::censor, pressed ? 1.0 : 0.0);
+            break;
+    }
+}
+
+void MixerEngine::recordEffectStages()
+{
+    int firstEffectStage = monitor.getFirstEffectStage();
+
+    // The workers have all finished, so every rack's timings for this block can be read here
+    for (int effect = 0; effect < DeckEffectsRack::numEffects; ++effect)
+    {
+        juce::int64 ticks = 0;
+        for (auto* rack : deckEffects)
+            ticks += rack->getLastEffectTicks(static_cast<DeckEffectsRack::Effect>(effect));
+
+        monitor.recordStage(firstEffectStage + effect, ticks);
+    }
+}
+
+void MixerEngine::mixDecks(int numSamples)
+{
+    // clears the master buffer
+    masterBuffer.clear(0, numSamples);
+
+    // mix with crossfader gains and apply master filter
+    float leftGain = static_cast<float>(crossfaderLeftGain.load());
+    float rightGain = static_cast<float>(crossfaderRightGain.load());
+    double filterValue = masterFilter;
+    float volume = static_cast<float>(masterVolume.load());
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto* outputData = masterBuffer.getWritePointer(channel);
+
+        for (int deck = 0; deck < decks.size(); ++deck)
+        {
+            float deckGain = isOnLeftOfCrossfader(deck) ? leftGain : rightGain;
+            juce::FloatVectorOperations::addWithMultiply(outputData, deckBuffers.getUnchecked(deck)->getReadPointer(channel),
+                                                         deckGain, numSamples);
+        }
+
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            float mixedSample = outputData[sample];
+
+            // Apply master filter effect
+            if (filterValue < 0.5)
+            {
+                // Low-pass filter (cut highs) - left side of slider
+                float cutoffRatio = filterValue * 2.0f;
+                float filterFactor = 0.1f + (cutoffRatio * 0.9f);
+                mixedSample *= filterFactor;
+            }
+            else if (filterValue > 0.5)
+            {
+                // High-pass filter (cut lows) - right side of slider
+                float cutoffRatio = (filterValue - 0.5f) * 2.0f;
+                float filterFactor = 1.0f - (cutoffRatio * 0.7f);
+                mixedSample = mixedSample * filterFactor + (mixedSample * 0.3f * cutoffRatio);
+            }
+
+            // Master volume
+            outputData[sample] = mixedSample * volume;
+        }
+    }
+}
+
+void MixerEngine::routeOutputs(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    auto& output = *bufferToFill.buffer;
+    int numOutputs = output.getNumChannels();
+    int numSamples = bufferToFill.numSamples;
+
+    bufferToFill.clearActiveBufferRegion();
+
+    if (blockRouting != OutputRouting::separateDecks)
+        for (int channel = 0; channel < juce::jmin(numOutputs, 2); ++channel)
+            output.copyFrom(channel, bufferToFill.startSample, masterBuffer, channel, 0, numSamples);
+
+    if (blockRouting == OutputRouting::masterAndCue)
+    {
+        float mix = static_cast<float>(cueMix.load());
+
+        for (int channel = 2; channel < juce::jmin(numOutputs, 4); ++channel)
+        {
+            auto* cueData = output.getWritePointer(channel, bufferToFill.startSample);
+
+            for (int deck = 0; deck < decks.size(); ++deck)
+                if (cuedThisBlock[(size_t) deck])
+                    juce::FloatVectorOperations::add(cueData, cueBuffers.getUnchecked(deck)->getReadPointer(channel - 2), numSamples);
+
+            // the cue is lined up with the limited master before they are blended
+            delayForAlignment(cueData, channel, numSamples);
+            juce::FloatVectorOperations::multiply(cueData, 1.0f - mix, numSamples);
+            juce::FloatVectorOperations::addWithMultiply(cueData, masterBuffer.getReadPointer(channel - 2), mix, numSamples);
+        }
+    }
+    else if (blockRouting == OutputRouting::separateDecks)
+    {
+        for (int channel = 0; channel < juce::jmin(numOutputs, 2 * decks.size()); ++channel)
+        {
+            output.copyFrom(channel, bufferToFill.startSample, *deckBuffers.getUnchecked(channel / 2), channel % 2, 0, numSamples);
+            delayForAlignment(output.getWritePointer(channel, bufferToFill.startSample), channel, numSamples);
+        }
+
+        for (int channel = 2 * decks.size(); channel < juce::jmin(numOutputs, 2 * decks.size() + 2); ++channel)
+        {
+            output.copyFrom(channel, bufferToFill.startSample, padBuffer, channel % 2, 0, numSamples);
+            delayForAlignment(output.getWritePointer(channel, bufferToFill.startSample), channel, numSamples);
+        }
+    }
+
+    if (alignmentDelay.getNumSamples() > 0)
+        alignmentPosition = (alignmentPosition + numSamples) % alignmentDelay.getNumSamples();
+}
+
+void MixerEngine::delayForAlignment(float* data, int outputChannel, int numSamples)
+{
+    int length = alignmentDelay.getNumSamples();
+
+    if (length == 0 || outputChannel >= alignmentDelay.getNumChannels())
+        return;
+
+    // each sample swaps places with the one put in the line a look-ahead ago
+    auto* line = alignmentDelay.getWritePointer(outputChannel);
+    int position = alignmentPosition;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        std::swap(data[i], line[position]);
+
+        if (++position == length)
+            position = 0;
+    }
+}
+
+void MixerEngine::setCrossfader(double position)
+{
+    // calculate gain for each side using crossfading curve
+    crossfaderLeftGain = std::cos(position * juce::MathConstants<double>::halfPi);
+    crossfaderRightGain = std::sin(position * juce::MathConstants<double>::halfPi);
+}
+
+void MixerEngine::setMasterVolume(double volume)
+{
+    masterVolume = volume;
+}
+
+void MixerEngine::setMasterFilter(double value)
+{
+    masterFilter = value;
+}
+
+bool MixerEngine::isOnLeftOfCrossfader(int deckIndex)
+{
+    return deckIndex % 2 == 0;
+}
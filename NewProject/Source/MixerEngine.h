@@ -0,0 +1,198 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DJAudioPlayer.h"
+#include "SyncEngine.h"
+#include "DeckRenderPool.h"
+#include "AudioCallbackMonitor.h"
+#include "LevelMeter.h"
+#include "MasterLimiter.h"
+#include "DeckEffectsRack.h"
+#include "SamplePadBank.h"
+#include "MidiControllerInput.h"
+
+// Mixes any number of decks, each with its own send effects, through the crossfader, master filter, master volume and limiter.
+// The sample pads join the mix after the master filter, at the master volume, so the limiter catches them too.
+// Decks render in parallel on the DeckRenderPool, and every control is an atomic so the
+// GUI (or the offline renderer) can set them while the audio thread is mixing.
+//
+// The master is mixed into a buffer of its own, then routed to the device's outputs: on 1/2 alone,
+// with a headphone cue on 3/4, or with each deck on its own pair for an external mixer and the pads
+// on the pair after the decks. Everything beside the master is delayed by the limiter's look-ahead,
+// so all the outputs line up.
+class MixerEngine : public juce::AudioSource
+{
+public:
+    static constexpr int MIN_DECKS = 2;
+    static constexpr int MAX_DECKS = 8;
+
+    enum class OutputRouting
+    {
+        master,         // the master on outputs 1/2
+        masterAndCue,   // the master on 1/2 and the headphone cue on 3/4
+        separateDecks   // deck 1 after its fader on 1/2, deck 2 on 3/4 and so on, then the pad bus at its
+                        // own volume on the next pair - the master isn't played
+    };
+
+    // The most outputs any routing needs - every deck's pair and the pads' pair
+    static constexpr int MAX_OUTPUT_CHANNELS = 2 * MAX_DECKS + 2;
+
+    MixerEngine();
+    ~MixerEngine() override;
+
+    // Adds a deck to the mix and to beat sync - call before the audio device starts
+    void addDeck(DJAudioPlayer* player);
+    int getNumDecks() const;
+    DJAudioPlayer* getDeck(int deckIndex) const;
+
+    SyncEngine& getSyncEngine();
+    AudioCallbackMonitor& getMonitor();
+
+    // Post-fader levels of each deck, and of the master output after the master section
+    const LevelMeter& getDeckMeter(int deckIndex) const;
+    const LevelMeter& getMasterMeter() const;
+
+    // Send effects on each deck, timed from the deck's tempo
+    DeckEffectsRack& getDeckEffects(int deckIndex);
+
+    // Sample pads mixed into the master
+    SamplePadBank& getSamplePads();
+
+    // A MIDI controller whose events are applied at the top of each block, or nullptr for none -
+    // call before the audio device starts
+    void setControllerInput(MidiControllerInput* input);
+
+    // Any thread - the device needs getNumOutputChannels() outputs for it, and a routing beyond the
+    // outputs it has loses the channels it can't play
+    void setOutputRouting(OutputRouting routing);
+    OutputRouting getOutputRouting() const;
+    int getNumOutputChannels() const;
+
+    // "master", "cue" or "decks" - the names saved settings and timelines use
+    static const char* getOutputRoutingName(OutputRouting routing);
+    static bool findOutputRouting(const juce::String& name, OutputRouting& routing);
+
+    // Decks in the headphone cue are heard there before their fader and the crossfader, with the
+    // masterAndCue routing
+    void setCueEnabled(int deckIndex, bool shouldCue);
+    bool isCueEnabled(int deckIndex) const;
+    // 0.0 = the cued decks only, 1.0 = the master only
+    void setCueMix(double mix);
+
+    // Called with the master after the limiter as each piece of a block is mixed, whatever the
+    // outputs carry - for the recorder (audio thread, set before the device starts)
+    std::function<void(const juce::AudioSourceChannelInfo& master)> onMasterBlock;
+
+    // Brick-wall limiter at the end of the master section
+    MasterLimiter& getLimiter();
+    // Output delay added by the mixer - the limiter's look-ahead
+    int getLatencyInSamples() const;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+    void releaseResources() override;
+
+    // 0.0 = full left (odd numbered decks), 1.0 = full right (even numbered decks)
+    void setCrossfader(double position);
+    void setMasterVolume(double volume);
+    // 0.5 is neutral, below cuts the highs and above cuts the lows
+    void setMasterFilter(double value);
+
+    // Decks on the left of the crossfader are 1, 3, 5, 7 and on the right 2, 4, 6, 8
+    static bool isOnLeftOfCrossfader(int deckIndex);
+
+    // Starts a deck on the exact sample of the leader deck's next downbeat, or at the start of
+    // the next block if the leader isn't playing or has no beat grid (any thread)
+    void startOnNextDownbeat(int deckIndex, int leaderIndex);
+
+    struct DownbeatStartStats
+    {
+        juce::uint32 numStarts{0};
+        // between the follower's first sample and the leader's bar line at the output, measured once
+        // the block has rendered from where the leader is audibly and where the start really landed
+        double maxErrorSamples{0.0};
+    };
+    DownbeatStartStats getDownbeatStartStats() const;
+
+    static constexpr int BEATS_PER_BAR = BPMAnalyser::BEATS_PER_BAR;
+
+private:
+    // Renders part of the callback no longer than the prepared block size (audio thread)
+    void renderBlock(const juce::AudioSourceChannelInfo& bufferToFill);
+    void renderDeck(int deckIndex);
+    // The master being mixed, for the pads to play into (audio thread)
+    juce::AudioSourceChannelInfo getMasterOutput();
+    // Where the deck is in the beat, for its effects
+    static DeckEffect::Timing getEffectTiming(DJAudioPlayer& player);
+    // Reports each effect's time summed over the decks to the monitor (audio thread)
+    void recordEffectStages();
+    // Sums the rendered decks through the crossfader and master section into the master buffer
+    void mixDecks(int numSamples);
+    // Fills the device's outputs from the master, the cue and the decks for this block's routing
+    void routeOutputs(const juce::AudioSourceChannelInfo& bufferToFill);
+    // Delays one output channel by the limiter's look-ahead, in place
+    void delayForAlignment(float* data, int outputChannel, int numSamples);
+    // Schedules the starts waiting for a downbeat that falls in this block (audio thread)
+    void scheduleDownbeatStarts(int numSamples);
+    // Measures the starts scheduled this block against the leader's output, once it has rendered
+    void measureDownbeatStarts();
+    // Applies the controller's queued events to the decks and master section (audio thread)
+    void applyControllerEvents();
+    void applyControllerEvent(const ControllerEvent& event);
+
+    juce::Array<DJAudioPlayer*> decks;
+    double currentSampleRate{44100.0};
+    SyncEngine syncEngine;
+    AudioCallbackMonitor monitor;
+    DeckRenderPool renderPool;
+
+    // one preallocated stereo buffer per deck, and another for its cue taken before the fader
+    juce::OwnedArray<juce::AudioBuffer<float>> deckBuffers;
+    juce::OwnedArray<juce::AudioBuffer<float>> cueBuffers;
+    juce::AudioBuffer<float> masterBuffer{2, 0};
+    // the pad bus, on its own pair when the decks are, otherwise mixed into the master
+    juce::AudioBuffer<float> padBuffer{2, 0};
+    int preparedBlockSize{0};
+    int currentBlockSize{0};
+    bool audioThreadNamed{false};
+
+    std::atomic<OutputRouting> outputRouting{OutputRouting::master};
+    std::array<std::atomic<bool>, MAX_DECKS> cueEnabled;
+    std::atomic<double> cueMix{0.0};
+
+    // Audio thread - the routing and cued decks taken at the start of the block, so a change
+    // part way through lands on the next one
+    OutputRouting blockRouting{OutputRouting::master};
+    std::array<bool, MAX_DECKS> cuedThisBlock{};
+
+    // A delay line the length of the limiter's look-ahead for each output channel
+    juce::AudioBuffer<float> alignmentDelay;
+    int alignmentPosition{0};
+
+    juce::OwnedArray<DeckEffectsRack> deckEffects;
+    juce::OwnedArray<LevelMeter> deckMeters;
+    LevelMeter masterMeter;
+    SamplePadBank samplePads;
+    MasterLimiter limiter;
+    MidiControllerInput* controllerInput{nullptr};
+
+    // crossfader gains for mixer
+    std::atomic<double> crossfaderLeftGain{0.707};
+    std::atomic<double> crossfaderRightGain{0.707};
+    std::atomic<double> masterVolume{0.8};
+    std::atomic<double> masterFilter{0.5};
+
+    // The leader each deck is waiting on to start, -1 if it isn't waiting
+    std::array<std::atomic<int>, MAX_DECKS> downbeatLeaders;
+    std::atomic<juce::uint32> downbeatStarts{0};
+    std::atomic<double> maxDownbeatError{0.0};
+    // Audio thread - the leader each start scheduled this block is measured against, -1 for none
+    std::array<int, MAX_DECKS> downbeatChecks;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MixerEngine)
+};
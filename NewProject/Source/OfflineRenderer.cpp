@@ -0,0 +1,548 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "OfflineRenderer.h"
+#include <iostream>
+
+OfflineRenderer::OfflineRenderer()
+{
+    formatManager.registerBasicFormats();
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+    mixer.releaseResources();
+}
+
+juce::Result OfflineRenderer::loadTimeline(const juce::File& timelineFile)
+{
+    if (! timelineFile.existsAsFile())
+        return juce::Result::fail("Timeline not found: " + timelineFile.getFullPathName());
+
+    juce::var timeline;
+    auto parseResult = juce::JSON::parse(timelineFile.loadFileAsString(), timeline);
+
+    if (parseResult.failed())
+        return juce::Result::fail("Timeline is not valid JSON: " + parseResult.getErrorMessage());
+
+    if (! timeline.isObject())
+        return juce::Result::fail("Timeline must be a JSON object");
+
+    timelineFolder = timelineFile.getParentDirectory();
+    sampleRate = timeline.getProperty("sampleRate", 44100.0);
+    blockSize = timeline.getProperty("blockSize", 512);
+    numDecks = juce::jlimit(MixerEngine::MIN_DECKS, MixerEngine::MAX_DECKS, (int) timeline.getProperty("decks", 2));
+    durationSeconds = timeline.getProperty("duration", 0.0);
+    autoGainTarget = timeline.getProperty("autoGainTarget", DJAudioPlayer::DEFAULT_AUTO_GAIN_TARGET);
+
+    if (sampleRate < 8000.0 || sampleRate > 384000.0)
+        return juce::Result::fail("Unsupported sample rate " + juce::String(sampleRate));
+
+    if (blockSize < 16 || blockSize > 8192)
+        return juce::Result::fail("Block size must be between 16 and 8192");
+
+    auto outputs = timeline.getProperty("outputs", "master").toString();
+
+    if (! MixerEngine::findOutputRouting(outputs, outputRouting))
+        return juce::Result::fail("Unknown outputs \"" + outputs + "\" - use master, cue or decks");
+
+    padFiles.clear();
+    auto padList = timeline.getProperty("pads", {});
+
+    if (padList.isArray())
+    {
+        if (padList.size() > SamplePadBank::NUM_PADS)
+            return juce::Result::fail("There are only " + juce::String(SamplePadBank::NUM_PADS) + " pads");
+
+        for (int i = 0; i < padList.size(); ++i)
+            padFiles.add(padList[i].toString());
+    }
+
+    auto eventList = timeline.getProperty("events", {});
+
+    if (! eventList.isArray())
+        return juce::Result::fail("Timeline has no events array");
+
+    events.clearQuick();
+
+    for (int i = 0; i < eventList.size(); ++i)
+    {
+        const auto& item = eventList[i];
+        auto action = item.getProperty("action", {}).toString();
+        double time = item.getProperty("time", 0.0);
+        int deck = item.getProperty("deck", 0);
+
+        if (action.isEmpty() || time < 0.0)
+            return juce::Result::fail("Event " + juce::String(i + 1) + " needs an action and a time of 0 or more");
+
+        // Master controls have no deck, everything else needs one
+        bool isMasterControl = action == "crossfader" || action == "masterVolume" || action == "masterFilter"
+                            || action == "pad" || action == "padVolume" || action == "cueMix";
+
+        if (! isMasterControl && (deck < 1 || deck > numDecks))
+            return juce::Result::fail("Event " + juce::String(i + 1) + " (" + action + ") needs a deck from 1 to " + juce::String(numDecks));
+
+        TimelineEvent event;
+        event.sample = static_cast<juce::int64>(time * sampleRate);
+        event.deckIndex = isMasterControl ? -1 : deck - 1;
+        event.action = action;
+        event.value = action == "load" ? item.getProperty("file", {}) : item.getProperty("value", {});
+        event.rampSeconds = item.getProperty("ramp", 0.0);
+        events.add(event);
+    }
+
+    // Events at the same time keep their file order, so a load can come before a play
+    std::stable_sort(events.begin(), events.end(),
+                     [](const TimelineEvent& a, const TimelineEvent& b) { return a.sample < b.sample; });
+
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRenderer::render(const juce::File& outputFile)
+{
+    // decks can only be added to the mixer once
+    jassert(mixer.getNumDecks() == 0);
+
+    // Decks and mixer are set up exactly as the app does it, minus the audio device
+    controlValues.clear();
+    ramps.clearQuick();
+    loadingSeconds = 0.0;
+    lastCommandSample = -1;
+
+    for (int i = 0; i < numDecks; ++i)
+        mixer.addDeck(players.add(new DJAudioPlayer(formatManager)));
+
+    mixer.setOutputRouting(outputRouting);
+    mixer.prepareToPlay(blockSize, sampleRate);
+
+    for (auto* player : players)
+    {
+        player->setResamplingQuality(SincResamplingAudioSource::Quality::high);
+        player->setAutoGainTarget(autoGainTarget);
+        player->setOfflineRendering(true);
+    }
+
+    setControl("crossfader", -1, 0.5, 0);
+    setControl("masterVolume", -1, 0.8, 0);
+    setControl("masterFilter", -1, 0.5, 0);
+    setControl("padVolume", -1, 1.0, 0);
+    setControl("cueMix", -1, 0.0, 0);
+
+    // the pads are decoded up front, like the app does when they are loaded
+    auto padsStart = juce::Time::getMillisecondCounterHiRes();
+
+    for (int pad = 0; pad < padFiles.size(); ++pad)
+    {
+        if (padFiles[pad].isEmpty())
+            continue;
+
+        auto result = mixer.getSamplePads().loadSample(pad, timelineFolder.getChildFile(padFiles[pad]), formatManager);
+
+        if (result.failed())
+            return result;
+    }
+
+    loadingSeconds += (juce::Time::getMillisecondCounterHiRes() - padsStart) / 1000.0;
+
+    outputFile.deleteFile();
+    std::unique_ptr<juce::FileOutputStream> stream(outputFile.createOutputStream());
+
+    if (stream == nullptr)
+        return juce::Result::fail("Can't write to " + outputFile.getFullPathName());
+
+    int numChannels = mixer.getNumOutputChannels();
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(stream.get(), sampleRate, (unsigned int) numChannels, 24, {}, 0));
+
+    if (writer == nullptr)
+        return juce::Result::fail("Can't create a WAV writer at " + juce::String(sampleRate) + " Hz");
+
+    // the writer owns the stream now
+    stream.release();
+
+    juce::AudioBuffer<float> block(numChannels, blockSize);
+    juce::int64 position = 0;
+    auto endSample = static_cast<juce::int64>((durationSeconds > 0.0 ? durationSeconds : MAX_RENDER_SECONDS) * sampleRate);
+    int nextEvent = 0;
+
+    // The limiter's look-ahead delays the mix, so its first samples are dropped and the end is
+    // rendered that much further on, keeping every event exactly where the timeline puts it
+    int latencyToSkip = mixer.getLatencyInSamples();
+
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    while (position < endSample)
+    {
+        while (nextEvent < events.size() && events.getReference(nextEvent).sample <= position)
+        {
+            auto result = applyEvent(events.getReference(nextEvent++));
+
+            if (result.failed())
+                return result;
+        }
+
+        // Without a duration, the mix is over once the script is and the decks have run out
+        if (durationSeconds <= 0.0 && nextEvent == events.size() && ramps.isEmpty()
+            && position > lastCommandSample && ! anyDeckPlaying() && ! anyPadPlaying())
+            break;
+
+        applyRamps(position);
+
+        // Blocks are cut short at the next event so every event lands on its own sample - apart
+        // from transport commands, which the decks land on their sample inside the block
+        auto numSamples = (int) juce::jmin((juce::int64) blockSize, endSample - position);
+
+        for (int i = nextEvent; i < events.size(); ++i)
+        {
+            if (! isTransportCommand(events.getReference(i).action))
+            {
+                numSamples = (int) juce::jmin((juce::int64) numSamples, events.getReference(i).sample - position);
+                break;
+            }
+        }
+
+        while (nextEvent < events.size() && events.getReference(nextEvent).sample < position + numSamples)
+        {
+            auto result = applyEvent(events.getReference(nextEvent++));
+
+            if (result.failed())
+                return result;
+        }
+
+        juce::AudioSourceChannelInfo info(&block, 0, numSamples);
+        mixer.getNextAudioBlock(info);
+
+        auto decoding = checkScratchDecoding();
+
+        if (decoding.failed())
+            return decoding;
+
+        int skipped = juce::jmin(latencyToSkip, numSamples);
+        latencyToSkip -= skipped;
+
+        if (! writer->writeFromAudioSampleBuffer(block, skipped, numSamples - skipped))
+            return juce::Result::fail("Failed writing to " + outputFile.getFullPathName());
+
+        position += numSamples;
+    }
+
+    for (int remaining = mixer.getLatencyInSamples() - latencyToSkip; remaining > 0;)
+    {
+        int numSamples = juce::jmin(blockSize, remaining);
+        juce::AudioSourceChannelInfo info(&block, 0, numSamples);
+        mixer.getNextAudioBlock(info);
+
+        auto decoding = checkScratchDecoding();
+
+        if (decoding.failed())
+            return decoding;
+
+        if (! writer->writeFromAudioSampleBuffer(block, 0, numSamples))
+            return juce::Result::fail("Failed writing to " + outputFile.getFullPathName());
+
+        remaining -= numSamples;
+    }
+
+    writer.reset();
+
+    double wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+    double renderSeconds = juce::jmax(1.0e-6, wallSeconds - loadingSeconds);
+    double mixSeconds = position / sampleRate;
+
+    std::cout << "Rendered " << juce::String(mixSeconds, 1) << " s of audio to " << outputFile.getFullPathName()
+              << " in " << juce::String(renderSeconds, 3) << " s ("
+              << juce::String(mixSeconds / renderSeconds, 1) << "x real time)"
+              << ", plus " << juce::String(loadingSeconds, 3) << " s loading and analysing tracks" << std::endl;
+
+    printCommandTiming();
+
+    return juce::Result::ok();
+}
+
+void OfflineRenderer::printCommandTiming() const
+{
+    for (int i = 0; i < players.size(); ++i)
+    {
+        auto stats = players.getUnchecked(i)->getCommandTimingStats();
+
+        if (stats.numCommands > 0)
+            std::cout << "Deck " << (i + 1) << ": " << stats.numCommands << " timed transport commands, "
+                      << stats.numLate << " late, worst " << stats.maxLateSamples << " samples late" << std::endl;
+    }
+
+    auto downbeats = mixer.getDownbeatStartStats();
+
+    if (downbeats.numStarts > 0)
+        std::cout << "Downbeat starts: " << downbeats.numStarts << ", worst "
+                  << juce::String(downbeats.maxErrorSamples, 2) << " samples from the beat" << std::endl;
+}
+
+juce::Result OfflineRenderer::checkScratchDecoding() const
+{
+    // the decks wait for their decoding, so this only happens if it stalled for OFFLINE_WAIT_MS
+    for (int i = 0; i < players.size(); ++i)
+        if (players.getUnchecked(i)->getScratchUnderruns() > 0)
+            return juce::Result::fail("Deck " + juce::String(i + 1) + "'s reverse or censor ran ahead of the decoder");
+
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRenderer::applyEvent(const TimelineEvent& event)
+{
+    auto* player = event.deckIndex >= 0 ? players[event.deckIndex] : nullptr;
+
+    if (event.action == "load")
+    {
+        auto file = timelineFolder.getChildFile(event.value.toString());
+
+        if (! file.existsAsFile())
+            return juce::Result::fail("Track not found: " + file.getFullPathName());
+
+        auto loadStart = juce::Time::getMillisecondCounterHiRes();
+        player->loadURL(juce::URL(file));
+        player->waitForAnalysis(ANALYSIS_TIMEOUT_MS);
+        loadingSeconds += (juce::Time::getMillisecondCounterHiRes() - loadStart) / 1000.0;
+
+        if (player->getLengthInSeconds() <= 0.0)
+            return juce::Result::fail("Couldn't read " + file.getFullPathName());
+
+        // loading resets the speed of the deck
+        controlValues["speed:" + juce::String(event.deckIndex)] = 1.0;
+    }
+    else if (isTransportCommand(event.action) && event.action != "startOnDownbeat")
+    {
+        // the deck's clock counts from the start of the render, so it is the timeline's sample
+        TransportCommand command;
+        command.type = event.action == "play" ? TransportCommand::Type::play
+                     : event.action == "stop" ? TransportCommand::Type::stop
+                     : event.action == "hotCue" ? TransportCommand::Type::hotCue
+                     : event.action == "loopIn" ? TransportCommand::Type::loopIn
+                     : event.action == "loopOut" ? TransportCommand::Type::loopOut
+                     : event.action == "autoLoop" ? TransportCommand::Type::autoLoop
+                     : event.action == "loopRoll" ? TransportCommand::Type::loopRoll
+                     : event.action == "loopExit" ? TransportCommand::Type::loopExit
+                     : event.action == "reverse" ? TransportCommand::Type::reverse
+                     : event.action == "censor" ? TransportCommand::Type::censor : TransportCommand::Type::seek;
+        command.value = event.action == "position" ? (double) event.value : 0.0;
+
+        if (event.action == "reverse" || event.action == "censor")
+            command.value = (double) event.value != 0.0 ? 1.0 : 0.0;
+        
+        if (event.action == "autoLoop" || event.action == "loopRoll")
+        {
+            command.value = event.value;
+            if (command.value < DJAudioPlayer::MIN_LOOP_BEATS || command.value > DJAudioPlayer::MAX_LOOP_BEATS)
+                return juce::Result::fail(event.action + " needs a length from 1/32 to 32 beats");
+        }
+
+        if (event.action == "hotCue")
+        {
+            int cue = event.value;
+            if (cue < 1 || cue > HotCueSource::NUM_CUES)
+                return juce::Result::fail("hotCue needs a cue from 1 to " + juce::String(HotCueSource::NUM_CUES));
+
+            command.value = cue - 1;
+        }
+
+        command.sampleTime = event.sample;
+        player->queueCommand(command);
+        lastCommandSample = juce::jmax(lastCommandSample, event.sample);
+    }
+    else if (event.action == "setCue")
+    {
+        int cue = event.value;
+        if (cue < 1 || cue > HotCueSource::NUM_CUES)
+            return juce::Result::fail("setCue needs a cue from 1 to " + juce::String(HotCueSource::NUM_CUES));
+
+        player->setHotCue(cue - 1, player->getPositionInSeconds());
+    }
+    else if (event.action == "startOnDownbeat")
+    {
+        int leader = event.value;
+
+        if (leader < 1 || leader > numDecks)
+            return juce::Result::fail("startOnDownbeat needs the deck to follow, from 1 to " + juce::String(numDecks));
+
+        mixer.startOnNextDownbeat(event.deckIndex, leader - 1);
+    }
+    else if (event.action == "pad")
+    {
+        int pad = event.value;
+        if (pad < 1 || pad > SamplePadBank::NUM_PADS)
+            return juce::Result::fail("pad needs a pad from 1 to " + juce::String(SamplePadBank::NUM_PADS));
+
+        // the block is cut at the event, so the pad starts on its sample
+        mixer.getSamplePads().trigger(pad - 1);
+    }
+    else if (event.action == "keyLock")
+    {
+        // the stretcher's crossfade starts on the event's sample, as a GUI toggle's would
+        player->queueCommand({ TransportCommand::Type::keyLock, (bool) event.value ? 1.0 : 0.0, event.sample });
+    }
+    else if (event.action == "autoGain")
+    {
+        player->setAutoGainEnabled(event.value);
+    }
+    else if (event.action == "killLow" || event.action == "killMid" || event.action == "killHigh")
+    {
+        auto band = event.action == "killLow" ? DeckEQ::low : (event.action == "killMid" ? DeckEQ::mid : DeckEQ::high);
+        player->setEQKill(band, event.value);
+    }
+    else if (findEffect(event.action) >= 0)
+    {
+        mixer.getDeckEffects(event.deckIndex).setEffectEnabled(static_cast<DeckEffectsRack::Effect>(findEffect(event.action)), event.value);
+    }
+    else if (event.action == "sync")
+    {
+        mixer.getSyncEngine().setSyncEnabled(event.deckIndex, event.value, event.sample);
+    }
+    else if (event.action == "cue")
+    {
+        mixer.setCueEnabled(event.deckIndex, event.value);
+    }
+    else if (isContinuousControl(event.action))
+    {
+        double target = event.value;
+
+        // any earlier ramp on the same control is replaced by this event
+        ramps.removeIf([&event](const Ramp& ramp) { return ramp.action == event.action && ramp.deckIndex == event.deckIndex; });
+
+        if (event.rampSeconds > 0.0)
+        {
+            Ramp ramp{ event.action, event.deckIndex, getControl(event.action, event.deckIndex), target,
+                       event.sample, event.sample + static_cast<juce::int64>(event.rampSeconds * sampleRate) + 1 };
+            ramps.add(ramp);
+        }
+        else
+            setControl(event.action, event.deckIndex, target, event.sample);
+    }
+    else
+    {
+        return juce::Result::fail("Unknown timeline action: " + event.action);
+    }
+
+    return juce::Result::ok();
+}
+
+void OfflineRenderer::applyRamps(juce::int64 position)
+{
+    for (int i = ramps.size(); --i >= 0;)
+    {
+        const auto& ramp = ramps.getReference(i);
+        double progress = juce::jlimit(0.0, 1.0, (double) (position - ramp.startSample) / (double) (ramp.endSample - ramp.startSample));
+
+        setControl(ramp.action, ramp.deckIndex, ramp.startValue + (ramp.endValue - ramp.startValue) * progress, position);
+
+        if (progress >= 1.0)
+            ramps.remove(i);
+    }
+}
+
+void OfflineRenderer::setControl(const juce::String& action, int deckIndex, double value, juce::int64 sampleTime)
+{
+    controlValues[action + ":" + juce::String(deckIndex)] = value;
+
+    if (action == "crossfader")
+        mixer.setCrossfader(juce::jlimit(0.0, 1.0, value));
+    else if (action == "masterVolume")
+        mixer.setMasterVolume(juce::jlimit(0.0, 1.0, value));
+    else if (action == "masterFilter")
+        mixer.setMasterFilter(juce::jlimit(0.0, 1.0, value));
+    else if (action == "padVolume")
+        mixer.getSamplePads().setVolume(static_cast<float>(value));
+    else if (action == "cueMix")
+        mixer.setCueMix(value);
+    else if (action == "volume")
+        players.getUnchecked(deckIndex)->setGain(value);
+    else if (action == "speed" && value > 0.0 && value <= 4.0)
+        players.getUnchecked(deckIndex)->queueCommand({ TransportCommand::Type::speed, value, sampleTime });
+    else if (action == "eqLow")
+        players.getUnchecked(deckIndex)->setEQGain(DeckEQ::low, value);
+    else if (action == "eqMid")
+        players.getUnchecked(deckIndex)->setEQGain(DeckEQ::mid, value);
+    else if (action == "eqHigh")
+        players.getUnchecked(deckIndex)->setEQGain(DeckEQ::high, value);
+}
+
+double OfflineRenderer::getControl(const juce::String& action, int deckIndex) const
+{
+    auto found = controlValues.find(action + ":" + juce::String(deckIndex));
+
+    if (found != controlValues.end())
+        return found->second;
+
+    // EQ gains start flat, volume and speed at 1.0, the master controls are set before rendering
+    return action.startsWith("eq") ? 0.0 : 1.0;
+}
+
+int OfflineRenderer::findEffect(const juce::String& action)
+{
+    for (int effect = 0; effect < DeckEffectsRack::numEffects; ++effect)
+        if (action == DeckEffectsRack::getEffectName(static_cast<DeckEffectsRack::Effect>(effect)))
+            return effect;
+
+    return -1;
+}
+
+bool OfflineRenderer::isTransportCommand(const juce::String& action)
+{
+    return action == "play" || action == "stop" || action == "position" || action == "hotCue"
+        || action == "loopIn" || action == "loopOut" || action == "autoLoop" || action == "loopRoll"
+        || action == "loopExit" || action == "reverse" || action == "censor" || action == "startOnDownbeat";
+}
+
+bool OfflineRenderer::isContinuousControl(const juce::String& action)
+{
+    return action == "crossfader" || action == "masterVolume" || action == "masterFilter" || action == "padVolume" || action == "cueMix"
+        || action == "volume" || action == "speed"
+        || action == "eqLow" || action == "eqMid" || action == "eqHigh";
+}
+
+bool OfflineRenderer::anyDeckPlaying() const
+{
+    for (auto* player : players)
+        if (player->isPlaying())
+            return true;
+
+    return false;
+}
+
+bool OfflineRenderer::anyPadPlaying()
+{
+    for (int pad = 0; pad < SamplePadBank::NUM_PADS; ++pad)
+        if (mixer.getSamplePads().isPlaying(pad))
+            return true;
+
+    return false;
+}
+
+int OfflineRenderer::renderFromCommandLine(const juce::StringArray& args)
+{
+    int renderArg = args.indexOf("--render");
+
+    if (renderArg < 0 || renderArg + 2 >= args.size())
+    {
+        std::cerr << "Usage: --render timeline.json output.wav" << std::endl;
+        return 1;
+    }
+
+    auto currentDir = juce::File::getCurrentWorkingDirectory();
+    auto timelineFile = currentDir.getChildFile(args[renderArg + 1].unquoted());
+    auto outputFile = currentDir.getChildFile(args[renderArg + 2].unquoted());
+
+    OfflineRenderer renderer;
+    auto result = renderer.loadTimeline(timelineFile);
+
+    if (result.wasOk())
+        result = renderer.render(outputFile);
+
+    if (result.failed())
+    {
+        std::cerr << "Render failed: " << result.getErrorMessage() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
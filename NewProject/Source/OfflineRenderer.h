@@ -0,0 +1,138 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DJAudioPlayer.h"
+#include "MixerEngine.h"
+
+// Renders a scripted mix to a WAV file as fast as the CPU allows, with no audio device and no GUI.
+// Started with --render timeline.json out.wav. The timeline is a JSON object like:
+//
+//   {
+//     "sampleRate": 44100, "blockSize": 512, "decks": 2, "duration": 90, "autoGainTarget": -14,
+//     "events": [
+//       { "time": 0,  "deck": 1, "action": "load", "file": "../tracks/a.mp3" },
+//       { "time": 0,  "deck": 1, "action": "play" },
+//       { "time": 30, "deck": 2, "action": "speed", "value": 1.04, "ramp": 4 },
+//       { "time": 40, "action": "crossfader", "value": 1.0, "ramp": 8 }
+//     ]
+//   }
+//
+// Decks are numbered from 1, relative files are found from the timeline's folder and "ramp" moves
+// a value to its target over that many seconds. Without a duration the render stops once the last
+// event has passed and every deck has stopped. Loading waits for the track's beat grid and loudness
+// analysis, so sync and auto-gain (switched per deck with the "autoGain" action) render the same
+// every time. The deck EQ is set with "eqLow", "eqMid" and "eqHigh" in dB, which can ramp, and
+// "killLow", "killMid" and "killHigh". The send effects are switched on and off with "echo",
+// "reverb", "flanger" and "delay".
+//
+// "setCue" sets the hot cue numbered by its value (1 to 8) where the deck is, and "hotCue" jumps to it.
+// "loopIn" and "loopOut" set a manual loop, "autoLoop" loops the number of beats given as its value
+// (1/32 to 32, from the beat grid) and "loopRoll" rolls them, and "loopExit" ends either.
+// "reverse" and "censor" start with a value of 1 and end with 0 - a censor ends where the deck would
+// have been without it. Reverse play is decoded in the background, so a render much faster than
+// real time can get ahead of it - the deck holds its last sample until the audio is there, and the
+// blocks it held are printed after the render.
+//
+// "play", "stop", "position", "hotCue", the loop actions, "reverse" and "censor" go through the
+// decks' transport command queues timestamped with their sample, as the GUI's do. So do "speed"
+// (a ramp's steps timestamped at the start of each block), "keyLock" and the end of "sync". And
+// "startOnDownbeat" starts a deck on the next downbeat of the deck given as its value. After the
+// render the timing of those commands is printed - how many landed late and by how much, and how
+// far the downbeat starts were from the beat.
+//
+// A "pads" array of files loads the sample pads before rendering, and "pad" fires the pad numbered
+// by its value (1 to 8) on its exact sample. "padVolume" sets the pad bus level and can ramp.
+//
+// "outputs" routes the render as the app routes the device: "master" (the default) writes a stereo
+// file, "cue" adds the headphone cue as channels 3/4 and "decks" writes each deck after its fader
+// on its own pair, with the pad bus on the pair after the decks. "cue" puts a deck in the headphone cue with a value of 1 and takes it out with 0,
+// and "cueMix" blends the cue (0) with the master (1) and can ramp.
+class OfflineRenderer
+{
+public:
+    OfflineRenderer();
+    ~OfflineRenderer();
+
+    // Reads and checks the timeline, without loading any tracks yet
+    juce::Result loadTimeline(const juce::File& timelineFile);
+
+    // Renders the whole timeline to a 24 bit WAV file, with a channel for each of the routing's
+    // outputs, and prints the real-time factor (call once)
+    juce::Result render(const juce::File& outputFile);
+
+    // Runs a render from the command line arguments and returns the process exit code
+    static int renderFromCommandLine(const juce::StringArray& args);
+
+private:
+    struct TimelineEvent
+    {
+        juce::int64 sample;
+        int deckIndex;      // -1 for master controls
+        juce::String action;
+        juce::var value;
+        double rampSeconds;
+    };
+
+    // A control moving towards its target value, updated once per rendered block
+    struct Ramp
+    {
+        juce::String action;
+        int deckIndex;
+        double startValue;
+        double endValue;
+        juce::int64 startSample;
+        juce::int64 endSample;
+    };
+
+    juce::Result applyEvent(const TimelineEvent& event);
+    // Fails once a deck has played a block its scratch decoding never caught up with
+    juce::Result checkScratchDecoding() const;
+    void applyRamps(juce::int64 position);
+    // Sets a control from the sample given - the speed goes through the deck's command queue for it
+    void setControl(const juce::String& action, int deckIndex, double value, juce::int64 sampleTime);
+    double getControl(const juce::String& action, int deckIndex) const;
+    static bool isContinuousControl(const juce::String& action);
+    // The effect an action switches, or -1
+    static int findEffect(const juce::String& action);
+    // Actions sent through the deck's command queue instead of landing on a block boundary
+    static bool isTransportCommand(const juce::String& action);
+    void printCommandTiming() const;
+
+    bool anyDeckPlaying() const;
+    bool anyPadPlaying();
+
+    juce::AudioFormatManager formatManager;
+    juce::OwnedArray<DJAudioPlayer> players;
+    MixerEngine mixer;
+
+    juce::File timelineFolder;
+    juce::Array<TimelineEvent> events;
+    juce::StringArray padFiles;
+    juce::Array<Ramp> ramps;
+    std::map<juce::String, double> controlValues;
+
+    double sampleRate{44100.0};
+    int blockSize{512};
+    int numDecks{MixerEngine::MIN_DECKS};
+    MixerEngine::OutputRouting outputRouting{MixerEngine::OutputRouting::master};
+    double durationSeconds{0.0};
+    double autoGainTarget{DJAudioPlayer::DEFAULT_AUTO_GAIN_TARGET};
+
+    // Last sample a transport command was queued for - the render doesn't stop before it lands
+    juce::int64 lastCommandSample{-1};
+
+    // Time spent decoding and analysing tracks, kept out of the real-time factor
+    double loadingSeconds{0.0};
+
+    // Stops a timeline with no duration rendering forever
+    static constexpr double MAX_RENDER_SECONDS = 4.0 * 60.0 * 60.0;
+    // Longest wait for a track's beat grid and loudness before rendering carries on without them
+    static constexpr int ANALYSIS_TIMEOUT_MS = 60000;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OfflineRenderer)
+};
@@ -0,0 +1,172 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "PerformanceOverlay.h"
+
+PerformanceOverlay::PerformanceOverlay(AudioCallbackMonitor& monitorToShow, std::function<int()> getDeviceXRuns)
+    : monitor(monitorToShow), deviceXRuns(std::move(getDeviceXRuns))
+{
+    setInterceptsMouseClicks(true, false);
+}
+
+PerformanceOverlay::~PerformanceOverlay()
+{
+    stopTimer();
+}
+
+void PerformanceOverlay::setRecorder(MasterRecorder* recorderToShow)
+{
+    recorder = recorderToShow;
+}
+
+void PerformanceOverlay::setLimiter(const MasterLimiter* limiterToShow)
+{
+    limiter = limiterToShow;
+}
+
+void PerformanceOverlay::setControllerInput(const MidiControllerInput* controllerToShow)
+{
+    controller = controllerToShow;
+}
+
+void PerformanceOverlay::visibilityChanged()
+{
+    // only polls the monitor while it can be seen
+    if (isVisible())
+    {
+        timerCallback();
+        startTimerHz(REFRESH_RATE_HZ);
+    }
+    else
+    {
+        stopTimer();
+    }
+}
+
+void PerformanceOverlay::timerCallback()
+{
+    snapshot = monitor.getSnapshot();
+    repaint();
+}
+
+void PerformanceOverlay::mouseDown(const juce::MouseEvent&)
+{
+    monitor.reset();
+}
+
+juce::Colour PerformanceOverlay::getLoadColour(double percent)
+{
+    if (percent < 50.0)
+        return juce::Colour::fromRGB(107, 255, 107);
+    if (percent < 80.0)
+        return juce::Colour::fromRGB(255, 159, 67);
+    return juce::Colour::fromRGB(220, 20, 60);
+}
+
+void PerformanceOverlay::paint(juce::Graphics& g)
+{
+    // translucent panel so the decks stay visible underneath
+    g.setColour(juce::Colour::fromRGB(18, 18, 22).withAlpha(0.9f));
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 6.0f);
+    g.setColour(juce::Colour::fromRGB(64, 224, 208).withAlpha(0.6f));
+    g.drawRoundedRectangle(getLocalBounds().toFloat().reduced(0.5f), 6.0f, 1.0f);
+
+    auto area = getLocalBounds().reduced(8);
+    const int lineHeight = 15;
+
+    auto drawLine = [&](const juce::String& text, juce::Colour colour)
+    {
+        g.setColour(colour);
+        g.drawText(text, area.removeFromTop(lineHeight), juce::Justification::centredLeft, true);
+    };
+
+    g.setFont(juce::Font(12.0f, juce::Font::bold));
+    drawLine("AUDIO CALLBACK (click to reset)", juce::Colour::fromRGB(220, 220, 225));
+
+    g.setFont(juce::Font(11.0f));
+    drawLine("load " + juce::String(snapshot.smoothedPercent, 1) + "%   last " + juce::String(snapshot.lastPercent, 1) + "%",
+             getLoadColour(snapshot.smoothedPercent));
+    drawLine("worst " + juce::String(snapshot.worstRecentPercent, 1) + "% in "
+             + juce::String(AudioCallbackMonitor::DEFAULT_WORST_CASE_SECONDS) + " s   peak "
+             + juce::String(snapshot.peakPercent, 1) + "%",
+             getLoadColour(snapshot.worstRecentPercent));
+
+    int deviceXRunCount = deviceXRuns != nullptr ? deviceXRuns() : -1;
+    bool anyXRuns = snapshot.numOverruns > 0 || snapshot.numGaps > 0 || deviceXRunCount > 0;
+    drawLine("overruns " + juce::String(snapshot.numOverruns) + "   gaps " + juce::String(snapshot.numGaps)
+             + "   device xruns " + (deviceXRunCount >= 0 ? juce::String(deviceXRunCount) : juce::String("n/a")),
+             anyXRuns ? juce::Colour::fromRGB(220, 20, 60) : juce::Colour::fromRGB(180, 180, 185));
+
+    // the stages, e.g. "sync 0.1%  mix 0.8%  deck 1 4.2%  deck 2 3.9%  echo 0.6%", wrapped onto
+    // a second line when the effects don't fit
+    juce::String stages;
+    for (int stage = 0; stage < snapshot.numStages; ++stage)
+    {
+        auto item = monitor.getStageName(stage) + " " + juce::String(snapshot.stages[(size_t) stage].smoothedPercent, 1) + "%";
+
+        if (stages.isNotEmpty() && g.getCurrentFont().getStringWidth(stages + "  " + item) > area.getWidth())
+        {
+            drawLine(stages, juce::Colour::fromRGB(180, 180, 185));
+            stages.clear();
+        }
+
+        stages << (stages.isEmpty() ? "" : "  ") << item;
+    }
+    drawLine(stages, juce::Colour::fromRGB(180, 180, 185));
+
+    if (recorder != nullptr)
+    {
+        auto stats = recorder->getStats();
+        bool anyDrops = stats.droppedBlocks > 0 || stats.writeFailed;
+        drawLine(juce::String(recorder->isRecording() ? "recording" : "recorder") + "   fifo peak "
+                 + juce::String(100.0 * stats.highWaterMark / juce::jmax(1, stats.fifoCapacity), 1) + "%   dropped "
+                 + juce::String(stats.droppedBlocks) + " blocks" + (stats.writeFailed ? "   DISK ERROR" : ""),
+                 anyDrops ? juce::Colour::fromRGB(220, 20, 60) : juce::Colour::fromRGB(180, 180, 185));
+    }
+
+    if (limiter != nullptr)
+    {
+        float reduction = limiter->getGainReductionDecibels();
+        drawLine(juce::String("limiter") + (limiter->isEnabled() ? "" : " off") + "   reduction "
+                 + juce::String(reduction, 1) + " dB   latency " + juce::String(limiter->getLatencyInSamples()) + " samples",
+                 reduction < -6.0f ? juce::Colour::fromRGB(255, 159, 67) : juce::Colour::fromRGB(180, 180, 185));
+    }
+
+    if (controller != nullptr)
+    {
+        auto stats = controller->getLatencyStats();
+        auto deviceName = controller->getDeviceName();
+        drawLine("midi " + (deviceName.isEmpty() ? juce::String("off") : deviceName) + "   "
+                 + juce::String(stats.numEvents) + " events   avg " + juce::String(stats.averageMs, 2) + " ms   max "
+                 + juce::String(stats.maxMs, 2) + " ms" + (stats.numDropped > 0 ? "   dropped " + juce::String(stats.numDropped) : ""),
+                 stats.numDropped > 0 ? juce::Colour::fromRGB(220, 20, 60) : juce::Colour::fromRGB(180, 180, 185));
+    }
+
+    // Histogram of callback times, scaled to the fullest bin, with a marker at the deadline
+    area.removeFromTop(4);
+    auto histogramArea = area.toFloat();
+    juce::uint32 maxCount = 1;
+    for (auto count : snapshot.histogram)
+        maxCount = juce::jmax(maxCount, count);
+
+    float binWidth = histogramArea.getWidth() / AudioCallbackMonitor::NUM_HISTOGRAM_BINS;
+
+    for (int bin = 0; bin < AudioCallbackMonitor::NUM_HISTOGRAM_BINS; ++bin)
+    {
+        auto count = snapshot.histogram[(size_t) bin];
+        if (count == 0)
+            continue;
+
+        // log scale so the rare slow callbacks still show up
+        float height = histogramArea.getHeight() * std::log1p((float) count) / std::log1p((float) maxCount);
+        g.setColour(getLoadColour(bin * AudioCallbackMonitor::HISTOGRAM_BIN_PERCENT));
+        g.fillRect(histogramArea.getX() + bin * binWidth, histogramArea.getBottom() - height,
+                   juce::jmax(1.0f, binWidth - 1.0f), height);
+    }
+
+    float deadlineX = histogramArea.getX() + (float) (100.0 / AudioCallbackMonitor::HISTOGRAM_BIN_PERCENT) * binWidth;
+    g.setColour(juce::Colour::fromRGB(220, 220, 225).withAlpha(0.6f));
+    g.drawVerticalLine(juce::roundToInt(deadlineX), histogramArea.getY(), histogramArea.getBottom());
+}
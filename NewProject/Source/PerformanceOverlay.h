@@ -0,0 +1,54 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioCallbackMonitor.h"
+#include "MasterRecorder.h"
+#include "MasterLimiter.h"
+#include "MidiControllerInput.h"
+
+// Shows the audio callback statistics on top of the decks - the load, the worst case of the
+// last few seconds, overruns, gaps and the device's own xrun count, each stage's share of the
+// deadline and a histogram of callback times. Clicking it resets the statistics.
+class PerformanceOverlay : public juce::Component,
+                           private juce::Timer
+{
+public:
+    // getDeviceXRuns returns the device's xrun count, or -1 if the device can't report it
+    PerformanceOverlay(AudioCallbackMonitor& monitorToShow, std::function<int()> getDeviceXRuns);
+    ~PerformanceOverlay() override;
+
+    // Adds the recorder's FIFO and drop counts to the overlay
+    void setRecorder(MasterRecorder* recorderToShow);
+
+    // Adds the limiter's gain reduction and latency to the overlay
+    void setLimiter(const MasterLimiter* limiterToShow);
+
+    // Adds the controller's event count and MIDI to audio thread latency to the overlay
+    void setControllerInput(const MidiControllerInput* controllerToShow);
+
+    void paint(juce::Graphics& g) override;
+    void mouseDown(const juce::MouseEvent& event) override;
+    void visibilityChanged() override;
+
+private:
+    void timerCallback() override;
+
+    // Colour for a share of the deadline - green, then orange, then red past 80%
+    static juce::Colour getLoadColour(double percent);
+
+    AudioCallbackMonitor& monitor;
+    MasterRecorder* recorder{nullptr};
+    const MasterLimiter* limiter{nullptr};
+    const MidiControllerInput* controller{nullptr};
+    std::function<int()> deviceXRuns;
+    AudioCallbackMonitor::Snapshot snapshot;
+
+    static constexpr int REFRESH_RATE_HZ = 10;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PerformanceOverlay)
+};
@@ -5,14 +5,17 @@
 
 #include <JuceHeader.h>
 #include "PlaylistComponent.h"
+#include "Tracing.h"
 
-PlaylistComponent::PlaylistComponent()
+PlaylistComponent::PlaylistComponent(int numDecks)
+    : numDecks(numDecks)
 {
     // load saved playlist state first
     loadPlaylistState();
     
     // if no saved state, load from tracks folder
     if (trackTitles.empty()) {
+        TRACE_SCOPE("playlist", "scan tracks folder");
         juce::File tracksDir("/Users/MacBook/Desktop/Projects/Uni/OtoDecks/NewProject/tracks");
         juce::Array<juce::File> files;
         tracksDir.findChildFiles(files, juce::File::findFiles, false, "*.mp3;*.wav");
@@ -30,8 +33,8 @@ PlaylistComponent::PlaylistComponent()
     // styles the table headers with track details and load buttons for each deck
     tableComponent.getHeader().addColumn("Track Title", 1, 300);
     tableComponent.getHeader().addColumn("Size", 2, 80);
-    tableComponent.getHeader().addColumn("Load Deck 1", 3, 100);
-    tableComponent.getHeader().addColumn("Load Deck 2", 4, 100);
+    for (int deck = 0; deck < numDecks; ++deck)
+        tableComponent.getHeader().addColumn("Load Deck " + juce::String(deck + 1), deck + 3, 100);
     tableComponent.getHeader().setStretchToFitActive(true);
     
     // Sets the header colors
@@ -172,14 +175,14 @@ void PlaylistComponent::paintCell(juce::Graphics& g,
                                         bool isRowSelected, 
                                         juce::Component *existingComponentToUpdate)
   {
-    // Column 3 = Deck 1, Column 4 = Deck 2
-      if (columnId == 3 || columnId == 4)
+    // Column 3 = Deck 1, Column 4 = Deck 2 and so on
+      if (columnId >= 3 && columnId < 3 + numDecks)
       {
         if (existingComponentToUpdate == nullptr)
         {
-          LoadButton* btn = new LoadButton(rowNumber, columnId - 3, this); // columnId-3 = deckIndex (0 or 1)
+          LoadButton* btn = new LoadButton(rowNumber, columnId - 3, this); // columnId-3 = deckIndex
           btn->setColour(juce::TextButton::buttonColourId, 
-                        columnId == 3 ? juce::Colour::fromRGB(70, 130, 180) : juce::Colour::fromRGB(220, 20, 60));
+                        (columnId - 3) % 2 == 0 ? juce::Colour::fromRGB(70, 130, 180) : juce::Colour::fromRGB(220, 20, 60));
           btn->setColour(juce::TextButton::textColourOffId, juce::Colours::white);
           btn->addListener(this);
           existingComponentToUpdate = btn;
@@ -222,13 +225,20 @@ juce::File PlaylistComponent::getPlaylistFile()
 
 void PlaylistComponent::savePlaylistState()
 {
+    savePlaylistState(getPlaylistFile());
+}
+
+void PlaylistComponent::savePlaylistState(const juce::File& playlistFile)
+{
+    TRACE_SCOPE("playlist", "save playlist");
+    
     // Create PropertiesFile
     juce::PropertiesFile::Options options;
     options.applicationName = "OtoDecks";
     options.filenameSuffix = ".properties";
     options.folderName = "OtoDecks";
     
-    playlistProperties.reset(new juce::PropertiesFile(getPlaylistFile(), options));
+    playlistProperties.reset(new juce::PropertiesFile(playlistFile, options));
     
     // Saves the track count and paths
     playlistProperties->setValue("trackCount", static_cast<int>(trackFiles.size()));
@@ -247,14 +257,19 @@ void PlaylistComponent::savePlaylistState()
 
 void PlaylistComponent::loadPlaylistState()
 {
+    loadPlaylistState(getPlaylistFile());
+}
+
+void PlaylistComponent::loadPlaylistState(const juce::File& playlistFile)
+{
+    TRACE_SCOPE("playlist", "load playlist");
+    
     // Loads the existing playlist state
     juce::PropertiesFile::Options options;
     options.applicationName = "OtoDecks";
     options.filenameSuffix = ".properties";
     options.folderName = "OtoDecks";
     
-    juce::File playlistFile = getPlaylistFile();
-    
     if (playlistFile.exists())
     {
         playlistProperties.reset(new juce::PropertiesFile(playlistFile, options));
@@ -16,7 +16,8 @@ class PlaylistComponent  : public juce::Component,
 
 {
 public:
-    PlaylistComponent();
+    // one "Load Deck" column is added for each deck
+    explicit PlaylistComponent(int numDecks = 2);
     ~PlaylistComponent() override;
 
     void paint (juce::Graphics&) override;
@@ -49,9 +50,11 @@ public:
     // Callback for when the tracks should be loaded to the decks
     std::function<void(int, const juce::File&)> onTrackLoadRequest;
     
-    // State persistence methods
+    // State persistence methods - without a file these use the playlist in the Documents folder
     void savePlaylistState();
     void loadPlaylistState();
+    void savePlaylistState(const juce::File& playlistFile);
+    void loadPlaylistState(const juce::File& playlistFile);
     
     // button component for the load buttons
     class LoadButton : public juce::TextButton
@@ -60,7 +63,7 @@ public:
         LoadButton(int trackIndex, int deckIndex, PlaylistComponent* parent)
         : trackIndex(trackIndex), deckIndex(deckIndex), parent(parent)
         {
-          setButtonText(deckIndex == 0 ? "Deck 1" : "Deck 2");
+          setButtonText("Deck " + juce::String(deckIndex + 1));
         }
         
         int trackIndex;
@@ -71,6 +74,7 @@ public:
 private:
 
     juce::TableListBox tableComponent;
+    int numDecks;
     std::vector<juce::String> trackTitles;
     std::vector<juce::File> trackFiles;
     
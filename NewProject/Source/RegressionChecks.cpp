@@ -0,0 +1,414 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "RegressionChecks.h"
+#include "OfflineRenderer.h"
+#include <iostream>
+
+int RegressionChecks::runAll()
+{
+    auto folder = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("OtoDecksChecks", {});
+
+    if (! folder.createDirectory())
+    {
+        std::cout << "Couldn't create " << folder.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    struct Check
+    {
+        const char* name;
+        juce::Result (*run)(const juce::File&);
+    };
+
+    int numFailed = 0;
+
+    const Check checks[] = { { "sync", checkSyncDrift }, { "timing", checkCommandTiming },
+                             { "loop", checkLoopWrap }, { "routing", checkRouting } };
+
+    for (auto& check : checks)
+    {
+        // each check renders in a folder of its own, so no track is mistaken for another's
+        auto checkFolder = folder.getChildFile(check.name);
+        checkFolder.createDirectory();
+
+        auto result = check.run(checkFolder);
+
+        if (result.failed())
+            ++numFailed;
+
+        std::cout << (result.wasOk() ? "PASS " : "FAIL ") << check.name
+                  << (result.wasOk() ? juce::String() : ": " + result.getErrorMessage()) << std::endl;
+    }
+
+    folder.deleteRecursively();
+    std::cout << numFailed << " of " << juce::numElementsInArray(checks) << " checks failed" << std::endl;
+
+    return numFailed;
+}
+
+juce::Result RegressionChecks::checkSyncDrift(const juce::File& folder)
+{
+    if (! writeWavFile(folder.getChildFile("leader.wav"), createKicks(120.0, 30.0))
+        || ! writeWavFile(folder.getChildFile("follower.wav"), createKicks(123.0, 30.0)))
+        return juce::Result::fail("Couldn't write the tracks");
+
+    // The follower starts off the beat and at its own tempo, so sync has both to correct
+    juce::AudioBuffer<float> output;
+    auto result = render(folder, makeTimeline(20.0, 2, "decks", {
+        makeEvent(0.0, 1, "load", "leader.wav"),
+        makeEvent(0.0, 2, "load", "follower.wav"),
+        makeEvent(0.2, 1, "play"),
+        makeEvent(0.45, 2, "play"),
+        makeEvent(1.0, 2, "sync", true) }), output);
+
+    if (result.failed())
+        return result;
+
+    auto leaderKicks = findOnsets(output, 0);
+    auto followerKicks = findOnsets(output, 2);
+    auto settled = static_cast<int>((1.0 + SYNC_SETTLE_SECONDS) * SAMPLE_RATE);
+
+    double worstMs = 0.0;
+    double worstBeatMs = 0.0;
+    int numMeasured = 0;
+
+    for (int i = 1; i < followerKicks.size(); ++i)
+    {
+        int kick = followerKicks[i];
+        if (kick < settled)
+            continue;
+
+        // how far each kick is from the leader's nearest, and each beat from the leader's length
+        int nearest = std::numeric_limits<int>::max();
+        for (auto leaderKick : leaderKicks)
+            if (std::abs(leaderKick - kick) < std::abs(nearest))
+                nearest = leaderKick - kick;
+
+        worstMs = juce::jmax(worstMs, 1000.0 * std::abs(nearest) / SAMPLE_RATE);
+        worstBeatMs = juce::jmax(worstBeatMs, 1000.0 * std::abs(kick - followerKicks[i - 1] - 0.5 * SAMPLE_RATE) / SAMPLE_RATE);
+        ++numMeasured;
+    }
+
+    std::cout << "  sync: " << numMeasured << " kicks after settling, worst " << juce::String(worstMs, 3)
+              << " ms from the leader's and " << juce::String(worstBeatMs, 3) << " ms off its beat" << std::endl;
+
+    if (numMeasured < 10)
+        return juce::Result::fail("Only " + juce::String(numMeasured) + " of the follower's kicks were found");
+
+    if (worstMs > SYNC_TOLERANCE_MS || worstBeatMs > SYNC_TOLERANCE_MS)
+        return juce::Result::fail("The synced deck drifted " + juce::String(worstMs, 3) + " ms from the leader");
+
+    return juce::Result::ok();
+}
+
+juce::Result RegressionChecks::checkCommandTiming(const juce::File& folder)
+{
+    const int pickupBeats = 1;
+
+    if (! writeWavFile(folder.getChildFile("kicks.wav"), createKicks(120.0, 30.0, pickupBeats)))
+        return juce::Result::fail("Couldn't write the track");
+
+    // The second play lands part way through a block, and deck 3 waits for deck 1's next bar
+    const double firstPlay = 0.5, secondPlay = 0.78;
+    juce::AudioBuffer<float> output;
+    auto result = render(folder, makeTimeline(6.0, 3, "decks", {
+        makeEvent(0.0, 1, "load", "kicks.wav"),
+        makeEvent(0.0, 2, "load", "kicks.wav"),
+        makeEvent(0.0, 3, "load", "kicks.wav"),
+        makeEvent(firstPlay, 1, "play"),
+        makeEvent(secondPlay, 2, "play"),
+        makeEvent(3.1, 3, "startOnDownbeat", 1) }), output);
+
+    if (result.failed())
+        return result;
+
+    auto first = findOnsets(output, 0);
+    auto second = findOnsets(output, 2);
+    auto downbeat = findOnsets(output, 4);
+
+    if (first.isEmpty() || second.isEmpty() || downbeat.isEmpty())
+        return juce::Result::fail("A deck never started");
+
+    // the timeline's times become samples the way the renderer makes them
+    auto expected = static_cast<juce::int64>(secondPlay * SAMPLE_RATE) - static_cast<juce::int64>(firstPlay * SAMPLE_RATE);
+    auto measured = static_cast<juce::int64>(second[0] - first[0]);
+
+    // Deck 1's first kick is the pickup, so its bars are every fourth kick from the one after
+    int nearest = 0;
+    for (int i = 1; i < first.size(); ++i)
+        if (std::abs(first[i] - downbeat[0]) < std::abs(first[nearest] - downbeat[0]))
+            nearest = i;
+
+    double downbeatMs = 1000.0 * std::abs(first[nearest] - downbeat[0]) / SAMPLE_RATE;
+
+    std::cout << "  timing: plays " << measured << " samples apart for " << expected << ", downbeat start "
+              << juce::String(downbeatMs, 3) << " ms from kick " << (nearest + 1) << " of the leader" << std::endl;
+
+    if (std::abs(measured - expected) > COMMAND_TOLERANCE_SAMPLES)
+        return juce::Result::fail("The plays came out " + juce::String(measured) + " samples apart, not " + juce::String(expected));
+
+    if ((nearest - pickupBeats) % BEATS_PER_BAR != 0 || downbeatMs > DOWNBEAT_TOLERANCE_MS)
+        return juce::Result::fail("The downbeat start landed " + juce::String(downbeatMs, 3) + " ms from kick "
+                                  + juce::String(nearest + 1) + ", not on a bar");
+
+    return juce::Result::ok();
+}
+
+juce::Result RegressionChecks::checkLoopWrap(const juce::File& folder)
+{
+    // A 300 Hz sine is 147 samples a cycle, so the half second loop is 150 whole cycles. The sine
+    // runs for 2 s and noise follows, so playing past the loop can't go unnoticed
+    const int period = 147;
+    juce::AudioBuffer<float> track(2, static_cast<int>(5.0 * SAMPLE_RATE));
+    auto noise = createNoise(3.0, 7);
+    int sineLength = static_cast<int>(2.0 * SAMPLE_RATE);
+
+    for (int i = 0; i < sineLength; ++i)
+        for (int channel = 0; channel < 2; ++channel)
+            track.setSample(channel, i, 0.5f * static_cast<float>(std::sin(juce::MathConstants<double>::twoPi * (i % period) / period)));
+
+    for (int channel = 0; channel < 2; ++channel)
+        track.copyFrom(channel, sineLength, noise, channel, 0, noise.getNumSamples());
+
+    if (! writeWavFile(folder.getChildFile("sine.wav"), track))
+        return juce::Result::fail("Couldn't write the track");
+
+    juce::AudioBuffer<float> output;
+    auto result = render(folder, makeTimeline(4.0, 2, "decks", {
+        makeEvent(0.0, 1, "load", "sine.wav"),
+        makeEvent(0.1, 1, "play"),
+        makeEvent(0.6, 1, "loopIn"),
+        makeEvent(1.1, 1, "loopOut") }), output);
+
+    if (result.failed())
+        return result;
+
+    // Once the loop is set, every sample should match the one a cycle before it - a wrap that
+    // clicks, drops out or lands off the cycle shows up against it
+    int start = static_cast<int>(1.2 * SAMPLE_RATE);
+    float peak = output.getMagnitude(0, start, output.getNumSamples() - start);
+    float worst = 0.0f;
+
+    for (int i = start; i < output.getNumSamples(); ++i)
+        worst = juce::jmax(worst, std::abs(output.getSample(0, i) - output.getSample(0, i - period)));
+
+    std::cout << "  loop: worst " << juce::String(worst / juce::jmax(peak, 1.0e-6f), 6)
+              << " of the peak from one cycle to the next, over " << juce::String((output.getNumSamples() - start) / SAMPLE_RATE, 1)
+              << " s of wraps" << std::endl;
+
+    if (peak < 0.01f)
+        return juce::Result::fail("The loop went silent");
+
+    if (worst > LOOP_TOLERANCE * peak)
+        return juce::Result::fail("The loop broke the sine by " + juce::String(worst / peak, 6) + " of its peak");
+
+    return juce::Result::ok();
+}
+
+juce::Result RegressionChecks::checkRouting(const juce::File& folder)
+{
+    if (! writeWavFile(folder.getChildFile("noise.wav"), createNoise(5.0, 1))
+        || ! writeWavFile(folder.getChildFile("pad.wav"), createNoise(0.3, 2)))
+        return juce::Result::fail("Couldn't write the tracks");
+
+    // Deck 1, deck 2 and the pad each play on their own, one after another
+    auto timeline = makeTimeline(4.5, 2, "decks", {
+        makeEvent(0.0, 1, "load", "noise.wav"),
+        makeEvent(0.0, 2, "load", "noise.wav"),
+        makeEvent(0.5, 1, "play"),
+        makeEvent(1.5, 1, "stop"),
+        makeEvent(2.0, 2, "play"),
+        makeEvent(3.0, 2, "stop"),
+        makeEvent(3.5, 0, "pad", 1) });
+
+    juce::Array<juce::var> pads;
+    pads.add("pad.wav");
+    timeline.getDynamicObject()->setProperty("pads", pads);
+
+    juce::AudioBuffer<float> output;
+    auto result = render(folder, timeline, output);
+
+    if (result.failed())
+        return result;
+
+    if (output.getNumChannels() != 6)
+        return juce::Result::fail("The render has " + juce::String(output.getNumChannels()) + " channels, not 6");
+
+    // When each one is playing, with a margin either side for the starts and stops
+    const double windows[3][2] = { { 0.55, 1.45 }, { 2.05, 2.95 }, { 3.55, 3.75 } };
+    const char* names[3] = { "deck 1", "deck 2", "the pads" };
+
+    for (int source = 0; source < 3; ++source)
+    {
+        for (int pair = 0; pair < 3; ++pair)
+        {
+            float rms = getPairRMS(output, 2 * pair, windows[source][0], windows[source][1]);
+            bool shouldHear = pair == source;
+
+            if (shouldHear && rms < 100.0f * SILENCE_RMS)
+                return juce::Result::fail(juce::String(names[source]) + " isn't on outputs " + juce::String(2 * pair + 1)
+                                          + "/" + juce::String(2 * pair + 2));
+
+            if (! shouldHear && rms > SILENCE_RMS)
+                return juce::Result::fail(juce::String(names[source]) + " leaks onto outputs " + juce::String(2 * pair + 1)
+                                          + "/" + juce::String(2 * pair + 2) + " at " + juce::String(rms, 6) + " RMS");
+        }
+    }
+
+    std::cout << "  routing: deck 1, deck 2 and the pads each heard on their own pair only" << std::endl;
+
+    return juce::Result::ok();
+}
+
+juce::Result RegressionChecks::render(const juce::File& folder, const juce::var& timeline, juce::AudioBuffer<float>& output)
+{
+    auto timelineFile = folder.getChildFile("timeline.json");
+    auto outputFile = folder.getChildFile("render.wav");
+
+    if (! timelineFile.replaceWithText(juce::JSON::toString(timeline)))
+        return juce::Result::fail("Couldn't write " + timelineFile.getFullPathName());
+
+    {
+        OfflineRenderer renderer;
+        auto result = renderer.loadTimeline(timelineFile);
+
+        if (result.wasOk())
+            result = renderer.render(outputFile);
+
+        if (result.failed())
+            return result;
+    }
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(outputFile));
+
+    if (reader == nullptr)
+        return juce::Result::fail("Couldn't read the render back");
+
+    output.setSize(static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples));
+    reader->read(&output, 0, output.getNumSamples(), 0, true, true);
+
+    return juce::Result::ok();
+}
+
+juce::var RegressionChecks::makeEvent(double time, int deck, const juce::String& action, const juce::var& value)
+{
+    auto* event = new juce::DynamicObject();
+    event->setProperty("time", time);
+    event->setProperty("action", action);
+
+    if (deck > 0)
+        event->setProperty("deck", deck);
+
+    if (! value.isVoid())
+        event->setProperty(action == "load" ? "file" : "value", value);
+
+    return juce::var(event);
+}
+
+juce::var RegressionChecks::makeTimeline(double durationSeconds, int numDecks, const juce::String& outputs, const juce::Array<juce::var>& events)
+{
+    auto* timeline = new juce::DynamicObject();
+    timeline->setProperty("sampleRate", SAMPLE_RATE);
+    timeline->setProperty("blockSize", BLOCK_SIZE);
+    timeline->setProperty("decks", numDecks);
+    timeline->setProperty("duration", durationSeconds);
+    timeline->setProperty("outputs", outputs);
+    timeline->setProperty("events", events);
+    return juce::var(timeline);
+}
+
+juce::AudioBuffer<float> RegressionChecks::createKicks(double bpm, double lengthInSeconds, int pickupBeats)
+{
+    int numSamples = static_cast<int>(SAMPLE_RATE * lengthInSeconds);
+    juce::AudioBuffer<float> buffer(2, numSamples);
+    double samplesPerBeat = SAMPLE_RATE * 60.0 / bpm;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // a cosine, so the kick is at full level on its first sample
+        auto beat = static_cast<int>(std::floor(i / samplesPerBeat));
+        auto beatStart = std::round(beat * samplesPerBeat);
+        double beatTime = (i - beatStart) / SAMPLE_RATE;
+        bool isDownbeat = ((beat - pickupBeats) % BEATS_PER_BAR + BEATS_PER_BAR) % BEATS_PER_BAR == 0;
+        auto level = isDownbeat ? 0.8 : 0.8 * OFFBEAT_LEVEL;
+        auto kick = static_cast<float>(level * std::cos(juce::MathConstants<double>::twoPi * 55.0 * beatTime) * std::exp(-beatTime * 12.0));
+
+        buffer.setSample(0, i, beatTime >= 0.0 ? kick : 0.0f);
+        buffer.setSample(1, i, beatTime >= 0.0 ? kick : 0.0f);
+    }
+
+    return buffer;
+}
+
+juce::AudioBuffer<float> RegressionChecks::createNoise(double lengthInSeconds, int seed)
+{
+    juce::AudioBuffer<float> buffer(2, static_cast<int>(SAMPLE_RATE * lengthInSeconds));
+    juce::Random random(seed);
+
+    for (int channel = 0; channel < 2; ++channel)
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            buffer.setSample(channel, i, 0.25f * (random.nextFloat() * 2.0f - 1.0f));
+
+    return buffer;
+}
+
+bool RegressionChecks::writeWavFile(const juce::File& file, const juce::AudioBuffer<float>& audio)
+{
+    file.deleteFile();
+    std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatWriter> writer(stream != nullptr ? wavFormat.createWriterFor(stream.get(), SAMPLE_RATE, 2, 24, {}, 0)
+                                                                      : nullptr);
+
+    if (writer == nullptr)
+        return false;
+
+    // the writer owns the stream now
+    stream.release();
+    return writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples());
+}
+
+juce::Array<int> RegressionChecks::findOnsets(const juce::AudioBuffer<float>& audio, int channel)
+{
+    juce::Array<int> onsets;
+
+    if (channel >= audio.getNumChannels())
+        return onsets;
+
+    float threshold = 0.5f * audio.getMagnitude(channel, 0, audio.getNumSamples());
+    int holdOff = static_cast<int>(0.25 * SAMPLE_RATE);
+    auto* data = audio.getReadPointer(channel);
+
+    if (threshold <= 0.0f)
+        return onsets;
+
+    for (int i = 0; i < audio.getNumSamples(); ++i)
+    {
+        if (std::abs(data[i]) >= threshold)
+        {
+            onsets.add(i);
+            i += holdOff;
+        }
+    }
+
+    return onsets;
+}
+
+float RegressionChecks::getPairRMS(const juce::AudioBuffer<float>& audio, int firstChannel, double startSeconds, double endSeconds)
+{
+    int start = juce::jlimit(0, audio.getNumSamples(), static_cast<int>(startSeconds * SAMPLE_RATE));
+    int end = juce::jlimit(start, audio.getNumSamples(), static_cast<int>(endSeconds * SAMPLE_RATE));
+
+    if (end == start || firstChannel + 1 >= audio.getNumChannels())
+        return 0.0f;
+
+    float left = audio.getRMSLevel(firstChannel, start, end - start);
+    float right = audio.getRMSLevel(firstChannel + 1, start, end - start);
+    return std::sqrt(0.5f * (left * left + right * right));
+}
@@ -0,0 +1,71 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Headless regression checks, run by starting the app with --check instead of opening the GUI.
+// Each check writes synthetic tracks and a timeline to a temporary folder, renders the timeline
+// with the OfflineRenderer and measures the rendered file against what the timeline asked for -
+// the engine's own statistics aren't trusted for the answer. Every check prints a line with what
+// it measured, and the exit code is the number of checks that failed.
+class RegressionChecks
+{
+public:
+    // Runs every check and returns how many failed
+    static int runAll();
+
+    // Kicks at the same tempo on both decks this long after sync, the tolerance for how far apart
+    // they may be, and for each deck's beat from its tempo
+    static constexpr double SYNC_SETTLE_SECONDS = 8.0;
+    static constexpr double SYNC_TOLERANCE_MS = 2.0;
+    // A start on a downbeat may be this far from the leader's kick
+    static constexpr double DOWNBEAT_TOLERANCE_MS = 2.0;
+    // A timed command may land this many samples from where it was asked for
+    static constexpr int COMMAND_TOLERANCE_SAMPLES = 1;
+    // How far a looped sine may stray from the sine, wraps included
+    static constexpr float LOOP_TOLERANCE = 1.0e-3f;
+    // A silent output may be no louder than this
+    static constexpr float SILENCE_RMS = 1.0e-4f;
+
+private:
+    // Sync: a 123 BPM deck synced to a 120 BPM deck plays every kick with the leader's
+    static juce::Result checkSyncDrift(const juce::File& folder);
+    // Command timing: two plays a few thousand samples apart come out that far apart to
+    // the sample, and a start on the downbeat comes out on the leader's bar - the track
+    // opens with a pickup beat, so the bar comes from the accents and not the first kick
+    static juce::Result checkCommandTiming(const juce::File& folder);
+    // Loop wrap: a manual loop over a sine whose period divides the loop plays the
+    // sine unbroken through every wrap, and keeps looping
+    static juce::Result checkLoopWrap(const juce::File& folder);
+    // Routing: with each deck on its own pair, each deck and the pads are heard on their
+    // own pair only
+    static juce::Result checkRouting(const juce::File& folder);
+
+    // Writes the timeline into the folder, renders it and reads the render back
+    static juce::Result render(const juce::File& folder, const juce::var& timeline, juce::AudioBuffer<float>& output);
+
+    // One timeline event - load events take the file as their value
+    static juce::var makeEvent(double time, int deck, const juce::String& action, const juce::var& value = {});
+    static juce::var makeTimeline(double durationSeconds, int numDecks, const juce::String& outputs, const juce::Array<juce::var>& events);
+
+    // A kick on every beat, starting on the first sample at full level so its onset is exact.
+    // The downbeats are accented, and the first bar starts after the pickup beats
+    static juce::AudioBuffer<float> createKicks(double bpm, double lengthInSeconds, int pickupBeats = 0);
+    static juce::AudioBuffer<float> createNoise(double lengthInSeconds, int seed);
+    static bool writeWavFile(const juce::File& file, const juce::AudioBuffer<float>& audio);
+
+    // Samples where the channel first rises past half its peak, at least a quarter second apart
+    static juce::Array<int> findOnsets(const juce::AudioBuffer<float>& audio, int channel);
+    // RMS over both channels of a pair between two times, 0 past the end
+    static float getPairRMS(const juce::AudioBuffer<float>& audio, int firstChannel, double startSeconds, double endSeconds);
+
+    static constexpr double SAMPLE_RATE = 44100.0;
+    static constexpr int BLOCK_SIZE = 512;
+    static constexpr int BEATS_PER_BAR = 4;
+    // Level of the kicks off the downbeat, against the downbeat's
+    static constexpr float OFFBEAT_LEVEL = 0.625f;
+};
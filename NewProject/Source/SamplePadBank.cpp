@@ -0,0 +1,298 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "SamplePadBank.h"
+#include "Tracing.h"
+
+SamplePadBank::SamplePadBank()
+{
+    for (int pad = 0; pad < NUM_PADS; ++pad)
+    {
+        padSamples[(size_t) pad] = nullptr;
+        pendingTriggers[(size_t) pad] = 0;
+        triggerVelocities[(size_t) pad] = 1.0f;
+        pendingStops[(size_t) pad] = false;
+        playingVoices[(size_t) pad] = 0;
+    }
+}
+
+SamplePadBank::~SamplePadBank()
+{
+}
+
+juce::Result SamplePadBank::loadSample(int pad, const juce::File& file, juce::AudioFormatManager& formatManager)
+{
+    if (! juce::isPositiveAndBelow(pad, NUM_PADS))
+        return juce::Result::fail("No pad " + juce::String(pad + 1));
+
+    freeRetiredSamples();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+
+    if (reader == nullptr)
+        return juce::Result::fail("Couldn't read " + file.getFullPathName());
+
+    auto length = juce::jmin(reader->lengthInSamples, static_cast<juce::int64>(MAX_SAMPLE_SECONDS * reader->sampleRate));
+
+    if (length <= 0)
+        return juce::Result::fail(file.getFullPathName() + " has no audio");
+
+    // decoded once, here - triggering only reads it
+    auto sample = std::make_unique<PadSample>();
+    sample->audio.setSize(2, static_cast<int>(length));
+    reader->read(&sample->audio, 0, static_cast<int>(length), 0, true, true);
+    sample->sampleRate = reader->sampleRate;
+    sample->name = file.getFileNameWithoutExtension();
+
+    replaceSample(pad, samples.add(sample.release()));
+    return juce::Result::ok();
+}
+
+void SamplePadBank::clearSample(int pad)
+{
+    if (juce::isPositiveAndBelow(pad, NUM_PADS))
+        replaceSample(pad, nullptr);
+}
+
+void SamplePadBank::replaceSample(int pad, PadSample* newSample)
+{
+    // The audio thread may still be playing the old sample in the block under way and fades it out
+    // in the next, so it is freed once two more blocks have finished
+    if (auto* oldSample = padSamples[(size_t) pad].exchange(newSample))
+        oldSample->retiredAfterBlock = blocksRendered.load();
+}
+
+void SamplePadBank::freeRetiredSamples()
+{
+    auto finishedBlocks = blocksRendered.load();
+
+    for (int i = samples.size(); --i >= 0;)
+    {
+        auto retiredAfter = samples.getUnchecked(i)->retiredAfterBlock;
+
+        if (retiredAfter >= 0 && finishedBlocks >= retiredAfter + 2)
+            samples.remove(i);
+    }
+}
+
+juce::String SamplePadBank::getSampleName(int pad) const
+{
+    if (! juce::isPositiveAndBelow(pad, NUM_PADS))
+        return {};
+
+    auto* sample = padSamples[(size_t) pad].load();
+    return sample != nullptr ? sample->name : juce::String();
+}
+
+bool SamplePadBank::hasSample(int pad) const
+{
+    return juce::isPositiveAndBelow(pad, NUM_PADS) && padSamples[(size_t) pad].load() != nullptr;
+}
+
+void SamplePadBank::trigger(int pad, float velocity)
+{
+    if (! juce::isPositiveAndBelow(pad, NUM_PADS))
+        return;
+
+    triggerVelocities[(size_t) pad] = juce::jlimit(0.0f, 1.0f, velocity);
+    ++pendingTriggers[(size_t) pad];
+}
+
+void SamplePadBank::stop(int pad)
+{
+    if (juce::isPositiveAndBelow(pad, NUM_PADS))
+        pendingStops[(size_t) pad] = true;
+}
+
+void SamplePadBank::stopAll()
+{
+    for (int pad = 0; pad < NUM_PADS; ++pad)
+        stop(pad);
+}
+
+bool SamplePadBank::isPlaying(int pad) const
+{
+    // a trigger waiting for the next block counts, so the pad lights as soon as it is hit
+    return juce::isPositiveAndBelow(pad, NUM_PADS)
+        && (playingVoices[(size_t) pad].load() > 0 || pendingTriggers[(size_t) pad].load() > 0);
+}
+
+void SamplePadBank::setVolume(float newVolume)
+{
+    volume = juce::jlimit(0.0f, 1.0f, newVolume);
+}
+
+void SamplePadBank::prepareToPlay(int, double sampleRate)
+{
+    deviceSampleRate = sampleRate;
+
+    // the audio thread isn't running, so voices playing at the old rate can just stop
+    for (auto& voice : voices)
+        voice.sample = nullptr;
+    for (auto& voice : stolenVoices)
+        voice.sample = nullptr;
+}
+
+void SamplePadBank::addNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill, float gain)
+{
+    TRACE_SCOPE("audio", "sample pads");
+    int numSamples = bufferToFill.numSamples;
+
+    // Voices of a replaced sample, or of a stopped pad, fade out within this block
+    for (auto* pool : { &voices, &stolenVoices })
+    {
+        for (auto& voice : *pool)
+        {
+            if (voice.sample == nullptr)
+                continue;
+
+            if (voice.sample != padSamples[(size_t) voice.pad].load())
+                beginFadeOut(voice, juce::jmin(STEAL_FADE_SAMPLES, numSamples));
+        }
+    }
+
+    for (int pad = 0; pad < NUM_PADS; ++pad)
+    {
+        if (pendingStops[(size_t) pad].exchange(false))
+            for (auto& voice : voices)
+                if (voice.sample != nullptr && voice.pad == pad)
+                    beginFadeOut(voice, STEAL_FADE_SAMPLES);
+
+        // Triggers that arrived together land together, so they start a single voice
+        if (pendingTriggers[(size_t) pad].exchange(0) > 0)
+            startVoice(pad, triggerVelocities[(size_t) pad].load());
+    }
+
+    float busGain = volume.load() * gain;
+    std::array<int, NUM_PADS> voicesPerPad{};
+
+    for (auto* pool : { &voices, &stolenVoices })
+    {
+        for (auto& voice : *pool)
+        {
+            if (voice.sample == nullptr)
+                continue;
+
+            renderVoice(voice, *bufferToFill.buffer, bufferToFill.startSample, numSamples, lastBusGain, busGain);
+
+            if (voice.sample != nullptr)
+                ++voicesPerPad[(size_t) voice.pad];
+        }
+    }
+
+    for (int pad = 0; pad < NUM_PADS; ++pad)
+        playingVoices[(size_t) pad] = voicesPerPad[(size_t) pad];
+
+    lastBusGain = busGain;
+    ++blocksRendered;
+}
+
+void SamplePadBank::startVoice(int pad, float velocity)
+{
+    auto* sample = padSamples[(size_t) pad].load();
+
+    if (sample == nullptr)
+        return;
+
+    // a free voice, or else the oldest
+    Voice* voice = &voices[0];
+
+    for (auto& candidate : voices)
+    {
+        if (candidate.sample == nullptr)
+        {
+            voice = &candidate;
+            break;
+        }
+
+        if (candidate.startOrder - nextStartOrder < voice->startOrder - nextStartOrder)
+            voice = &candidate;
+    }
+
+    if (voice->sample != nullptr)
+    {
+        // The stolen voice carries on fading out in a spare slot - the oldest of those is cut if
+        // they are all still fading
+        Voice* spare = &stolenVoices[0];
+
+        for (auto& candidate : stolenVoices)
+        {
+            if (candidate.sample == nullptr)
+            {
+                spare = &candidate;
+                break;
+            }
+
+            if (candidate.startOrder - nextStartOrder < spare->startOrder - nextStartOrder)
+                spare = &candidate;
+        }
+
+        *spare = *voice;
+        beginFadeOut(*spare, STEAL_FADE_SAMPLES);
+    }
+
+    voice->sample = sample;
+    voice->pad = pad;
+    voice->position = 0.0;
+    voice->increment = sample->sampleRate / deviceSampleRate;
+    voice->gain = velocity;
+    voice->fadeRemaining = -1;
+    voice->fadeLength = 0;
+    voice->startOrder = nextStartOrder++;
+}
+
+void SamplePadBank::beginFadeOut(Voice& voice, int fadeSamples)
+{
+    // a voice already fading out only ever fades faster
+    if (voice.fadeRemaining >= 0 && voice.fadeRemaining <= fadeSamples)
+        return;
+
+    // picks up from the gain the fade had reached
+    float fadeGain = voice.fadeRemaining >= 0 ? static_cast<float>(voice.fadeRemaining) / voice.fadeLength : 1.0f;
+    voice.gain *= fadeGain;
+    voice.fadeLength = juce::jmax(1, fadeSamples);
+    voice.fadeRemaining = voice.fadeLength;
+}
+
+void SamplePadBank::renderVoice(Voice& voice, juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                float startGain, float endGain)
+{
+    const auto& audio = voice.sample->audio;
+    int length = audio.getNumSamples();
+    int numChannels = juce::jmin(buffer.getNumChannels(), 2);
+    float gainStep = (endGain - startGain) / static_cast<float>(juce::jmax(1, numSamples));
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // Linear interpolation only matters for a sample at a different rate to the device
+        int index = static_cast<int>(voice.position);
+
+        if (index >= length || voice.fadeRemaining == 0)
+        {
+            voice.sample = nullptr;
+            return;
+        }
+
+        float fraction = static_cast<float>(voice.position - index);
+        float sampleGain = voice.gain * (startGain + gainStep * i);
+
+        if (voice.fadeRemaining > 0)
+            sampleGain *= static_cast<float>(voice.fadeRemaining--) / voice.fadeLength;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* source = audio.getReadPointer(channel);
+            float current = source[index];
+            float next = index + 1 < length ? source[index + 1] : 0.0f;
+            buffer.addSample(channel, startSample + i, (current + (next - current) * fraction) * sampleGain);
+        }
+
+        voice.position += voice.increment;
+    }
+
+    // a fade that ran out on the block's last sample
+    if (voice.fadeRemaining == 0)
+        voice.sample = nullptr;
+}
@@ -0,0 +1,107 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+// A bank of one-shot sample pads - airhorns, drops, IDs - mixed into the master. Each pad's sample
+// is decoded into memory once, when it is loaded, and triggers play it polyphonically from a fixed
+// pool of MAX_VOICES voices, so a trigger never allocates. With every voice busy, the oldest is
+// stolen and fades out over STEAL_FADE_SAMPLES under the new one.
+//
+// Triggers are counted per pad in atomics, so any thread can fire a pad without locking, and the
+// audio thread starts them at the top of its next block - never more than a block late.
+class SamplePadBank
+{
+public:
+    SamplePadBank();
+    ~SamplePadBank();
+
+    static constexpr int NUM_PADS = 8;
+    static constexpr int MAX_VOICES = 16;
+    // Longer files are cut short, so one pad can't fill the memory
+    static constexpr double MAX_SAMPLE_SECONDS = 30.0;
+    static constexpr int STEAL_FADE_SAMPLES = 256;
+
+    // Decodes the file into the pad, replacing what it held - any voices still playing the old
+    // sample fade out at the next block (message thread)
+    juce::Result loadSample(int pad, const juce::File& file, juce::AudioFormatManager& formatManager);
+    void clearSample(int pad);
+
+    // The file name of the pad's sample, empty without one (message thread)
+    juce::String getSampleName(int pad) const;
+
+    // Any thread
+    bool hasSample(int pad) const;
+    void trigger(int pad, float velocity = 1.0f);
+    // Fades out every voice of the pad, or of every pad
+    void stop(int pad);
+    void stopAll();
+    // True from the trigger until the pad's last voice has finished
+    bool isPlaying(int pad) const;
+    void setVolume(float newVolume);
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+    // Renders the pad bus into the buffer - it isn't cleared first, so pads can be mixed straight in
+    // (audio thread)
+    void addNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill, float gain);
+
+private:
+    // A decoded sample, never changed once a pad holds it
+    struct PadSample
+    {
+        juce::AudioBuffer<float> audio;
+        double sampleRate{44100.0};
+        juce::String name;
+        // blocks the audio thread had finished when the pad let go of it, -1 while a pad holds it
+        juce::int64 retiredAfterBlock{-1};
+    };
+
+    struct Voice
+    {
+        const PadSample* sample{nullptr};
+        int pad{-1};
+        double position{0.0};
+        double increment{1.0};
+        float gain{1.0f};
+        // counts down from the fade length while the voice fades out, -1 while it plays on
+        int fadeRemaining{-1};
+        int fadeLength{0};
+        juce::uint32 startOrder{0};
+    };
+
+    // Starts a voice of the pad, stealing the oldest if they are all busy (audio thread)
+    void startVoice(int pad, float velocity);
+    // Adds the voice into the buffer, with the bus gain ramping across the block
+    static void renderVoice(Voice& voice, juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                            float startGain, float endGain);
+    static void beginFadeOut(Voice& voice, int fadeSamples);
+    // Gives the pad a new sample and marks the old one for freeing (message thread)
+    void replaceSample(int pad, PadSample* newSample);
+    // Frees replaced samples once no block can still be playing them (message thread)
+    void freeRetiredSamples();
+
+    // message thread - every sample loaded and not yet freed
+    juce::OwnedArray<PadSample> samples;
+
+    std::array<std::atomic<PadSample*>, NUM_PADS> padSamples;
+    std::array<std::atomic<int>, NUM_PADS> pendingTriggers;
+    std::array<std::atomic<float>, NUM_PADS> triggerVelocities;
+    std::array<std::atomic<bool>, NUM_PADS> pendingStops;
+    std::array<std::atomic<int>, NUM_PADS> playingVoices;
+    std::atomic<float> volume{1.0f};
+    std::atomic<juce::int64> blocksRendered{0};
+
+    // audio thread - the voice pool, and stolen voices fading out under the voices that took them
+    std::array<Voice, MAX_VOICES> voices;
+    std::array<Voice, MAX_VOICES> stolenVoices;
+    juce::uint32 nextStartOrder{0};
+    double deviceSampleRate{44100.0};
+    float lastBusGain{0.0f};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SamplePadBank)
+};
@@ -0,0 +1,122 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "SamplePadComponent.h"
+
+SamplePadComponent::SamplePadComponent(SamplePadBank& bankToUse, juce::AudioFormatManager& formatManagerToUse)
+    : bank(bankToUse), formatManager(formatManagerToUse)
+{
+    titleLabel.setText("PADS", juce::dontSendNotification);
+    titleLabel.setJustificationType(juce::Justification::centred);
+    titleLabel.setColour(juce::Label::textColourId, juce::Colour::fromRGB(200, 200, 210));
+    titleLabel.setFont(juce::Font(10.0f, juce::Font::bold));
+    addAndMakeVisible(titleLabel);
+
+    for (int pad = 0; pad < SamplePadBank::NUM_PADS; ++pad)
+    {
+        auto& padButton = padButtons[(size_t) pad];
+
+        // fires on the press, so the pad sounds as soon as the mouse goes down
+        padButton.setTriggeredOnMouseDown(true);
+        padButton.setColour(juce::TextButton::buttonColourId, juce::Colour::fromRGB(55, 55, 65));
+        padButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour::fromRGB(162, 155, 254).withAlpha(0.9f)); // Lavender
+        padButton.setColour(juce::TextButton::textColourOffId, juce::Colour::fromRGB(200, 200, 210));
+        padButton.setColour(juce::TextButton::textColourOnId, juce::Colour::fromRGB(25, 25, 30));
+        padButton.onClick = [this, pad] { padPressed(pad); };
+        updatePadText(pad);
+        addAndMakeVisible(padButton);
+    }
+
+    volumeSlider.setRange(0.0, 1.0);
+    volumeSlider.setValue(0.8);
+    volumeSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    volumeSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    volumeSlider.setColour(juce::Slider::thumbColourId, juce::Colour::fromRGB(162, 155, 254));
+    volumeSlider.setColour(juce::Slider::trackColourId, juce::Colour::fromRGB(65, 65, 75));
+    volumeSlider.onValueChange = [this] { bank.setVolume(static_cast<float>(volumeSlider.getValue())); };
+    addAndMakeVisible(volumeSlider);
+    bank.setVolume(static_cast<float>(volumeSlider.getValue()));
+
+    startTimerHz(REFRESH_RATE_HZ);
+}
+
+SamplePadComponent::~SamplePadComponent()
+{
+    stopTimer();
+}
+
+void SamplePadComponent::paint(juce::Graphics& g)
+{
+    g.setColour(juce::Colour::fromRGB(35, 35, 45).withAlpha(0.8f));
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 8.0f);
+
+    g.setColour(juce::Colour::fromRGB(70, 70, 80).withAlpha(0.4f));
+    g.drawRoundedRectangle(getLocalBounds().toFloat().reduced(0.5f), 8.0f, 1.0f);
+}
+
+void SamplePadComponent::resized()
+{
+    auto area = getLocalBounds().reduced(4);
+
+    titleLabel.setBounds(area.removeFromTop(18));
+    volumeSlider.setBounds(area.removeFromBottom(22));
+    area.removeFromBottom(4);
+
+    int numRows = SamplePadBank::NUM_PADS / NUM_COLUMNS;
+    int padWidth = area.getWidth() / NUM_COLUMNS;
+    int padHeight = juce::jmin(area.getHeight() / numRows, padWidth);
+
+    for (int pad = 0; pad < SamplePadBank::NUM_PADS; ++pad)
+    {
+        int row = pad / NUM_COLUMNS;
+        int column = pad % NUM_COLUMNS;
+        juce::Rectangle<int> padArea(area.getX() + column * padWidth, area.getY() + row * padHeight, padWidth, padHeight);
+        padButtons[(size_t) pad].setBounds(padArea.reduced(2));
+    }
+}
+
+void SamplePadComponent::timerCallback()
+{
+    for (int pad = 0; pad < SamplePadBank::NUM_PADS; ++pad)
+        padButtons[(size_t) pad].setToggleState(bank.isPlaying(pad), juce::dontSendNotification);
+}
+
+void SamplePadComponent::padPressed(int pad)
+{
+    if (! bank.hasSample(pad) || juce::ModifierKeys::currentModifiers.isShiftDown())
+        chooseSample(pad);
+    else
+        bank.trigger(pad);
+}
+
+void SamplePadComponent::chooseSample(int pad)
+{
+    fileChooser = std::make_unique<juce::FileChooser>("Select a sample for pad " + juce::String(pad + 1) + "...",
+                                                      juce::File::getSpecialLocation(juce::File::userHomeDirectory),
+                                                      "*.wav;*.mp3;*.m4a;*.aac;*.flac;*.ogg;*.aif;*.aiff");
+
+    fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                             [this, pad](const juce::FileChooser& fc)
+                             {
+                                 auto file = fc.getResult();
+                                 if (! file.existsAsFile())
+                                     return;
+
+                                 auto result = bank.loadSample(pad, file, formatManager);
+                                 if (result.failed())
+                                     juce::Logger::writeToLog("Pad not loaded: " + result.getErrorMessage());
+
+                                 updatePadText(pad);
+                             });
+}
+
+void SamplePadComponent::updatePadText(int pad)
+{
+    auto name = bank.getSampleName(pad);
+    auto& padButton = padButtons[(size_t) pad];
+
+    padButton.setButtonText(name.isEmpty() ? "+" : name.toUpperCase());
+    padButton.setTooltip(name.isEmpty() ? "Click to load a sample" : name + " - shift-click to load another sample");
+}
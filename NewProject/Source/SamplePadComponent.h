@@ -0,0 +1,44 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include "SamplePadBank.h"
+
+// A grid of the sample pads, with the pad bus volume underneath. An empty pad asks for a file when
+// clicked, and a loaded one fires on the mouse press rather than the release - shift-click loads
+// another sample into it. Pads stay lit while any of their voices are playing.
+class SamplePadComponent : public juce::Component,
+                           private juce::Timer
+{
+public:
+    SamplePadComponent(SamplePadBank& bankToUse, juce::AudioFormatManager& formatManagerToUse);
+    ~SamplePadComponent() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+    static constexpr int NUM_COLUMNS = 2;
+
+private:
+    void timerCallback() override;
+    void padPressed(int pad);
+    void chooseSample(int pad);
+    void updatePadText(int pad);
+
+    SamplePadBank& bank;
+    juce::AudioFormatManager& formatManager;
+
+    std::array<juce::TextButton, SamplePadBank::NUM_PADS> padButtons;
+    juce::Slider volumeSlider;
+    juce::Label titleLabel;
+    std::unique_ptr<juce::FileChooser> fileChooser;
+
+    static constexpr int REFRESH_RATE_HZ = 30;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SamplePadComponent)
+};
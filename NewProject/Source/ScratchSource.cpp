@@ -0,0 +1,403 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "ScratchSource.h"
+#include "Tracing.h"
+
+ScratchSource::ScratchSource(juce::AudioFormatReader* readerToUse)
+    : juce::Thread("Scratch ring"),
+      reader(readerToUse),
+      fileSampleRate(readerToUse != nullptr ? readerToUse->sampleRate : 44100.0),
+      ringLength(juce::jmax(BEHIND_BLOCK_SAMPLES * 4, static_cast<int>(RING_SECONDS * fileSampleRate)))
+{
+    resampler.setQuality(SincResamplingAudioSource::Quality::normal);
+
+    if (reader != nullptr)
+    {
+        ring.setSize(2, ringLength);
+        decodeBuffer.setSize(2, BEHIND_BLOCK_SAMPLES);
+        startThread();
+    }
+}
+
+ScratchSource::~ScratchSource()
+{
+    stopThread(2000);
+}
+
+void ScratchSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    deviceSampleRate = sampleRate;
+    resampler.prepareToPlay(samplesPerBlockExpected, sampleRate);
+}
+
+void ScratchSource::releaseResources()
+{
+    resampler.releaseResources();
+}
+
+bool ScratchSource::isAvailable() const
+{
+    return reader != nullptr;
+}
+
+void ScratchSource::grab()
+{
+    if (reader != nullptr)
+    {
+        decoding = true;
+        held = true;
+    }
+}
+
+void ScratchSource::moveBy(double seconds)
+{
+    double pending = pendingMovement.load();
+    while (! pendingMovement.compare_exchange_weak(pending, pending + seconds))
+    {
+    }
+}
+
+void ScratchSource::release()
+{
+    held = false;
+}
+
+bool ScratchSource::isHeld() const
+{
+    return held.load();
+}
+
+void ScratchSource::setPlayhead(juce::int64 filePosition)
+{
+    playhead = filePosition;
+    backwards = false;
+}
+
+void ScratchSource::warmUp()
+{
+    if (reader != nullptr)
+        decoding = true;
+}
+
+void ScratchSource::start(juce::int64 filePosition, double startVelocity)
+{
+    position = static_cast<double>(filePosition);
+    velocity = startVelocity;
+    handPosition = static_cast<double>(filePosition);
+    pendingMovement = 0.0;
+    lastGain = static_cast<float>(juce::jmin(1.0, std::abs(startVelocity) / QUIET_VELOCITY));
+
+    ringReader.position = filePosition;
+    ringReader.direction = startVelocity < 0.0 ? -1 : 1;
+    resampler.flushBuffers();
+    playhead = filePosition;
+    backwards = startVelocity < 0.0;
+    decoding = reader != nullptr;
+}
+
+void ScratchSource::stop()
+{
+    decoding = false;
+}
+
+void ScratchSource::render(const juce::AudioSourceChannelInfo& bufferToFill, double releaseVelocity)
+{
+    auto& buffer = *bufferToFill.buffer;
+    bool isHeldNow = held.load();
+    double currentPosition = position.load();
+    double currentVelocity = velocity.load();
+    double fileSamplesPerDeviceSample = fileSampleRate / deviceSampleRate;
+    // a high rate file can't be resampled as fast as MAX_VELOCITY, so the record is held to what can
+    double maxVelocity = juce::jmin(MAX_VELOCITY, SincResamplingAudioSource::MAX_RATIO / fileSamplesPerDeviceSample);
+
+    // The hand's movement is taken once a block - a released record forgets where the hand was
+    if (isHeldNow)
+        handPosition += pendingMovement.exchange(0.0) * fileSampleRate;
+    else
+        handPosition = currentPosition;
+
+    for (int done = 0; done < bufferToFill.numSamples;)
+    {
+        int numSamples = juce::jmin(CONTROL_SAMPLES, bufferToFill.numSamples - done);
+        int startSample = bufferToFill.startSample + done;
+        double elapsed = numSamples / deviceSampleRate;
+
+        // Held, the record chases the hand through its own weight - released, it runs up to speed
+        if (isHeldNow)
+        {
+            double wanted = (handPosition - currentPosition) / fileSampleRate / RESPONSE_SECONDS;
+            currentVelocity += (wanted - currentVelocity) * juce::jmin(1.0, elapsed / INERTIA_SECONDS);
+        }
+        else
+        {
+            currentVelocity += (releaseVelocity - currentVelocity) * juce::jmin(1.0, elapsed / RELEASE_SECONDS);
+        }
+
+        currentVelocity = juce::jlimit(-maxVelocity, maxVelocity, currentVelocity);
+        auto gain = static_cast<float>(juce::jmin(1.0, std::abs(currentVelocity) / QUIET_VELOCITY));
+        juce::AudioSourceChannelInfo chunk(&buffer, startSample, numSamples);
+
+        if (gain > 0.0f || lastGain > 0.0f)
+        {
+            ringReader.direction = currentVelocity < 0.0 ? -1 : 1;
+            resampler.setResamplingRatio(juce::jmax(std::abs(currentVelocity), 1.0e-3) * fileSamplesPerDeviceSample);
+            resampler.getNextAudioBlock(chunk);
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                buffer.applyGainRamp(channel, startSample, numSamples, lastGain, gain);
+        }
+        else
+        {
+            chunk.clearActiveBufferRegion();
+        }
+
+        lastGain = gain;
+        currentPosition += currentVelocity * numSamples * fileSamplesPerDeviceSample;
+        done += numSamples;
+    }
+
+    position = currentPosition;
+    velocity = currentVelocity;
+    playhead = static_cast<juce::int64>(currentPosition);
+    backwards = currentVelocity < 0.0;
+}
+
+bool ScratchSource::isSettled(double releaseVelocity) const
+{
+    return ! held.load() && std::abs(velocity.load() - releaseVelocity) < SETTLED_VELOCITY;
+}
+
+juce::int64 ScratchSource::getPosition() const
+{
+    return juce::jmax(static_cast<juce::int64>(0), static_cast<juce::int64>(std::round(position.load())));
+}
+
+juce::uint32 ScratchSource::getNumUnderruns() const
+{
+    return underruns.load();
+}
+
+bool ScratchSource::isDecoded(juce::int64 filePosition) const
+{
+    return filePosition >= ringStart.load() && filePosition < ringEnd.load();
+}
+
+void ScratchSource::setOffline(bool shouldWait)
+{
+    offline = shouldWait;
+}
+
+bool ScratchSource::waitUntilDecoded(juce::int64 firstPosition, int direction, int numSamples, juce::uint32 deadline) const
+{
+    // the span the block reads, leaving out anything off the ends of the track, which plays silence
+    auto length = reader != nullptr ? reader->lengthInSamples : 0;
+    auto lastPosition = firstPosition + direction * (numSamples - 1);
+    auto start = juce::jlimit(static_cast<juce::int64>(0), length, juce::jmin(firstPosition, lastPosition));
+    auto end = juce::jlimit(static_cast<juce::int64>(0), length, juce::jmax(firstPosition, lastPosition) + 1);
+
+    for (;;)
+    {
+        auto generation = ringGeneration.load(std::memory_order_acquire);
+
+        if ((generation & 1) == 0 && (start >= end || (start >= ringStart.load() && end <= ringEnd.load())))
+            return true;
+
+        if (juce::Time::getMillisecondCounter() >= deadline)
+            return false;
+
+        juce::Thread::sleep(1);
+    }
+}
+
+void ScratchSource::RingReader::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    if (owner.offline.load())
+    {
+        auto firstPosition = position;
+        auto firstSample = lastSample;
+        auto deadline = juce::Time::getMillisecondCounter() + (juce::uint32) OFFLINE_WAIT_MS;
+
+        while (owner.waitUntilDecoded(firstPosition, direction, bufferToFill.numSamples, deadline))
+        {
+            if (copyBlock(bufferToFill))
+                return;
+
+            position = firstPosition;
+            lastSample = firstSample;
+        }
+    }
+
+    if (! copyBlock(bufferToFill))
+        owner.underruns.store(owner.underruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+bool ScratchSource::RingReader::copyBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    auto& buffer = *bufferToFill.buffer;
+    auto generation = owner.ringGeneration.load(std::memory_order_acquire);
+    auto start = owner.ringStart.load();
+    auto end = owner.ringEnd.load();
+    auto length = owner.reader != nullptr ? owner.reader->lengthInSamples : 0;
+    auto firstPosition = position;
+    auto holding = lastSample;
+    bool underrun = false;
+
+    // odd while the thread is moving the span, so the block can't be trusted from the start
+    bool torn = (generation & 1) != 0;
+
+    for (int i = 0; i < bufferToFill.numSamples && ! torn; ++i)
+    {
+        int index = bufferToFill.startSample + i;
+
+        if (position >= start && position < end)
+        {
+            int ringIndex = static_cast<int>(position % owner.ringLength);
+            for (int channel = 0; channel < 2; ++channel)
+                holding[(size_t) channel] = owner.ring.getSample(channel, ringIndex);
+        }
+        else if (position >= 0 && position < length)
+        {
+            // Not decoded yet - the last sample is held rather than dropping to silence, which
+            // would click in and out as the thread catches up
+            underrun = true;
+        }
+        else
+        {
+            // off either end of the track
+            holding.fill(0.0f);
+        }
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            buffer.setSample(channel, index, holding[(size_t) juce::jmin(channel, 1)]);
+
+        position += direction;
+    }
+
+    // If the thread dropped part of the span while this was copying, some of it may be torn
+    std::atomic_thread_fence(std::memory_order_acquire);
+    torn = torn || owner.ringGeneration.load(std::memory_order_relaxed) != generation;
+
+    if (torn)
+    {
+        // nothing new is played - the block holds the last sample, and the playhead moves on regardless
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            juce::FloatVectorOperations::fill(buffer.getWritePointer(channel, bufferToFill.startSample),
+                                              lastSample[(size_t) juce::jmin(channel, 1)], bufferToFill.numSamples);
+
+        position = firstPosition + direction * bufferToFill.numSamples;
+    }
+    else
+    {
+        lastSample = holding;
+    }
+
+    return ! torn && ! underrun;
+}
+
+void ScratchSource::run()
+{
+    while (! threadShouldExit())
+        if (! decodeNextBlock())
+            wait(POLL_INTERVAL_MS);
+}
+
+bool ScratchSource::decodeNextBlock()
+{
+    if (! decoding.load())
+        return false;
+
+    auto length = reader->lengthInSamples;
+    auto centre = juce::jlimit(static_cast<juce::int64>(0), length, playhead.load());
+    auto start = ringStart.load();
+    auto end = ringEnd.load();
+
+    // The playhead has jumped away from the ring, so it starts again there, empty
+    if (centre < start || centre > end)
+    {
+        shrinkRing(centre, centre);
+        start = end = centre;
+    }
+
+    // Playing backwards, most of the ring is kept behind the playhead
+    bool isBackwards = backwards.load();
+    auto ahead = end - centre;
+    auto behind = centre - start;
+    int aheadLimit = isBackwards ? ringLength / 4 : ringLength / 2;
+    int behindLimit = ringLength - aheadLimit - BEHIND_BLOCK_SAMPLES;
+    bool canGoForward = end < length && ahead < aheadLimit;
+    bool canGoBack = start > 0 && behind < behindLimit;
+
+    if (! canGoForward && ! canGoBack)
+        return false;
+
+    // Read-behind: going backwards, the blocks behind the playhead are decoded before anything
+    // ahead, until the behind side is full. Otherwise whichever side is emptier goes first, behind
+    // on a tie - a grab or a reverse starts by needing what has just played
+    bool forward = canGoForward && (! canGoBack || (! isBackwards && static_cast<double>(ahead) / aheadLimit
+                                                                     < static_cast<double>(behind) / behindLimit));
+    juce::int64 blockStart;
+    int count;
+
+    if (forward)
+    {
+        TRACE_SCOPE("decode", "scratch ring ahead");
+        count = static_cast<int>(juce::jmin(static_cast<juce::int64>(DECODE_BLOCK_SAMPLES), length - end));
+        blockStart = end;
+
+        // drops the far end of what's behind before writing over it
+        if (end + count - start > ringLength)
+            shrinkRing(end + count - ringLength, end);
+
+        reader->read(&decodeBuffer, 0, count, blockStart, true, true);
+    }
+    else
+    {
+        // Backwards a block at a time - each block is a decoder seek, so they are longer, apart
+        // from the first behind the playhead, which is short so reverse has audio sooner
+        TRACE_SCOPE("decode", "scratch ring behind");
+        int blockLength = behind < DECODE_BLOCK_SAMPLES ? DECODE_BLOCK_SAMPLES : BEHIND_BLOCK_SAMPLES;
+        count = static_cast<int>(juce::jmin(static_cast<juce::int64>(blockLength), start));
+        blockStart = start - count;
+
+        if (end - blockStart > ringLength)
+            shrinkRing(start, blockStart + ringLength);
+
+        reader->read(&decodeBuffer, 0, count, blockStart, true, true);
+    }
+
+    int ringIndex = static_cast<int>(blockStart % ringLength);
+    int firstPart = juce::jmin(count, ringLength - ringIndex);
+
+    for (int channel = 0; channel < ring.getNumChannels(); ++channel)
+    {
+        int decodedChannel = juce::jmin(channel, decodeBuffer.getNumChannels() - 1);
+        ring.copyFrom(channel, ringIndex, decodeBuffer, decodedChannel, 0, firstPart);
+
+        if (count > firstPart)
+            ring.copyFrom(channel, 0, decodeBuffer, decodedChannel, firstPart, count - firstPart);
+    }
+
+    if (forward)
+        ringEnd = blockStart + count;
+    else
+        ringStart = blockStart;
+
+    return true;
+}
+
+void ScratchSource::shrinkRing(juce::int64 newStart, juce::int64 newEnd)
+{
+    // Odd while the span changes, so no reader pairs an old end with a new start. The fence keeps
+    // the writes that follow behind the change, so a reader that sees any of them sees it too
+    auto generation = ringGeneration.load(std::memory_order_relaxed);
+    ringGeneration.store(generation + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    ringStart = newStart;
+    ringEnd = newEnd;
+
+    ringGeneration.store(generation + 2, std::memory_order_release);
+}
@@ -0,0 +1,162 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include "SincResamplingAudioSource.h"
+
+// Plays a track at any velocity, forwards or backwards, for scratching and reverse play. A ring of
+// decoded audio RING_SECONDS long is kept around the playhead by the source's own thread - centred,
+// or mostly behind it while playing backwards, decoding back through the file a block at a time -
+// so the audio thread never touches the decoder. The thread only decodes from a grab, a warm-up or
+// a start until stop(), so a deck that is only playing forwards doesn't decode its track twice.
+// Going backwards it reads behind first, a short block and then long ones, ahead of the reverse
+// playhead. Anything of the track the ring doesn't hold yet holds the last sample played, and
+// counts as an underrun. The ring is read one sample at a time in the direction of travel and
+// band-limited by a sinc resampler whose ratio follows the velocity every CONTROL_SAMPLES.
+//
+// The thread moves the ring's span under the reader. Every time it drops part of the span, before
+// writing over it, it changes ringGeneration - a copy that started before the change is thrown
+// away and the block holds the reader's last sample, so a torn or stale copy is never played. That
+// counts as an underrun too.
+//
+// The velocity comes from a platter: while it is held the record follows the hand, and once it is
+// released it runs back up to the deck's speed.
+class ScratchSource : private juce::Thread
+{
+public:
+    // Takes ownership of the reader, which must read the deck's track. Without one nothing scratches.
+    explicit ScratchSource(juce::AudioFormatReader* reader);
+    ~ScratchSource() override;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+    void releaseResources();
+
+    // False if it was made without a reader
+    bool isAvailable() const;
+
+    // The platter - moveBy pushes the record through the track by seconds of audio, backwards when
+    // negative (any thread)
+    void grab();
+    void moveBy(double seconds);
+    void release();
+    bool isHeld() const;
+
+    // Follows the transport while the deck isn't scratching, for where the ring starts (audio thread)
+    void setPlayhead(juce::int64 filePosition);
+    // Starts the ring decoding ahead of a reverse or censor that is on its way (any thread)
+    void warmUp();
+    // Starts scratching from the position, at the velocity the deck was playing at (audio thread)
+    void start(juce::int64 filePosition, double velocity);
+    // The deck has handed back to the transport - the ring stops decoding (audio thread)
+    void stop();
+    // Renders at the platter's velocity, heading for the release velocity once it is let go (audio thread)
+    void render(const juce::AudioSourceChannelInfo& bufferToFill, double releaseVelocity);
+    // True once the platter is let go and back at the release velocity
+    bool isSettled(double releaseVelocity) const;
+    // Where the scratch has got to, in file samples
+    juce::int64 getPosition() const;
+
+    // True while the ring holds the file sample (any thread)
+    bool isDecoded(juce::int64 filePosition) const;
+    // Offline rendering - a block the ring doesn't hold yet waits up to OFFLINE_WAIT_MS for the
+    // thread, and is copied again if the span moved under it, so a render doesn't depend on how
+    // fast the thread decoded. A block that still can't be played is an underrun (not real time)
+    void setOffline(bool shouldWait);
+    // Blocks the reader held its last sample through, for want of decoded audio (any thread)
+    juce::uint32 getNumUnderruns() const;
+
+    static constexpr double RING_SECONDS = 8.0;
+    // Velocities in track seconds per second - 1 is the track's normal speed
+    static constexpr double MAX_VELOCITY = 4.0;
+    // How quickly the record catches up with the hand, and how heavy it is
+    static constexpr double RESPONSE_SECONDS = 0.01;
+    static constexpr double INERTIA_SECONDS = 0.0025;
+    // Longest an offline block waits for the thread before it counts as an underrun
+    static constexpr int OFFLINE_WAIT_MS = 10000;
+    // How quickly a released record runs back up to speed
+    static constexpr double RELEASE_SECONDS = 0.15;
+    // The record fades out below this velocity, as it stops
+    static constexpr double QUIET_VELOCITY = 0.02;
+    // The velocity and resampling ratio are updated this often
+    static constexpr int CONTROL_SAMPLES = 32;
+
+private:
+    // Feeds the resampler from the ring, a sample at a time in the direction of travel
+    class RingReader : public juce::AudioSource
+    {
+    public:
+        explicit RingReader(ScratchSource& ownerToUse) : owner(ownerToUse) {}
+
+        void prepareToPlay(int, double) override {}
+        void releaseResources() override {}
+        void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+        juce::int64 position{0};
+        int direction{1};
+
+    private:
+        // Copies the block from the ring, moving the position on - false if any of it held the last
+        // sample, for want of decoded audio or because the thread moved the span under it
+        bool copyBlock(const juce::AudioSourceChannelInfo& bufferToFill);
+
+        // played again while a copy is thrown away
+        std::array<float, 2> lastSample{};
+
+        ScratchSource& owner;
+    };
+
+    void run() override;
+    // Decodes the next block ahead of or behind the playhead, false if the ring is full or isn't needed
+    bool decodeNextBlock();
+    // Moves the span to one that holds less of the ring, before any of what it drops is written over
+    void shrinkRing(juce::int64 newStart, juce::int64 newEnd);
+    // Waits for the ring to hold the samples a block reads, false once the deadline passes (offline only)
+    bool waitUntilDecoded(juce::int64 firstPosition, int direction, int numSamples, juce::uint32 deadline) const;
+
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    const double fileSampleRate;
+    const int ringLength;
+
+    // The span of the file the ring holds - the thread shrinks it before writing and grows it after.
+    // The generation is odd while the span shrinks, and moves on each time it does
+    juce::AudioBuffer<float> ring;
+    std::atomic<juce::int64> ringStart{0};
+    std::atomic<juce::int64> ringEnd{0};
+    std::atomic<juce::uint32> ringGeneration{0};
+    // the thread's decode space
+    juce::AudioBuffer<float> decodeBuffer;
+    // Where the thread keeps the ring, and which way the playhead is going
+    std::atomic<juce::int64> playhead{0};
+    std::atomic<bool> backwards{false};
+    std::atomic<bool> decoding{false};
+    std::atomic<bool> offline{false};
+    std::atomic<juce::uint32> underruns{0};
+
+    RingReader ringReader{*this};
+    SincResamplingAudioSource resampler{&ringReader, false, 2};
+    double deviceSampleRate{44100.0};
+
+    // The platter - the hand's movement in seconds, waiting for the audio thread
+    std::atomic<bool> held{false};
+    std::atomic<double> pendingMovement{0.0};
+
+    // audio thread - in file samples, except the velocity
+    std::atomic<double> position{0.0};
+    std::atomic<double> velocity{0.0};
+    double handPosition{0.0};
+    float lastGain{0.0f};
+
+    // How often the thread looks for work once the ring is full
+    static constexpr int POLL_INTERVAL_MS = 5;
+    static constexpr int DECODE_BLOCK_SAMPLES = 8192;
+    static constexpr int BEHIND_BLOCK_SAMPLES = 32768;
+    // Close enough to the release velocity to hand back to the transport
+    static constexpr double SETTLED_VELOCITY = 0.01;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ScratchSource)
+};
@@ -0,0 +1,302 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "SincResamplingAudioSource.h"
+#include "VectorOps.h"
+#include "Tracing.h"
+
+// Precomputed Kaiser-windowed sinc filters, one set per quality tier. Each set has a table per
+// anti-aliasing step: reading faster than 1:1 needs a lower cutoff and a proportionally longer filter.
+class SincResamplingAudioSource::FilterTables
+{
+public:
+    struct Table
+    {
+        int halfLength = 0;
+        int numTaps = 0;
+        int numPhases = 0;
+        bool interpolatePhases = false;
+        std::vector<float> coefficients; // numPhases + 1 rows of numTaps
+
+        const float* getPhase(int phase) const { return coefficients.data() + phase * numTaps; }
+    };
+
+    static const FilterTables& getInstance()
+    {
+        static const FilterTables instance;
+        return instance;
+    }
+
+    const Table& getTable(Quality qualityToUse, double ratio) const
+    {
+        const auto& tiers = tables[static_cast<size_t>(qualityToUse)];
+
+        for (size_t i = 0; i < ratioSteps.size(); ++i)
+            if (ratio <= ratioSteps[i])
+                return tiers[i];
+
+        return tiers.back();
+    }
+
+    // Longest half filter length of any table, so the input history always fits every filter
+    static constexpr int maxHalfLength = 16 * 20;
+    static constexpr double maxRatio = SincResamplingAudioSource::MAX_RATIO;
+
+private:
+    struct TierSettings
+    {
+        int halfLength;
+        int numPhases;
+        double kaiserBeta;
+        double rolloff;
+        bool interpolatePhases;
+    };
+
+    FilterTables()
+    {
+        const TierSettings tierSettings[] = {
+            { 4,  64,  5.0, 0.80, false }, // draft
+            { 8,  128, 7.0, 0.88, true },  // normal
+            { 16, 256, 9.0, 0.93, true }   // high
+        };
+
+        for (size_t tier = 0; tier < tables.size(); ++tier)
+            for (double step : ratioSteps)
+                tables[tier].push_back(createTable(tierSettings[tier], step));
+    }
+
+    static Table createTable(const TierSettings& settings, double step)
+    {
+        Table table;
+
+        // Rounded to a multiple of 4 either side so the tap count suits the 8-wide dot product
+        table.halfLength = static_cast<int>(std::ceil(settings.halfLength * step / 4.0)) * 4;
+        table.numTaps = table.halfLength * 2;
+        table.numPhases = settings.numPhases;
+        table.interpolatePhases = settings.interpolatePhases;
+        table.coefficients.resize(static_cast<size_t>((table.numPhases + 1) * table.numTaps));
+
+        // Cutoff relative to the input rate, lowered when reading faster so nothing aliases
+        double cutoff = 0.5 * settings.rolloff / step;
+        double besselOfBeta = besselI0(settings.kaiserBeta);
+
+        for (int phase = 0; phase <= table.numPhases; ++phase)
+        {
+            double fraction = static_cast<double>(phase) / table.numPhases;
+            float* row = table.coefficients.data() + phase * table.numTaps;
+            double sum = 0.0;
+
+            for (int tap = 0; tap < table.numTaps; ++tap)
+            {
+                double t = tap - (table.halfLength - 1) - fraction;
+                double x = t / table.halfLength;
+                double window = std::abs(x) < 1.0 ? besselI0(settings.kaiserBeta * std::sqrt(1.0 - x * x)) / besselOfBeta : 0.0;
+                double arg = juce::MathConstants<double>::pi * 2.0 * cutoff * t;
+                double sinc = std::abs(arg) < 1.0e-9 ? 1.0 : std::sin(arg) / arg;
+                double value = 2.0 * cutoff * sinc * window;
+
+                row[tap] = static_cast<float>(value);
+                sum += value;
+            }
+
+            // Unity gain at DC for every phase, so the level doesn't ripple with the fractional position
+            for (int tap = 0; tap < table.numTaps; ++tap)
+                row[tap] = static_cast<float>(row[tap] / sum);
+        }
+
+        return table;
+    }
+
+    // Zeroth-order modified Bessel function of the first kind, for the Kaiser window
+    static double besselI0(double x)
+    {
+        double sum = 1.0;
+        double term = 1.0;
+
+        for (int k = 1; k < 50; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+            if (term < sum * 1.0e-12)
+                break;
+        }
+
+        return sum;
+    }
+
+    static constexpr std::array<double, 12> ratioSteps{ { 1.0, 1.25, 1.5, 2.0, 2.5, 3.0, 4.0, 6.0, 8.0, 12.0, 16.0, 20.0 } };
+    static_assert(ratioSteps.back() == maxRatio, "every ratio up to the maximum needs a table");
+
+    std::array<std::vector<Table>, 3> tables;
+};
+
+SincResamplingAudioSource::SincResamplingAudioSource(juce::AudioSource* inputSource, bool deleteInputWhenDeleted, int numChannelsToUse)
+    : input(inputSource, deleteInputWhenDeleted),
+      numChannels(numChannelsToUse),
+      tables(FilterTables::getInstance())
+{
+}
+
+SincResamplingAudioSource::~SincResamplingAudioSource()
+{
+}
+
+void SincResamplingAudioSource::setResamplingRatio(double samplesInPerOutputSample)
+{
+    jassert(samplesInPerOutputSample > 0.0);
+    // a faster ratio would be clamped, so the output plays slower than asked for
+    jassert(samplesInPerOutputSample <= FilterTables::maxRatio);
+    ratio = juce::jlimit(0.01, FilterTables::maxRatio, samplesInPerOutputSample);
+}
+
+double SincResamplingAudioSource::getResamplingRatio() const
+{
+    return ratio;
+}
+
+void SincResamplingAudioSource::setQuality(Quality newQuality)
+{
+    quality = newQuality;
+}
+
+SincResamplingAudioSource::Quality SincResamplingAudioSource::getQuality() const
+{
+    return quality;
+}
+
+void SincResamplingAudioSource::flushBuffers()
+{
+    flushRequested = true;
+}
+
+double SincResamplingAudioSource::getBufferedInputSamples() const
+{
+    // a pending flush throws the buffered input away
+    if (flushRequested.load())
+        return 0.0;
+
+    return inputCount - inputPosition;
+}
+
+void SincResamplingAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    maxBlockSize = juce::jmax(samplesPerBlockExpected, 64);
+
+    // History for the longest filter, plus one block read at the fastest ratio and its look-ahead
+    int capacity = FilterTables::maxHalfLength * 2
+                   + static_cast<int>(std::ceil(maxBlockSize * FilterTables::maxRatio)) + 2;
+    inputBuffer.setSize(numChannels, capacity);
+
+    input->prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+    resetState();
+}
+
+void SincResamplingAudioSource::releaseResources()
+{
+    input->releaseResources();
+    inputBuffer.setSize(numChannels, 0);
+}
+
+void SincResamplingAudioSource::resetState()
+{
+    // Starts with silence as history, so the first output sample is the first input sample
+    inputBuffer.clear();
+    inputCount = FilterTables::maxHalfLength - 1;
+    inputPosition = FilterTables::maxHalfLength - 1;
+}
+
+void SincResamplingAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    TRACE_SCOPE("audio", "resample");
+    if (maxBlockSize == 0)
+    {
+        bufferToFill.clearActiveBufferRegion();
+        return;
+    }
+
+    if (flushRequested.exchange(false))
+        resetState();
+
+    double currentRatio = ratio;
+
+    for (int done = 0; done < bufferToFill.numSamples; done += maxBlockSize)
+        processChunk(bufferToFill, done, juce::jmin(maxBlockSize, bufferToFill.numSamples - done), currentRatio);
+
+    for (int channel = numChannels; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+        bufferToFill.buffer->clear(channel, bufferToFill.startSample, bufferToFill.numSamples);
+}
+
+void SincResamplingAudioSource::processChunk(const juce::AudioSourceChannelInfo& bufferToFill, int startOffset, int numSamples, double currentRatio)
+{
+    const auto& table = tables.getTable(quality, currentRatio);
+    const int channelsToFill = juce::jmin(numChannels, bufferToFill.buffer->getNumChannels());
+    const int startSample = bufferToFill.startSample + startOffset;
+
+    // Reads enough input for the last output sample's look-ahead
+    int lastIndex = static_cast<int>(inputPosition + (numSamples - 1) * currentRatio) + table.halfLength;
+    fillInputTo(lastIndex + 1);
+
+    double endPosition = inputPosition;
+    const float phaseScale = static_cast<float>(table.numPhases);
+
+    // Even at 1:1 on a whole sample the filter runs - every tier's cutoff is below Nyquist, so copying
+    // the input through would change the sound whenever the speed passed exactly 1
+    for (int channel = 0; channel < channelsToFill; ++channel)
+    {
+        const float* in = inputBuffer.getReadPointer(channel);
+        float* out = bufferToFill.buffer->getWritePointer(channel, startSample);
+        double position = inputPosition;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            int index = static_cast<int>(position);
+            float phasePosition = static_cast<float>(position - index) * phaseScale;
+            int phase = juce::jmin(static_cast<int>(phasePosition), table.numPhases - 1);
+            const float* taps = in + index - table.halfLength + 1;
+
+            float value = VectorOps::dotProduct(taps, table.getPhase(phase), table.numTaps);
+
+            if (table.interpolatePhases)
+            {
+                float nextValue = VectorOps::dotProduct(taps, table.getPhase(phase + 1), table.numTaps);
+                value += (nextValue - value) * (phasePosition - static_cast<float>(phase));
+            }
+
+            out[i] = value;
+            position += currentRatio;
+        }
+
+        endPosition = position;
+    }
+
+    inputPosition = endPosition;
+
+    // Keeps just enough history behind the read position for the longest filter
+    int numToDrop = juce::jmin(inputCount, static_cast<int>(inputPosition) - (FilterTables::maxHalfLength - 1));
+    if (numToDrop > 0)
+    {
+        int numToKeep = inputCount - numToDrop;
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            float* data = inputBuffer.getWritePointer(channel);
+            std::memmove(data, data + numToDrop, sizeof(float) * static_cast<size_t>(numToKeep));
+        }
+
+        inputCount = numToKeep;
+        inputPosition -= numToDrop;
+    }
+}
+
+void SincResamplingAudioSource::fillInputTo(int endIndex)
+{
+    int numToRead = juce::jmin(endIndex, inputBuffer.getNumSamples()) - inputCount;
+    if (numToRead <= 0)
+        return;
+
+    juce::AudioSourceChannelInfo info(&inputBuffer, inputCount, numToRead);
+    input->getNextAudioBlock(info);
+    inputCount += numToRead;
+}
@@ -0,0 +1,172 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "SyncEngine.h"
+
+SyncEngine::SyncEngine()
+{
+    startTimer(DRIFT_LOG_INTERVAL_MS);
+}
+
+SyncEngine::~SyncEngine()
+{
+    stopTimer();
+}
+
+void SyncEngine::addDeck(DJAudioPlayer* player)
+{
+    auto* deck = new SyncedDeck();
+    deck->player = player;
+    decks.add(deck);
+}
+
+void SyncEngine::prepareToPlay(int samplesPerBlockExpected, double newSampleRate)
+{
+    sampleRate = newSampleRate;
+}
+
+void SyncEngine::setSyncEnabled(int deckIndex, bool shouldSync, juce::int64 releaseSampleTime)
+{
+    if (auto* deck = decks[deckIndex])
+    {
+        // Starts the drift statistics again from scratch for the new sync session
+        deck->locked = false;
+        deck->leaderIndex = -1;
+        deck->maxErrorSinceLogMs = 0.0;
+        deck->maxErrorSinceLockMs = 0.0;
+        deck->samplesLocked = 0;
+        
+        if (deck->syncEnabled.exchange(shouldSync) && ! shouldSync)
+        {
+            if (releaseSampleTime >= 0)
+                deck->player->queueCommand({ TransportCommand::Type::syncRatio, 0.0, releaseSampleTime });
+            else
+                deck->player->setSyncRatio(0.0);
+        }
+    }
+}
+
+bool SyncEngine::isSyncEnabled(int deckIndex) const
+{
+    if (auto* deck = decks[deckIndex])
+        return deck->syncEnabled;
+    return false;
+}
+
+double SyncEngine::getPhaseErrorMs(int deckIndex) const
+{
+    if (auto* deck = decks[deckIndex])
+        return deck->phaseErrorMs;
+    return 0.0;
+}
+
+double SyncEngine::getBeatPhase(DJAudioPlayer& player)
+{
+    return (player.getAudiblePositionInSeconds() - player.getBeatGridOffset()) * player.getOriginalBPM() / 60.0;
+}
+
+void SyncEngine::processBlock(int numSamples)
+{
+    // The leader is the first playing deck with a beat grid that isn't itself following another deck
+    int leaderIndex = -1;
+    for (int i = 0; i < decks.size(); ++i)
+    {
+        auto* deck = decks.getUnchecked(i);
+        if (! deck->syncEnabled && deck->player->isPlaying() && deck->player->isBPMAnalysisComplete())
+        {
+            leaderIndex = i;
+            break;
+        }
+    }
+
+    if (leaderIndex < 0)
+        return;
+
+    auto& leader = *decks.getUnchecked(leaderIndex)->player;
+    double leaderBPM = leader.getBPM();
+    double leaderPhase = getBeatPhase(leader);
+
+    for (int i = 0; i < decks.size(); ++i)
+    {
+        auto* deck = decks.getUnchecked(i);
+        auto& follower = *deck->player;
+
+        if (! deck->syncEnabled || ! follower.isBPMAnalysisComplete())
+            continue;
+
+        // Restarts the lock statistics when the deck starts following a different leader
+        if (deck->leaderIndex.exchange(leaderIndex) != leaderIndex)
+        {
+            deck->locked = false;
+            deck->maxErrorSinceLockMs = 0.0;
+            deck->samplesLocked = 0;
+        }
+
+        // Tempo match: the ratio that plays the follower's beats at the leader's current BPM
+        double matchedRatio = leaderBPM / follower.getOriginalBPM();
+
+        if (! follower.isPlaying())
+        {
+            follower.setSyncRatio(matchedRatio);
+            continue;
+        }
+
+        // Phase error in beats, wrapped to the nearest beat so decks lock to the closest grid line
+        double phaseError = leaderPhase - getBeatPhase(follower);
+        phaseError -= std::round(phaseError);
+
+        // Positive error means the leader is ahead, so the follower is nudged faster. Applying the
+        // correction as a continuous ratio change keeps the sub-sample part of the error as well
+        double errorSeconds = phaseError * 60.0 / leaderBPM;
+        double nudge = juce::jlimit(-MAX_TEMPO_NUDGE, MAX_TEMPO_NUDGE, errorSeconds / CORRECTION_TIME_SECONDS);
+        follower.setSyncRatio(matchedRatio * (1.0 + nudge));
+
+        // Drift statistics for the log
+        double errorMs = std::abs(errorSeconds) * 1000.0;
+        deck->phaseErrorMs = errorSeconds * 1000.0;
+
+        if (! deck->locked && errorMs < LOCK_THRESHOLD_MS)
+            deck->locked = true;
+
+        if (deck->locked)
+        {
+            deck->samplesLocked += numSamples;
+            if (errorMs > deck->maxErrorSinceLockMs)
+                deck->maxErrorSinceLockMs = errorMs;
+        }
+
+        if (errorMs > deck->maxErrorSinceLogMs)
+            deck->maxErrorSinceLogMs = errorMs;
+    }
+}
+
+void SyncEngine::timerCallback()
+{
+    // Logs the drift of every synced deck so long overlaps can be checked against the 1 ms target
+    for (int i = 0; i < decks.size(); ++i)
+    {
+        auto* deck = decks.getUnchecked(i);
+        double maxSinceLog = deck->maxErrorSinceLogMs.exchange(0.0);
+
+        if (! deck->syncEnabled || deck->leaderIndex < 0)
+            continue;
+
+        if (! deck->locked)
+        {
+            juce::Logger::writeToLog("Sync: deck " + juce::String(i + 1) + " locking to deck "
+                                     + juce::String(deck->leaderIndex + 1) + ", phase error "
+                                     + juce::String(deck->phaseErrorMs.load(), 3) + " ms");
+            continue;
+        }
+
+        double lockedSeconds = static_cast<double>(deck->samplesLocked) / sampleRate;
+
+        juce::Logger::writeToLog("Sync: deck " + juce::String(i + 1) + " -> deck " + juce::String(deck->leaderIndex + 1)
+                                 + " max drift " + juce::String(maxSinceLog, 3) + " ms over last "
+                                 + juce::String(DRIFT_LOG_INTERVAL_MS / 1000) + " s, "
+                                 + juce::String(deck->maxErrorSinceLockMs.load(), 3) + " ms over "
+                                 + juce::String(lockedSeconds, 1) + " s locked");
+    }
+}
@@ -0,0 +1,66 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DJAudioPlayer.h"
+
+// Matches the tempo of synced decks to a leader deck and keeps their beat grids phase locked
+class SyncEngine : private juce::Timer
+{
+public:
+    SyncEngine();
+    ~SyncEngine() override;
+
+    // Registers a deck that can take part in sync - call before the audio device starts
+    void addDeck(DJAudioPlayer* player);
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+
+    // Turns sync on or off for a deck - off hands the deck back its own speed, at the synced tempo, on
+    // releaseSampleTime of the deck's clock if one is given, or like a GUI action if not (message thread)
+    void setSyncEnabled(int deckIndex, bool shouldSync, juce::int64 releaseSampleTime = -1);
+    bool isSyncEnabled(int deckIndex) const;
+
+    // Called from the audio callback once per block, before the decks render
+    void processBlock(int numSamples);
+
+    // Latest beat phase error of a synced deck against its leader, in milliseconds
+    double getPhaseErrorMs(int deckIndex) const;
+
+private:
+    void timerCallback() override;
+
+    // Beat phase of a deck in beats since the first beat of its grid, at the next sample it puts out,
+    // so neither the block size nor what its stretcher and resampler hold shift the phase
+    static double getBeatPhase(DJAudioPlayer& player);
+
+    struct SyncedDeck
+    {
+        DJAudioPlayer* player = nullptr;
+        std::atomic<bool> syncEnabled{false};
+
+        // Drift statistics - written by the audio thread, read and reset by the timer
+        std::atomic<int> leaderIndex{-1};
+        std::atomic<double> phaseErrorMs{0.0};
+        std::atomic<double> maxErrorSinceLogMs{0.0};
+        std::atomic<double> maxErrorSinceLockMs{0.0};
+        std::atomic<juce::int64> samplesLocked{0};
+        std::atomic<bool> locked{false};
+    };
+
+    juce::OwnedArray<SyncedDeck> decks;
+    double sampleRate{44100.0};
+
+    // Phase errors are pulled in over this time constant, within +/- maxTempoNudge of the matched tempo
+    static constexpr double CORRECTION_TIME_SECONDS = 0.2;
+    static constexpr double MAX_TEMPO_NUDGE = 0.04;
+    // A follower counts as locked once its phase error first drops below this
+    static constexpr double LOCK_THRESHOLD_MS = 1.0;
+    static constexpr int DRIFT_LOG_INTERVAL_MS = 10000;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SyncEngine)
+};
@@ -0,0 +1,406 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "TimeStretchAudioSource.h"
+#include "VectorOps.h"
+#include "Tracing.h"
+
+TimeStretchAudioSource::TimeStretchAudioSource(juce::AudioSource* inputSource, bool deleteInputWhenDeleted, int numChannelsToUse)
+    : input(inputSource, deleteInputWhenDeleted), numChannels(numChannelsToUse)
+{
+}
+
+TimeStretchAudioSource::~TimeStretchAudioSource()
+{
+}
+
+void TimeStretchAudioSource::setTempo(double newTempo)
+{
+    // same range as the deck speed slider
+    tempo = juce::jlimit(0.25, 4.0, newTempo);
+}
+
+double TimeStretchAudioSource::getTempo() const
+{
+    return tempo;
+}
+
+void TimeStretchAudioSource::setBypassed(bool shouldBeBypassed)
+{
+    bypassed = shouldBeBypassed;
+}
+
+bool TimeStretchAudioSource::isBypassed() const
+{
+    return bypassed;
+}
+
+void TimeStretchAudioSource::setInputSampleRate(double newInputSampleRate)
+{
+    inputSampleRate = newInputSampleRate;
+}
+
+void TimeStretchAudioSource::flushBuffers()
+{
+    flushRequested = true;
+}
+
+int TimeStretchAudioSource::getLatencyInSamples() const
+{
+    return frameSize + searchRange;
+}
+
+void TimeStretchAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    // 30 ms frames at 50% overlap, each free to move +/- 8 ms to line up with the previous frame
+    double frameRate = inputSampleRate > 0.0 ? inputSampleRate : sampleRate;
+    hopSize = juce::roundToInt(frameRate * 0.015);
+    frameSize = hopSize * 2;
+    searchRange = juce::roundToInt(frameRate * 0.008);
+    maxInputChunk = juce::jmax(samplesPerBlockExpected, 256);
+
+    // Periodic Hann window, which sums to exactly 1 at 50% overlap
+    window.allocate(static_cast<size_t>(frameSize), false);
+    for (int i = 0; i < frameSize; ++i)
+        window[i] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * static_cast<float>(i) / static_cast<float>(frameSize));
+
+    // Room for one frame plus its search range, at the fastest tempo, with one input chunk spare
+    int inputCapacity = frameSize + 2 * searchRange + hopSize * 4 + maxInputChunk;
+    inputBuffer.setSize(numChannels, inputCapacity);
+    monoInput.allocate(static_cast<size_t>(inputCapacity), true);
+    energyPrefix.allocate(static_cast<size_t>(inputCapacity + 1), true);
+
+    overlapBuffer.setSize(numChannels, frameSize);
+    outputBuffer.setSize(numChannels, hopSize);
+
+    input->prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+    resetState();
+}
+
+void TimeStretchAudioSource::releaseResources()
+{
+    input->releaseResources();
+}
+
+void TimeStretchAudioSource::resetState()
+{
+    inputStart = 0;
+    inputCount = 0;
+    overlapBuffer.clear();
+    outputBuffer.clear();
+    outputReadPos = hopSize;
+    analysisPosition = 0.0;
+    // a silent frame before the first, which fades in from nothing
+    previousFrameStart = -hopSize;
+    handingBack = false;
+}
+
+void TimeStretchAudioSource::continueFromInput()
+{
+    // Where a hand back had got to, keeping what it had read ahead, or the input's next sample
+    juce::int64 start = 0;
+
+    if (handingBack)
+    {
+        start = passThroughPosition;
+        discardInputBefore(start);
+    }
+    else
+    {
+        inputStart = 0;
+        inputCount = 0;
+    }
+
+    overlapBuffer.clear();
+    outputBuffer.clear();
+    outputReadPos = hopSize;
+    analysisPosition = static_cast<double>(start);
+    previousFrameStart = start - hopSize;
+    handingBack = false;
+
+    // The falling half of the window over the input, which the first frame's rising half completes
+    fillInputTo(start + hopSize);
+    int index = static_cast<int>(start - inputStart);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        juce::FloatVectorOperations::multiply(overlapBuffer.getWritePointer(channel), inputBuffer.getReadPointer(channel, index),
+                                              window + hopSize, hopSize);
+}
+
+void TimeStretchAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    if (bypassed)
+    {
+        // Switched off while playing - what was read ahead is still to be heard. A jump in the
+        // input makes it worthless, so that passes straight through
+        if (flushRequested.exchange(false))
+        {
+            handingBack = false;
+        }
+        else if (! wasBypassed && hopSize > 0)
+        {
+            handingBack = true;
+            passThroughPosition = previousFrameStart + hopSize;
+            handBackFadeDone = 0;
+        }
+
+        wasBypassed = true;
+
+        if (handingBack)
+        {
+            renderHandBack(bufferToFill);
+            return;
+        }
+
+        TRACE_SCOPE("decode", "read input");
+        input->getNextAudioBlock(bufferToFill);
+        return;
+    }
+
+    if (hopSize == 0)
+    {
+        bufferToFill.clearActiveBufferRegion();
+        return;
+    }
+
+    // Starts from an empty state when the input has jumped, and from the input being heard when
+    // stretching is switched on
+    if (flushRequested.exchange(false))
+    {
+        resetState();
+        wasBypassed = false;
+    }
+    else if (wasBypassed)
+    {
+        continueFromInput();
+        wasBypassed = false;
+    }
+
+    int channelsToCopy = juce::jmin(bufferToFill.buffer->getNumChannels(), numChannels);
+    int samplesDone = 0;
+
+    while (samplesDone < bufferToFill.numSamples)
+    {
+        if (outputReadPos >= hopSize)
+            processFrame();
+
+        int samplesToCopy = juce::jmin(bufferToFill.numSamples - samplesDone, hopSize - outputReadPos);
+
+        for (int channel = 0; channel < channelsToCopy; ++channel)
+        {
+            bufferToFill.buffer->copyFrom(channel, bufferToFill.startSample + samplesDone,
+                                          outputBuffer, channel, outputReadPos, samplesToCopy);
+        }
+
+        samplesDone += samplesToCopy;
+        outputReadPos += samplesToCopy;
+    }
+
+    for (int channel = channelsToCopy; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+        bufferToFill.buffer->clear(channel, bufferToFill.startSample, bufferToFill.numSamples);
+}
+
+void TimeStretchAudioSource::renderHandBack(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    int channelsToFill = juce::jmin(bufferToFill.buffer->getNumChannels(), numChannels);
+    int done = 0;
+
+    // the rest of the last stretched hop
+    if (outputReadPos < hopSize)
+    {
+        done = juce::jmin(bufferToFill.numSamples, hopSize - outputReadPos);
+
+        for (int channel = 0; channel < channelsToFill; ++channel)
+            bufferToFill.buffer->copyFrom(channel, bufferToFill.startSample, outputBuffer, channel, outputReadPos, done);
+
+        outputReadPos += done;
+    }
+
+    // The frame's tail fades out over the input it was reading, as the window's rising half fades that in
+    if (done < bufferToFill.numSamples && handBackFadeDone < hopSize)
+    {
+        int num = juce::jmin(bufferToFill.numSamples - done, hopSize - handBackFadeDone);
+        fillInputTo(passThroughPosition + num);
+        int index = static_cast<int>(passThroughPosition - inputStart);
+
+        for (int channel = 0; channel < channelsToFill; ++channel)
+        {
+            float* out = bufferToFill.buffer->getWritePointer(channel, bufferToFill.startSample + done);
+            juce::FloatVectorOperations::copy(out, overlapBuffer.getReadPointer(channel, handBackFadeDone), num);
+            juce::FloatVectorOperations::addWithMultiply(out, inputBuffer.getReadPointer(channel, index), window + handBackFadeDone, num);
+        }
+
+        handBackFadeDone += num;
+        passThroughPosition += num;
+        done += num;
+    }
+
+    // what was read ahead, then the input itself
+    if (done < bufferToFill.numSamples)
+    {
+        int index = static_cast<int>(passThroughPosition - inputStart);
+        int num = juce::jmin(bufferToFill.numSamples - done, inputCount - index);
+
+        for (int channel = 0; channel < channelsToFill; ++channel)
+            bufferToFill.buffer->copyFrom(channel, bufferToFill.startSample + done, inputBuffer, channel, index, num);
+
+        passThroughPosition += num;
+        done += num;
+    }
+
+    if (done < bufferToFill.numSamples)
+    {
+        handingBack = false;
+        TRACE_SCOPE("decode", "read input");
+        input->getNextAudioBlock(juce::AudioSourceChannelInfo(bufferToFill.buffer, bufferToFill.startSample + done,
+                                                              bufferToFill.numSamples - done));
+        return;
+    }
+
+    for (int channel = channelsToFill; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+        bufferToFill.buffer->clear(channel, bufferToFill.startSample, bufferToFill.numSamples);
+}
+
+void TimeStretchAudioSource::processFrame()
+{
+    TRACE_SCOPE("audio", "time-stretch frame");
+    double currentTempo = tempo;
+    auto nominalStart = static_cast<juce::int64>(std::llround(analysisPosition));
+
+    fillInputTo(nominalStart + searchRange + frameSize);
+
+    auto frameStart = juce::jmax(inputStart, nominalStart + findBestOffset(nominalStart));
+    int frameIndex = static_cast<int>(frameStart - inputStart);
+
+    // Overlap-adds the windowed frame, then hands the finished first hop to the output
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        float* overlap = overlapBuffer.getWritePointer(channel);
+
+        juce::FloatVectorOperations::addWithMultiply(overlap, inputBuffer.getReadPointer(channel, frameIndex),
+                                                     window.getData(), frameSize);
+
+        outputBuffer.copyFrom(channel, 0, overlap, hopSize);
+
+        std::memmove(overlap, overlap + hopSize, sizeof(float) * static_cast<size_t>(frameSize - hopSize));
+        juce::FloatVectorOperations::clear(overlap + frameSize - hopSize, hopSize);
+    }
+
+    outputReadPos = 0;
+    previousFrameStart = frameStart;
+    analysisPosition += hopSize * currentTempo;
+
+    // Keeps the next frame's search range and the tail this frame leaves for it to match
+    auto nextNominalStart = static_cast<juce::int64>(std::llround(analysisPosition));
+    discardInputBefore(juce::jmin(previousFrameStart + hopSize, nextNominalStart - searchRange));
+}
+
+int TimeStretchAudioSource::findBestOffset(juce::int64 nominalStart)
+{
+    if (previousFrameStart < 0)
+        return 0;
+
+    // The template is how the previous frame would naturally have continued
+    const int overlapLength = frameSize - hopSize;
+    const float* naturalContinuation = monoInput + (previousFrameStart + hopSize - inputStart);
+
+    auto lowest = juce::jmax(nominalStart - searchRange, inputStart);
+    auto highest = nominalStart + searchRange;
+    int firstIndex = static_cast<int>(lowest - inputStart);
+    int numCandidates = static_cast<int>(highest - lowest) + 1;
+
+    // Running sum of squares, so each candidate's energy is one subtraction
+    energyPrefix[0] = 0.0;
+    for (int i = 0; i < numCandidates + overlapLength - 1; ++i)
+    {
+        double sample = monoInput[firstIndex + i];
+        energyPrefix[i + 1] = energyPrefix[i] + sample * sample;
+    }
+
+    auto similarity = [&](int candidate)
+    {
+        float correlation = VectorOps::dotProduct(naturalContinuation, monoInput + firstIndex + candidate, overlapLength);
+        double energy = energyPrefix[candidate + overlapLength] - energyPrefix[candidate];
+        return correlation / std::sqrt(energy + 1.0e-9);
+    };
+
+    // Coarse search every 4 samples, then a fine search around the best coarse match
+    constexpr int coarseStep = 4;
+    int bestCandidate = 0;
+    double bestSimilarity = -std::numeric_limits<double>::max();
+
+    for (int candidate = 0; candidate < numCandidates; candidate += coarseStep)
+    {
+        double value = similarity(candidate);
+        if (value > bestSimilarity)
+        {
+            bestSimilarity = value;
+            bestCandidate = candidate;
+        }
+    }
+
+    int fineStart = juce::jmax(0, bestCandidate - coarseStep + 1);
+    int fineEnd = juce::jmin(numCandidates - 1, bestCandidate + coarseStep - 1);
+
+    for (int candidate = fineStart; candidate <= fineEnd; ++candidate)
+    {
+        double value = similarity(candidate);
+        if (value > bestSimilarity)
+        {
+            bestSimilarity = value;
+            bestCandidate = candidate;
+        }
+    }
+
+    return static_cast<int>(lowest + bestCandidate - nominalStart);
+}
+
+void TimeStretchAudioSource::fillInputTo(juce::int64 endPosition)
+{
+    while (inputStart + inputCount < endPosition)
+    {
+        int numToRead = static_cast<int>(juce::jmin(endPosition - (inputStart + inputCount),
+                                                    static_cast<juce::int64>(maxInputChunk),
+                                                    static_cast<juce::int64>(inputBuffer.getNumSamples() - inputCount)));
+        if (numToRead <= 0)
+        {
+            jassertfalse; // input FIFO too small for the requested tempo
+            return;
+        }
+
+        juce::AudioSourceChannelInfo info(&inputBuffer, inputCount, numToRead);
+        {
+            TRACE_SCOPE("decode", "read input");
+            input->getNextAudioBlock(info);
+        }
+
+        // Mono mix used for the waveform similarity search
+        float* mono = monoInput + inputCount;
+        juce::FloatVectorOperations::copy(mono, inputBuffer.getReadPointer(0, inputCount), numToRead);
+        for (int channel = 1; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::add(mono, inputBuffer.getReadPointer(channel, inputCount), numToRead);
+
+        inputCount += numToRead;
+    }
+}
+
+void TimeStretchAudioSource::discardInputBefore(juce::int64 position)
+{
+    int numToDrop = static_cast<int>(juce::jlimit(static_cast<juce::int64>(0), static_cast<juce::int64>(inputCount), position - inputStart));
+    if (numToDrop == 0)
+        return;
+
+    int numToKeep = inputCount - numToDrop;
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        float* data = inputBuffer.getWritePointer(channel);
+        std::memmove(data, data + numToDrop, sizeof(float) * static_cast<size_t>(numToKeep));
+    }
+    std::memmove(monoInput.getData(), monoInput + numToDrop, sizeof(float) * static_cast<size_t>(numToKeep));
+
+    inputStart += numToDrop;
+    inputCount = numToKeep;
+}
@@ -0,0 +1,100 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Changes the tempo of its input without changing the pitch (key lock), using WSOLA:
+// overlapping windowed frames are read at the tempo ratio and each one is shifted
+// within a small search range to line up with the waveform of the previous frame
+class TimeStretchAudioSource : public juce::AudioSource
+{
+public:
+    TimeStretchAudioSource(juce::AudioSource* inputSource, bool deleteInputWhenDeleted, int numChannels = 2);
+    ~TimeStretchAudioSource() override;
+
+    // Tempo ratio - 1.0 is the original tempo, 1.08 plays 8% faster at the same pitch
+    void setTempo(double newTempo);
+    double getTempo() const;
+
+    // When bypassed the input passes straight through untouched. Switching either way while playing
+    // crossfades over one frame overlap and carries on from the input sample being heard, so the
+    // position neither jumps nor fades up from silence
+    void setBypassed(bool shouldBeBypassed);
+    bool isBypassed() const;
+
+    // The rate of the input when it isn't the rate the source is prepared at, e.g. in front of a
+    // resampler - the frames are sized in input samples (call before prepareToPlay)
+    void setInputSampleRate(double newInputSampleRate);
+
+    // Drops the buffered audio so the next block starts fresh from the input, e.g. after a seek
+    void flushBuffers();
+
+    // Fixed delay the stretcher adds between reading the input and playing it back
+    int getLatencyInSamples() const;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+private:
+    // Produces the next hop of stretched output into outputBuffer
+    void processFrame();
+    // Reads from the input until samples up to (but not including) the absolute position are buffered
+    void fillInputTo(juce::int64 endPosition);
+    // Drops buffered input that comes before the absolute position
+    void discardInputBefore(juce::int64 position);
+    // Finds the shift of the frame around nominalStart that best continues the previous frame
+    int findBestOffset(juce::int64 nominalStart);
+    void resetState();
+    // Carries on from the next input sample not yet heard, as if the input so far had been a frame
+    // fading out, so the first stretched frame crossfades in over it
+    void continueFromInput();
+    // After being bypassed - plays out the last stretched hop, crossfades its frame into the input it
+    // was reading, then passes through what was read ahead before reading the input directly
+    void renderHandBack(const juce::AudioSourceChannelInfo& bufferToFill);
+
+    juce::OptionalScopedPointer<juce::AudioSource> input;
+    const int numChannels;
+
+    std::atomic<double> tempo{1.0};
+    std::atomic<bool> bypassed{false};
+    std::atomic<bool> flushRequested{false};
+    bool wasBypassed{true};
+    double inputSampleRate{0.0};
+
+    // Handing back to the input after being bypassed - the next input sample to pass through and
+    // how far the crossfade out of the last frame has got
+    bool handingBack{false};
+    juce::int64 passThroughPosition{0};
+    int handBackFadeDone{0};
+
+    // Frame sizes, set from the sample rate in prepareToPlay
+    int hopSize{0};
+    int frameSize{0};
+    int searchRange{0};
+    int maxInputChunk{0};
+
+    juce::HeapBlock<float> window;
+
+    // Input FIFO - inputStart is the absolute input position of sample 0
+    juce::AudioBuffer<float> inputBuffer;
+    juce::HeapBlock<float> monoInput;
+    juce::HeapBlock<double> energyPrefix;
+    juce::int64 inputStart{0};
+    int inputCount{0};
+
+    // Overlap-add accumulator and the finished hop waiting to be played
+    juce::AudioBuffer<float> overlapBuffer;
+    juce::AudioBuffer<float> outputBuffer;
+    int outputReadPos{0};
+
+    // The next frame continues naturally from previousFrameStart + hopSize
+    double analysisPosition{0.0};
+    juce::int64 previousFrameStart{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TimeStretchAudioSource)
+};
@@ -0,0 +1,243 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "Tracing.h"
+
+struct Tracing::ThreadBuffer
+{
+    struct Event
+    {
+        const char* category;
+        const char* name;
+        juce::int64 startTicks;
+        juce::int64 endTicks;
+    };
+
+    // Only the owning thread writes, the dump reads the events behind writeCount
+    std::array<Event, EVENTS_PER_THREAD> events;
+    std::atomic<juce::uint64> writeCount{0};
+
+    // claimed once any thread has written here, inUse while one still is
+    std::atomic<bool> claimed{false};
+    std::atomic<bool> inUse{false};
+    char threadName[64]{};
+
+    void setThreadName(const char* name) noexcept
+    {
+        std::strncpy(threadName, name, sizeof(threadName) - 1);
+    }
+};
+
+// The calling thread's buffer, given back when the thread ends
+struct Tracing::ThreadSlot
+{
+    ~ThreadSlot()
+    {
+        if (index >= 0 && index < MAX_THREADS)
+            threadBuffers[index]->inUse.store(false, std::memory_order_release);
+    }
+
+    int index = -1;          // MAX_THREADS once the thread has found them all in use
+    const char* name = nullptr;
+};
+
+thread_local Tracing::ThreadSlot Tracing::currentThreadSlot;
+std::atomic<bool> Tracing::enabled{false};
+std::unique_ptr<Tracing::ThreadBuffer>* Tracing::threadBuffers = nullptr;
+std::atomic<int> Tracing::numUntracedThreads{0};
+
+void Tracing::setEnabled(bool shouldBeEnabled)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (shouldBeEnabled == isEnabled())
+        return;
+
+    if (shouldBeEnabled)
+    {
+        if (threadBuffers == nullptr)
+        {
+            threadBuffers = new std::unique_ptr<ThreadBuffer>[MAX_THREADS];
+
+            for (int i = 0; i < MAX_THREADS; ++i)
+                threadBuffers[i] = std::make_unique<ThreadBuffer>();
+        }
+
+        // each trace starts empty
+        for (int i = 0; i < MAX_THREADS; ++i)
+            threadBuffers[i]->writeCount.store(0, std::memory_order_relaxed);
+    }
+
+    enabled.store(shouldBeEnabled, std::memory_order_release);
+}
+
+Tracing::ThreadBuffer* Tracing::getBufferForThisThread() noexcept
+{
+    auto& slot = currentThreadSlot;
+
+    if (slot.index >= 0)
+        return slot.index < MAX_THREADS ? threadBuffers[slot.index].get() : nullptr;
+
+    // JUCE threads already have names, the rest can name themselves - nothing here allocates
+    char name[64]{};
+
+    if (slot.name != nullptr)
+        std::strncpy(name, slot.name, sizeof(name) - 1);
+    else if (juce::MessageManager::existsAndIsCurrentThread())
+        std::strncpy(name, "Message thread", sizeof(name) - 1);
+    else if (auto* thread = juce::Thread::getCurrentThread())
+        thread->getThreadName().copyToUTF8(name, sizeof(name) - 1);
+
+    slot.index = claimBuffer(name);
+
+    // all in use - this thread won't ask again
+    if (slot.index >= MAX_THREADS)
+    {
+        numUntracedThreads.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    auto* buffer = threadBuffers[slot.index].get();
+
+    if (name[0] != 0)
+        buffer->setThreadName(name);
+    else
+        std::snprintf(buffer->threadName, sizeof(buffer->threadName), "thread %d", slot.index + 1);
+
+    buffer->claimed.store(true, std::memory_order_release);
+    return buffer;
+}
+
+int Tracing::claimBuffer(const char* name) noexcept
+{
+    auto tryClaim = [](int index)
+    {
+        bool expected = false;
+        return threadBuffers[index]->inUse.compare_exchange_strong(expected, true, std::memory_order_acq_rel);
+    };
+
+    // A thread of the same name that has ended carries on in the same row
+    if (name[0] != 0)
+        for (int i = 0; i < MAX_THREADS; ++i)
+            if (threadBuffers[i]->claimed.load(std::memory_order_acquire)
+                && std::strncmp(threadBuffers[i]->threadName, name, sizeof(ThreadBuffer::threadName)) == 0 && tryClaim(i))
+                return i;
+
+    for (int i = 0; i < MAX_THREADS; ++i)
+        if (! threadBuffers[i]->claimed.load(std::memory_order_acquire) && tryClaim(i))
+            return i;
+
+    // A buffer left by a thread of another name - its events would be shown under the new name
+    for (int i = 0; i < MAX_THREADS; ++i)
+    {
+        if (tryClaim(i))
+        {
+            threadBuffers[i]->writeCount.store(0, std::memory_order_release);
+            return i;
+        }
+    }
+
+    return MAX_THREADS;
+}
+
+void Tracing::setCurrentThreadName(const char* name)
+{
+    currentThreadSlot.name = name;
+
+    if (! enabled.load(std::memory_order_acquire))
+        return;
+
+    if (auto* buffer = getBufferForThisThread())
+        buffer->setThreadName(name);
+}
+
+void Tracing::recordEvent(const char* category, const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept
+{
+    if (! enabled.load(std::memory_order_acquire))
+        return;
+
+    if (auto* buffer = getBufferForThisThread())
+    {
+        auto count = buffer->writeCount.load(std::memory_order_relaxed);
+        buffer->events[(size_t) (count % EVENTS_PER_THREAD)] = { category, name, startTicks, endTicks };
+        buffer->writeCount.store(count + 1, std::memory_order_release);
+    }
+}
+
+juce::File Tracing::getDefaultTraceFile()
+{
+    auto folder = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("OtoDecks");
+    folder.createDirectory();
+    return folder.getChildFile("trace-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".json");
+}
+
+juce::Result Tracing::writeChromeTrace(const juce::File& file)
+{
+    if (threadBuffers == nullptr)
+        return juce::Result::fail("Nothing has been traced yet");
+
+    file.deleteFile();
+    juce::FileOutputStream out(file);
+
+    if (out.failedToOpen())
+        return juce::Result::fail("Can't write to " + file.getFullPathName());
+
+    // Timestamps are in microseconds from the earliest event still in the buffers
+    double ticksPerMicrosecond = juce::Time::getHighResolutionTicksPerSecond() / 1.0e6;
+    juce::int64 firstTicks = std::numeric_limits<juce::int64>::max();
+    int numThreads = MAX_THREADS;
+
+    if (auto numUntraced = numUntracedThreads.load())
+        juce::Logger::writeToLog("Tracing: " + juce::String(numUntraced) + " threads weren't traced, all "
+                                 + juce::String(MAX_THREADS) + " buffers were in use");
+
+    for (int i = 0; i < numThreads; ++i)
+    {
+        auto& buffer = *threadBuffers[i];
+        auto count = buffer.writeCount.load(std::memory_order_acquire);
+        auto oldest = count > (juce::uint64) EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD : 0;
+
+        if (buffer.claimed.load(std::memory_order_acquire) && count > 0)
+            firstTicks = juce::jmin(firstTicks, buffer.events[(size_t) (oldest % EVENTS_PER_THREAD)].startTicks);
+    }
+
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+
+    for (int i = 0; i < numThreads; ++i)
+    {
+        auto& buffer = *threadBuffers[i];
+
+        if (! buffer.claimed.load(std::memory_order_acquire))
+            continue;
+
+        auto tid = juce::String(i + 1);
+        out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":" << juce::JSON::toString(juce::String(buffer.threadName)) << "}}";
+        first = false;
+
+        // The thread may keep writing while this runs, so events it could have overwritten are skipped
+        auto endCount = buffer.writeCount.load(std::memory_order_acquire);
+        auto startCount = endCount > (juce::uint64) EVENTS_PER_THREAD ? endCount - EVENTS_PER_THREAD : 0;
+
+        for (auto index = startCount; index < endCount; ++index)
+        {
+            auto event = buffer.events[(size_t) (index % EVENTS_PER_THREAD)];
+
+            if (buffer.writeCount.load(std::memory_order_acquire) - index > (juce::uint64) EVENTS_PER_THREAD)
+                continue;
+
+            out << ",\n{\"ph\":\"X\",\"cat\":\"" << event.category << "\",\"name\":\"" << event.name
+                << "\",\"pid\":1,\"tid\":" << tid
+                << ",\"ts\":" << juce::String((event.startTicks - firstTicks) / ticksPerMicrosecond, 3)
+                << ",\"dur\":" << juce::String((event.endTicks - event.startTicks) / ticksPerMicrosecond, 3) << "}";
+        }
+    }
+
+    out << "\n]}\n";
+    out.flush();
+
+    return out.getStatus();
+}
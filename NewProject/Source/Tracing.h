@@ -0,0 +1,94 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Set to 0 to compile every TRACE_SCOPE out completely
+#ifndef OTODECKS_TRACING
+ #define OTODECKS_TRACING 1
+#endif
+
+// Scoped trace events for chrome://tracing and Perfetto. Each thread writes into its own
+// preallocated ring buffer, so recording an event is two timer reads and a few stores with
+// no locks or allocations, and is safe on the audio thread. While tracing is off a scope
+// costs one relaxed atomic load. The buffers are dumped to a Chrome trace JSON file on demand.
+class Tracing
+{
+public:
+    // Starting allocates the buffers (once) and clears them, stopping keeps what was recorded
+    static void setEnabled(bool shouldBeEnabled);
+    static bool isEnabled() noexcept { return enabled.load(std::memory_order_relaxed); }
+
+    // Names the calling thread in the trace, once - threads that aren't juce::Threads and don't
+    // name themselves show up as "thread N". Works whether tracing is on or not, and the name
+    // must be a string literal
+    static void setCurrentThreadName(const char* name);
+
+    // Writes everything still in the buffers as a Chrome trace (message thread)
+    static juce::Result writeChromeTrace(const juce::File& file);
+
+    // Default location for a trace, in the OtoDecks documents folder
+    static juce::File getDefaultTraceFile();
+
+    // Records one complete event - the name and category must be string literals
+    static void recordEvent(const char* category, const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept;
+
+    class ScopedEvent
+    {
+    public:
+        ScopedEvent(const char* eventCategory, const char* eventName) noexcept
+            : category(eventCategory), name(eventName),
+              startTicks(isEnabled() ? juce::Time::getHighResolutionTicks() : 0)
+        {
+        }
+
+        ~ScopedEvent()
+        {
+            if (startTicks != 0)
+                recordEvent(category, name, startTicks, juce::Time::getHighResolutionTicks());
+        }
+
+    private:
+        const char* category;
+        const char* name;
+        juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedEvent)
+    };
+
+    // Threads running at once past this many are not traced. A thread gives its buffer back when
+    // it ends, and a later thread of the same name carries on in it - so one row per track load's
+    // threads rather than a new buffer each time
+    static constexpr int MAX_THREADS = 24;
+    // Events kept per thread - several seconds of audio callbacks
+    static constexpr int EVENTS_PER_THREAD = 16384;
+
+private:
+    struct ThreadBuffer;
+
+    struct ThreadSlot;
+
+    // Finds or claims the calling thread's buffer, nullptr when they are all in use
+    static ThreadBuffer* getBufferForThisThread() noexcept;
+    // Takes a free buffer, preferring one a thread of the same name had, then one never used
+    static int claimBuffer(const char* name) noexcept;
+
+    static std::atomic<bool> enabled;
+
+    // Allocated the first time tracing starts and never freed, so a thread still holding its
+    // buffer can't outlive it
+    static std::unique_ptr<ThreadBuffer>* threadBuffers;
+    // Threads that found every buffer in use, reported when the trace is written
+    static std::atomic<int> numUntracedThreads;
+    static thread_local ThreadSlot currentThreadSlot;
+};
+
+#if OTODECKS_TRACING
+ #define TRACE_SCOPE(category, name) Tracing::ScopedEvent JUCE_JOIN_MACRO(traceScope_, __LINE__) (category, name)
+#else
+ #define TRACE_SCOPE(category, name)
+#endif
@@ -0,0 +1,99 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "TrackAnalysisCache.h"
+
+static std::atomic<bool> cacheInMemory{false};
+
+static std::unique_ptr<juce::PropertiesFile> openCacheFile()
+{
+    if (cacheInMemory.load())
+        return nullptr;
+
+    // Same settings as the saved playlist
+    juce::PropertiesFile::Options options;
+    options.applicationName = "OtoDecks";
+    options.filenameSuffix = ".properties";
+    options.folderName = "OtoDecks";
+
+    return std::make_unique<juce::PropertiesFile>(TrackAnalysisCache::getCacheFile(), options);
+}
+
+TrackAnalysisCache::TrackAnalysisCache()
+    : file(openCacheFile()),
+      properties(file != nullptr ? *file : memoryOnly)
+{
+}
+
+TrackAnalysisCache::~TrackAnalysisCache()
+{
+    save();
+}
+
+void TrackAnalysisCache::keepInMemory()
+{
+    cacheInMemory = true;
+}
+
+void TrackAnalysisCache::save()
+{
+    if (file != nullptr)
+        file->saveIfNeeded();
+}
+
+juce::File TrackAnalysisCache::getCacheFile()
+{
+    auto folder = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("OtoDecks");
+    folder.createDirectory();
+    return folder.getChildFile("analysis.properties");
+}
+
+juce::String TrackAnalysisCache::getKey(const juce::File& audioFile, int analyserVersion)
+{
+    auto identity = audioFile.getFullPathName() + "|" + juce::String(audioFile.getSize())
+                  + "|" + juce::String(audioFile.getLastModificationTime().toMilliseconds())
+                  + "|" + juce::String(analyserVersion);
+    return juce::String::toHexString(identity.hashCode64());
+}
+
+bool TrackAnalysisCache::getBeatGrid(const juce::File& audioFile, double& bpm, double& beatGridOffset) const
+{
+    auto key = getKey(audioFile, BEAT_GRID_VERSION);
+
+    if (! properties.containsKey(key + "_bpm"))
+        return false;
+
+    bpm = properties.getDoubleValue(key + "_bpm");
+    beatGridOffset = properties.getDoubleValue(key + "_beatGridOffset");
+    return true;
+}
+
+bool TrackAnalysisCache::getLoudness(const juce::File& audioFile, double& integratedLUFS, double& truePeakDecibels) const
+{
+    auto key = getKey(audioFile, LOUDNESS_VERSION);
+
+    if (! properties.containsKey(key + "_lufs"))
+        return false;
+
+    integratedLUFS = properties.getDoubleValue(key + "_lufs");
+    truePeakDecibels = properties.getDoubleValue(key + "_truePeak");
+    return true;
+}
+
+void TrackAnalysisCache::setBeatGrid(const juce::File& audioFile, double bpm, double beatGridOffset)
+{
+    auto key = getKey(audioFile, BEAT_GRID_VERSION);
+    properties.setValue(key + "_bpm", bpm);
+    properties.setValue(key + "_beatGridOffset", beatGridOffset);
+    save();
+}
+
+void TrackAnalysisCache::setLoudness(const juce::File& audioFile, double integratedLUFS, double truePeakDecibels)
+{
+    auto key = getKey(audioFile, LOUDNESS_VERSION);
+    properties.setValue(key + "_lufs", integratedLUFS);
+    properties.setValue(key + "_truePeak", truePeakDecibels);
+    save();
+}
@@ -0,0 +1,50 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Remembers the results of analysing each track - beat grid and loudness - so loading a track
+// a second time costs nothing. Entries are keyed on the file's path, size and modification
+// time, so an edited file is analysed again, and on the version of the analyser that made them,
+// so a changed analyser doesn't go on using old results. Every deck shares one cache through a
+// juce::SharedResourcePointer, and it can be used from any thread.
+class TrackAnalysisCache
+{
+public:
+    TrackAnalysisCache();
+    ~TrackAnalysisCache();
+
+    // Each returns false if the track hasn't been analysed yet
+    bool getBeatGrid(const juce::File& audioFile, double& bpm, double& beatGridOffset) const;
+    bool getLoudness(const juce::File& audioFile, double& integratedLUFS, double& truePeakDecibels) const;
+
+    void setBeatGrid(const juce::File& audioFile, double bpm, double beatGridOffset);
+    void setLoudness(const juce::File& audioFile, double integratedLUFS, double truePeakDecibels);
+
+    // Cache file in the OtoDecks documents folder
+    static juce::File getCacheFile();
+
+    // Caches made from now on are kept in memory and never saved - for the headless modes, so
+    // their temporary tracks stay out of the user's cache (before any deck is made)
+    static void keepInMemory();
+
+    // Bumped whenever an analyser's results change, so the old entries are no longer found
+    static constexpr int BEAT_GRID_VERSION = 2;
+    static constexpr int LOUDNESS_VERSION = 1;
+
+private:
+    // Unique to this version of the file and of the analyser
+    static juce::String getKey(const juce::File& audioFile, int analyserVersion);
+    void save();
+
+    // The cache file, or nothing while the cache is only kept in memory
+    std::unique_ptr<juce::PropertiesFile> file;
+    juce::PropertySet memoryOnly;
+    juce::PropertySet& properties;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrackAnalysisCache)
+};
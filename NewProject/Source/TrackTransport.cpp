@@ -0,0 +1,102 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "TrackTransport.h"
+
+TrackTransport::TrackTransport(juce::PositionableAudioSource* sourceToPlay)
+    : source(sourceToPlay)
+{
+    jassert(source != nullptr);
+}
+
+void TrackTransport::start()
+{
+    playing.store(true, std::memory_order_release);
+}
+
+void TrackTransport::stop()
+{
+    playing.store(false, std::memory_order_release);
+}
+
+bool TrackTransport::isPlaying() const
+{
+    return playing.load(std::memory_order_acquire);
+}
+
+void TrackTransport::setNextReadPosition(juce::int64 newPosition)
+{
+    source->setNextReadPosition(newPosition);
+}
+
+juce::int64 TrackTransport::getNextReadPosition() const
+{
+    return source->getNextReadPosition();
+}
+
+juce::int64 TrackTransport::getTotalLength() const
+{
+    return source->getTotalLength();
+}
+
+void TrackTransport::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    source->prepareToPlay(samplesPerBlockExpected, sampleRate);
+    wasPlaying = false;
+    declickSamplesLeft = 0;
+}
+
+void TrackTransport::releaseResources()
+{
+    source->releaseResources();
+}
+
+void TrackTransport::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    bool shouldPlay = playing.load(std::memory_order_acquire);
+
+    if (shouldPlay != wasPlaying)
+    {
+        wasPlaying = shouldPlay;
+        declickSamplesLeft = DECLICK_SAMPLES;
+    }
+
+    if (! shouldPlay && declickSamplesLeft == 0)
+    {
+        bufferToFill.clearActiveBufferRegion();
+        return;
+    }
+
+    auto& buffer = *bufferToFill.buffer;
+    int fade = juce::jmin(bufferToFill.numSamples, declickSamplesLeft);
+    float fadeStart = static_cast<float>(declickSamplesLeft) / DECLICK_SAMPLES;
+    float fadeEnd = static_cast<float>(declickSamplesLeft - fade) / DECLICK_SAMPLES;
+    declickSamplesLeft -= fade;
+
+    if (shouldPlay)
+    {
+        source->getNextAudioBlock(bufferToFill);
+
+        // fades in from silence after a start
+        if (fade > 0)
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                buffer.applyGainRamp(channel, bufferToFill.startSample, fade, 1.0f - fadeStart, 1.0f - fadeEnd);
+
+        // stops by itself at the end of the track
+        if (source->getNextReadPosition() >= source->getTotalLength())
+            playing.store(false, std::memory_order_release);
+    }
+    else
+    {
+        // Stopping - plays out the rest of the fade and holds the position where it ends
+        source->getNextAudioBlock(juce::AudioSourceChannelInfo(&buffer, bufferToFill.startSample, fade));
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            buffer.applyGainRamp(channel, bufferToFill.startSample, fade, fadeStart, fadeEnd);
+            buffer.clear(channel, bufferToFill.startSample + fade, bufferToFill.numSamples - fade);
+        }
+    }
+}
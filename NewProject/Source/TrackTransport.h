@@ -0,0 +1,45 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Plays a positionable source with a start and stop that are only an atomic flag, so the audio
+// thread itself can start and stop a track part way through a block - juce::AudioTransportSource
+// sleeps in stop() until the callback has seen it. A stopped track outputs silence and holds its
+// place, and every start and stop is faded over a few samples so it doesn't click.
+class TrackTransport : public juce::AudioSource
+{
+public:
+    explicit TrackTransport(juce::PositionableAudioSource* sourceToPlay);
+
+    // Any thread - the next block starts or stops
+    void start();
+    void stop();
+    bool isPlaying() const;
+
+    // Moves the read position in source samples (audio thread, or while it isn't running)
+    void setNextReadPosition(juce::int64 newPosition);
+    juce::int64 getNextReadPosition() const;
+    juce::int64 getTotalLength() const;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+    // Length of the fade in on a start and out on a stop
+    static constexpr int DECLICK_SAMPLES = 64;
+
+private:
+    juce::PositionableAudioSource* source;
+    std::atomic<bool> playing{false};
+
+    // audio thread only - the fade carries on across blocks cut short by a command
+    bool wasPlaying{false};
+    int declickSamplesLeft{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrackTransport)
+};
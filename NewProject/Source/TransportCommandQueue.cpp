@@ -0,0 +1,32 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#include "TransportCommandQueue.h"
+
+bool TransportCommandQueue::push(const TransportCommand& command)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 + size2 < 1)
+        return false;
+
+    commands[(size_t) (size1 > 0 ? start1 : start2)] = command;
+    fifo.finishedWrite(1);
+    return true;
+}
+
+bool TransportCommandQueue::pop(TransportCommand& command)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(1, start1, size1, start2, size2);
+
+    if (size1 + size2 < 1)
+        return false;
+
+    command = commands[(size_t) (size1 > 0 ? start1 : start2)];
+    fifo.finishedRead(1);
+    return true;
+}
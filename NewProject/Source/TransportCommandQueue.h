@@ -0,0 +1,44 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+// A transport action for a deck, to land on an exact sample of the deck's clock
+struct TransportCommand
+{
+    enum class Type { play, stop, seek, speed, hotCue, loopIn, loopOut, autoLoop, loopRoll, loopExit, reverse, censor, syncRatio, keyLock };
+
+    Type type{Type::play};
+    double value{0.0};          // seconds for a seek, the ratio for a speed change, the index of a hot
+                                // cue, the beats of an auto-loop or roll, non-zero to start reverse
+                                // or a censor and zero to end it, the synced ratio or zero to release sync,
+                                // non-zero to lock the key and zero to unlock it
+    juce::int64 sampleTime{0};  // when it lands - a time already past lands at the start of the next block
+};
+
+// Single producer, single consumer FIFO of transport commands into the audio thread. The
+// commands live in a fixed array behind an AbstractFifo, so neither side locks or allocates.
+class TransportCommandQueue
+{
+public:
+    TransportCommandQueue() = default;
+
+    static constexpr int CAPACITY = 128;
+
+    // One thread at a time - false if the queue is full
+    bool push(const TransportCommand& command);
+
+    // Audio thread - false once the queue is empty
+    bool pop(TransportCommand& command);
+
+private:
+    juce::AbstractFifo fifo{CAPACITY};
+    std::array<TransportCommand, CAPACITY> commands;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TransportCommandQueue)
+};
@@ -0,0 +1,83 @@
+/*
+  Author: Sam May
+  Note: Entire file written by me as part of CM2005 coursework
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_USE_SSE_INTRINSICS
+ #include <xmmintrin.h>
+#elif JUCE_USE_ARM_NEON
+ #include <arm_neon.h>
+#endif
+
+// Small SIMD kernels for the DSP hot loops that juce::FloatVectorOperations doesn't cover
+namespace VectorOps
+{
+    // Sum of a[i] * b[i]
+    inline float dotProduct(const float* a, const float* b, int num) noexcept
+    {
+        int i = 0;
+        float result = 0.0f;
+
+       #if JUCE_USE_SSE_INTRINSICS
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+
+        for (; i + 8 <= num; i += 8)
+        {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i),     _mm_loadu_ps(b + i)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        }
+
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, _mm_add_ps(acc0, acc1));
+        result = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+       #elif JUCE_USE_ARM_NEON
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+
+        for (; i + 8 <= num; i += 8)
+        {
+            acc0 = vmlaq_f32(acc0, vld1q_f32(a + i),     vld1q_f32(b + i));
+            acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        }
+
+        float32x4_t acc = vaddq_f32(acc0, acc1);
+        result = (vgetq_lane_f32(acc, 0) + vgetq_lane_f32(acc, 1)) + (vgetq_lane_f32(acc, 2) + vgetq_lane_f32(acc, 3));
+       #endif
+
+        for (; i < num; ++i)
+            result += a[i] * b[i];
+
+        return result;
+    }
+
+    // Sum of a[i] * a[i]
+    inline float sumOfSquares(const float* a, int num) noexcept
+    {
+        return dotProduct(a, a, num);
+    }
+
+    // dest[i] = max(|a[i]|, |b[i]|) - the linked peak of a stereo pair
+    inline void maxAbs(float* dest, const float* a, const float* b, int num) noexcept
+    {
+        int i = 0;
+
+       #if JUCE_USE_SSE_INTRINSICS
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+
+        for (; i + 4 <= num; i += 4)
+            _mm_storeu_ps(dest + i, _mm_max_ps(_mm_andnot_ps(signMask, _mm_loadu_ps(a + i)),
+                                               _mm_andnot_ps(signMask, _mm_loadu_ps(b + i))));
+       #elif JUCE_USE_ARM_NEON
+        for (; i + 4 <= num; i += 4)
+            vst1q_f32(dest + i, vmaxq_f32(vabsq_f32(vld1q_f32(a + i)), vabsq_f32(vld1q_f32(b + i))));
+       #endif
+
+        for (; i < num; ++i)
+            dest[i] = juce::jmax(std::abs(a[i]), std::abs(b[i]));
+    }
+}
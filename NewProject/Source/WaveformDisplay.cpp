@@ -5,6 +5,7 @@
 
 #include <JuceHeader.h>
 #include "WaveformDisplay.h"
+#include "Tracing.h"
 
 WaveformDisplay::WaveformDisplay(juce::AudioFormatManager & formatManagerToUse,
                                   juce::AudioThumbnailCache & thumbnailCacheToUse)
@@ -24,6 +25,8 @@ WaveformDisplay::~WaveformDisplay()
 
 void WaveformDisplay::paint (juce::Graphics& g)
 {
+    TRACE_SCOPE("gui", "waveform paint");
+    
     // Dark waveform background
     g.fillAll(juce::Colour::fromRGB(25, 25, 30));
 
@@ -76,8 +79,21 @@ void WaveformDisplay::loadURL(juce::URL audioURL)
     }
 }
 
+void WaveformDisplay::setScratchMode(bool shouldScratch)
+{
+    scratchMode = shouldScratch;
+}
+
 void WaveformDisplay::mouseDown(const juce::MouseEvent& event)
 {
+    if (scratchMode)
+    {
+        lastScratchX = event.position.x;
+        if (onScratchStart)
+            onScratchStart();
+        return;
+    }
+    
     if (fileLoaded && audioThumbnail.getTotalLength() > 0)
     {
         // Calculates the relative position (0.0 to 1.0) from the DJ's mouse click
@@ -95,7 +111,24 @@ void WaveformDisplay::mouseDown(const juce::MouseEvent& event)
 
 void WaveformDisplay::mouseDrag(const juce::MouseEvent& event)
 {
-    mouseDown(event);
+    if (! scratchMode)
+    {
+        mouseDown(event);
+        return;
+    }
+    
+    // Dragging right pushes the record forwards
+    double seconds = (event.position.x - lastScratchX) / juce::jmax(1, getWidth()) * SCRATCH_SECONDS_ACROSS;
+    lastScratchX = event.position.x;
+    
+    if (onScratchMove)
+        onScratchMove(seconds);
+}
+
+void WaveformDisplay::mouseUp(const juce::MouseEvent&)
+{
+    if (scratchMode && onScratchEnd)
+        onScratchEnd();
 }
 
 void WaveformDisplay::changeListenerCallback (juce::ChangeBroadcaster *source)
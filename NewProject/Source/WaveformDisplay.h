@@ -21,6 +21,7 @@ public:
     // Mouse interaction for seeking
 void mouseDown (const juce::MouseEvent& event) override;
 void mouseDrag (const juce::MouseEvent& event) override;
+    void mouseUp (const juce::MouseEvent& event) override;
 
     void changeListenerCallback (juce::ChangeBroadcaster *source) override;
 
@@ -31,6 +32,16 @@ void mouseDrag (const juce::MouseEvent& event) override;
     
     // Callback for when user clicks/drags to change position
     std::function<void(double)> onPositionChange;
+    
+    // In scratch mode a drag moves the record instead of seeking - pressing grabs it, dragging
+    // pushes it by seconds of the track and letting go releases it
+    void setScratchMode(bool shouldScratch);
+    std::function<void()> onScratchStart;
+    std::function<void(double)> onScratchMove;
+    std::function<void()> onScratchEnd;
+    
+    // In scratch mode the width of the display is one turn of a record at 33 rpm
+    static constexpr double SCRATCH_SECONDS_ACROSS = 1.8;
 
 private:
     juce::AudioFormatManager & formatManager;
@@ -38,6 +49,8 @@ private:
     juce::AudioThumbnail audioThumbnail;
     bool fileLoaded;
     double position;
+    bool scratchMode{false};
+    float lastScratchX{0.0f};
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveformDisplay)
 };